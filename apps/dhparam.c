@@ -14,6 +14,7 @@
 #include <openssl/err.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
+#include <stdcompat.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,7 +41,8 @@ int dhparam_main(int argc, char **argv)
 #ifndef OPENSSL_NO_ENGINE
     char *engine = NULL;
 #endif
-    int num = 0, g = 0;
+    int num = 0, g = 0, threads = 0;
+    const char *stnerr = NULL;
 
     if (bio_err == NULL)
         if ((bio_err = BIO_new(BIO_s_file())) != NULL)
@@ -98,6 +100,13 @@ int dhparam_main(int argc, char **argv)
             g = 2;
         else if (strcmp(*argv, "-5") == 0)
             g = 5;
+        else if (strcmp(*argv, "-threads") == 0) {
+            if (--argc < 1)
+                goto bad;
+            threads = strtonum(*(++argv), 1, BN_GENCB_MAX_THREADS, &stnerr);
+            if (stnerr)
+                goto bad;
+        }
         else if (((sscanf(*argv, "%d", &num) == 0) || (num <= 0)))
             goto bad;
         argv++;
@@ -122,6 +131,7 @@ int dhparam_main(int argc, char **argv)
                             "the generator value\n");
         BIO_printf(bio_err, " -5            generate parameters using  5 as "
                             "the generator value\n");
+        BIO_printf(bio_err, " -threads n    search for the prime in n threads\n");
         BIO_printf(bio_err, " numbits       number of bits in to generate (default 2048)\n");
 #ifndef OPENSSL_NO_ENGINE
         BIO_printf(bio_err, " -engine e     use engine e, possibly a hardware device.\n");
@@ -156,6 +166,7 @@ int dhparam_main(int argc, char **argv)
 
         BN_GENCB cb;
         BN_GENCB_set(&cb, dh_cb, bio_err);
+        BN_GENCB_set_threads(&cb, threads);
 
 #ifndef OPENSSL_NO_DSA
         if (dsaparam) {
@@ -27,6 +27,7 @@
 #include <openssl/pem.h>
 #include <openssl/rsa.h>
 #include <openssl/x509.h>
+#include <stdcompat.h>
 
 #include "apps.h"
 
@@ -47,6 +48,7 @@ int genrsa_main(int argc, char **argv)
     unsigned long f4 = RSA_F4;
     char *outfile = NULL;
     char *passargout = NULL, *passout = NULL;
+    const char *stnerr = NULL;
 #ifndef OPENSSL_NO_ENGINE
     char *engine = NULL;
 #endif
@@ -83,6 +85,14 @@ int genrsa_main(int argc, char **argv)
             f4 = 3;
         else if (strcmp(*argv, "-F4") == 0 || strcmp(*argv, "-f4") == 0)
             f4 = RSA_F4;
+        else if (strcmp(*argv, "-threads") == 0) {
+            if (--argc < 1)
+                goto bad;
+            BN_GENCB_set_threads(&cb, strtonum(*(++argv), 1,
+                                               BN_GENCB_MAX_THREADS, &stnerr));
+            if (stnerr)
+                goto bad;
+        }
 #ifndef OPENSSL_NO_ENGINE
         else if (strcmp(*argv, "-engine") == 0) {
             if (--argc < 1)
@@ -140,6 +150,7 @@ int genrsa_main(int argc, char **argv)
         BIO_printf(bio_err, " -passout arg    output file pass phrase source\n");
         BIO_printf(bio_err, " -f4             use F4 (0x10001) for the E value\n");
         BIO_printf(bio_err, " -3              use 3 for the E value\n");
+        BIO_printf(bio_err, " -threads n      search for primes in n threads\n");
 #ifndef OPENSSL_NO_ENGINE
         BIO_printf(bio_err, " -engine e       use engine e, possibly a hardware device.\n");
 #endif
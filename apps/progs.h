@@ -40,6 +40,7 @@ extern int pkeyparam_main(int argc, char *argv[]);
 extern int pkeyutl_main(int argc, char *argv[]);
 extern int spkac_main(int argc, char *argv[]);
 extern int smime_main(int argc, char *argv[]);
+extern int snapshot_main(int argc, char *argv[]);
 extern int rand_main(int argc, char *argv[]);
 extern int engine_main(int argc, char *argv[]);
 extern int ocsp_main(int argc, char *argv[]);
@@ -116,6 +117,7 @@ FUNCTION functions[] = { { FUNC_TYPE_GENERAL, "verify", verify_main },
                          { FUNC_TYPE_GENERAL, "pkeyutl", pkeyutl_main },
                          { FUNC_TYPE_GENERAL, "spkac", spkac_main },
                          { FUNC_TYPE_GENERAL, "smime", smime_main },
+                         { FUNC_TYPE_GENERAL, "snapshot", snapshot_main },
                          { FUNC_TYPE_GENERAL, "rand", rand_main },
 #ifndef OPENSSL_NO_ENGINE
                          { FUNC_TYPE_GENERAL, "engine", engine_main },
@@ -14,10 +14,35 @@
 #define PORT 4433
 #define PORT_STR "4433"
 #define PROTOCOL "tcp"
+#define MAX_WORKERS 256
 
 int do_server(int port, int type, int *ret,
               int (*cb)(char *hostname, int s, int stype, uint8_t *context),
               uint8_t *context, int naccept);
+
+/* The parameters of s_time's load generator */
+typedef struct {
+    const char *host;
+    /* Page to GET on each connection, or NULL to send echo requests */
+    const char *www_path;
+    int threads;
+    /* Connections kept open by each thread */
+    int conns;
+    /* Connections started per second in all, or zero for no limit */
+    int rate;
+    int seconds;
+    /* Echo requests made on each connection, and their size */
+    int requests;
+    int size;
+    /* Percentage of connections that resume the thread's last session */
+    int resume;
+} LOAD_PARAMS;
+
+#ifdef HEADER_SSL_H
+int do_client_load(SSL_CTX *ctx, const LOAD_PARAMS *params, BIO *out);
+int do_server_workers(int port, int workers, int interval, int www,
+                      int naccept, SSL_CTX *ctx, uint8_t *context, BIO *out);
+#endif
 #ifdef HEADER_X509_H
 int verify_callback(int ok, X509_STORE_CTX *ctx);
 #endif
@@ -0,0 +1,606 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * The load generator behind s_time's -threads and -conns options. Each
+ * thread keeps a number of non-blocking connections going from one epoll
+ * loop: a connection connects, handshakes (resuming the thread's last
+ * session when asked to), runs its requests and closes, after which its slot
+ * starts a new one, paced by the target rate if there is one. Handshake and
+ * first byte latencies go into log-linear histograms which are merged and
+ * reported at the end.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "apps.h"
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "internal/threads.h"
+
+#include "s_apps.h"
+
+#if defined(__linux__) && defined(OPENSSL_THREADS)
+
+#include <sys/epoll.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LOAD_BUFSIZE (16 * 1024)
+#define LOAD_MAX_EVENTS 64
+
+/*
+ * Latencies are kept in microseconds, to about 1.5% precision: values below
+ * 128 have a bucket each, and above that every power of two is split into
+ * 64 buckets.
+ */
+#define HIST_SUB_BITS 6
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_SIZE (2 * HIST_SUB + (64 - HIST_SUB_BITS - 1) * HIST_SUB)
+
+typedef struct {
+    uint64_t counts[HIST_SIZE];
+    uint64_t total, max;
+} LOAD_HIST;
+
+enum { LOAD_IDLE, LOAD_CONNECT, LOAD_HANDSHAKE, LOAD_WRITE, LOAD_READ };
+
+typedef struct {
+    SSL *ssl;
+    int fd;
+    int state;
+    uint32_t events;
+    int resuming;
+    /* When the connection, or the current request, started */
+    uint64_t start;
+    int requests;
+    int first_byte;
+    size_t off, got;
+} LOAD_CONN;
+
+typedef struct {
+    const LOAD_PARAMS *params;
+    SSL_CTX *ctx;
+    const struct addrinfo *addr;
+    const char *request;
+    size_t request_len;
+    CRYPTO_THREAD thread;
+    int started;
+    int epoll_fd;
+    LOAD_CONN *conns;
+    int active;
+    /* The session to resume, and how often to resume it */
+    SSL_SESSION *session;
+    int resume_acc;
+    /* Pacing, in microseconds of the monotonic clock */
+    uint64_t interval, next_start, end;
+    unsigned long connections, full, resumed, missed, errors, requests;
+    uint64_t bytes;
+    LOAD_HIST handshake, first_byte;
+    char buf[LOAD_BUFSIZE];
+} LOAD_THREAD;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int hist_index(uint64_t v)
+{
+    int shift;
+
+    if (v < 2 * HIST_SUB)
+        return (int)v;
+    shift = 63 - __builtin_clzll(v) - HIST_SUB_BITS;
+    return 2 * HIST_SUB + (shift - 1) * HIST_SUB +
+           (int)(v >> shift) - HIST_SUB;
+}
+
+/* hist_value returns the highest value that falls in bucket |i|. */
+static uint64_t hist_value(int i)
+{
+    int shift;
+
+    if (i < 2 * HIST_SUB)
+        return i;
+    shift = (i - 2 * HIST_SUB) / HIST_SUB + 1;
+    return (((uint64_t)((i - 2 * HIST_SUB) % HIST_SUB + HIST_SUB + 1))
+            << shift) - 1;
+}
+
+static void hist_add(LOAD_HIST *h, uint64_t v)
+{
+    h->counts[hist_index(v)]++;
+    h->total++;
+    if (v > h->max)
+        h->max = v;
+}
+
+static void hist_merge(LOAD_HIST *to, const LOAD_HIST *from)
+{
+    int i;
+
+    for (i = 0; i < HIST_SIZE; i++)
+        to->counts[i] += from->counts[i];
+    to->total += from->total;
+    if (from->max > to->max)
+        to->max = from->max;
+}
+
+static uint64_t hist_percentile(const LOAD_HIST *h, double pct)
+{
+    uint64_t want, seen = 0;
+    int i;
+
+    want = (uint64_t)(pct / 100 * h->total + 0.5);
+    if (want == 0)
+        want = 1;
+    for (i = 0; i < HIST_SIZE; i++) {
+        if ((seen += h->counts[i]) >= want)
+            return hist_value(i) < h->max ? hist_value(i) : h->max;
+    }
+    return h->max;
+}
+
+static void hist_print(BIO *out, const char *name, const LOAD_HIST *h)
+{
+    static const double pcts[] = { 50, 90, 99, 99.9 };
+    size_t i;
+
+    if (h->total == 0)
+        return;
+    BIO_printf(out, "%-10s latency (ms):", name);
+    for (i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++)
+        BIO_printf(out, " p%g %.3f", pcts[i],
+                   hist_percentile(h, pcts[i]) / 1000.0);
+    BIO_printf(out, " max %.3f\n", h->max / 1000.0);
+}
+
+static int conn_want(LOAD_THREAD *t, LOAD_CONN *c, uint32_t want, int op)
+{
+    struct epoll_event ev;
+
+    if (want == c->events)
+        return 1;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = want;
+    ev.data.ptr = c;
+    if (epoll_ctl(t->epoll_fd, op, c->fd, &ev) == -1)
+        return 0;
+    c->events = want;
+    return 1;
+}
+
+enum { CLOSE_ERROR, CLOSE_DONE, CLOSE_ABANDON };
+
+/* conn_close ends |c|, counting it according to |how|, and frees its slot. */
+static void conn_close(LOAD_THREAD *t, LOAD_CONN *c, int how)
+{
+    if (c->ssl != NULL) {
+        /* As with NO_SHUTDOWN, keep the session resumable */
+        if (how == CLOSE_DONE)
+            SSL_set_shutdown(c->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        SSL_free(c->ssl);
+        c->ssl = NULL;
+    }
+    if (c->fd != -1)
+        close(c->fd);
+    c->fd = -1;
+    c->state = LOAD_IDLE;
+    c->events = 0;
+    t->active--;
+    if (how == CLOSE_DONE)
+        t->connections++;
+    else if (how == CLOSE_ERROR)
+        t->errors++;
+    ERR_clear_error();
+}
+
+static void conn_start(LOAD_THREAD *t, LOAD_CONN *c)
+{
+    const struct addrinfo *ai = t->addr;
+    int one = 1;
+
+    c->start = now_us();
+    c->requests = 0;
+    c->fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                   ai->ai_protocol);
+    t->active++;
+    if (c->fd == -1) {
+        conn_close(t, c, CLOSE_ERROR);
+        return;
+    }
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c->state = LOAD_CONNECT;
+    if ((connect(c->fd, ai->ai_addr, ai->ai_addrlen) == -1 &&
+         errno != EINPROGRESS) ||
+        !conn_want(t, c, EPOLLOUT, EPOLL_CTL_ADD))
+        conn_close(t, c, CLOSE_ERROR);
+}
+
+static int conn_connected(LOAD_THREAD *t, LOAD_CONN *c)
+{
+    socklen_t len = sizeof(int);
+    int err = 0;
+
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1 || err != 0)
+        return 0;
+    if ((c->ssl = SSL_new(t->ctx)) == NULL || !SSL_set_fd(c->ssl, c->fd))
+        return 0;
+    SSL_set_connect_state(c->ssl);
+
+    c->resuming = 0;
+    if (t->session != NULL &&
+        (t->resume_acc += t->params->resume) >= 100) {
+        t->resume_acc -= 100;
+        c->resuming = SSL_set_session(c->ssl, t->session);
+    }
+    c->state = LOAD_HANDSHAKE;
+    return 1;
+}
+
+/*
+ * read_closed returns whether the SSL_read on |ssl| that returned |n| failed
+ * because the server closed the connection, with a close_notify or at EOF.
+ */
+static int read_closed(SSL *ssl, int n)
+{
+    switch (SSL_get_error(ssl, n)) {
+    case SSL_ERROR_ZERO_RETURN:
+        return 1;
+    case SSL_ERROR_SYSCALL:
+        return n == 0 && ERR_peek_error() == 0;
+    default:
+        return 0;
+    }
+}
+
+static void request_start(LOAD_CONN *c)
+{
+    c->state = LOAD_WRITE;
+    c->start = now_us();
+    c->off = c->got = 0;
+    c->first_byte = 0;
+}
+
+/*
+ * conn_drive makes as much progress on |c| as it can without blocking,
+ * closing it when it is done or has failed.
+ */
+static void conn_drive(LOAD_THREAD *t, LOAD_CONN *c)
+{
+    const LOAD_PARAMS *p = t->params;
+    SSL_SESSION *sess;
+    unsigned int id_len;
+    uint32_t want;
+    int n = 0;
+
+    for (;;) {
+        switch (c->state) {
+        case LOAD_IDLE:
+            return;
+
+        case LOAD_CONNECT:
+            if (!conn_connected(t, c)) {
+                conn_close(t, c, CLOSE_ERROR);
+                return;
+            }
+            continue;
+
+        case LOAD_HANDSHAKE:
+            if ((n = SSL_do_handshake(c->ssl)) != 1)
+                break;
+            hist_add(&t->handshake, now_us() - c->start);
+            if (SSL_session_reused(c->ssl)) {
+                t->resumed++;
+            } else {
+                t->full++;
+                if (c->resuming)
+                    t->missed++;
+                /*
+                 * Keep the session for later connections only if the server
+                 * made it resumable. A session without an ID is updated in
+                 * place when offered, which would race between connections.
+                 */
+                if (p->resume > 0 &&
+                    (sess = SSL_get1_session(c->ssl)) != NULL) {
+                    SSL_SESSION_get_id(sess, &id_len);
+                    if (id_len > 0) {
+                        SSL_SESSION_free(t->session);
+                        t->session = sess;
+                    } else
+                        SSL_SESSION_free(sess);
+                }
+            }
+            if (p->requests == 0) {
+                conn_close(t, c, CLOSE_DONE);
+                return;
+            }
+            request_start(c);
+            continue;
+
+        case LOAD_WRITE:
+            n = SSL_write(c->ssl, t->request + c->off,
+                          t->request_len - c->off);
+            if (n <= 0)
+                break;
+            t->bytes += n;
+            if ((c->off += n) == t->request_len)
+                c->state = LOAD_READ;
+            continue;
+
+        case LOAD_READ:
+            n = SSL_read(c->ssl, t->buf, sizeof(t->buf));
+            if (n <= 0) {
+                /* An HTTP/1.0 reply ends when the server closes */
+                if (p->www_path != NULL && c->first_byte &&
+                    read_closed(c->ssl, n)) {
+                    t->requests++;
+                    conn_close(t, c, CLOSE_DONE);
+                    return;
+                }
+                break;
+            }
+            if (!c->first_byte) {
+                hist_add(&t->first_byte, now_us() - c->start);
+                c->first_byte = 1;
+            }
+            t->bytes += n;
+            if (p->www_path != NULL || (c->got += n) < t->request_len)
+                continue;
+            /* The echo is complete */
+            t->requests++;
+            if (++c->requests == p->requests) {
+                conn_close(t, c, CLOSE_DONE);
+                return;
+            }
+            request_start(c);
+            continue;
+        }
+
+        switch (SSL_get_error(c->ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+            want = EPOLLIN;
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            want = EPOLLOUT;
+            break;
+        default:
+            conn_close(t, c, CLOSE_ERROR);
+            return;
+        }
+        if (!conn_want(t, c, want, EPOLL_CTL_MOD))
+            conn_close(t, c, CLOSE_ERROR);
+        return;
+    }
+}
+
+static void *load_main(void *arg)
+{
+    struct epoll_event events[LOAD_MAX_EVENTS];
+    LOAD_THREAD *t = arg;
+    uint64_t now;
+    int i, n, timeout;
+
+    for (;;) {
+        now = now_us();
+        if (now >= t->end)
+            break;
+
+        /* Fill idle slots, as far as the rate allows */
+        for (i = 0; i < t->params->conns; i++) {
+            if (t->conns[i].state != LOAD_IDLE)
+                continue;
+            if (t->interval != 0) {
+                if (t->next_start > now)
+                    break;
+                /* Don't make up for time lost to a stall with a burst */
+                if (now - t->next_start > 1000000)
+                    t->next_start = now;
+                t->next_start += t->interval;
+            }
+            conn_start(t, &t->conns[i]);
+        }
+
+        if (t->interval != 0 && t->active < t->params->conns &&
+            t->next_start < t->end)
+            timeout = (int)((t->next_start - now + 999) / 1000);
+        else
+            timeout = (int)((t->end - now + 999) / 1000);
+        n = epoll_wait(t->epoll_fd, events, LOAD_MAX_EVENTS, timeout);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (i = 0; i < n; i++)
+            conn_drive(t, events[i].data.ptr);
+    }
+
+    /* Connections still open when time runs out are not counted */
+    for (i = 0; i < t->params->conns; i++) {
+        if (t->conns[i].state != LOAD_IDLE)
+            conn_close(t, &t->conns[i], CLOSE_ABANDON);
+    }
+    SSL_SESSION_free(t->session);
+    t->session = NULL;
+    ERR_remove_thread_state(NULL);
+    return NULL;
+}
+
+static struct addrinfo *load_resolve(const char *host_port)
+{
+    struct addrinfo hints, *ai = NULL;
+    char *host, *port;
+    int i;
+
+    if ((host = strdup(host_port)) == NULL)
+        return NULL;
+    if ((port = strrchr(host, ':')) == NULL) {
+        BIO_printf(bio_err, "no port in %s\n", host_port);
+        goto end;
+    }
+    *port++ = '\0';
+    /* Allow [address]:port for IPv6 */
+    if (host[0] == '[' && port - host > 2 && port[-2] == ']') {
+        port[-2] = '\0';
+        memmove(host, host + 1, strlen(host));
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if ((i = getaddrinfo(host, port, &hints, &ai)) != 0) {
+        BIO_printf(bio_err, "getaddrinfo: %s\n", gai_strerror(i));
+        ai = NULL;
+    }
+
+end:
+    free(host);
+    return ai;
+}
+
+int do_client_load(SSL_CTX *ctx, const LOAD_PARAMS *params, BIO *out)
+{
+    unsigned long connections = 0, full = 0, resumed = 0, missed = 0;
+    unsigned long errors = 0, requests = 0;
+    uint64_t bytes = 0, start, end;
+    LOAD_HIST *handshake = NULL, *first_byte = NULL;
+    struct addrinfo *ai;
+    LOAD_THREAD *t = NULL;
+    char *request = NULL;
+    size_t request_len = 0;
+    double secs;
+    int i, j, ret = 0;
+
+    if ((ai = load_resolve(params->host)) == NULL)
+        return 0;
+
+    if (params->www_path != NULL) {
+        if (asprintf(&request, "GET %s HTTP/1.0\r\n\r\n",
+                     params->www_path) == -1) {
+            request = NULL;
+            goto end;
+        }
+        request_len = strlen(request);
+    } else if (params->requests > 0) {
+        if ((request = malloc(params->size)) == NULL)
+            goto end;
+        memset(request, 'x', params->size);
+        request_len = params->size;
+    }
+
+    if ((t = calloc(params->threads, sizeof(*t))) == NULL ||
+        (handshake = calloc(1, sizeof(*handshake))) == NULL ||
+        (first_byte = calloc(1, sizeof(*first_byte))) == NULL)
+        goto end;
+
+    BIO_printf(out, "Running %d threads of %d connections for %d seconds\n",
+               params->threads, params->conns, params->seconds);
+    (void)BIO_flush(out);
+
+    start = now_us();
+    end = start + (uint64_t)params->seconds * 1000000;
+    for (i = 0; i < params->threads; i++)
+        t[i].epoll_fd = -1;
+    for (i = 0; i < params->threads; i++) {
+        t[i].params = params;
+        t[i].ctx = ctx;
+        t[i].addr = ai;
+        t[i].request = request;
+        t[i].request_len = request_len;
+        t[i].end = end;
+        t[i].next_start = start;
+        if (params->rate > 0)
+            t[i].interval = (uint64_t)params->threads * 1000000 /
+                            params->rate;
+        if ((t[i].epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+            perror("epoll_create1");
+            goto end;
+        }
+        if ((t[i].conns = calloc(params->conns, sizeof(LOAD_CONN))) == NULL)
+            goto end;
+        for (j = 0; j < params->conns; j++)
+            t[i].conns[j].fd = -1;
+    }
+    for (i = 0; i < params->threads; i++) {
+        if (!CRYPTO_thread_spawn(&t[i].thread, load_main, &t[i])) {
+            BIO_printf(bio_err, "unable to start thread %d\n", i);
+            /* The threads that did start stop at the end time */
+            goto end;
+        }
+        t[i].started = 1;
+    }
+    ret = 1;
+
+end:
+    if (t != NULL) {
+        for (i = 0; i < params->threads; i++) {
+            if (t[i].started) {
+                CRYPTO_thread_join(t[i].thread);
+                connections += t[i].connections;
+                full += t[i].full;
+                resumed += t[i].resumed;
+                missed += t[i].missed;
+                errors += t[i].errors;
+                requests += t[i].requests;
+                bytes += t[i].bytes;
+                hist_merge(handshake, &t[i].handshake);
+                hist_merge(first_byte, &t[i].first_byte);
+            }
+            if (t[i].epoll_fd != -1)
+                close(t[i].epoll_fd);
+            free(t[i].conns);
+        }
+    }
+    if (ret) {
+        secs = (now_us() - start) / 1e6;
+        BIO_printf(out, "%lu connections in %.2fs: %lu full handshakes, "
+                        "%lu resumed (%lu resumptions refused), %lu errors\n",
+                   connections, secs, full, resumed, missed, errors);
+        BIO_printf(out, "%.2f connections/s, %.2f handshakes/s, "
+                        "%.2f requests/s, %.0f bytes/s\n",
+                   connections / secs, (full + resumed) / secs,
+                   requests / secs, bytes / secs);
+        hist_print(out, "handshake", handshake);
+        hist_print(out, "first byte", first_byte);
+    }
+    free(handshake);
+    free(first_byte);
+    free(t);
+    free(request);
+    freeaddrinfo(ai);
+    return ret;
+}
+
+#else
+
+int do_client_load(SSL_CTX *ctx, const LOAD_PARAMS *params, BIO *out)
+{
+    BIO_printf(bio_err, "load generation is not supported on this platform\n");
+    return 0;
+}
+
+#endif
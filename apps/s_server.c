@@ -241,6 +241,8 @@ static void sv_usage(void)
     BIO_printf(bio_err, " -WWW          - Respond to a 'GET /<path> HTTP/1.0' with file ./<path>\n");
     BIO_printf(bio_err, " -HTTP         - Respond to a 'GET /<path> HTTP/1.0' with file ./<path>\n");
     BIO_printf(bio_err, "                 with the assumption it contains a complete HTTP response.\n");
+    BIO_printf(bio_err, " -workers n    - Serve from n threads, each with its own epoll loop\n");
+    BIO_printf(bio_err, " -stats_interval n - With -workers, print rates every n seconds\n");
 #ifndef OPENSSL_NO_ENGINE
     BIO_printf(bio_err, " -engine id    - Initialise and use the specified engine\n");
 #endif
@@ -523,6 +525,7 @@ int s_server_main(int argc, char *argv[])
     EVP_PKEY *s_key = NULL, *s_dkey = NULL;
     int no_cache = 0, ext_cache = 0;
     int rev = 0, naccept = -1;
+    int workers = 0, stats_interval = 1;
     EVP_PKEY *s_key2 = NULL;
     X509 *s_cert2 = NULL;
     tlsextctx tlsextcbp = { NULL, NULL, SSL_TLSEXT_ERR_ALERT_WARNING };
@@ -579,6 +582,18 @@ int s_server_main(int argc, char *argv[])
                 BIO_printf(bio_err, "bad accept value %s\n", *argv);
                 goto bad;
             }
+        } else if (strcmp(*argv, "-workers") == 0) {
+            if (--argc < 1)
+                goto bad;
+            workers = strtonum(*(++argv), 1, MAX_WORKERS, &stnerr);
+            if (stnerr)
+                goto bad;
+        } else if (strcmp(*argv, "-stats_interval") == 0) {
+            if (--argc < 1)
+                goto bad;
+            stats_interval = strtonum(*(++argv), 1, INT_MAX, &stnerr);
+            if (stnerr)
+                goto bad;
         } else if (strcmp(*argv, "-verify") == 0) {
             s_server_verify = SSL_VERIFY_PEER | SSL_VERIFY_CLIENT_ONCE;
             if (--argc < 1)
@@ -890,6 +905,18 @@ int s_server_main(int argc, char *argv[])
     }
 #endif
 
+    if (workers) {
+        if (socket_type == SOCK_DGRAM || rev || www > 1) {
+            BIO_printf(bio_err, "-workers only supports TLS with or without "
+                                "-www\n");
+            goto end;
+        }
+        if (ext_cache) {
+            BIO_printf(bio_err, "You can't use -ext_cache with -workers\n");
+            goto end;
+        }
+    }
+
     SSL_load_error_strings();
     OpenSSL_add_ssl_algorithms();
 
@@ -1237,7 +1264,11 @@ int s_server_main(int argc, char *argv[])
 
     BIO_printf(bio_s_out, "ACCEPT\n");
     (void)BIO_flush(bio_s_out);
-    if (rev)
+    if (workers) {
+        if (!do_server_workers(port, workers, stats_interval, www, naccept,
+                               ctx, context, bio_s_out))
+            goto end;
+    } else if (rev)
         do_server(port, socket_type, &accept_socket, rev_body, context,
                   naccept);
     else if (www)
@@ -77,6 +77,9 @@ static long bytes_read = 0;
 static int st_bugs = 0;
 static int perform = 0;
 static int t_nbio = 0;
+static int load = 0;
+static LOAD_PARAMS load_params;
+static int resume_ticket = 0;
 
 static void s_time_init(void)
 {
@@ -95,6 +98,13 @@ static void s_time_init(void)
     st_bugs = 0;
     perform = 0;
     t_nbio = 0;
+    load = 0;
+    memset(&load_params, 0, sizeof(load_params));
+    load_params.threads = 1;
+    load_params.conns = 1;
+    load_params.requests = -1;
+    load_params.size = 64;
+    resume_ticket = 0;
 }
 
 /***********************************************************************
@@ -120,6 +130,14 @@ static void s_time_usage(void)
     printf("-new          - Just time new connections\n");
     printf("-reuse        - Just time connection reuse\n");
     printf("-www page     - Retrieve 'page' from the site\n");
+    printf("\nLoad generation, started by any of these options:\n");
+    printf("-threads n    - Number of threads to run, default 1\n");
+    printf("-conns n      - Concurrent connections per thread, default 1\n");
+    printf("-rate n       - Connections to start per second, default no limit\n");
+    printf("-requests n   - Echo requests per connection, default 0 (1 with -www)\n");
+    printf("-size n       - Bytes per echo request, default 64\n");
+    printf("-resume pct   - Percentage of connections that resume a session\n");
+    printf("-resume_ticket - Resume with session tickets rather than session IDs\n");
     printf(umsg, SECONDS);
 }
 
@@ -196,6 +214,51 @@ static int parseArgs(int argc, char **argv)
                 BIO_printf(bio_err, "-www option too long\n");
                 badop = 1;
             }
+        } else if (strcmp(*argv, "-threads") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.threads = strtonum(*(++argv), 1, MAX_WORKERS, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-conns") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.conns = strtonum(*(++argv), 1, 65536, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-rate") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.rate = strtonum(*(++argv), 0, 1000000, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-requests") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.requests = strtonum(*(++argv), 0, INT_MAX, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-size") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.size = strtonum(*(++argv), 1, MYBUFSIZ, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-resume") == 0) {
+            if (--argc < 1)
+                goto bad;
+            load_params.resume = strtonum(*(++argv), 0, 100, &stnerr);
+            if (stnerr)
+                goto bad;
+            load = 1;
+        } else if (strcmp(*argv, "-resume_ticket") == 0) {
+            resume_ticket = 1;
+            load = 1;
         } else if (strcmp(*argv, "-bugs") == 0)
             st_bugs = 1;
         else if (strcmp(*argv, "-time") == 0) {
@@ -217,6 +280,19 @@ static int parseArgs(int argc, char **argv)
     if (perform == 0)
         perform = 3;
 
+    if (load) {
+        load_params.host = host;
+        load_params.www_path = s_www_path;
+        load_params.seconds = maxTime;
+        if (load_params.requests == -1)
+            load_params.requests = s_www_path != NULL ? 1 : 0;
+        if (s_www_path != NULL && load_params.requests != 1) {
+            BIO_printf(bio_err, "-www makes exactly one request per "
+                                "connection\n");
+            badop = 1;
+        }
+    }
+
     if (badop) {
     bad:
         s_time_usage();
@@ -291,6 +367,20 @@ int s_time_main(int argc, char **argv)
         fprintf(stderr, "No CIPHER specified\n");
     }
 
+    if (load) {
+        BIO *out;
+
+        /* Resuming by session ID needs the server to keep a cache */
+        if (!resume_ticket)
+            SSL_CTX_set_options(tm_ctx, SSL_OP_NO_TICKET);
+        if ((out = BIO_new_fp(stdout, BIO_NOCLOSE)) == NULL)
+            goto end;
+        if (do_client_load(tm_ctx, &load_params, out))
+            ret = 0;
+        BIO_free(out);
+        goto end;
+    }
+
     if (!(perform & 1))
         goto next;
     printf("Collecting connection statistics for %d seconds\n", maxTime);
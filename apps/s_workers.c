@@ -0,0 +1,508 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * The -workers mode of s_server. Each worker thread owns a listening socket
+ * bound with SO_REUSEPORT, so that the kernel spreads new connections across
+ * the workers, and drives all of its connections from one epoll loop using
+ * non-blocking SSL objects made from the shared SSL_CTX. The main thread
+ * only prints the rates at which handshakes complete and data moves.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "apps.h"
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "internal/threads.h"
+
+#include "s_apps.h"
+
+#if defined(__linux__) && defined(SO_REUSEPORT) && defined(OPENSSL_THREADS)
+
+#include <sys/epoll.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define WORKER_BUFSIZE (16 * 1024)
+#define WORKER_MAX_EVENTS 64
+/* How often, in milliseconds, workers and the main thread look for a stop */
+#define WORKER_TICK 100
+
+
+/* The canned reply to a 'GET' in -www mode, after which the server closes */
+static const char www_response[] =
+    "HTTP/1.0 200 ok\r\nContent-type: text/html\r\n\r\n"
+    "<HTML><BODY BGCOLOR=\"#ffffff\">\n"
+    "<pre>\n"
+    "s_server worker\n"
+    "</pre></BODY></HTML>\r\n\r\n";
+
+enum { CONN_HANDSHAKE, CONN_READ, CONN_WRITE };
+
+typedef struct worker_conn_st {
+    struct worker_conn_st *prev, *next;
+    SSL *ssl;
+    int fd;
+    int state;
+    /* The events that the connection is registered with epoll for */
+    uint32_t events;
+    /* What has been read, and what is being written back */
+    size_t inlen;
+    const char *out;
+    size_t outlen, outoff;
+    char buf[WORKER_BUFSIZE];
+} WORKER_CONN;
+
+typedef struct {
+    SSL_CTX *ctx;
+    uint8_t *context;
+    int www;
+    /* The number of connections to accept in all, or -1 for no limit */
+    int naccept;
+    int accepted;
+    int stop;
+    /* Guards the counters where there are no atomic operations */
+    CRYPTO_MUTEX *lock;
+} WORKER_SHARED;
+
+typedef struct {
+    WORKER_SHARED *shared;
+    CRYPTO_THREAD thread;
+    int started;
+    int listen_fd;
+    int epoll_fd;
+    WORKER_CONN *conns;
+    int done;
+    /* Written by the worker and read by the main thread */
+    int live, handshakes, resumed, failed, bytes;
+    /* The value of |bytes| that the main thread last counted */
+    unsigned int bytes_seen;
+} WORKER;
+
+static int counter_add(WORKER_SHARED *shared, int *counter, int n)
+{
+    int ret;
+
+    CRYPTO_atomic_add(counter, n, &ret, shared->lock);
+    return ret;
+}
+
+static int counter_get(WORKER_SHARED *shared, int *counter)
+{
+    return counter_add(shared, counter, 0);
+}
+
+/*
+ * worker_bytes returns the bytes that |w| has moved since it was last
+ * called. The counter wraps, but the main thread calls this every tick.
+ */
+static unsigned long worker_bytes(WORKER *w)
+{
+    unsigned int bytes = counter_get(w->shared, &w->bytes);
+    unsigned int n = bytes - w->bytes_seen;
+
+    w->bytes_seen = bytes;
+    return n;
+}
+
+static int worker_listen(int port)
+{
+    struct sockaddr_in server;
+    int s, one = 1;
+
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons((unsigned short)port);
+    server.sin_addr.s_addr = INADDR_ANY;
+
+    s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+               IPPROTO_TCP);
+    if (s == -1) {
+        perror("socket");
+        return -1;
+    }
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1 ||
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1) {
+        perror("setsockopt");
+        goto err;
+    }
+    if (bind(s, (struct sockaddr *)&server, sizeof(server)) == -1) {
+        perror("bind");
+        goto err;
+    }
+    if (listen(s, SOMAXCONN) == -1) {
+        perror("listen");
+        goto err;
+    }
+    return s;
+
+err:
+    close(s);
+    return -1;
+}
+
+static void conn_free(WORKER *w, WORKER_CONN *c)
+{
+    if (c->prev != NULL)
+        c->prev->next = c->next;
+    else
+        w->conns = c->next;
+    if (c->next != NULL)
+        c->next->prev = c->prev;
+    /* Keep the session resumable, as www_body does */
+    if (c->state != CONN_HANDSHAKE)
+        SSL_set_shutdown(c->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    SSL_free(c->ssl);
+    close(c->fd);
+    free(c);
+    counter_add(w->shared, &w->live, -1);
+}
+
+static int conn_new(WORKER *w, int fd)
+{
+    WORKER_SHARED *shared = w->shared;
+    struct epoll_event ev;
+    WORKER_CONN *c;
+    int one = 1;
+
+    if ((c = calloc(1, sizeof(*c))) == NULL) {
+        close(fd);
+        return 0;
+    }
+    c->fd = fd;
+    c->state = CONN_HANDSHAKE;
+    c->events = EPOLLIN;
+
+    /* The handshake flights are small and should not wait on Nagle */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if ((c->ssl = SSL_new(shared->ctx)) == NULL)
+        goto err;
+    if (shared->context != NULL &&
+        !SSL_set_session_id_context(c->ssl, shared->context,
+                                    strlen((char *)shared->context)))
+        goto err;
+    if (!SSL_set_fd(c->ssl, fd))
+        goto err;
+    SSL_set_accept_state(c->ssl);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = c->events;
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+        goto err;
+
+    c->next = w->conns;
+    if (w->conns != NULL)
+        w->conns->prev = c;
+    w->conns = c;
+    counter_add(shared, &w->live, 1);
+    return 1;
+
+err:
+    ERR_clear_error();
+    SSL_free(c->ssl);
+    close(fd);
+    free(c);
+    return 0;
+}
+
+/*
+ * conn_drive makes as much progress on |c| as it can without blocking. It
+ * returns one if the connection is waiting on its socket, and zero if it is
+ * finished with and should be freed.
+ */
+static int conn_drive(WORKER *w, WORKER_CONN *c)
+{
+    struct epoll_event ev;
+    uint32_t want;
+    int n = 0;
+
+    for (;;) {
+        switch (c->state) {
+        case CONN_HANDSHAKE:
+            if ((n = SSL_do_handshake(c->ssl)) == 1) {
+                counter_add(w->shared, &w->handshakes, 1);
+                if (SSL_session_reused(c->ssl))
+                    counter_add(w->shared, &w->resumed, 1);
+                c->state = CONN_READ;
+                continue;
+            }
+            break;
+
+        case CONN_READ:
+            n = SSL_read(c->ssl, c->buf + c->inlen, sizeof(c->buf) - c->inlen);
+            if (n <= 0)
+                break;
+            counter_add(w->shared, &w->bytes, n);
+            if (!w->shared->www) {
+                /* Echo whatever arrives */
+                c->out = c->buf;
+                c->outlen = n;
+            } else {
+                /* Answer once the request line is complete */
+                c->inlen += n;
+                if (memchr(c->buf + c->inlen - n, '\n', n) == NULL) {
+                    if (c->inlen == sizeof(c->buf))
+                        return 0;
+                    continue;
+                }
+                if (c->inlen < 4 || strncmp(c->buf, "GET ", 4) != 0)
+                    return 0;
+                c->out = www_response;
+                c->outlen = sizeof(www_response) - 1;
+            }
+            c->outoff = 0;
+            c->state = CONN_WRITE;
+            continue;
+
+        case CONN_WRITE:
+            n = SSL_write(c->ssl, c->out + c->outoff, c->outlen - c->outoff);
+            if (n <= 0)
+                break;
+            counter_add(w->shared, &w->bytes, n);
+            c->outoff += n;
+            if (c->outoff < c->outlen)
+                continue;
+            /* As in -www mode, the connection closes after the reply */
+            if (w->shared->www)
+                return 0;
+            c->inlen = 0;
+            c->state = CONN_READ;
+            continue;
+        }
+
+        switch (SSL_get_error(c->ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+            want = EPOLLIN;
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            want = EPOLLOUT;
+            break;
+        default:
+            if (c->state == CONN_HANDSHAKE)
+                counter_add(w->shared, &w->failed, 1);
+            ERR_clear_error();
+            return 0;
+        }
+        if (want != c->events) {
+            memset(&ev, 0, sizeof(ev));
+            ev.events = want;
+            ev.data.ptr = c;
+            if (epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev) == -1)
+                return 0;
+            c->events = want;
+        }
+        return 1;
+    }
+}
+
+static void worker_stop_listening(WORKER *w)
+{
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, w->listen_fd, NULL);
+    close(w->listen_fd);
+    w->listen_fd = -1;
+}
+
+static void worker_accept(WORKER *w)
+{
+    WORKER_SHARED *shared = w->shared;
+    int fd, n;
+
+    while (w->listen_fd != -1) {
+        fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (shared->naccept != -1) {
+            n = counter_add(shared, &shared->accepted, 1);
+            if (n >= shared->naccept)
+                counter_add(shared, &shared->stop, 1);
+            if (n > shared->naccept) {
+                close(fd);
+                worker_stop_listening(w);
+                return;
+            }
+        }
+        conn_new(w, fd);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    struct epoll_event events[WORKER_MAX_EVENTS];
+    WORKER *w = arg;
+    WORKER_CONN *c;
+    int i, n;
+
+    while (w->listen_fd != -1 || w->conns != NULL) {
+        if (w->listen_fd != -1 && counter_get(w->shared, &w->shared->stop))
+            worker_stop_listening(w);
+
+        n = epoll_wait(w->epoll_fd, events, WORKER_MAX_EVENTS, WORKER_TICK);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            if ((c = events[i].data.ptr) == NULL)
+                worker_accept(w);
+            else if (!conn_drive(w, c))
+                conn_free(w, c);
+        }
+    }
+
+    while (w->conns != NULL)
+        conn_free(w, w->conns);
+    if (w->listen_fd != -1)
+        worker_stop_listening(w);
+    ERR_remove_thread_state(NULL);
+    counter_add(w->shared, &w->done, 1);
+    return NULL;
+}
+
+static double elapsed(const struct timespec *from, const struct timespec *to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+int do_server_workers(int port, int workers, int interval, int www,
+                      int naccept, SSL_CTX *ctx, uint8_t *context, BIO *out)
+{
+    static const struct timespec tick = { 0, WORKER_TICK * 1000000L };
+    unsigned long handshakes, resumed, failed, bytes = 0, live;
+    unsigned long last_handshakes = 0, last_resumed = 0, last_bytes = 0;
+    struct timespec last, now;
+    struct epoll_event ev;
+    WORKER_SHARED shared;
+    WORKER *w;
+    double secs;
+    int i, running, ret = 0;
+
+    memset(&shared, 0, sizeof(shared));
+    shared.ctx = ctx;
+    shared.context = context;
+    shared.www = www;
+    shared.naccept = naccept;
+
+    if ((shared.lock = CRYPTO_thread_new()) == NULL)
+        return 0;
+    if ((w = calloc(workers, sizeof(*w))) == NULL) {
+        CRYPTO_thread_cleanup(shared.lock);
+        return 0;
+    }
+    for (i = 0; i < workers; i++) {
+        w[i].shared = &shared;
+        w[i].listen_fd = w[i].epoll_fd = -1;
+    }
+    for (i = 0; i < workers; i++) {
+        if ((w[i].listen_fd = worker_listen(port)) == -1)
+            goto end;
+        if ((w[i].epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+            perror("epoll_create1");
+            goto end;
+        }
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        if (epoll_ctl(w[i].epoll_fd, EPOLL_CTL_ADD, w[i].listen_fd,
+                      &ev) == -1) {
+            perror("epoll_ctl");
+            goto end;
+        }
+    }
+
+    for (i = 0; i < workers; i++) {
+        if (!CRYPTO_thread_spawn(&w[i].thread, worker_main, &w[i])) {
+            BIO_printf(bio_err, "unable to start worker %d\n", i);
+            goto end;
+        }
+        w[i].started = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &last);
+    for (running = workers; running > 0;) {
+        nanosleep(&tick, NULL);
+
+        running = 0;
+        handshakes = resumed = live = 0;
+        for (i = 0; i < workers; i++) {
+            if (!counter_get(&shared, &w[i].done))
+                running++;
+            live += counter_get(&shared, &w[i].live);
+            handshakes += counter_get(&shared, &w[i].handshakes);
+            resumed += counter_get(&shared, &w[i].resumed);
+            bytes += worker_bytes(&w[i]);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((secs = elapsed(&last, &now)) < interval)
+            continue;
+        BIO_printf(out, "%4lu connections %10.1f handshakes/s "
+                        "%10.1f resumptions/s %14.1f bytes/s\n",
+                   live, (handshakes - last_handshakes) / secs,
+                   (resumed - last_resumed) / secs,
+                   (bytes - last_bytes) / secs);
+        (void)BIO_flush(out);
+        last = now;
+        last_handshakes = handshakes;
+        last_resumed = resumed;
+        last_bytes = bytes;
+    }
+    ret = 1;
+
+end:
+    counter_add(&shared, &shared.stop, 1);
+    handshakes = resumed = failed = 0;
+    for (i = 0; i < workers; i++) {
+        if (w[i].started) {
+            CRYPTO_thread_join(w[i].thread);
+            handshakes += w[i].handshakes;
+            resumed += w[i].resumed;
+            failed += w[i].failed;
+            bytes += worker_bytes(&w[i]);
+        } else if (w[i].listen_fd != -1)
+            close(w[i].listen_fd);
+        if (w[i].epoll_fd != -1)
+            close(w[i].epoll_fd);
+    }
+    if (ret)
+        BIO_printf(out, "%lu handshakes (%lu resumed), %lu failed, "
+                        "%lu bytes\n", handshakes, resumed, failed, bytes);
+    free(w);
+    CRYPTO_thread_cleanup(shared.lock);
+    return ret;
+}
+
+#else
+
+int do_server_workers(int port, int workers, int interval, int www,
+                      int naccept, SSL_CTX *ctx, uint8_t *context, BIO *out)
+{
+    BIO_printf(bio_err, "-workers is not supported on this platform\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "apps.h"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* add_certs appends the certificates in the PEM file |infile| to |certs|. */
+static int add_certs(STACK_OF(X509) *certs, const char *infile)
+{
+    STACK_OF(X509_INFO) *inf;
+    X509_INFO *itmp;
+    BIO *in;
+    int i, n = 0;
+
+    if (infile != NULL)
+        in = BIO_new_file(infile, "r");
+    else
+        in = BIO_new_fp(stdin, BIO_NOCLOSE);
+    if (in == NULL) {
+        BIO_printf(bio_err, "Can't open input file %s\n", infile);
+        return 0;
+    }
+    inf = PEM_X509_INFO_read_bio(in, NULL, NULL, NULL);
+    BIO_free(in);
+    if (inf == NULL) {
+        BIO_printf(bio_err, "Error reading certs file %s\n",
+                   infile != NULL ? infile : "<stdin>");
+        return 0;
+    }
+    for (i = 0; i < sk_X509_INFO_num(inf); i++) {
+        itmp = sk_X509_INFO_value(inf, i);
+        if (itmp->x509 == NULL)
+            continue;
+        if (!sk_X509_push(certs, itmp->x509)) {
+            n = -1;
+            break;
+        }
+        itmp->x509 = NULL;
+        n++;
+    }
+    sk_X509_INFO_pop_free(inf, X509_INFO_free);
+    if (n == 0)
+        BIO_printf(bio_err, "No certificates in %s\n",
+                   infile != NULL ? infile : "<stdin>");
+    return n > 0;
+}
+
+/*
+ * open_temp opens a new file next to |outfile| for writing, and returns its
+ * name in |tmpfile|, so that the snapshot can be renamed over |outfile| once
+ * complete: processes that have loaded the old one keep a consistent copy,
+ * and none ever loads half a snapshot.
+ */
+static BIO *open_temp(const char *outfile, char **tmpfile)
+{
+    mode_t mask;
+    BIO *out;
+    int fd;
+
+    if (asprintf(tmpfile, "%s.XXXXXX", outfile) == -1) {
+        *tmpfile = NULL;
+        return NULL;
+    }
+    if ((fd = mkstemp(*tmpfile)) == -1) {
+        free(*tmpfile);
+        *tmpfile = NULL;
+        return NULL;
+    }
+    /* mkstemp creates the file private; a trust store is read by others. */
+    mask = umask(0);
+    umask(mask);
+    if (fchmod(fd, 0666 & ~mask) == -1 ||
+        (out = BIO_new_fd(fd, BIO_CLOSE)) == NULL) {
+        close(fd);
+        unlink(*tmpfile);
+        free(*tmpfile);
+        *tmpfile = NULL;
+        return NULL;
+    }
+    return out;
+}
+
+int snapshot_main(int argc, char **argv)
+{
+    STACK_OF(X509) *certs = NULL;
+    char **args, *outfile = NULL, *tmpfile = NULL;
+    BIO *out = NULL;
+    int nin = 0, ret = 1;
+    int badarg = 0;
+
+    if (bio_err == NULL)
+        bio_err = BIO_new_fp(stderr, BIO_NOCLOSE);
+    if ((certs = sk_X509_new_null()) == NULL)
+        goto end;
+
+    args = argv + 1;
+    while (!badarg && *args && *args[0] == '-') {
+        if (!strcmp(*args, "-in")) {
+            if (args[1]) {
+                args++;
+                if (!add_certs(certs, *args))
+                    goto end;
+                nin++;
+            } else
+                badarg = 1;
+        } else if (!strcmp(*args, "-out")) {
+            if (args[1]) {
+                args++;
+                outfile = *args;
+            } else
+                badarg = 1;
+        } else
+            badarg = 1;
+        args++;
+    }
+
+    if (badarg) {
+        BIO_printf(bio_err, "Trust store snapshot utility\n");
+        BIO_printf(bio_err, "Usage snapshot [options]\n");
+        BIO_printf(bio_err, "where options are\n");
+        BIO_printf(bio_err, "-in file  PEM certificates to include (may be repeated)\n");
+        BIO_printf(bio_err, "-out file output file\n");
+        goto end;
+    }
+
+    if (nin == 0 && !add_certs(certs, NULL))
+        goto end;
+
+    if (outfile) {
+        if (!(out = open_temp(outfile, &tmpfile))) {
+            BIO_printf(bio_err, "Can't open output file %s\n", outfile);
+            perror("reason");
+            goto end;
+        }
+    } else {
+        out = BIO_new_fp(stdout, BIO_NOCLOSE);
+    }
+
+    if (!X509_snapshot_write_bio(out, certs)) {
+        BIO_printf(bio_err, "Error writing snapshot\n");
+        goto end;
+    }
+    if (tmpfile != NULL) {
+        BIO_free_all(out);
+        out = NULL;
+        if (rename(tmpfile, outfile) == -1) {
+            BIO_printf(bio_err, "unable to rename %s to %s\n", tmpfile,
+                       outfile);
+            perror("reason");
+            goto end;
+        }
+        free(tmpfile);
+        tmpfile = NULL;
+    }
+    ret = 0;
+
+end:
+    if (ret != 0)
+        ERR_print_errors(bio_err);
+    BIO_free_all(out);
+    if (tmpfile != NULL) {
+        unlink(tmpfile);
+        free(tmpfile);
+    }
+    sk_X509_pop_free(certs, X509_free);
+
+    return (ret);
+}
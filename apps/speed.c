@@ -26,6 +26,7 @@
 #define DSA_SECONDS 10
 #define ECDSA_SECONDS 10
 #define ECDH_SECONDS 10
+#define DH_SECONDS 10
 
 #include "apps.h"
 #include <limits.h>
@@ -44,6 +45,7 @@
 #include <signal.h>
 
 #include <openssl/bn.h>
+#include <openssl/dh.h>
 #ifndef OPENSSL_NO_DES
 #include <openssl/des.h>
 #endif
@@ -88,6 +90,7 @@
 
 #undef BUFSIZE
 #define BUFSIZE ((long)1024 * 8 + 64)
+#define MB_LANES 8
 static volatile int run = 0;
 
 static int mr = 0;
@@ -102,21 +105,23 @@ static void print_result(int alg, int run_no, int count, double time_used);
 static int do_multi(int multi);
 #endif
 
-#define ALGOR_NUM 27
+#define ALGOR_NUM 29
 #define SIZE_NUM 5
-#define RSA_NUM 4
+#define RSA_NUM 5
 #define DSA_NUM 3
 
 #define EC_NUM 16
 #define MAX_ECDH_SIZE 256
 
+#define DH_NUM 3
+
 static const char *names[ALGOR_NUM] = {
     "md5", "hmac(md5)", "sha1", "rmd160", "rc4", "des cbc", "des ede3",
     "idea cbc", "rc2 cbc", "rc5-32/12 cbc", "blowfish cbc", "cast cbc",
     "aes-128 cbc", "aes-192 cbc", "aes-256 cbc", "camellia-128 cbc",
     "camellia-192 cbc", "camellia-256 cbc", "evp", "sha256", "sha512",
     "whirlpool", "aes-128 ige", "aes-192 ige", "aes-256 ige", "ghash",
-    "chacha20 poly1305",
+    "chacha20 poly1305", "sha1-mb", "sha256-mb",
 };
 static double results[ALGOR_NUM][SIZE_NUM];
 static int lengths[SIZE_NUM] = { 16, 64, 256, 1024, 8 * 1024 };
@@ -126,6 +131,7 @@ static double dsa_results[DSA_NUM][2];
 #endif
 static double ecdsa_results[EC_NUM][2];
 static double ecdh_results[EC_NUM][1];
+static double dh_results[DH_NUM][2];
 
 #ifdef SIGALRM
 #if defined(__STDC__) || defined(sgi) || defined(_AIX)
@@ -180,6 +186,7 @@ int speed_main(int argc, char **argv)
     uint8_t sha[SHA_DIGEST_LENGTH];
     uint8_t sha256[SHA256_DIGEST_LENGTH];
     uint8_t sha512[SHA512_DIGEST_LENGTH];
+    uint8_t mb_md[MB_LANES * SHA256_DIGEST_LENGTH];
     uint8_t whirlpool[WHIRLPOOL_DIGEST_LENGTH];
 #ifndef OPENSSL_NO_RIPEMD
     uint8_t rmd160[RIPEMD160_DIGEST_LENGTH];
@@ -261,6 +268,8 @@ int speed_main(int argc, char **argv)
 #define D_IGE_256_AES  24
 #define D_GHASH        25
 #define D_CHACHA20_POLY1305 26
+#define D_SHA1_MB      27
+#define D_SHA256_MB    28
     double d = 0.0;
     long c[ALGOR_NUM][SIZE_NUM];
 #define R_DSA_512 0
@@ -269,7 +278,8 @@ int speed_main(int argc, char **argv)
 #define R_RSA_512 0
 #define R_RSA_1024 1
 #define R_RSA_2048 2
-#define R_RSA_4096 3
+#define R_RSA_3072 3
+#define R_RSA_4096 4
 
 #define R_EC_P160 0
 #define R_EC_P192 1
@@ -288,14 +298,20 @@ int speed_main(int argc, char **argv)
 #define R_EC_B409 14
 #define R_EC_B571 15
 
+#define R_DH_2048 0
+#define R_DH_3072 1
+#define R_DH_4096 2
+
     RSA *rsa_key[RSA_NUM];
     long rsa_c[RSA_NUM][2];
-    static unsigned int rsa_bits[RSA_NUM] = { 512, 1024, 2048, 4096 };
+    static unsigned int rsa_bits[RSA_NUM] = { 512, 1024, 2048, 3072, 4096 };
     static uint8_t *rsa_data[RSA_NUM] = { test512, test1024, test2048,
-                                          test4096 };
+                                          test3072, test4096 };
     static int rsa_data_length[RSA_NUM] = { sizeof(test512), sizeof(test1024),
-                                            sizeof(test2048),
+                                            sizeof(test2048), sizeof(test3072),
                                             sizeof(test4096) };
+    /* The number of primes in the RSA keys, which are generated if not 2 */
+    int rsa_primes = 2;
 #ifndef OPENSSL_NO_DSA
     DSA *dsa_key[DSA_NUM];
     long dsa_c[DSA_NUM][2];
@@ -338,10 +354,21 @@ int speed_main(int argc, char **argv)
     int secret_idx = 0;
     long ecdh_c[EC_NUM][2];
 
+    /* DHE as a server does it, with a new key in a copy of the parameters
+     * for every handshake */
+    DH *dh_params[DH_NUM], *dh_a = NULL, *dh_b = NULL;
+    long dh_c[DH_NUM][2];
+    static unsigned int dh_bits[DH_NUM] = { 2048, 3072, 4096 };
+    static BIGNUM *(*dh_primes[DH_NUM])(BIGNUM *) = {
+        get_rfc3526_prime_2048, get_rfc3526_prime_3072, get_rfc3526_prime_4096
+    };
+    uint8_t *dh_secret = NULL;
+
     int rsa_doit[RSA_NUM];
     int dsa_doit[DSA_NUM];
     int ecdsa_doit[EC_NUM];
     int ecdh_doit[EC_NUM];
+    int dh_doit[DH_NUM];
     int doit[ALGOR_NUM];
     int pr_header = 0;
     const EVP_CIPHER *evp_cipher = NULL;
@@ -367,6 +394,8 @@ int speed_main(int argc, char **argv)
         ecdh_a[i] = NULL;
         ecdh_b[i] = NULL;
     }
+    for (i = 0; i < DH_NUM; i++)
+        dh_params[i] = NULL;
 
     if (bio_err == NULL)
         if ((bio_err = BIO_new(BIO_s_file())) != NULL)
@@ -402,6 +431,8 @@ int speed_main(int argc, char **argv)
         ecdsa_doit[i] = 0;
     for (i = 0; i < EC_NUM; i++)
         ecdh_doit[i] = 0;
+    for (i = 0; i < DH_NUM; i++)
+        dh_doit[i] = 0;
 
     j = 0;
     argc--;
@@ -467,7 +498,22 @@ int speed_main(int argc, char **argv)
                    an algorithm. */
         }
 #endif
-        else if (argc > 0 && !strcmp(*argv, "-mr")) {
+        else if ((argc > 0) && (strcmp(*argv, "-primes") == 0)) {
+            argc--;
+            argv++;
+            if (argc == 0) {
+                BIO_printf(bio_err, "no prime count given\n");
+                goto end;
+            }
+            rsa_primes = strtonum(argv[0], 2, RSA_MAX_PRIME_NUM, &stnerr);
+            if (stnerr) {
+                BIO_printf(bio_err, "bad prime count %s, errmsg=%s\n",
+                           argv[0], stnerr);
+                goto end;
+            }
+            j--; /* Otherwise, -primes gets confused with
+                   an algorithm. */
+        } else if (argc > 0 && !strcmp(*argv, "-mr")) {
             mr = 1;
             j--; /* Otherwise, -mr gets confused with
                    an algorithm. */
@@ -488,6 +534,10 @@ int speed_main(int argc, char **argv)
             doit[D_SHA256] = 1;
         else if (strcmp(*argv, "sha512") == 0)
             doit[D_SHA512] = 1;
+        else if (strcmp(*argv, "sha1-mb") == 0)
+            doit[D_SHA1_MB] = 1;
+        else if (strcmp(*argv, "sha256-mb") == 0)
+            doit[D_SHA256_MB] = 1;
         else if (strcmp(*argv, "whirlpool") == 0)
             doit[D_WHIRLPOOL] = 1;
         else
@@ -543,6 +593,8 @@ int speed_main(int argc, char **argv)
             rsa_doit[R_RSA_1024] = 2;
         else if (strcmp(*argv, "rsa2048") == 0)
             rsa_doit[R_RSA_2048] = 2;
+        else if (strcmp(*argv, "rsa3072") == 0)
+            rsa_doit[R_RSA_3072] = 2;
         else if (strcmp(*argv, "rsa4096") == 0)
             rsa_doit[R_RSA_4096] = 2;
         else
@@ -611,6 +663,7 @@ int speed_main(int argc, char **argv)
             rsa_doit[R_RSA_512] = 1;
             rsa_doit[R_RSA_1024] = 1;
             rsa_doit[R_RSA_2048] = 1;
+            rsa_doit[R_RSA_3072] = 1;
             rsa_doit[R_RSA_4096] = 1;
         } else
 #ifndef OPENSSL_NO_DSA
@@ -687,7 +740,16 @@ int speed_main(int argc, char **argv)
             ecdh_doit[R_EC_B409] = 2;
         else if (strcmp(*argv, "ecdhb571") == 0)
             ecdh_doit[R_EC_B571] = 2;
-        else if (strcmp(*argv, "ecdh") == 0) {
+        else if (strcmp(*argv, "dhe2048") == 0)
+            dh_doit[R_DH_2048] = 2;
+        else if (strcmp(*argv, "dhe3072") == 0)
+            dh_doit[R_DH_3072] = 2;
+        else if (strcmp(*argv, "dhe4096") == 0)
+            dh_doit[R_DH_4096] = 2;
+        else if (strcmp(*argv, "dhe") == 0) {
+            for (i = 0; i < DH_NUM; i++)
+                dh_doit[i] = 1;
+        } else if (strcmp(*argv, "ecdh") == 0) {
             for (i = 0; i < EC_NUM; i++)
                 ecdh_doit[i] = 1;
         } else {
@@ -699,6 +761,8 @@ int speed_main(int argc, char **argv)
             BIO_printf(bio_err, "sha1     ");
             BIO_printf(bio_err, "sha256   ");
             BIO_printf(bio_err, "sha512   ");
+            BIO_printf(bio_err, "sha1-mb  ");
+            BIO_printf(bio_err, "sha256-mb ");
             BIO_printf(bio_err, "whirlpool");
 #ifndef OPENSSL_NO_RIPEMD160
             BIO_printf(bio_err, "rmd160");
@@ -730,7 +794,7 @@ int speed_main(int argc, char **argv)
             BIO_printf(bio_err, "rc4");
             BIO_printf(bio_err, "\n");
 
-            BIO_printf(bio_err, "rsa512   rsa1024  rsa2048  rsa4096\n");
+            BIO_printf(bio_err, "rsa512   rsa1024  rsa2048  rsa3072  rsa4096\n");
 
 #ifndef OPENSSL_NO_DSA
             BIO_printf(bio_err, "dsa512   dsa1024  dsa2048\n");
@@ -744,6 +808,7 @@ int speed_main(int argc, char **argv)
             BIO_printf(bio_err, "ecdhk163  ecdhk233  ecdhk283  ecdhk409  ecdhk571\n");
             BIO_printf(bio_err, "ecdhb163  ecdhb233  ecdhb283  ecdhb409  ecdhb571\n");
             BIO_printf(bio_err, "ecdh\n");
+            BIO_printf(bio_err, "dhe2048   dhe3072   dhe4096   dhe\n");
 
 #ifndef OPENSSL_NO_IDEA
             BIO_printf(bio_err, "idea     ");
@@ -775,6 +840,7 @@ int speed_main(int argc, char **argv)
             BIO_printf(bio_err, "-decrypt        time decryption instead of "
                                 "encryption (only EVP).\n");
             BIO_printf(bio_err, "-mr             produce machine readable output.\n");
+            BIO_printf(bio_err, "-primes n       use RSA keys with n primes.\n");
 #if defined(HAVE_FORK)
             BIO_printf(bio_err, "-multi n        run n benchmarks in parallel.\n");
 #endif
@@ -803,6 +869,8 @@ int speed_main(int argc, char **argv)
             ecdsa_doit[i] = 1;
         for (i = 0; i < EC_NUM; i++)
             ecdh_doit[i] = 1;
+        for (i = 0; i < DH_NUM; i++)
+            dh_doit[i] = 1;
     }
     for (i = 0; i < ALGOR_NUM; i++)
         if (doit[i])
@@ -824,6 +892,40 @@ int speed_main(int argc, char **argv)
         }
     }
 
+    /* There are no test keys with more primes, so new ones are made */
+    if (rsa_primes > 2) {
+        BIGNUM *e = BN_new();
+
+        if (e == NULL || !BN_set_word(e, RSA_F4)) {
+            BN_free(e);
+            goto end;
+        }
+        for (i = 0; i < RSA_NUM; i++) {
+            RSA *key;
+
+            if (!rsa_doit[i])
+                continue;
+            if (!mr)
+                BIO_printf(bio_err, "Generating %u bit RSA key with %d "
+                                    "primes\n", rsa_bits[i], rsa_primes);
+            key = RSA_new();
+            if (key == NULL ||
+                !RSA_generate_multi_prime_key(key, rsa_bits[i], rsa_primes, e,
+                                              NULL)) {
+                BIO_printf(bio_err, "cannot generate %u bit RSA key with %d "
+                                    "primes, skipping it\n", rsa_bits[i],
+                           rsa_primes);
+                ERR_clear_error();
+                RSA_free(key);
+                rsa_doit[i] = 0;
+                continue;
+            }
+            RSA_free(rsa_key[i]);
+            rsa_key[i] = key;
+        }
+        BN_free(e);
+    }
+
 #ifndef OPENSSL_NO_DSA
     dsa_key[0] = get_dsa512();
     dsa_key[1] = get_dsa1024();
@@ -892,6 +994,8 @@ int speed_main(int argc, char **argv)
     c[D_CBC_256_CML][0] = count;
     c[D_SHA256][0] = count;
     c[D_SHA512][0] = count;
+    c[D_SHA1_MB][0] = count;
+    c[D_SHA256_MB][0] = count;
     c[D_WHIRLPOOL][0] = count;
     c[D_IGE_128_AES][0] = count;
     c[D_IGE_192_AES][0] = count;
@@ -906,6 +1010,8 @@ int speed_main(int argc, char **argv)
         c[D_RMD160][i] = c[D_RMD160][0] * 4 * lengths[0] / lengths[i];
         c[D_SHA256][i] = c[D_SHA256][0] * 4 * lengths[0] / lengths[i];
         c[D_SHA512][i] = c[D_SHA512][0] * 4 * lengths[0] / lengths[i];
+        c[D_SHA1_MB][i] = c[D_SHA1_MB][0] * 4 * lengths[0] / lengths[i];
+        c[D_SHA256_MB][i] = c[D_SHA256_MB][0] * 4 * lengths[0] / lengths[i];
         c[D_WHIRLPOOL][i] = c[D_WHIRLPOOL][0] * 4 * lengths[0] / lengths[i];
     }
     for (i = 1; i < SIZE_NUM; i++) {
@@ -1049,6 +1155,21 @@ int speed_main(int argc, char **argv)
         }
     }
 
+    dh_c[R_DH_2048][0] = count / 1000;
+    dh_c[R_DH_2048][1] = count / 4000;
+    for (i = 1; i < DH_NUM; i++) {
+        dh_c[i][0] = dh_c[i - 1][0] / 2;
+        dh_c[i][1] = dh_c[i - 1][1] / 4;
+        if ((dh_doit[i] <= 1) && (dh_c[i][0] == 0))
+            dh_doit[i] = 0;
+        else {
+            if (dh_c[i][0] == 0) {
+                dh_c[i][0] = 1;
+                dh_c[i][1] = 1;
+            }
+        }
+    }
+
 #define COND(d) (count < (d))
 #define COUNT(d) (d)
 #else
@@ -1126,6 +1247,38 @@ int speed_main(int argc, char **argv)
         }
     }
 
+    /*
+     * The multi-buffer digests hash MB_LANES messages per call; the count
+     * is in messages so that the results compare with the serial ones.
+     */
+    if (doit[D_SHA1_MB] || doit[D_SHA256_MB]) {
+        const uint8_t *mb_data[MB_LANES];
+        size_t mb_lens[MB_LANES];
+
+        for (k = 0; k < MB_LANES; k++)
+            mb_data[k] = buf;
+        for (j = 0; doit[D_SHA1_MB] && j < SIZE_NUM; j++) {
+            for (k = 0; k < MB_LANES; k++)
+                mb_lens[k] = lengths[j];
+            print_message(names[D_SHA1_MB], c[D_SHA1_MB][j], lengths[j]);
+            Time_F(START);
+            for (count = 0, run = 1; COND(c[D_SHA1_MB][j]); count += MB_LANES)
+                SHA1_multi(MB_LANES, mb_data, mb_lens, mb_md);
+            d = Time_F(STOP);
+            print_result(D_SHA1_MB, j, count, d);
+        }
+        for (j = 0; doit[D_SHA256_MB] && j < SIZE_NUM; j++) {
+            for (k = 0; k < MB_LANES; k++)
+                mb_lens[k] = lengths[j];
+            print_message(names[D_SHA256_MB], c[D_SHA256_MB][j], lengths[j]);
+            Time_F(START);
+            for (count = 0, run = 1; COND(c[D_SHA256_MB][j]); count += MB_LANES)
+                SHA256_multi(MB_LANES, mb_data, mb_lens, mb_md);
+            d = Time_F(STOP);
+            print_result(D_SHA256_MB, j, count, d);
+        }
+    }
+
     if (doit[D_WHIRLPOOL]) {
         for (j = 0; j < SIZE_NUM; j++) {
             print_message(names[D_WHIRLPOOL], c[D_WHIRLPOOL][j], lengths[j]);
@@ -1768,6 +1921,78 @@ int speed_main(int argc, char **argv)
                 ecdh_doit[j] = 0;
         }
     }
+
+    for (j = 0; j < DH_NUM; j++) {
+        int secret_size;
+
+        if (!dh_doit[j])
+            continue;
+        rsa_count = 1;
+        if ((dh_params[j] = DH_new()) == NULL ||
+            (dh_params[j]->p = dh_primes[j](NULL)) == NULL ||
+            (dh_params[j]->g = BN_new()) == NULL ||
+            !BN_set_word(dh_params[j]->g, DH_GENERATOR_2) ||
+            (dh_a = DHparams_dup(dh_params[j])) == NULL ||
+            (dh_b = DHparams_dup(dh_params[j])) == NULL ||
+            !DH_generate_key(dh_a) || !DH_generate_key(dh_b)) {
+            BIO_printf(bio_err, "DH key generation failure.\n");
+            ERR_print_errors(bio_err);
+        } else {
+            free(dh_secret);
+            dh_secret = malloc(2 * DH_size(dh_a));
+            if (dh_secret == NULL ||
+                (secret_size = DH_compute_key(dh_secret, dh_b->pub_key,
+                                              dh_a)) <= 0 ||
+                DH_compute_key(dh_secret + secret_size, dh_a->pub_key,
+                               dh_b) != secret_size ||
+                memcmp(dh_secret, dh_secret + secret_size, secret_size) != 0) {
+                BIO_printf(bio_err, "DH computations don't match.\n");
+                ERR_print_errors(bio_err);
+            } else {
+                pkey_print_message("keygen", "dhe", dh_c[j][0], dh_bits[j],
+                                   DH_SECONDS);
+                Time_F(START);
+                for (count = 0, run = 1; COND(dh_c[j][0]); count++) {
+                    DH *dh = DHparams_dup(dh_params[j]);
+
+                    if (dh == NULL || !DH_generate_key(dh)) {
+                        BIO_printf(bio_err, "DH key generation failure\n");
+                        ERR_print_errors(bio_err);
+                        DH_free(dh);
+                        count = 1;
+                        break;
+                    }
+                    DH_free(dh);
+                }
+                d = Time_F(STOP);
+                BIO_printf(bio_err, mr ? "+R8:%ld:%d:%.2f\n" :
+                                         "%ld %d bit DHE keygens in %.2fs\n",
+                           count, dh_bits[j], d);
+                dh_results[j][0] = d / (double)count;
+                rsa_count = count;
+
+                pkey_print_message("derive", "dhe", dh_c[j][1], dh_bits[j],
+                                   DH_SECONDS);
+                Time_F(START);
+                for (count = 0, run = 1; COND(dh_c[j][1]); count++)
+                    DH_compute_key(dh_secret, dh_b->pub_key, dh_a);
+                d = Time_F(STOP);
+                BIO_printf(bio_err, mr ? "+R9:%ld:%d:%.2f\n" :
+                                         "%ld %d bit DHE derives in %.2fs\n",
+                           count, dh_bits[j], d);
+                dh_results[j][1] = d / (double)count;
+            }
+        }
+        DH_free(dh_a);
+        DH_free(dh_b);
+        dh_a = dh_b = NULL;
+
+        if (rsa_count <= 1) {
+            /* if longer than 10s, don't do any more */
+            for (j++; j < DH_NUM; j++)
+                dh_doit[j] = 0;
+        }
+    }
 #if defined(HAVE_FORK)
 show_res:
 #endif
@@ -1824,6 +2049,8 @@ show_res:
         if (!rsa_doit[k])
             continue;
         if (j && !mr) {
+            if (rsa_primes > 2)
+                printf("rsa keys with %d primes\n", rsa_primes);
             printf("%18ssign    verify    sign/s verify/s\n", " ");
             j = 0;
         }
@@ -1890,6 +2117,23 @@ show_res:
                     ecdh_results[k][0], 1.0 / ecdh_results[k][0]);
     }
 
+    j = 1;
+    for (k = 0; k < DH_NUM; k++) {
+        if (!dh_doit[k])
+            continue;
+        if (j && !mr) {
+            printf("%18skeygen    derive  keygen/s derive/s\n", " ");
+            j = 0;
+        }
+        if (mr)
+            fprintf(stdout, "+F6:%u:%u:%f:%f\n", k, dh_bits[k],
+                    dh_results[k][0], dh_results[k][1]);
+        else
+            fprintf(stdout, "dhe %4u bits %8.6fs %8.6fs %8.1f %8.1f\n",
+                    dh_bits[k], dh_results[k][0], dh_results[k][1],
+                    1.0 / dh_results[k][0], 1.0 / dh_results[k][1]);
+    }
+
     mret = 0;
 
 end:
@@ -1914,6 +2158,11 @@ end:
         if (ecdh_b[i] != NULL)
             EC_KEY_free(ecdh_b[i]);
     }
+    for (i = 0; i < DH_NUM; i++)
+        DH_free(dh_params[i]);
+    DH_free(dh_a);
+    DH_free(dh_b);
+    free(dh_secret);
 
     return (mret);
 }
@@ -2132,6 +2381,27 @@ static int do_multi(int multi)
 
             }
 
+            else if (!strncmp(buf, "+F6:", 4)) {
+                int k;
+                double d;
+
+                p = buf + 4;
+                k = strtonum(sstrsep(&p, sep), 0, DH_NUM - 1, &stnerr);
+                sstrsep(&p, sep);
+
+                d = atof(sstrsep(&p, sep));
+                if (n)
+                    dh_results[k][0] = 1 / (1 / dh_results[k][0] + 1 / d);
+                else
+                    dh_results[k][0] = d;
+
+                d = atof(sstrsep(&p, sep));
+                if (n)
+                    dh_results[k][1] = 1 / (1 / dh_results[k][1] + 1 / d);
+                else
+                    dh_results[k][1] = d;
+            }
+
             else if (!strncmp(buf, "+H:", 3)) {
             } else
                 fprintf(stderr, "Unknown type '%s' from child %d\n", buf, n);
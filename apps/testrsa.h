@@ -244,6 +244,157 @@ static uint8_t test2048[] = {
     0x1b, 0xe4, 0x95,
 };
 
+static uint8_t test3072[] = {
+    0x30, 0x82, 0x06, 0xe4, 0x02, 0x01, 0x00, 0x02, 0x82, 0x01, 0x81, 0x00,
+    0xe0, 0xc2, 0x7f, 0x97, 0x14, 0x13, 0xb6, 0xe6, 0x16, 0xc0, 0xda, 0x37,
+    0xcf, 0x4c, 0xaf, 0x2a, 0x75, 0x4e, 0x49, 0x79, 0x57, 0xf3, 0x03, 0x88,
+    0xbc, 0x26, 0x5d, 0x0c, 0x38, 0x3f, 0x58, 0xc1, 0x2a, 0x67, 0x1b, 0x8e,
+    0xce, 0xc6, 0xbb, 0xaa, 0x39, 0xa8, 0xdd, 0x82, 0xf4, 0x4e, 0xb3, 0x1d,
+    0x40, 0x3b, 0x9a, 0xf8, 0x20, 0xfc, 0x06, 0xb7, 0x0b, 0x8f, 0x83, 0x7f,
+    0xc5, 0xa6, 0x2e, 0x58, 0x14, 0xa8, 0x10, 0xd5, 0x2d, 0x5b, 0x4f, 0x00,
+    0xa6, 0x1e, 0x20, 0x59, 0xdc, 0x30, 0xca, 0x05, 0x5e, 0xdf, 0x03, 0x66,
+    0xe9, 0x7a, 0x3a, 0x53, 0xb7, 0x97, 0xfd, 0x1f, 0x7e, 0x43, 0x8b, 0xab,
+    0x30, 0xee, 0xb1, 0x2f, 0x06, 0xad, 0xa2, 0x07, 0x99, 0x03, 0x42, 0x77,
+    0x06, 0x56, 0xaa, 0x51, 0x41, 0x6e, 0xde, 0xa2, 0x54, 0x41, 0x3c, 0x80,
+    0x62, 0x9c, 0x42, 0x50, 0x6b, 0x99, 0xff, 0xf1, 0xf1, 0xd2, 0xec, 0xd7,
+    0x52, 0xd4, 0xea, 0x13, 0x22, 0x96, 0x0b, 0xf0, 0x74, 0xec, 0x0a, 0x1a,
+    0x83, 0xdd, 0xac, 0x0d, 0xd5, 0x3d, 0xdd, 0x25, 0x75, 0x77, 0x14, 0x10,
+    0x5d, 0x1c, 0xce, 0xa8, 0x0d, 0xef, 0x79, 0xbb, 0x8f, 0xaa, 0x33, 0x57,
+    0xe5, 0xda, 0x7d, 0x94, 0xbf, 0x6f, 0xea, 0xa5, 0x28, 0x69, 0x4e, 0x58,
+    0xb9, 0x92, 0xa8, 0x9c, 0x96, 0x70, 0xf9, 0x7d, 0x03, 0xb3, 0xa6, 0x63,
+    0x97, 0x56, 0x22, 0x39, 0xfb, 0x93, 0xd4, 0x92, 0x7a, 0xd4, 0xe6, 0x87,
+    0x9e, 0xe0, 0xee, 0x4a, 0xe0, 0xc0, 0x65, 0x88, 0x73, 0xd8, 0x08, 0x6b,
+    0xd9, 0x11, 0xa8, 0x5d, 0x4d, 0xfa, 0x42, 0x99, 0xe5, 0x7c, 0x41, 0xed,
+    0xef, 0x87, 0x25, 0x54, 0x7e, 0xe1, 0xee, 0x2f, 0x54, 0x77, 0xbf, 0x8c,
+    0x2b, 0xa4, 0xfa, 0xa2, 0xef, 0x7e, 0x20, 0x4c, 0x3a, 0x7e, 0x5d, 0x53,
+    0xae, 0xa6, 0x3c, 0xd9, 0x41, 0x19, 0x02, 0x8e, 0x7c, 0x8b, 0x04, 0x02,
+    0x5f, 0x6b, 0xcc, 0xe0, 0x1e, 0xfd, 0xf6, 0xe7, 0xcc, 0xc8, 0xc3, 0x74,
+    0x0e, 0x0c, 0x63, 0x77, 0x87, 0xeb, 0xe5, 0x37, 0x01, 0x2f, 0x37, 0x65,
+    0xfb, 0x8b, 0xda, 0x02, 0x60, 0x4e, 0x51, 0x64, 0x11, 0x2d, 0x92, 0xda,
+    0xf7, 0x69, 0x03, 0xf0, 0x1b, 0x95, 0xa1, 0xc6, 0xe0, 0x88, 0xad, 0x5c,
+    0x05, 0xe4, 0xe5, 0x3c, 0xbe, 0xf6, 0x7c, 0xe6, 0xf1, 0xd6, 0x13, 0xd5,
+    0x63, 0x3c, 0x16, 0xb1, 0x15, 0x30, 0xf6, 0x04, 0xab, 0xd4, 0x15, 0x3a,
+    0xb4, 0x85, 0x82, 0x02, 0x11, 0x9e, 0xca, 0xdc, 0x4f, 0x5c, 0x40, 0x93,
+    0xc9, 0x51, 0x87, 0x33, 0xd0, 0x26, 0x2c, 0x32, 0xa6, 0x50, 0xaa, 0x8f,
+    0xcc, 0x54, 0x74, 0x69, 0x5b, 0x12, 0x93, 0xa8, 0xf5, 0x9e, 0xa9, 0x69,
+    0x33, 0xe9, 0x78, 0xa2, 0xe9, 0xd0, 0x33, 0x18, 0xb6, 0xd9, 0x27, 0xdf,
+    0x02, 0x03, 0x01, 0x00, 0x01, 0x02, 0x82, 0x01, 0x80, 0x1a, 0xbc, 0xf8,
+    0xb9, 0xcb, 0xe1, 0x26, 0x86, 0x8b, 0xd9, 0x68, 0x7c, 0x70, 0x34, 0x62,
+    0xb8, 0x4d, 0xd9, 0x40, 0xe3, 0x67, 0x23, 0x99, 0x5d, 0x88, 0x68, 0x95,
+    0xf4, 0x30, 0xb2, 0xd4, 0x87, 0xb2, 0x58, 0x2e, 0xce, 0x97, 0xe9, 0xcb,
+    0x84, 0x8e, 0x34, 0x79, 0x19, 0xad, 0x9f, 0xb9, 0x2e, 0x37, 0x28, 0x80,
+    0x20, 0x99, 0xa7, 0xf1, 0xd2, 0x8f, 0xd5, 0x04, 0x63, 0x4c, 0x6b, 0x9f,
+    0x22, 0xca, 0x5e, 0x4e, 0x16, 0x56, 0x3d, 0x81, 0x12, 0x06, 0x31, 0x1a,
+    0x4f, 0x26, 0x63, 0x45, 0x7d, 0x4b, 0x12, 0x83, 0xd0, 0x97, 0xe0, 0xfb,
+    0x14, 0x5f, 0x88, 0x7c, 0xcb, 0xe4, 0xd4, 0xfb, 0x46, 0x23, 0xdd, 0x99,
+    0x85, 0x8b, 0x29, 0x57, 0xd7, 0xc8, 0x8b, 0xbb, 0x39, 0xf6, 0xae, 0x93,
+    0xb7, 0x73, 0xed, 0xd1, 0x1d, 0x85, 0xa1, 0x77, 0x25, 0x9c, 0xd5, 0x93,
+    0x0c, 0x07, 0x28, 0xfc, 0x6a, 0x57, 0x86, 0xec, 0xb7, 0x16, 0xfb, 0x0e,
+    0x57, 0xb5, 0x6b, 0x1d, 0x43, 0x7f, 0x5d, 0x5f, 0x3c, 0x55, 0x48, 0xa7,
+    0x41, 0xc4, 0x07, 0x06, 0x8a, 0x80, 0xc5, 0x68, 0x45, 0x24, 0x16, 0x9b,
+    0xbd, 0x21, 0x5f, 0x46, 0x5f, 0x9a, 0x51, 0x38, 0xa7, 0x71, 0xc8, 0x42,
+    0xdd, 0x51, 0xc2, 0xea, 0x2a, 0xb8, 0xba, 0x82, 0x60, 0x0a, 0xbf, 0x98,
+    0x40, 0x7c, 0xa3, 0x37, 0x02, 0xf8, 0xd0, 0x43, 0xf0, 0x66, 0xf8, 0x43,
+    0x6a, 0x59, 0x3f, 0xb6, 0xda, 0x64, 0x0b, 0x47, 0x79, 0x3f, 0x1a, 0x69,
+    0x16, 0x83, 0x15, 0xde, 0x0e, 0xb0, 0xb8, 0xdd, 0x2c, 0x6b, 0x98, 0x97,
+    0x48, 0xe8, 0xb1, 0x29, 0xfa, 0xfd, 0xc5, 0x8a, 0xd1, 0x6a, 0x2e, 0xb1,
+    0x58, 0xf4, 0xbc, 0x9c, 0x22, 0xb8, 0xd7, 0x26, 0x64, 0x63, 0xec, 0x25,
+    0xec, 0x92, 0x8b, 0x7b, 0x10, 0x52, 0x93, 0x2e, 0x2c, 0xc0, 0x26, 0x29,
+    0x89, 0x53, 0x62, 0xa9, 0xfc, 0x47, 0x88, 0x06, 0x1f, 0x47, 0xb5, 0x05,
+    0x94, 0x64, 0x80, 0xbb, 0x85, 0x8d, 0xd8, 0xc2, 0xb6, 0x6e, 0x8f, 0xfa,
+    0x6c, 0x76, 0xb9, 0xa3, 0x55, 0x05, 0x6a, 0x06, 0xcc, 0xcf, 0xa9, 0xe7,
+    0x29, 0xa6, 0xd6, 0x06, 0xd3, 0x9f, 0x7c, 0xe6, 0xdc, 0xbe, 0x34, 0x84,
+    0x15, 0xe9, 0x4b, 0x4a, 0x17, 0x42, 0x81, 0xfc, 0x3d, 0x96, 0x78, 0x09,
+    0x68, 0x6d, 0xee, 0x6e, 0x1b, 0x23, 0x62, 0xfb, 0x75, 0x95, 0xa6, 0x5a,
+    0xc3, 0xe6, 0x51, 0xc8, 0xdf, 0x4a, 0x7c, 0x3c, 0x77, 0x54, 0x1a, 0xfb,
+    0xec, 0x1e, 0x2c, 0x82, 0xa4, 0xd0, 0x1a, 0xc7, 0x5f, 0xe2, 0xac, 0x4a,
+    0x20, 0x36, 0x6d, 0xf8, 0x60, 0xe9, 0xac, 0x1f, 0xfb, 0x78, 0xf5, 0x45,
+    0x45, 0xa6, 0xe2, 0xa4, 0x9f, 0x66, 0xbc, 0xf3, 0x56, 0x4d, 0xbc, 0xdd,
+    0xc4, 0xaf, 0xd8, 0xa5, 0x9b, 0xac, 0xb7, 0xb4, 0xd5, 0x02, 0x81, 0xc1,
+    0x00, 0xfc, 0x7a, 0x30, 0x67, 0xb6, 0x5f, 0xfa, 0xad, 0x8c, 0xae, 0x22,
+    0x39, 0xfc, 0x92, 0xeb, 0xab, 0xfe, 0x6d, 0xdf, 0x15, 0x28, 0xbe, 0xbc,
+    0x26, 0xb5, 0xa2, 0x43, 0xc9, 0x0b, 0xff, 0xc7, 0x55, 0xb4, 0x1b, 0x55,
+    0x0c, 0xdd, 0x69, 0x44, 0xc3, 0xaf, 0xe1, 0xa5, 0x33, 0xc3, 0x80, 0x7a,
+    0xfe, 0xab, 0x58, 0x6d, 0x99, 0xc2, 0xbe, 0x10, 0x71, 0x63, 0x38, 0x1d,
+    0x27, 0xfd, 0x8d, 0xc7, 0x75, 0xa0, 0x52, 0xde, 0xad, 0x5a, 0xe9, 0x31,
+    0x21, 0x8f, 0xee, 0xf4, 0x2c, 0x33, 0xa4, 0x4c, 0x64, 0x57, 0x10, 0x7e,
+    0xa8, 0xff, 0x73, 0xbe, 0xe6, 0x91, 0x99, 0x93, 0x5c, 0x5b, 0x07, 0x54,
+    0x2a, 0x9f, 0xb6, 0x81, 0xe3, 0x36, 0x88, 0xb5, 0x1e, 0xa5, 0x94, 0x32,
+    0x6f, 0x5a, 0x49, 0x2d, 0x7a, 0xa7, 0xd9, 0xbc, 0x79, 0x28, 0x22, 0xd4,
+    0x30, 0x9a, 0x01, 0x4f, 0xc9, 0xe4, 0x48, 0x8e, 0xb7, 0xd4, 0x6c, 0x5f,
+    0xa9, 0x29, 0x8e, 0x55, 0x63, 0x1b, 0xc1, 0x06, 0x7d, 0x0d, 0x63, 0xba,
+    0x97, 0x9c, 0x06, 0xe6, 0x3b, 0x8e, 0x77, 0xf7, 0xf4, 0xad, 0x09, 0x47,
+    0xe7, 0xfc, 0xc9, 0x9e, 0x58, 0xac, 0x33, 0xc9, 0x70, 0x9e, 0xc7, 0x38,
+    0x3b, 0xa6, 0x42, 0x25, 0x9d, 0x37, 0x75, 0x2c, 0xbf, 0x06, 0x49, 0xf3,
+    0x2e, 0xf0, 0xfd, 0xdf, 0x13, 0xc4, 0xe4, 0x61, 0x36, 0xe2, 0x43, 0x37,
+    0x43, 0x02, 0x81, 0xc1, 0x00, 0xe3, 0xe5, 0x4e, 0x72, 0x27, 0xfa, 0x23,
+    0xcd, 0x8e, 0x11, 0xe6, 0x41, 0x0a, 0x06, 0xaf, 0x91, 0x01, 0x67, 0xa6,
+    0x65, 0xac, 0x89, 0x1f, 0x2d, 0x8d, 0xc9, 0xc2, 0x67, 0xe5, 0xe7, 0xf0,
+    0xba, 0xb8, 0x47, 0xf7, 0xb3, 0x26, 0x91, 0xcd, 0x12, 0xb3, 0xba, 0xb1,
+    0xe9, 0xc9, 0x69, 0xf4, 0x23, 0x4d, 0x38, 0xf8, 0x40, 0x89, 0x3a, 0x9d,
+    0xad, 0x3e, 0x9f, 0x8d, 0xe9, 0x0e, 0xf5, 0x3c, 0x95, 0xa7, 0xb3, 0xda,
+    0xeb, 0xde, 0x31, 0xea, 0x8a, 0xda, 0x7a, 0x42, 0x6f, 0x63, 0xb4, 0x28,
+    0xc1, 0x70, 0xd1, 0x27, 0xe8, 0x84, 0x82, 0xb5, 0x97, 0xde, 0x7f, 0x0a,
+    0x1a, 0x96, 0x6d, 0x18, 0xe8, 0x0a, 0x5c, 0xb2, 0x62, 0x4f, 0xb0, 0xd6,
+    0x38, 0x70, 0xa7, 0xaa, 0x36, 0x7b, 0xef, 0x93, 0xa8, 0x6a, 0x95, 0x2f,
+    0xce, 0x1e, 0x8a, 0x4d, 0xbf, 0xae, 0x9f, 0x5f, 0x62, 0xf3, 0x68, 0xb2,
+    0x31, 0x1a, 0x06, 0xe4, 0x24, 0x92, 0x34, 0x5d, 0xb0, 0xc5, 0xd8, 0xd6,
+    0x85, 0xf2, 0xf0, 0x82, 0xf9, 0x1a, 0xf2, 0x6a, 0xe1, 0x62, 0x82, 0x5b,
+    0xab, 0x5f, 0x8c, 0xf5, 0x87, 0xa9, 0x85, 0xd4, 0xc6, 0xf6, 0x1a, 0x51,
+    0xda, 0x03, 0x90, 0x06, 0x65, 0x63, 0xa1, 0x2e, 0xcd, 0x50, 0xe6, 0xc1,
+    0x74, 0x9e, 0x7e, 0xd2, 0x10, 0x43, 0x3e, 0x3a, 0xc3, 0x15, 0xf8, 0x5d,
+    0x4a, 0x40, 0x91, 0x7d, 0x35, 0x02, 0x81, 0xc0, 0x48, 0xdf, 0x6b, 0xc1,
+    0x43, 0x9e, 0x88, 0x58, 0x37, 0x56, 0xbb, 0x82, 0x49, 0x28, 0x8e, 0xe5,
+    0x61, 0xd6, 0x8c, 0xa1, 0x2a, 0xd5, 0x82, 0xb1, 0x19, 0x93, 0xf0, 0x44,
+    0xc3, 0x35, 0xdc, 0x6f, 0x1c, 0x41, 0x17, 0x57, 0x53, 0x40, 0xe3, 0x1c,
+    0x28, 0x53, 0xd4, 0xbf, 0x10, 0x1a, 0xb1, 0x65, 0x78, 0x47, 0x59, 0xbb,
+    0x1b, 0xbe, 0x88, 0x38, 0x72, 0x0e, 0xec, 0x3b, 0x72, 0xaf, 0xcd, 0x76,
+    0x62, 0x04, 0x09, 0x49, 0xb8, 0x07, 0xbe, 0xaa, 0x95, 0x44, 0xbf, 0x2d,
+    0x52, 0xea, 0x85, 0x32, 0x20, 0xff, 0x1d, 0xcf, 0xe1, 0x8b, 0xa2, 0xfa,
+    0x21, 0xe4, 0x55, 0xe8, 0x3e, 0x4d, 0xeb, 0x39, 0x32, 0x48, 0x17, 0x4d,
+    0x61, 0x9c, 0x2b, 0xca, 0xe0, 0xb7, 0xd9, 0xa6, 0xd2, 0x44, 0x74, 0xe0,
+    0x06, 0x3a, 0x8e, 0x6f, 0xd9, 0xe9, 0xd3, 0x9d, 0x03, 0x96, 0x85, 0x55,
+    0x1c, 0x92, 0xe4, 0xbe, 0xa2, 0x8d, 0x75, 0x3e, 0xfa, 0x43, 0x9e, 0xd9,
+    0xb0, 0x55, 0x12, 0x6e, 0x5d, 0xc2, 0xff, 0x44, 0x6b, 0x40, 0x82, 0x8b,
+    0x86, 0x1f, 0x92, 0x6e, 0x08, 0xd3, 0xb8, 0xf1, 0x78, 0xc1, 0x28, 0xf7,
+    0x27, 0x1c, 0xfb, 0x73, 0x8a, 0x20, 0xae, 0x56, 0x69, 0x32, 0x86, 0x70,
+    0xce, 0x64, 0xff, 0xb9, 0x53, 0x33, 0x5d, 0x01, 0x9b, 0x85, 0x6b, 0x31,
+    0xe5, 0x8e, 0x95, 0x90, 0xa5, 0xd6, 0x08, 0xc9, 0x02, 0x81, 0xc1, 0x00,
+    0xce, 0xe3, 0x95, 0x5b, 0xbd, 0x3f, 0x30, 0xd1, 0xa3, 0x70, 0x4c, 0x80,
+    0x2f, 0x01, 0xf2, 0xd0, 0xc9, 0x5d, 0xb7, 0x8a, 0x06, 0x20, 0x55, 0xd5,
+    0x9d, 0x2a, 0xd4, 0xfa, 0x4d, 0x95, 0x4a, 0xcd, 0xb8, 0x0e, 0x5d, 0xa8,
+    0x9e, 0x13, 0x2f, 0x01, 0x13, 0x79, 0x21, 0x9b, 0x03, 0xe6, 0xd4, 0x64,
+    0x57, 0xee, 0xa8, 0x30, 0xae, 0x64, 0x30, 0x50, 0xde, 0xd1, 0x2a, 0x9b,
+    0xb1, 0xa0, 0xa0, 0xe7, 0x9b, 0xdf, 0x83, 0x97, 0x2d, 0x98, 0x53, 0x3c,
+    0xcb, 0x2a, 0xc2, 0xb5, 0x2c, 0xe6, 0x99, 0x39, 0x43, 0x9a, 0x1d, 0x88,
+    0xd1, 0x03, 0x78, 0xa7, 0xee, 0xad, 0x96, 0x16, 0x9d, 0x09, 0x5d, 0xdb,
+    0x09, 0xcd, 0x2d, 0x84, 0x62, 0xa4, 0x3f, 0x55, 0xed, 0xaf, 0xc8, 0xae,
+    0xbd, 0xc4, 0xb9, 0x5f, 0xe3, 0xa2, 0x9c, 0x4b, 0x9b, 0x1e, 0x23, 0x87,
+    0x28, 0x98, 0x36, 0x98, 0x36, 0x31, 0x8d, 0xd3, 0x55, 0xb5, 0x7b, 0xd8,
+    0x57, 0x82, 0x82, 0xab, 0xc0, 0x71, 0x22, 0x0f, 0x68, 0x85, 0x3f, 0xe1,
+    0xb5, 0xbc, 0xed, 0x9a, 0xbf, 0x3b, 0x68, 0xcd, 0x23, 0x69, 0x6c, 0x5d,
+    0x44, 0x60, 0xe2, 0xd1, 0xdd, 0x09, 0xf7, 0xd4, 0xdb, 0xf7, 0x1c, 0x57,
+    0x5f, 0x23, 0x2c, 0xc1, 0xe7, 0xf8, 0x15, 0x18, 0x31, 0xeb, 0x1f, 0xf8,
+    0xf3, 0x92, 0xc2, 0xf5, 0xe8, 0x34, 0x19, 0x3d, 0x17, 0x70, 0xfd, 0x21,
+    0x02, 0x81, 0xc1, 0x00, 0xd0, 0x59, 0x5e, 0xca, 0x76, 0x8d, 0xfe, 0x77,
+    0xde, 0xf6, 0x4f, 0xb8, 0xca, 0xf4, 0xd5, 0x19, 0xf4, 0x04, 0x5c, 0x76,
+    0xd1, 0x8e, 0x46, 0xcf, 0xb2, 0x35, 0x79, 0x10, 0xe8, 0xe5, 0xb5, 0x75,
+    0xda, 0x51, 0xd0, 0xe6, 0xc4, 0xf4, 0xab, 0x61, 0x7f, 0xe2, 0x4d, 0x20,
+    0x0e, 0xb6, 0x28, 0xbb, 0xcf, 0xb8, 0x49, 0xcb, 0x75, 0x37, 0x27, 0x56,
+    0xa9, 0x8a, 0x86, 0x95, 0x6e, 0xa5, 0x12, 0x6a, 0x53, 0xe7, 0x50, 0x66,
+    0x78, 0x3d, 0x58, 0xe3, 0x70, 0xef, 0xa5, 0x20, 0x0b, 0x75, 0xdc, 0x21,
+    0x81, 0x95, 0x0d, 0xf6, 0x61, 0x28, 0x59, 0x1f, 0x58, 0x36, 0xc1, 0xd9,
+    0xbb, 0xd0, 0xe3, 0x4c, 0x54, 0x87, 0xd5, 0xcd, 0x86, 0x16, 0x24, 0x46,
+    0x43, 0xe7, 0xa8, 0xdc, 0x5c, 0xa4, 0x35, 0xc6, 0xcd, 0x48, 0x00, 0x4d,
+    0x72, 0x0d, 0xd9, 0x26, 0xd4, 0x34, 0x1b, 0xfc, 0x99, 0xa3, 0xda, 0x93,
+    0xad, 0xa5, 0x6b, 0x17, 0x49, 0xd1, 0xb1, 0xff, 0x56, 0xac, 0x87, 0xc9,
+    0xd2, 0x9a, 0x49, 0xad, 0x26, 0x25, 0x8a, 0xa2, 0x2c, 0x2a, 0x21, 0xb0,
+    0xcc, 0xbb, 0x70, 0x73, 0x32, 0x90, 0xf6, 0x8d, 0x87, 0x8c, 0x07, 0x32,
+    0x36, 0x26, 0x11, 0xf4, 0x97, 0xbc, 0x91, 0x9a, 0x92, 0xce, 0x28, 0x93,
+    0x0b, 0xd7, 0x0a, 0xdb, 0xa5, 0x09, 0x47, 0xa7, 0x4f, 0x93, 0xc9, 0x97,
+    0xbf, 0x32, 0x7b, 0xdb,
+};
+
 static uint8_t test4096[] = {
     0x30, 0x82, 0x09, 0x29, 0x02, 0x01, 0x00, 0x02, 0x82, 0x02, 0x01, 0x00,
     0xc0, 0x71, 0xac, 0x1a, 0x13, 0x88, 0x82, 0x43, 0x3b, 0x51, 0x57, 0x71,
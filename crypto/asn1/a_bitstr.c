@@ -13,6 +13,7 @@
 #include <openssl/asn1.h>
 #include <openssl/err.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 
 int ASN1_BIT_STRING_set(ASN1_BIT_STRING *x, uint8_t *d, int len)
@@ -96,6 +97,11 @@ ASN1_BIT_STRING *c2i_ASN1_BIT_STRING(ASN1_BIT_STRING **a,
     } else
         ret = (*a);
 
+    if ((ret->flags & ASN1_STRING_FLAG_ARENA) && asn1_arena_current() == NULL) {
+        i = ASN1_R_VALUE_IN_ARENA;
+        goto err;
+    }
+
     p = *pp;
     i = *(p++);
     if (i > 7) {
@@ -110,7 +116,7 @@ ASN1_BIT_STRING *c2i_ASN1_BIT_STRING(ASN1_BIT_STRING **a,
 
     if (len-- > 1) /* using one because of the bits left byte */
     {
-        s = malloc((int)len);
+        s = asn1_malloc((int)len);
         if (s == NULL) {
             i = ERR_R_MALLOC_FAILURE;
             goto err;
@@ -122,7 +128,7 @@ ASN1_BIT_STRING *c2i_ASN1_BIT_STRING(ASN1_BIT_STRING **a,
         s = NULL;
 
     ret->length = (int)len;
-    free(ret->data);
+    asn1_free(ret->data);
     ret->data = s;
     ret->type = V_ASN1_BIT_STRING;
     if (a != NULL)
@@ -151,6 +157,10 @@ int ASN1_BIT_STRING_set_bit(ASN1_BIT_STRING *a, int n, int value)
 
     if (a == NULL)
         return 0;
+    if (a->flags & ASN1_STRING_FLAG_ARENA) {
+        ASN1err(ASN1_F_ASN1_BIT_STRING_SET_BIT, ASN1_R_VALUE_IN_ARENA);
+        return 0;
+    }
 
     a->flags &= ~(ASN1_STRING_FLAG_BITS_LEFT | 0x07); /* clear, set on write */
 
@@ -15,6 +15,7 @@
 #include <openssl/bn.h>
 #include <openssl/err.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 
 ASN1_INTEGER *ASN1_INTEGER_dup(const ASN1_INTEGER *x)
@@ -395,6 +396,11 @@ ASN1_INTEGER *d2i_ASN1_UINTEGER(ASN1_INTEGER **a, const uint8_t **pp,
     } else
         ret = (*a);
 
+    if ((ret->flags & ASN1_STRING_FLAG_ARENA) && asn1_arena_current() == NULL) {
+        i = ASN1_R_VALUE_IN_ARENA;
+        goto err;
+    }
+
     p = *pp;
     inf = ASN1_get_object(&p, &len, &tag, &xclass, length);
     if (inf & 0x80) {
@@ -411,7 +417,7 @@ ASN1_INTEGER *d2i_ASN1_UINTEGER(ASN1_INTEGER **a, const uint8_t **pp,
      * We must malloc stuff, even for 0 bytes otherwise it signifies
      * a missing NULL parameter.
      */
-    s = malloc((int)len + 1);
+    s = asn1_malloc((int)len + 1);
     if (s == NULL) {
         i = ERR_R_MALLOC_FAILURE;
         goto err;
@@ -426,7 +432,7 @@ ASN1_INTEGER *d2i_ASN1_UINTEGER(ASN1_INTEGER **a, const uint8_t **pp,
         p += len;
     }
 
-    free(ret->data);
+    asn1_free(ret->data);
     ret->data = s;
     ret->length = (int)len;
     if (a != NULL)
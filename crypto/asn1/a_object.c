@@ -226,6 +226,7 @@ ASN1_OBJECT *c2i_ASN1_OBJECT(ASN1_OBJECT **a, const uint8_t **pp,
                              long len)
 {
     ASN1_OBJECT *ret = NULL;
+    ASN1_ARENA *arena;
     const uint8_t *p;
     uint8_t *data;
     int i, length;
@@ -250,7 +251,16 @@ ASN1_OBJECT *c2i_ASN1_OBJECT(ASN1_OBJECT **a, const uint8_t **pp,
 
     /* only the ASN1_OBJECTs from the 'table' will have values
      * for ->sn or ->ln */
-    if ((a == NULL) || ((*a) == NULL) || !((*a)->flags & ASN1_OBJECT_FLAG_DYNAMIC)) {
+    if ((arena = asn1_arena_current()) != NULL) {
+        /* Decoding into an arena: the object and its data live there */
+        if ((ret = asn1_arena_alloc(arena, sizeof(ASN1_OBJECT))) == NULL) {
+            i = ERR_R_MALLOC_FAILURE;
+            goto err;
+        }
+        memset(ret, 0, sizeof(ASN1_OBJECT));
+        ret->flags = ASN1_OBJECT_FLAG_ARENA;
+    } else if ((a == NULL) || ((*a) == NULL) ||
+               !((*a)->flags & ASN1_OBJECT_FLAG_DYNAMIC)) {
         if ((ret = ASN1_OBJECT_new()) == NULL)
             return (NULL);
     } else
@@ -263,13 +273,17 @@ ASN1_OBJECT *c2i_ASN1_OBJECT(ASN1_OBJECT **a, const uint8_t **pp,
     /* once detached we can change it */
     if ((data == NULL) || (ret->length < length)) {
         ret->length = 0;
-        free(data);
-        data = malloc(length);
+        if (arena != NULL) {
+            data = asn1_arena_alloc(arena, length);
+        } else {
+            free(data);
+            data = malloc(length);
+            ret->flags |= ASN1_OBJECT_FLAG_DYNAMIC_DATA;
+        }
         if (data == NULL) {
             i = ERR_R_MALLOC_FAILURE;
             goto err;
         }
-        ret->flags |= ASN1_OBJECT_FLAG_DYNAMIC_DATA;
     }
     memcpy(data, p, length);
     /* reattach data to object, after which it remains const */
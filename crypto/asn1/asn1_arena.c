@@ -0,0 +1,322 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Arena decoding. While ASN1_item_d2i_arena runs, the structures, strings,
+ * objects, names and saved encodings built by the template decoder are
+ * carved out of the arena's chunks instead of being malloc'd one by one.
+ * Everything else the decoder or the item callbacks allocate (stacks, keys,
+ * locks) still comes from the heap, since it may be shared with or cached by
+ * code outside the decoder. ASN1_ARENA_free runs the normal free path over
+ * each decoded value, during which the arena's own memory is skipped and
+ * only heap memory is released, and then drops the chunks.
+ *
+ * Strings and objects record where they live themselves: an arena string
+ * has ASN1_STRING_FLAG_ARENA set and an arena object has no
+ * ASN1_OBJECT_FLAG_DYNAMIC, so freeing a heap one costs a flag test. Other
+ * allocations check a global count of threads inside an arena call first,
+ * and only then look at the thread's arena, whose chunks are kept sorted by
+ * address for the ownership test. Arena values must not escape the arena:
+ * d2i_X509_arena and d2i_X509_CRL_arena set EXFLAG_ARENA, and the functions
+ * that would keep a reference or modify the value refuse such objects.
+ *
+ * The arena is tracked per thread, so an arena must only be used by one
+ * thread at a time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/asn1.h>
+#include <openssl/asn1t.h>
+#include <openssl/err.h>
+#include <stdcompat.h>
+
+#include "internal/asn1_int.h"
+#include "internal/threads.h"
+
+#define ASN1_ARENA_ALIGN 16
+#define ASN1_ARENA_MIN_CHUNK 4096
+#define ASN1_ARENA_MAX_CHUNK 65536
+
+/* Each allocation is preceded by its size, for asn1_arena_realloc */
+#define ASN1_ARENA_HEADER ASN1_ARENA_ALIGN
+
+typedef struct asn1_arena_chunk_st {
+    struct asn1_arena_chunk_st *next;
+    uint8_t *data;
+    size_t size;
+    size_t used;
+} ASN1_ARENA_CHUNK;
+
+typedef struct {
+    ASN1_VALUE *val;
+    const ASN1_ITEM *it;
+} ASN1_ARENA_ROOT;
+
+struct asn1_arena_st {
+    ASN1_ARENA_CHUNK *chunks;
+    /* The chunks again, in address order */
+    ASN1_ARENA_CHUNK **by_addr;
+    size_t num_chunks;
+    size_t chunks_alloc;
+    size_t next_chunk;
+    size_t allocated;
+    ASN1_ARENA_ROOT *roots;
+    size_t num_roots;
+    size_t roots_alloc;
+};
+
+static CRYPTO_ONCE asn1_arena_once = CRYPTO_ONCE_STATIC_INIT;
+static CRYPTO_THREAD_LOCAL asn1_arena_local;
+static CRYPTO_MUTEX *asn1_arena_lock;
+
+/*
+ * Number of threads currently decoding into or freeing an arena. While it is
+ * zero the allocation hooks do not need to look at the thread local.
+ */
+static int asn1_arena_users;
+
+static void asn1_arena_init(void)
+{
+    asn1_arena_lock = CRYPTO_thread_new();
+    CRYPTO_thread_init_local(&asn1_arena_local, NULL);
+}
+
+ASN1_ARENA *asn1_arena_current(void)
+{
+    if (asn1_arena_users == 0)
+        return NULL;
+    return CRYPTO_thread_get_local(&asn1_arena_local);
+}
+
+/* asn1_arena_enter makes |arena| current and returns the previous one. */
+static ASN1_ARENA *asn1_arena_enter(ASN1_ARENA *arena)
+{
+    ASN1_ARENA *prev;
+    int n;
+
+    CRYPTO_thread_run_once(&asn1_arena_once, asn1_arena_init);
+    prev = CRYPTO_thread_get_local(&asn1_arena_local);
+    CRYPTO_thread_set_local(&asn1_arena_local, arena);
+    CRYPTO_atomic_add(&asn1_arena_users, 1, &n, asn1_arena_lock);
+    return prev;
+}
+
+static void asn1_arena_leave(ASN1_ARENA *prev)
+{
+    int n;
+
+    CRYPTO_thread_set_local(&asn1_arena_local, prev);
+    CRYPTO_atomic_add(&asn1_arena_users, -1, &n, asn1_arena_lock);
+}
+
+static int asn1_arena_owns(const ASN1_ARENA *arena, const void *ptr)
+{
+    const ASN1_ARENA_CHUNK *chunk;
+    const uint8_t *p = ptr;
+    size_t lo = 0, hi = arena->num_chunks, mid;
+
+    /* Find the last chunk starting at or below |p| */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (arena->by_addr[mid]->data <= p)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return 0;
+    chunk = arena->by_addr[lo - 1];
+    return p < chunk->data + chunk->used;
+}
+
+/* asn1_arena_add_chunk files a new |chunk| in |arena|'s address order. */
+static int asn1_arena_add_chunk(ASN1_ARENA *arena, ASN1_ARENA_CHUNK *chunk)
+{
+    ASN1_ARENA_CHUNK **by_addr;
+    size_t i, n;
+
+    if (arena->num_chunks == arena->chunks_alloc) {
+        n = arena->chunks_alloc == 0 ? 8 : 2 * arena->chunks_alloc;
+        by_addr = reallocarray(arena->by_addr, n, sizeof(*by_addr));
+        if (by_addr == NULL)
+            return 0;
+        arena->by_addr = by_addr;
+        arena->chunks_alloc = n;
+    }
+    for (i = arena->num_chunks; i > 0; i--) {
+        if (arena->by_addr[i - 1]->data < chunk->data)
+            break;
+        arena->by_addr[i] = arena->by_addr[i - 1];
+    }
+    arena->by_addr[i] = chunk;
+    arena->num_chunks++;
+    return 1;
+}
+
+void *asn1_arena_alloc(ASN1_ARENA *arena, size_t len)
+{
+    ASN1_ARENA_CHUNK *chunk = arena->chunks;
+    size_t need, size;
+    uint8_t *p;
+
+    if (len > SIZE_MAX - ASN1_ARENA_HEADER - ASN1_ARENA_ALIGN)
+        return NULL;
+    need = ASN1_ARENA_HEADER +
+           ((len + ASN1_ARENA_ALIGN - 1) & ~(size_t)(ASN1_ARENA_ALIGN - 1));
+
+    if (chunk == NULL || chunk->size - chunk->used < need) {
+        size = arena->next_chunk > need ? arena->next_chunk : need;
+        if ((chunk = malloc(sizeof(*chunk) + ASN1_ARENA_ALIGN + size)) == NULL)
+            return NULL;
+        chunk->data = (uint8_t *)(chunk + 1);
+        chunk->data += ASN1_ARENA_ALIGN - ((size_t)chunk->data % ASN1_ARENA_ALIGN);
+        chunk->size = size;
+        chunk->used = 0;
+        if (!asn1_arena_add_chunk(arena, chunk)) {
+            free(chunk);
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        if (arena->next_chunk < ASN1_ARENA_MAX_CHUNK)
+            arena->next_chunk *= 2;
+    }
+
+    p = chunk->data + chunk->used;
+    chunk->used += need;
+    arena->allocated += len;
+    memcpy(p, &len, sizeof(len));
+    return p + ASN1_ARENA_HEADER;
+}
+
+void *asn1_malloc(size_t len)
+{
+    ASN1_ARENA *arena;
+
+    if ((arena = asn1_arena_current()) == NULL)
+        return malloc(len);
+    return asn1_arena_alloc(arena, len);
+}
+
+void *asn1_calloc(size_t num, size_t size)
+{
+    ASN1_ARENA *arena;
+    void *p;
+
+    if ((arena = asn1_arena_current()) == NULL)
+        return calloc(num, size);
+    if (size != 0 && num > SIZE_MAX / size)
+        return NULL;
+    if ((p = asn1_arena_alloc(arena, num * size)) != NULL)
+        memset(p, 0, num * size);
+    return p;
+}
+
+void *asn1_arena_realloc(ASN1_ARENA *arena, void *ptr, size_t len)
+{
+    size_t old_len;
+    void *p;
+
+    if (ptr == NULL)
+        return asn1_arena_alloc(arena, len);
+
+    /* Never grown in place: the old block stays until the arena goes */
+    memcpy(&old_len, (uint8_t *)ptr - ASN1_ARENA_HEADER, sizeof(old_len));
+    if (len <= old_len)
+        return ptr;
+    if ((p = asn1_arena_alloc(arena, len)) != NULL)
+        memcpy(p, ptr, old_len);
+    return p;
+}
+
+void asn1_free(void *ptr)
+{
+    ASN1_ARENA *arena;
+
+    if (ptr == NULL)
+        return;
+    if ((arena = asn1_arena_current()) != NULL && asn1_arena_owns(arena, ptr))
+        return;
+    free(ptr);
+}
+
+ASN1_ARENA *ASN1_ARENA_new(void)
+{
+    ASN1_ARENA *arena;
+
+    if ((arena = calloc(1, sizeof(*arena))) == NULL) {
+        ASN1err(ASN1_F_ASN1_ARENA_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    arena->next_chunk = ASN1_ARENA_MIN_CHUNK;
+    return arena;
+}
+
+void ASN1_ARENA_free(ASN1_ARENA *arena)
+{
+    ASN1_ARENA_CHUNK *chunk, *next;
+    ASN1_ARENA *prev;
+    size_t i;
+
+    if (arena == NULL)
+        return;
+
+    if (arena->num_roots > 0) {
+        prev = asn1_arena_enter(arena);
+        for (i = arena->num_roots; i > 0; i--)
+            ASN1_item_free(arena->roots[i - 1].val, arena->roots[i - 1].it);
+        asn1_arena_leave(prev);
+    }
+
+    for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        vigortls_zeroize(chunk->data, chunk->used);
+        free(chunk);
+    }
+    free(arena->by_addr);
+    free(arena->roots);
+    free(arena);
+}
+
+size_t ASN1_ARENA_allocated(const ASN1_ARENA *arena)
+{
+    return arena->allocated;
+}
+
+ASN1_VALUE *ASN1_item_d2i_arena(ASN1_ARENA *arena, const uint8_t **in,
+                                long len, const ASN1_ITEM *it)
+{
+    ASN1_ARENA_ROOT *roots;
+    ASN1_ARENA *prev;
+    ASN1_VALUE *ret;
+    size_t n;
+
+    if (arena->num_roots == arena->roots_alloc) {
+        n = arena->roots_alloc == 0 ? 8 : 2 * arena->roots_alloc;
+        if ((roots = reallocarray(arena->roots, n, sizeof(*roots))) == NULL) {
+            ASN1err(ASN1_F_ASN1_ITEM_D2I_ARENA, ERR_R_MALLOC_FAILURE);
+            return NULL;
+        }
+        arena->roots = roots;
+        arena->roots_alloc = n;
+    }
+
+    prev = asn1_arena_enter(arena);
+    ret = ASN1_item_d2i(NULL, in, len, it);
+    asn1_arena_leave(prev);
+
+    if (ret != NULL) {
+        arena->roots[arena->num_roots].val = ret;
+        arena->roots[arena->num_roots].it = it;
+        arena->num_roots++;
+    }
+    return ret;
+}
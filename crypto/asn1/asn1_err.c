@@ -23,6 +23,7 @@ static ERR_STRING_DATA ASN1_str_functs[] = {
     { ERR_FUNC(ASN1_F_A2I_ASN1_INTEGER), "A2I_ASN1_INTEGER" },
     { ERR_FUNC(ASN1_F_A2I_ASN1_STRING), "A2I_ASN1_STRING" },
     { ERR_FUNC(ASN1_F_APPEND_EXP), "APPEND_EXP" },
+    { ERR_FUNC(ASN1_F_ASN1_ARENA_NEW), "ASN1_ARENA_NEW" },
     { ERR_FUNC(ASN1_F_ASN1_BIT_STRING_SET_BIT), "ASN1_BIT_STRING_SET_BIT" },
     { ERR_FUNC(ASN1_F_ASN1_CB), "ASN1_CB" },
     { ERR_FUNC(ASN1_F_ASN1_CHECK_TLEN), "ASN1_CHECK_TLEN" },
@@ -49,6 +50,7 @@ static ERR_STRING_DATA ASN1_str_functs[] = {
     { ERR_FUNC(ASN1_F_ASN1_I2D_FP), "ASN1_I2D_FP" },
     { ERR_FUNC(ASN1_F_ASN1_INTEGER_SET), "ASN1_INTEGER_SET" },
     { ERR_FUNC(ASN1_F_ASN1_INTEGER_TO_BN), "ASN1_INTEGER_TO_BN" },
+    { ERR_FUNC(ASN1_F_ASN1_ITEM_D2I_ARENA), "ASN1_ITEM_D2I_ARENA" },
     { ERR_FUNC(ASN1_F_ASN1_ITEM_D2I_FP), "ASN1_ITEM_D2I_FP" },
     { ERR_FUNC(ASN1_F_ASN1_ITEM_DUP), "ASN1_ITEM_DUP" },
     { ERR_FUNC(ASN1_F_ASN1_ITEM_EX_D2I), "ASN1_ITEM_EX_D2I" },
@@ -292,6 +294,7 @@ static ERR_STRING_DATA ASN1_str_reasons[] = {
     { ERR_REASON(ASN1_R_UNSUPPORTED_PUBLIC_KEY_TYPE),
      "unsupported public key type" },
     { ERR_REASON(ASN1_R_UNSUPPORTED_TYPE), "unsupported type" },
+    { ERR_REASON(ASN1_R_VALUE_IN_ARENA), "value in arena" },
     { ERR_REASON(ASN1_R_WRONG_INTEGER_TYPE), "wrong integer type" },
     { ERR_REASON(ASN1_R_WRONG_PUBLIC_KEY_TYPE), "wrong public key type" },
     { ERR_REASON(ASN1_R_WRONG_TAG), "wrong tag" },
@@ -15,6 +15,7 @@
 #include <openssl/err.h>
 
 #include "cryptlib.h"
+#include "internal/asn1_int.h"
 
 static int asn1_get_length(const uint8_t **pp, int *inf, long *rl, long max);
 static void asn1_put_length(uint8_t **pp, int length);
@@ -239,7 +240,8 @@ int ASN1_STRING_copy(ASN1_STRING *dst, const ASN1_STRING *str)
     dst->type = str->type;
     if (!ASN1_STRING_set(dst, str->data, str->length))
         return 0;
-    dst->flags = str->flags;
+    dst->flags = (str->flags & ~ASN1_STRING_FLAG_ARENA) |
+                 (dst->flags & ASN1_STRING_FLAG_ARENA);
     return 1;
 }
 
@@ -260,9 +262,16 @@ ASN1_STRING *ASN1_STRING_dup(const ASN1_STRING *str)
 
 int ASN1_STRING_set(ASN1_STRING *str, const void *_data, int len)
 {
+    ASN1_ARENA *arena = NULL;
     uint8_t *c;
     const char *data = _data;
 
+    /* Arena strings are only written while they are being decoded */
+    if ((str->flags & ASN1_STRING_FLAG_ARENA) &&
+        (arena = asn1_arena_current()) == NULL) {
+        ASN1err(ASN1_F_ASN1_STRING_SET, ASN1_R_VALUE_IN_ARENA);
+        return 0;
+    }
     if (len < 0) {
         if (data == NULL)
             return (0);
@@ -271,7 +280,9 @@ int ASN1_STRING_set(ASN1_STRING *str, const void *_data, int len)
     }
     if ((str->length <= len) || (str->data == NULL)) {
         c = str->data;
-        if (c == NULL)
+        if (arena != NULL)
+            str->data = asn1_arena_realloc(arena, c, len + 1);
+        else if (c == NULL)
             str->data = malloc(len + 1);
         else
             str->data = realloc(c, len + 1);
@@ -293,7 +304,9 @@ int ASN1_STRING_set(ASN1_STRING *str, const void *_data, int len)
 
 void ASN1_STRING_set0(ASN1_STRING *str, void *data, int len)
 {
-    free(str->data);
+    /* An arena string's old data goes with the arena */
+    if (!(str->flags & ASN1_STRING_FLAG_ARENA))
+        free(str->data);
     str->data = data;
     str->length = len;
 }
@@ -306,8 +319,12 @@ ASN1_STRING *ASN1_STRING_new(void)
 ASN1_STRING *ASN1_STRING_type_new(int type)
 {
     ASN1_STRING *ret;
+    ASN1_ARENA *arena;
 
-    ret = malloc(sizeof(ASN1_STRING));
+    if ((arena = asn1_arena_current()) != NULL)
+        ret = asn1_arena_alloc(arena, sizeof(ASN1_STRING));
+    else
+        ret = malloc(sizeof(ASN1_STRING));
     if (ret == NULL) {
         ASN1err(ASN1_F_ASN1_STRING_TYPE_NEW, ERR_R_MALLOC_FAILURE);
         return (NULL);
@@ -315,7 +332,7 @@ ASN1_STRING *ASN1_STRING_type_new(int type)
     ret->length = 0;
     ret->type = type;
     ret->data = NULL;
-    ret->flags = 0;
+    ret->flags = arena != NULL ? ASN1_STRING_FLAG_ARENA : 0;
     return (ret);
 }
 
@@ -323,6 +340,16 @@ void ASN1_STRING_free(ASN1_STRING *a)
 {
     if (a == NULL)
         return;
+    if (a->flags & ASN1_STRING_FLAG_ARENA) {
+        /*
+         * Released with the arena, which also frees any heap data the
+         * decoder attached to it.
+         */
+        if (asn1_arena_current() != NULL &&
+            !(a->flags & ASN1_STRING_FLAG_NDEF))
+            asn1_free(a->data);
+        return;
+    }
     if (!(a->flags & ASN1_STRING_FLAG_NDEF))
         free(a->data);
     free(a);
@@ -332,7 +359,8 @@ void ASN1_STRING_clear_free(ASN1_STRING *a)
 {
     if (a == NULL)
         return;
-    if (!(a->flags & ASN1_STRING_FLAG_NDEF))
+    /* Arena memory is cleared when the arena is freed */
+    if (!(a->flags & (ASN1_STRING_FLAG_NDEF | ASN1_STRING_FLAG_ARENA)))
         vigortls_zeroize(a->data, a->length);
     ASN1_STRING_free(a);
 }
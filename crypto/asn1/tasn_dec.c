@@ -15,6 +15,7 @@
 #include <openssl/buffer.h>
 #include <openssl/err.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 
 static int asn1_check_eoc(const uint8_t **in, long len);
@@ -851,7 +852,7 @@ static int asn1_ex_c2i(ASN1_VALUE **pval, const uint8_t *cont, int len, int utyp
             /* If we've already allocated a buffer use it */
             if (*free_cont) {
                 if (stmp->data)
-                    free(stmp->data);
+                    asn1_free(stmp->data);
                 stmp->data = (uint8_t *)cont; /* UGLY CAST! RL */
                 stmp->length = len;
                 *free_cont = 0;
@@ -12,6 +12,7 @@
 #include <openssl/asn1t.h>
 #include <openssl/objects.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 
 /* Free up an ASN1 structure */
@@ -65,7 +66,7 @@ void ASN1_item_ex_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
             }
             if (asn1_cb)
                 asn1_cb(ASN1_OP_FREE_POST, pval, it, NULL);
-            free(*pval);
+            asn1_free(*pval);
             *pval = NULL;
             break;
 
@@ -102,7 +103,7 @@ void ASN1_item_ex_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
             }
             if (asn1_cb)
                 asn1_cb(ASN1_OP_FREE_POST, pval, it, NULL);
-            free(*pval);
+            asn1_free(*pval);
             *pval = NULL;
             break;
     }
@@ -169,7 +170,7 @@ void asn1_primitive_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
 
         case V_ASN1_ANY:
             asn1_primitive_free(pval, NULL);
-            free(*pval);
+            asn1_free(*pval);
             break;
 
         default:
@@ -14,6 +14,7 @@
 #include <openssl/asn1t.h>
 #include <string.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 
 static int asn1_primitive_new(ASN1_VALUE **pval, const ASN1_ITEM *it);
@@ -78,7 +79,7 @@ int ASN1_item_ex_new(ASN1_VALUE **pval, const ASN1_ITEM *it)
                 if (i == 2)
                     return 1;
             }
-            *pval = calloc(1, it->size);
+            *pval = asn1_calloc(1, it->size);
             if (*pval == NULL)
                 goto memerr;
             asn1_set_choice_selector(pval, -1, it);
@@ -95,7 +96,7 @@ int ASN1_item_ex_new(ASN1_VALUE **pval, const ASN1_ITEM *it)
                 if (i == 2)
                     return 1;
             }
-            *pval = calloc(1, it->size);
+            *pval = asn1_calloc(1, it->size);
             if (*pval == NULL)
                 goto memerr;
             asn1_do_lock(pval, 0, it);
@@ -230,7 +231,7 @@ int asn1_primitive_new(ASN1_VALUE **pval, const ASN1_ITEM *it)
             return 1;
 
         case V_ASN1_ANY:
-            typ = malloc(sizeof(ASN1_TYPE));
+            typ = asn1_malloc(sizeof(ASN1_TYPE));
             if (typ != NULL) {
                 typ->value.ptr = NULL;
                 typ->type = V_ASN1_UNDEF;
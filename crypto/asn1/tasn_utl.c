@@ -14,6 +14,7 @@
 #include <openssl/objects.h>
 #include <openssl/err.h>
 
+#include "internal/asn1_int.h"
 #include "asn1_locl.h"
 #include "internal/threads.h"
 
@@ -105,7 +106,7 @@ void asn1_enc_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
     enc = asn1_get_enc_ptr(pval, it);
     if (enc) {
         if (enc->enc)
-            free(enc->enc);
+            asn1_free(enc->enc);
         enc->enc = NULL;
         enc->len = 0;
         enc->modified = 1;
@@ -121,8 +122,8 @@ int asn1_enc_save(ASN1_VALUE **pval, const uint8_t *in, int inlen,
         return 1;
 
     if (enc->enc)
-        free(enc->enc);
-    enc->enc = malloc(inlen);
+        asn1_free(enc->enc);
+    enc->enc = asn1_malloc(inlen);
     if (!enc->enc)
         return 0;
     memcpy(enc->enc, in, inlen);
@@ -8,18 +8,52 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <openssl/asn1t.h>
 #include <openssl/err.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 
+#include <stdcompat.h>
+
 #include "asn1_locl.h"
 #include "internal/threads.h"
 
 static int X509_REVOKED_cmp(const X509_REVOKED *const *a,
                             const X509_REVOKED *const *b);
 static void setup_idp(X509_CRL *crl, ISSUING_DIST_POINT *idp);
+static int crl_index_build(X509_CRL *crl);
+static void crl_index_free(X509_CRL *crl);
+
+/*
+ * The revoked entries of a decoded CRL are indexed by serial number once,
+ * so that lookups are a binary search over a flat array that is never
+ * written afterwards and needs no lock. Each entry carries a key made of
+ * the serial length and its leading bytes, which settles almost every
+ * comparison without touching the ASN1_INTEGER.
+ *
+ * The index only removes the lock and the sort from the lookup path. Every
+ * entry is still decoded in full into the revoked stack, and the index adds
+ * a slot per entry and a sort to each decode, so a CRL takes somewhat more
+ * memory and time to load than without it.
+ *
+ * The revoked stack is public and callers may still change it through
+ * X509_CRL_get_REVOKED, so an entry is only used while the stack holds the
+ * same pointer at the same position. Anything else makes the lookup fall
+ * back to searching the stack.
+ */
+typedef struct {
+    uint64_t key;
+    X509_REVOKED *rev;
+    int pos;
+} X509_CRL_INDEX_ENTRY;
+
+struct x509_crl_index_st {
+    STACK_OF(X509_REVOKED) *revoked;
+    size_t num;
+    X509_CRL_INDEX_ENTRY *entries;
+};
 
 ASN1_SEQUENCE(X509_REVOKED) = {
     ASN1_SIMPLE(X509_REVOKED, serialNumber, ASN1_INTEGER),
@@ -165,6 +199,7 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
             crl->issuers = NULL;
             crl->crl_number = NULL;
             crl->base_crl_number = NULL;
+            crl->revoked_index = NULL;
             break;
 
         case ASN1_OP_D2I_POST:
@@ -217,6 +252,9 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
             if (!crl_set_issuers(crl))
                 return 0;
 
+            if (!crl_index_build(crl))
+                return 0;
+
             if (crl->meth->crl_init) {
                 if (crl->meth->crl_init(crl) == 0)
                     return 0;
@@ -235,6 +273,7 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
             ASN1_INTEGER_free(crl->crl_number);
             ASN1_INTEGER_free(crl->base_crl_number);
             sk_GENERAL_NAMES_pop_free(crl->issuers, GENERAL_NAMES_free);
+            crl_index_free(crl);
             break;
     }
     return 1;
@@ -329,6 +368,17 @@ X509_CRL *d2i_X509_CRL(X509_CRL **a, const uint8_t **in, long len)
     return (X509_CRL *)ASN1_item_d2i((ASN1_VALUE **)a, in, len, ASN1_ITEM_rptr(X509_CRL));
 }
 
+X509_CRL *d2i_X509_CRL_arena(ASN1_ARENA *arena, const uint8_t **in, long len)
+{
+    X509_CRL *ret;
+
+    ret = (X509_CRL *)ASN1_item_d2i_arena(arena, in, len,
+                                          ASN1_ITEM_rptr(X509_CRL));
+    if (ret != NULL)
+        ret->flags |= EXFLAG_ARENA;
+    return ret;
+}
+
 int i2d_X509_CRL(X509_CRL *a, uint8_t **out)
 {
     return ASN1_item_i2d((ASN1_VALUE *)a, out, ASN1_ITEM_rptr(X509_CRL));
@@ -341,6 +391,9 @@ X509_CRL *X509_CRL_new(void)
 
 void X509_CRL_free(X509_CRL *a)
 {
+    /* ASN1_ARENA_free releases arena CRLs along with the arena. */
+    if (a != NULL && (a->flags & EXFLAG_ARENA))
+        return;
     ASN1_item_free((ASN1_VALUE *)a, ASN1_ITEM_rptr(X509_CRL));
 }
 
@@ -354,6 +407,75 @@ X509_REVOKED *X509_REVOKED_dup(X509_REVOKED *rev)
     return ASN1_item_dup(ASN1_ITEM_rptr(X509_REVOKED), rev);
 }
 
+static uint64_t crl_index_key(const ASN1_INTEGER *serial)
+{
+    uint64_t key;
+    int i;
+
+    key = (uint64_t)(serial->length < 0xff ? serial->length : 0xff) << 56;
+    for (i = 0; i < 7 && i < serial->length; i++)
+        key |= (uint64_t)serial->data[i] << (48 - 8 * i);
+    return key;
+}
+
+static int crl_index_cmp(uint64_t akey, const ASN1_INTEGER *a,
+                         uint64_t bkey, const ASN1_INTEGER *b)
+{
+    if (akey != bkey)
+        return akey < bkey ? -1 : 1;
+    return ASN1_STRING_cmp(a, b);
+}
+
+static int crl_index_entry_cmp(const void *a_, const void *b_)
+{
+    const X509_CRL_INDEX_ENTRY *a = a_, *b = b_;
+
+    return crl_index_cmp(a->key, a->rev->serialNumber,
+                         b->key, b->rev->serialNumber);
+}
+
+static int crl_index_build(X509_CRL *crl)
+{
+    STACK_OF(X509_REVOKED) *revoked = crl->crl->revoked;
+    struct x509_crl_index_st *index;
+    size_t i, num;
+
+    crl_index_free(crl);
+    if (sk_X509_REVOKED_num(revoked) <= 0)
+        return 1;
+    num = sk_X509_REVOKED_num(revoked);
+
+    if ((index = malloc(sizeof(*index))) == NULL)
+        return 0;
+    index->revoked = revoked;
+    index->num = num;
+    index->entries = reallocarray(NULL, num, sizeof(*index->entries));
+    if (index->entries == NULL) {
+        free(index);
+        return 0;
+    }
+    for (i = 0; i < num; i++) {
+        X509_REVOKED *rev = sk_X509_REVOKED_value(revoked, i);
+
+        index->entries[i].key = crl_index_key(rev->serialNumber);
+        index->entries[i].rev = rev;
+        index->entries[i].pos = i;
+    }
+    qsort(index->entries, num, sizeof(*index->entries), crl_index_entry_cmp);
+
+    crl->revoked_index = index;
+    return 1;
+}
+
+static void crl_index_free(X509_CRL *crl)
+{
+    if (crl->revoked_index == NULL)
+        return;
+    free(crl->revoked_index->entries);
+    free(crl->revoked_index);
+    crl->revoked_index = NULL;
+}
+
 static int X509_REVOKED_cmp(const X509_REVOKED *const *a, const X509_REVOKED *const *b)
 {
     return (ASN1_STRING_cmp(
@@ -364,6 +486,9 @@ static int X509_REVOKED_cmp(const X509_REVOKED *const *a, const X509_REVOKED *co
 int X509_CRL_add0_revoked(X509_CRL *crl, X509_REVOKED *rev)
 {
     X509_CRL_INFO *inf;
+
+    if (crl->flags & EXFLAG_ARENA)
+        return 0;
     inf = crl->crl;
     if (!inf->revoked)
         inf->revoked = sk_X509_REVOKED_new(X509_REVOKED_cmp);
@@ -371,6 +496,8 @@ int X509_CRL_add0_revoked(X509_CRL *crl, X509_REVOKED *rev)
         ASN1err(ASN1_F_X509_CRL_ADD0_REVOKED, ERR_R_MALLOC_FAILURE);
         return 0;
     }
+    /* The index no longer covers every entry: use the stack from now on */
+    crl_index_free(crl);
     inf->enc.modified = 1;
     return 1;
 }
@@ -431,10 +558,80 @@ static int crl_revoked_issuer_match(X509_CRL *crl, X509_NAME *nm,
     return 0;
 }
 
+static int crl_revoked_found(X509_REVOKED **ret, X509_REVOKED *rev)
+{
+    if (ret)
+        *ret = rev;
+    if (rev->reason == CRL_REASON_REMOVE_FROM_CRL)
+        return 2;
+    return 1;
+}
+
+/*
+ * crl_index_get returns the revoked entry that |e| refers to, or NULL if the
+ * stack no longer holds it where the index was built.
+ */
+static X509_REVOKED *crl_index_get(const X509_CRL *crl,
+                                   const X509_CRL_INDEX_ENTRY *e)
+{
+    X509_REVOKED *rev = sk_X509_REVOKED_value(crl->crl->revoked, e->pos);
+
+    if (rev == NULL || rev != e->rev ||
+        crl_index_key(rev->serialNumber) != e->key)
+        return NULL;
+    return rev;
+}
+
+/*
+ * crl_index_lookup searches the serial number index of |crl|. It returns -1
+ * if the revoked stack has changed since the index was built.
+ */
+static int crl_index_lookup(X509_CRL *crl, X509_REVOKED **ret,
+                            ASN1_INTEGER *serial, X509_NAME *issuer)
+{
+    const struct x509_crl_index_st *index = crl->revoked_index;
+    X509_REVOKED *rev;
+    uint64_t key = crl_index_key(serial);
+    size_t lo = 0, hi = index->num, mid;
+
+    if (crl->crl->revoked != index->revoked ||
+        (size_t)sk_X509_REVOKED_num(crl->crl->revoked) != index->num)
+        return -1;
+
+    /* Find the first entry not below |serial| */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if ((rev = crl_index_get(crl, &index->entries[mid])) == NULL)
+            return -1;
+        if (crl_index_cmp(index->entries[mid].key, rev->serialNumber, key,
+                          serial) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Several entries may share a serial in an indirect CRL */
+    for (; lo < index->num; lo++) {
+        if ((rev = crl_index_get(crl, &index->entries[lo])) == NULL)
+            return -1;
+        if (crl_index_cmp(index->entries[lo].key, rev->serialNumber, key,
+                          serial) != 0)
+            return 0;
+        if (crl_revoked_issuer_match(crl, issuer, rev))
+            return crl_revoked_found(ret, rev);
+    }
+    return 0;
+}
+
 static int def_crl_lookup(X509_CRL *crl, X509_REVOKED **ret, ASN1_INTEGER *serial, X509_NAME *issuer)
 {
     X509_REVOKED rtmp, *rev;
     int idx;
+
+    if (crl->revoked_index != NULL &&
+        (idx = crl_index_lookup(crl, ret, serial, issuer)) >= 0)
+        return idx;
+
     rtmp.serialNumber = serial;
     /* Sort revoked into serial number order if not already sorted.
      * Do this under a lock to avoid race condition.
@@ -452,13 +649,8 @@ static int def_crl_lookup(X509_CRL *crl, X509_REVOKED **ret, ASN1_INTEGER *seria
         rev = sk_X509_REVOKED_value(crl->crl->revoked, idx);
         if (ASN1_INTEGER_cmp(rev->serialNumber, serial))
             return 0;
-        if (crl_revoked_issuer_match(crl, issuer, rev)) {
-            if (ret)
-                *ret = rev;
-            if (rev->reason == CRL_REASON_REMOVE_FROM_CRL)
-                return 2;
-            return 1;
-        }
+        if (crl_revoked_issuer_match(crl, issuer, rev))
+            return crl_revoked_found(ret, rev);
     }
     return 0;
 }
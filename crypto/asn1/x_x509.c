@@ -101,6 +101,16 @@ X509 *d2i_X509(X509 **a, const uint8_t **in, long len)
     return (X509 *)ASN1_item_d2i((ASN1_VALUE **)a, in, len, ASN1_ITEM_rptr(X509));
 }
 
+X509 *d2i_X509_arena(ASN1_ARENA *arena, const uint8_t **in, long len)
+{
+    X509 *ret;
+
+    ret = (X509 *)ASN1_item_d2i_arena(arena, in, len, ASN1_ITEM_rptr(X509));
+    if (ret != NULL)
+        ret->ex_flags |= EXFLAG_ARENA;
+    return ret;
+}
+
 int i2d_X509(X509 *a, uint8_t **out)
 {
     return ASN1_item_i2d((ASN1_VALUE *)a, out, ASN1_ITEM_rptr(X509));
@@ -113,6 +123,9 @@ X509 *X509_new(void)
 
 void X509_free(X509 *a)
 {
+    /* ASN1_ARENA_free releases arena certificates along with the arena. */
+    if (a != NULL && (a->ex_flags & EXFLAG_ARENA))
+        return;
     ASN1_item_free((ASN1_VALUE *)a, ASN1_ITEM_rptr(X509));
 }
 
@@ -11,10 +11,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <stdcompat.h>
 
 #include "bn_lcl.h"
+#include "internal/threads.h"
 
 #if !defined(BN_CTX_DEBUG) && !defined(BN_DEBUG)
 #ifndef NDEBUG
@@ -38,6 +40,8 @@
 #define BN_CTX_POOL_SIZE 16
 /* The stack frame info is resizing, set a first-time expansion size; */
 #define BN_CTX_START_FRAMES 32
+/* How many contexts each thread keeps for BN_CTX_new_cached(); */
+#define BN_CTX_THREAD_CACHE_SIZE 4
 
 /***********/
 /* BN_POOL */
@@ -100,8 +104,20 @@ struct bignum_ctx {
     int err_stack;
     /* Block "gets" until an "end" (compatibility behaviour) */
     int too_many;
+    /* Set if the context belongs to a thread's cache */
+    int cached;
+    /* Set while a cached context is handed out */
+    int in_use;
 };
 
+/* The contexts kept by a thread for BN_CTX_new_cached() */
+typedef struct bignum_ctx_cache {
+    BN_CTX *ctx[BN_CTX_THREAD_CACHE_SIZE];
+} BN_CTX_CACHE;
+
+static CRYPTO_ONCE bn_ctx_cache_once = CRYPTO_ONCE_STATIC_INIT;
+static CRYPTO_THREAD_LOCAL bn_ctx_cache_local;
+
 /* Enable this to find BN_CTX bugs */
 #ifdef BN_CTX_DEBUG
 static const char *ctxdbg_cur = NULL;
@@ -176,13 +192,102 @@ BN_CTX *BN_CTX_new(void)
     ret->used = 0;
     ret->err_stack = 0;
     ret->too_many = 0;
+    ret->cached = 0;
+    ret->in_use = 0;
     return ret;
 }
 
+static void bn_ctx_cache_free(void *arg)
+{
+    BN_CTX_CACHE *cache = arg;
+    int i;
+
+    if (cache == NULL)
+        return;
+    for (i = 0; i < BN_CTX_THREAD_CACHE_SIZE; i++) {
+        if (cache->ctx[i] != NULL) {
+            cache->ctx[i]->cached = 0;
+            BN_CTX_free(cache->ctx[i]);
+        }
+    }
+    free(cache);
+}
+
+static void bn_ctx_cache_init(void)
+{
+    CRYPTO_thread_init_local(&bn_ctx_cache_local, bn_ctx_cache_free);
+}
+
+BN_CTX *BN_CTX_new_cached(void)
+{
+    BN_CTX_CACHE *cache;
+    BN_CTX *ctx;
+    int i;
+
+    CRYPTO_thread_run_once(&bn_ctx_cache_once, bn_ctx_cache_init);
+    cache = CRYPTO_thread_get_local(&bn_ctx_cache_local);
+    if (cache == NULL) {
+        cache = calloc(1, sizeof(BN_CTX_CACHE));
+        if (cache == NULL ||
+            !CRYPTO_thread_set_local(&bn_ctx_cache_local, cache)) {
+            free(cache);
+            return BN_CTX_new();
+        }
+    }
+
+    for (i = 0; i < BN_CTX_THREAD_CACHE_SIZE; i++) {
+        if ((ctx = cache->ctx[i]) == NULL) {
+            if ((ctx = BN_CTX_new()) == NULL)
+                return NULL;
+            ctx->cached = 1;
+            cache->ctx[i] = ctx;
+        }
+        if (!ctx->in_use) {
+            ctx->in_use = 1;
+            return ctx;
+        }
+    }
+
+    /* Deeply nested callers get a context of their own */
+    return BN_CTX_new();
+}
+
+/*
+ * bn_ctx_release returns a cached context to its thread, clearing the values
+ * left in it but keeping their storage for the next operation.
+ */
+static void bn_ctx_release(BN_CTX *ctx)
+{
+    BN_POOL_ITEM *item;
+    BIGNUM *bn;
+    unsigned int i;
+
+    for (item = ctx->pool.head; item != NULL; item = item->next) {
+        for (i = 0, bn = item->vals; i < BN_CTX_POOL_SIZE; i++, bn++) {
+            if (bn->d != NULL)
+                vigortls_zeroize(bn->d, bn->dmax * sizeof(bn->d[0]));
+            bn->top = 0;
+            bn->neg = 0;
+            bn->flags &= ~BN_FLG_CONSTTIME;
+        }
+    }
+    ctx->pool.current = ctx->pool.head;
+    ctx->pool.used = 0;
+    ctx->stack.depth = 0;
+    ctx->used = 0;
+    ctx->err_stack = 0;
+    ctx->too_many = 0;
+    ctx->in_use = 0;
+}
+
 void BN_CTX_free(BN_CTX *ctx)
 {
     if (ctx == NULL)
         return;
+    if (ctx->cached) {
+        bn_ctx_release(ctx);
+        return;
+    }
 #ifdef BN_CTX_DEBUG
     {
         BN_POOL_ITEM *pool = ctx->pool.head;
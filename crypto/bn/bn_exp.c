@@ -615,9 +615,11 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
     /* Get the window size to use with size of p. */
     window = BN_window_bits_for_ctime_exponent_size(bits);
 #if defined(OPENSSL_BN_ASM_MONT5)
-    if (window == 6 && bits <= 1024) {
-        window = 5; /* ~5% improvement for RSA2048 sign, and even for RSA4096 */
-        /* reserve space for mont->N.d[] copy */
+    /* The assembly below only takes a window of 5, but beats the C loop
+     * with a window of 6 at every size, including the primes of RSA-4096
+     * and multi-prime keys. It needs space for a copy of mont->N.d[]. */
+    if (window >= 5) {
+        window = 5;
         powerbufLen += top * sizeof(mont->N.d[0]);
     }
 #endif
@@ -635,18 +637,21 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
         powerbufFree = alloca(powerbufLen + MOD_EXP_CTIME_MIN_CACHE_LINE_WIDTH);
     else
 #endif
-        if ((powerbufFree
-             = malloc(powerbufLen + MOD_EXP_CTIME_MIN_CACHE_LINE_WIDTH)) == NULL)
-        goto err;
+    {
+        /* Larger tables are taken from |ctx|, so that a context which is
+         * reused keeps its storage between exponentiations */
+        BIGNUM *buf = BN_CTX_get(ctx);
+
+        if (buf == NULL ||
+            bn_wexpand(buf, (powerbufLen + MOD_EXP_CTIME_MIN_CACHE_LINE_WIDTH) /
+                                sizeof(BN_ULONG) + 1) == NULL)
+            goto err;
+        powerbufFree = (uint8_t *)buf->d;
+    }
 
     powerbuf = MOD_EXP_CTIME_ALIGN(powerbufFree);
     memset(powerbuf, 0, powerbufLen);
 
-#ifdef alloca
-    if (powerbufLen < 3072)
-        powerbufFree = NULL;
-#endif
-
     /* lay down tmp and am right after powers table */
     tmp.d = (BN_ULONG *)(powerbuf + sizeof(m->d[0]) * top * numPowers);
     am.d = tmp.d + top;
@@ -860,11 +865,8 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
 err:
     if ((in_mont == NULL) && (mont != NULL))
         BN_MONT_CTX_free(mont);
-    if (powerbuf != NULL) {
+    if (powerbuf != NULL)
         vigortls_zeroize(powerbuf, powerbufLen);
-        if (powerbufFree)
-            free(powerbufFree);
-    }
     BN_CTX_end(ctx);
     return (ret);
 }
@@ -8,11 +8,14 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <openssl/err.h>
 
 #include "bn_lcl.h"
+#include "internal/threads.h"
 
 /* NB: these functions have been "upgraded", the deprecated versions (which are
  * compatibility wrappers using these functions) are in bn_depr.c.
@@ -25,13 +28,65 @@
  */
 #include "bn_prime.h"
 
+/*
+ * Candidates are sieved SIEVE_WINDOW at a time, each |step| apart, by ruling
+ * out those that the odd primes below SIEVE_LIMIT show to be composite. The
+ * residues of the first window are found a word at a time, and those of each
+ * window after it by addition, so that a long search (as for a safe prime)
+ * divides the big number just once.
+ */
+#define SIEVE_LIMIT 65536
+#define SIEVE_NUM_PRIMES 6541 /* the odd primes below SIEVE_LIMIT */
+#define SIEVE_WINDOW 16384
+
+static uint16_t sieve_primes[SIEVE_NUM_PRIMES];
+
+/* Runs of sieve_primes whose product is small enough for BN_mod_word */
+static struct {
+    BN_ULONG product;
+    int start, num;
+} sieve_groups[SIEVE_NUM_PRIMES];
+static int sieve_num_groups;
+
+static CRYPTO_ONCE sieve_once = CRYPTO_ONCE_STATIC_INIT;
+
+/* A prime search, which may be shared by several threads. */
+typedef struct {
+    int bits, safe, checks;
+    const BIGNUM *add, *rem;
+    int stop;           /* set once a prime is found or the search fails */
+    int count;          /* the candidates tried by every thread */
+    CRYPTO_MUTEX *lock; /* for the atomics where the compiler has none */
+} PRIME_SEARCH;
+
+/*
+ * One thread's window of candidates. In a search for a safe prime p, the
+ * candidates are the values of (p-1)/2.
+ */
+typedef struct {
+    BIGNUM *base;  /* the first candidate in the window */
+    BIGNUM *step;  /* the distance between candidates */
+    BIGNUM *wstep; /* the distance between windows */
+    int num;       /* how many of sieve_primes are used */
+    int ones;      /* whether to rule out candidates one above a multiple */
+    uint16_t res[SIEVE_NUM_PRIMES];  /* base modulo each prime */
+    uint16_t wres[SIEVE_NUM_PRIMES]; /* wstep modulo each prime */
+    uint16_t inv[SIEVE_NUM_PRIMES];  /* the inverse of step, or zero */
+    uint8_t composite[SIEVE_WINDOW / 8];
+    int next; /* the next candidate in the window to look at */
+} PRIME_SIEVE;
+
+typedef struct {
+    PRIME_SEARCH *search;
+    BIGNUM *prime;
+    int ret;
+    CRYPTO_THREAD thread;
+} PRIME_WORKER;
+
 static int witness(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
                    const BIGNUM *a1_odd, int k, BN_CTX *ctx, BN_MONT_CTX *mont);
-static int probable_prime(BIGNUM *rnd, int bits);
-static int probable_prime_dh(BIGNUM *rnd, int bits,
-                             const BIGNUM *add, const BIGNUM *rem, BN_CTX *ctx);
-static int probable_prime_dh_safe(BIGNUM *rnd, int bits,
-                                  const BIGNUM *add, const BIGNUM *rem, BN_CTX *ctx);
+static void sieve_init(void);
+static int prime_search(PRIME_SEARCH *search, BIGNUM *ret, BN_GENCB *cb);
 
 int BN_GENCB_call(BN_GENCB *cb, int a, int b)
 {
@@ -47,6 +102,8 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b)
             return 1;
         case 2:
             /* New-style callbacks */
+            if (!cb->cb.cb_2)
+                return 1;
             return cb->cb.cb_2(a, b, cb);
         default:
             break;
@@ -55,14 +112,22 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b)
     return 0;
 }
 
+static void *prime_worker(void *arg)
+{
+    PRIME_WORKER *worker = arg;
+
+    /* The callback is left to the thread that started the search */
+    worker->ret = prime_search(worker->search, worker->prime, NULL);
+    ERR_remove_thread_state(NULL);
+    return NULL;
+}
+
 int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
                          const BIGNUM *add, const BIGNUM *rem, BN_GENCB *cb)
 {
-    BIGNUM *t;
-    int found = 0;
-    int i, j, c1 = 0;
-    BN_CTX *ctx;
-    int checks;
+    PRIME_SEARCH search;
+    PRIME_WORKER *workers = NULL;
+    int i, r, found = 0, threads = 0, num_workers = 0;
 
     if (bits < 2 || (bits == 2 && safe)) {
         /*
@@ -72,74 +137,60 @@ int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
         BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_BITS_TOO_SMALL);
         return 0;
     }
-        
-
-    if ((ctx = BN_CTX_new()) == NULL)
-        goto err;
-    BN_CTX_start(ctx);
-    if ((t = BN_CTX_get(ctx)) == NULL)
-        goto err;
 
-    checks = BN_prime_checks_for_size(bits);
+    if (!CRYPTO_thread_run_once(&sieve_once, sieve_init))
+        return 0;
 
-loop:
-    /* make a random number and set the top and bottom bits */
-    if (add == NULL) {
-        if (!probable_prime(ret, bits))
+    memset(&search, 0, sizeof(search));
+    search.bits = bits;
+    search.safe = safe;
+    search.checks = BN_prime_checks_for_size(bits);
+    search.add = add;
+    search.rem = rem;
+
+    if (cb != NULL)
+        threads = cb->threads;
+    if (threads > BN_GENCB_MAX_THREADS)
+        threads = BN_GENCB_MAX_THREADS;
+    if (threads > 1) {
+        if ((search.lock = CRYPTO_thread_new()) == NULL ||
+            (workers = calloc(threads - 1, sizeof(*workers))) == NULL) {
+            BNerr(BN_F_BN_GENERATE_PRIME_EX, ERR_R_MALLOC_FAILURE);
             goto err;
-    } else {
-        if (safe) {
-            if (!probable_prime_dh_safe(ret, bits, add, rem, ctx))
-                goto err;
-        } else {
-            if (!probable_prime_dh(ret, bits, add, rem, ctx))
-                goto err;
+        }
+        /* The other threads only help, so the search goes on without them */
+        for (; num_workers < threads - 1; num_workers++) {
+            PRIME_WORKER *worker = &workers[num_workers];
+
+            worker->search = &search;
+            if ((worker->prime = BN_new()) == NULL)
+                break;
+            if (!CRYPTO_thread_spawn(&worker->thread, prime_worker, worker)) {
+                BN_free(worker->prime);
+                worker->prime = NULL;
+                break;
+            }
         }
     }
-    /* if (BN_mod_word(ret,(BN_ULONG)3) == 1) goto loop; */
-    if (!BN_GENCB_call(cb, 0, c1++))
-        /* aborted */
-        goto err;
-
-    if (!safe) {
-        i = BN_is_prime_fasttest_ex(ret, checks, ctx, 0, cb);
-        if (i == -1)
-            goto err;
-        if (i == 0)
-            goto loop;
-    } else {
-        /* for "safe prime" generation,
-         * check that (p-1)/2 is prime.
-         * Since a prime is odd, We just
-         * need to divide by 2 */
-        if (!BN_rshift1(t, ret))
-            goto err;
-
-        for (i = 0; i < checks; i++) {
-            j = BN_is_prime_fasttest_ex(ret, 1, ctx, 0, cb);
-            if (j == -1)
-                goto err;
-            if (j == 0)
-                goto loop;
-
-            j = BN_is_prime_fasttest_ex(t, 1, ctx, 0, cb);
-            if (j == -1)
-                goto err;
-            if (j == 0)
-                goto loop;
 
-            if (!BN_GENCB_call(cb, 2, c1 - 1))
-                goto err;
-            /* We have a safe prime test pass */
-        }
+    r = prime_search(&search, ret, cb);
+    if (r == 1)
+        found = 1;
+    for (i = 0; i < num_workers; i++) {
+        CRYPTO_thread_join(workers[i].thread);
+        if (r == -1 && workers[i].ret == 1)
+            found = BN_copy(ret, workers[i].prime) != NULL;
     }
-    /* we have a prime :-) */
-    found = 1;
+    if (r == -1 && !found)
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, ERR_R_INTERNAL_ERROR);
+
 err:
-    if (ctx != NULL) {
-        BN_CTX_end(ctx);
-        BN_CTX_free(ctx);
+    if (workers != NULL) {
+        for (i = 0; i < num_workers; i++)
+            BN_clear_free(workers[i].prime);
+        free(workers);
     }
+    CRYPTO_thread_cleanup(search.lock);
     bn_check_top(ret);
     return found;
 }
@@ -276,139 +327,353 @@ static int witness(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
     return 1;
 }
 
-static int probable_prime(BIGNUM *rnd, int bits)
+
+static void sieve_init(void)
 {
-    int i;
-    prime_t mods[NUMPRIMES];
-    BN_ULONG delta, maxdelta;
-
-again:
-    if (!BN_rand(rnd, bits, 1, 1))
-        return (0);
-    /* we now have a random number 'rand' to test. */
-    for (i = 1; i < NUMPRIMES; i++)
-        mods[i] = (prime_t)BN_mod_word(rnd, (BN_ULONG)primes[i]);
-    maxdelta = BN_MASK2 - primes[NUMPRIMES - 1];
-    delta = 0;
-loop:
-    for (i = 1; i < NUMPRIMES; i++) {
-        /* check that rnd is not a prime and also
-         * that gcd(rnd-1,primes) == 1 (except for 2) */
-        if (((mods[i] + delta) % primes[i]) <= 1) {
-            delta += 2;
-            if (delta > maxdelta)
-                goto again;
-            goto loop;
+    uint8_t composite[SIEVE_LIMIT / 16]; /* one bit for each odd number */
+    int i, j, n = 0, g = -1;
+
+    memset(composite, 0, sizeof(composite));
+    for (i = 3; i < SIEVE_LIMIT; i += 2) {
+        if (composite[i >> 4] & (1 << ((i >> 1) & 7)))
+            continue;
+        if (i < SIEVE_LIMIT / i) {
+            for (j = i * i; j < SIEVE_LIMIT; j += 2 * i)
+                composite[j >> 4] |= 1 << ((j >> 1) & 7);
         }
+        sieve_primes[n] = i;
+
+        /* BN_mod_word is quickest with a divisor of half a word */
+        if (g < 0 ||
+            sieve_groups[g].product > ((BN_ULONG)1 << BN_BITS4) / i) {
+            g++;
+            sieve_groups[g].product = 1;
+            sieve_groups[g].start = n;
+            sieve_groups[g].num = 0;
+        }
+        sieve_groups[g].product *= i;
+        sieve_groups[g].num++;
+        n++;
     }
-    if (!BN_add_word(rnd, delta))
-        return (0);
-    bn_check_top(rnd);
-    return (1);
+    sieve_num_groups = g + 1;
 }
 
-static int probable_prime_dh(BIGNUM *rnd, int bits,
-                             const BIGNUM *add, const BIGNUM *rem, BN_CTX *ctx)
+/* sieve_residues sets |res| to |a| modulo each of the first |num| primes. */
+static void sieve_residues(uint16_t *res, const BIGNUM *a, int num)
 {
-    int i, ret = 0;
-    BIGNUM *t1;
+    BN_ULONG m;
+    int i, j, end;
+
+    for (i = 0; i < sieve_num_groups && sieve_groups[i].start < num; i++) {
+        m = BN_mod_word(a, sieve_groups[i].product);
+        end = sieve_groups[i].start + sieve_groups[i].num;
+        for (j = sieve_groups[i].start; j < end && j < num; j++)
+            res[j] = m % sieve_primes[j];
+    }
+}
 
-    BN_CTX_start(ctx);
-    if ((t1 = BN_CTX_get(ctx)) == NULL)
-        goto err;
+/* sieve_inverse returns the inverse of |a| modulo the prime |p|. */
+static uint16_t sieve_inverse(uint32_t a, uint32_t p)
+{
+    int32_t t = 0, new_t = 1, tmp;
+    uint32_t r = p, new_r = a, q, tmp_r;
+
+    while (new_r != 0) {
+        q = r / new_r;
+        tmp = t - (int32_t)q * new_t;
+        t = new_t;
+        new_t = tmp;
+        tmp_r = r - q * new_r;
+        r = new_r;
+        new_r = tmp_r;
+    }
+    if (t < 0)
+        t += p;
+    return (uint16_t)t;
+}
 
-    if (!BN_rand(rnd, bits, 0, 1))
-        goto err;
+/*
+ * sieve_fill marks the candidates in the window that are divisible by one of
+ * the sieve primes, or whose safe prime would be. It returns zero if every
+ * candidate, in this window and all others, is composite.
+ */
+static int sieve_fill(PRIME_SIEVE *sieve, int safe)
+{
+    uint32_t p, r, k, ruled_out[2];
+    int i, j, num_ruled_out;
+
+    memset(sieve->composite, 0, sizeof(sieve->composite));
+    sieve->next = 0;
+    for (i = 0; i < sieve->num; i++) {
+        p = sieve_primes[i];
+        r = sieve->res[i];
+        ruled_out[0] = 0;
+        num_ruled_out = 1;
+        if (safe)
+            ruled_out[num_ruled_out++] = (p - 1) / 2; /* 2r + 1 == 0 */
+        else if (sieve->ones)
+            ruled_out[num_ruled_out++] = 1;
+
+        if (sieve->inv[i] == 0) {
+            /* p divides the step, so every candidate has the same residue */
+            if (r == 0 || (safe && r == ruled_out[1]))
+                return 0;
+            continue;
+        }
+        for (j = 0; j < num_ruled_out; j++) {
+            k = (ruled_out[j] + p - r) % p * sieve->inv[i] % p;
+            for (; k < SIEVE_WINDOW; k += p)
+                sieve->composite[k >> 3] |= 1 << (k & 7);
+        }
+    }
+    return 1;
+}
 
-    /* we need ((rnd-rem) % add) == 0 */
+/* sieve_reseed starts |sieve| again from a random window. */
+static int sieve_reseed(PRIME_SIEVE *sieve, const PRIME_SEARCH *search,
+                        BN_CTX *ctx)
+{
+    const BIGNUM *add = search->add;
+    BIGNUM *t;
+    int ret = 0;
 
-    if (!BN_mod(t1, rnd, add, ctx))
-        goto err;
-    if (!BN_sub(rnd, rnd, t1))
+    BN_CTX_start(ctx);
+    if ((t = BN_CTX_get(ctx)) == NULL)
         goto err;
-    if (rem == NULL) {
-        if (!BN_add_word(rnd, 1))
+
+    if (search->safe) {
+        if (!BN_rand(sieve->base, search->bits - 1, 0, 1))
+            goto err;
+    } else if (add == NULL) {
+        if (!BN_rand(sieve->base, search->bits, 1, 1))
             goto err;
     } else {
-        if (!BN_add(rnd, rnd, rem))
+        if (!BN_rand(sieve->base, search->bits, 0, 1))
             goto err;
     }
 
-/* we now have a random number 'rand' to test. */
-
-loop:
-    for (i = 1; i < NUMPRIMES; i++) {
-        /* check that rnd is a prime */
-        if (BN_mod_word(rnd, (BN_ULONG)primes[i]) <= 1) {
-            if (!BN_add(rnd, rnd, add))
+    if (add != NULL) {
+        /* We need ((base - rem) % add) == 0, or half that for a safe prime */
+        if (!BN_mod(t, sieve->base, sieve->step, ctx))
+            goto err;
+        if (!BN_sub(sieve->base, sieve->base, t))
+            goto err;
+        if (search->rem == NULL) {
+            if (!BN_add_word(sieve->base, 1))
+                goto err;
+        } else if (search->safe) {
+            if (!BN_rshift1(t, search->rem))
+                goto err;
+            if (!BN_add(sieve->base, sieve->base, t))
+                goto err;
+        } else {
+            if (!BN_add(sieve->base, sieve->base, search->rem))
                 goto err;
-            goto loop;
         }
     }
+
+    sieve_residues(sieve->res, sieve->base, sieve->num);
+    if (!sieve_fill(sieve, search->safe)) {
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_NO_SOLUTION);
+        goto err;
+    }
     ret = 1;
+
 err:
     BN_CTX_end(ctx);
-    bn_check_top(rnd);
-    return (ret);
+    return ret;
 }
 
-static int probable_prime_dh_safe(BIGNUM *p, int bits, const BIGNUM *padd,
-                                  const BIGNUM *rem, BN_CTX *ctx)
+static PRIME_SIEVE *sieve_new(const PRIME_SEARCH *search, BN_CTX *ctx)
 {
-    int i, ret = 0;
-    BIGNUM *t1, *qadd, *q;
+    PRIME_SIEVE *sieve;
+    int i;
 
-    bits--;
-    BN_CTX_start(ctx);
-    t1 = BN_CTX_get(ctx);
-    q = BN_CTX_get(ctx);
-    qadd = BN_CTX_get(ctx);
-    if (qadd == NULL)
+    if ((sieve = calloc(1, sizeof(*sieve))) == NULL) {
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    sieve->base = BN_CTX_get(ctx);
+    sieve->step = BN_CTX_get(ctx);
+    sieve->wstep = BN_CTX_get(ctx);
+    if (sieve->wstep == NULL)
         goto err;
 
-    if (!BN_rshift1(qadd, padd))
+    if (search->add == NULL) {
+        if (!BN_set_word(sieve->step, 2))
+            goto err;
+    } else if (search->safe) {
+        if (!BN_rshift1(sieve->step, search->add))
+            goto err;
+    } else {
+        if (BN_copy(sieve->step, search->add) == NULL)
+            goto err;
+    }
+    if (BN_is_zero(sieve->step)) {
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_INVALID_RANGE);
         goto err;
-
-    if (!BN_rand(q, bits, 0, 1))
+    }
+    if (BN_copy(sieve->wstep, sieve->step) == NULL ||
+        !BN_mul_word(sieve->wstep, SIEVE_WINDOW))
         goto err;
 
-    /* we need ((rnd-rem) % add) == 0 */
-    if (!BN_mod(t1, q, qadd, ctx))
+    /*
+     * A small candidate may be one of the sieve primes, so only primes below
+     * the smallest candidate are used. Ruling out candidates one above a
+     * prime keeps p-1 free of small factors, but leaves too few candidates
+     * when they are small.
+     */
+    while (sieve->num < SIEVE_NUM_PRIMES &&
+           (search->bits > 17 ||
+            sieve_primes[sieve->num] < 1U << (search->bits - 2)))
+        sieve->num++;
+    sieve->ones = sieve->num == SIEVE_NUM_PRIMES;
+
+    sieve_residues(sieve->inv, sieve->step, sieve->num);
+    for (i = 0; i < sieve->num; i++) {
+        sieve->wres[i] = sieve->inv[i] * SIEVE_WINDOW % sieve_primes[i];
+        if (sieve->inv[i] != 0)
+            sieve->inv[i] = sieve_inverse(sieve->inv[i], sieve_primes[i]);
+    }
+    return sieve;
+
+err:
+    free(sieve);
+    return NULL;
+}
+
+/*
+ * sieve_next sets |p| to the next candidate that the sieve has not ruled
+ * out, and |q| to (p-1)/2 in a search for a safe prime.
+ */
+static int sieve_next(PRIME_SIEVE *sieve, const PRIME_SEARCH *search,
+                      BIGNUM *p, BIGNUM *q, BN_CTX *ctx)
+{
+    BIGNUM *c = search->safe ? q : p;
+    int i;
+
+    for (;;) {
+        while (sieve->next < SIEVE_WINDOW &&
+               (sieve->composite[sieve->next >> 3] & (1 << (sieve->next & 7))))
+            sieve->next++;
+
+        if (sieve->next == SIEVE_WINDOW) {
+            /* Move on to the next window, and its residues with it */
+            if (!BN_add(sieve->base, sieve->base, sieve->wstep))
+                return 0;
+            for (i = 0; i < sieve->num; i++)
+                sieve->res[i] = ((uint32_t)sieve->res[i] + sieve->wres[i]) %
+                                sieve_primes[i];
+            sieve_fill(sieve, search->safe);
+            continue;
+        }
+
+        if (BN_copy(c, sieve->step) == NULL ||
+            !BN_mul_word(c, sieve->next++) ||
+            !BN_add(c, c, sieve->base))
+            return 0;
+        if (search->safe) {
+            if (!BN_lshift1(p, q) || !BN_add_word(p, 1))
+                return 0;
+        }
+        /* Start again from a new window if the candidates got too long */
+        if (BN_num_bits(p) > search->bits) {
+            if (!sieve_reseed(sieve, search, ctx))
+                return 0;
+            continue;
+        }
+        return 1;
+    }
+}
+
+/*
+ * prime_test runs Miller-Rabin on a candidate |p|, and on |q| = (p-1)/2 when
+ * a safe prime is wanted. It returns one if they are probably prime, zero if
+ * not and -1 on error.
+ */
+static int prime_test(const PRIME_SEARCH *search, const BIGNUM *p,
+                      const BIGNUM *q, int c1, BN_CTX *ctx, BN_GENCB *cb)
+{
+    int i, j;
+
+    if (!search->safe)
+        return BN_is_prime_fasttest_ex(p, search->checks, ctx, 0, cb);
+
+    for (i = 0; i < search->checks; i++) {
+        j = BN_is_prime_fasttest_ex(p, 1, ctx, 0, cb);
+        if (j != 1)
+            return j;
+
+        j = BN_is_prime_fasttest_ex(q, 1, ctx, 0, cb);
+        if (j != 1)
+            return j;
+
+        if (!BN_GENCB_call(cb, 2, c1))
+            return -1;
+        /* We have a safe prime test pass */
+    }
+    return 1;
+}
+
+/*
+ * prime_search looks for a prime for |search| until it or another thread
+ * finds one. It returns one if it found the prime, which is left in |ret|,
+ * -1 if another thread found it or failed, and zero on error or when |cb|
+ * stops it.
+ */
+static int prime_search(PRIME_SEARCH *search, BIGNUM *ret, BN_GENCB *cb)
+{
+    PRIME_SIEVE *sieve = NULL;
+    BN_CTX *ctx;
+    BIGNUM *q;
+    int i, c1, stop, found = 0;
+
+    if ((ctx = BN_CTX_new()) == NULL)
+        goto err;
+    BN_CTX_start(ctx);
+    if ((q = BN_CTX_get(ctx)) == NULL)
+        goto err;
+    if ((sieve = sieve_new(search, ctx)) == NULL)
         goto err;
-    if (!BN_sub(q, q, t1))
+    if (!sieve_reseed(sieve, search, ctx))
         goto err;
-    if (rem == NULL) {
-        if (!BN_add_word(q, 1))
+
+    for (;;) {
+        if (!CRYPTO_atomic_add(&search->stop, 0, &stop, search->lock))
             goto err;
-    } else {
-        if (!BN_rshift1(t1, rem))
+        if (stop) {
+            found = -1;
+            goto err;
+        }
+
+        if (!sieve_next(sieve, search, ret, q, ctx))
             goto err;
-        if (!BN_add(q, q, t1))
+        if (!CRYPTO_atomic_add(&search->count, 1, &c1, search->lock))
             goto err;
+        c1--;
+        if (!BN_GENCB_call(cb, 0, c1))
+            /* aborted */
+            goto err;
+
+        i = prime_test(search, ret, q, c1, ctx, cb);
+        if (i == -1)
+            goto err;
+        if (i == 1)
+            break;
     }
 
-    /* we now have a random number 'rand' to test. */
-    if (!BN_lshift1(p, q))
-        goto err;
-    if (!BN_add_word(p, 1))
-        goto err;
+    /* we have a prime :-) but only the first thread to find one keeps it */
+    found = CRYPTO_atomic_add_unless(&search->stop, 1, 1, &stop,
+                                     search->lock) ? 1 : -1;
 
-loop:
-    for (i = 1; i < NUMPRIMES; i++) {
-        /* check that p and q are prime */
-        /* check that for p and q
-         * gcd(p-1,primes) == 1 (except for 2) */
-        if ((BN_mod_word(p, (BN_ULONG)primes[i]) == 0) || (BN_mod_word(q, (BN_ULONG)primes[i]) == 0)) {
-            if (!BN_add(p, p, padd))
-                goto err;
-            if (!BN_add(q, q, qadd))
-                goto err;
-            goto loop;
-        }
-    }
-    ret = 1;
 err:
-    BN_CTX_end(ctx);
-    bn_check_top(p);
-    return (ret);
+    if (found == 0)
+        /* Have the other threads give up as well */
+        CRYPTO_atomic_add_unless(&search->stop, 1, 1, &stop, search->lock);
+    free(sieve);
+    if (ctx != NULL) {
+        BN_CTX_end(ctx);
+        BN_CTX_free(ctx);
+    }
+    return found;
 }
@@ -460,6 +460,12 @@ VIGORTLS_EXPORT int CBB_add_u16(CBB *cbb, uint16_t value);
  */
 VIGORTLS_EXPORT int CBB_add_u24(CBB *cbb, uint32_t value);
 
+/*
+ * CBB_add_u32 appends a 32-bit, big-endian number from |value| to |cbb|. It
+ * returns one on success and zero otherwise.
+ */
+VIGORTLS_EXPORT int CBB_add_u32(CBB *cbb, uint32_t value);
+
 /*
  * CBB_add_asn1_uint64 writes an ASN.1 INTEGER into |cbb| using |CBB_add_asn1|
  * and writes |value| in its contents. It returns one on success and zero on
@@ -224,7 +224,7 @@ static int test_get_optional_asn1_bool(void)
 
 static int test_cbb_basic(void)
 {
-    static const uint8_t kExpected[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    static const uint8_t kExpected[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
     uint8_t *buf;
     size_t buf_len;
     int ok;
@@ -238,6 +238,7 @@ static int test_cbb_basic(void)
     if (!CBB_init(&cbb, 0) || !CBB_add_u8(&cbb, 1) || !CBB_add_u16(&cbb, 0x203)
         || !CBB_add_u24(&cbb, 0x40506)
         || !CBB_add_bytes(&cbb, (const uint8_t *)"\x07\x08", 2)
+        || !CBB_add_u32(&cbb, 0x090a0b0c)
         || !CBB_finish(&cbb, &buf, &buf_len))
         return 0;
 
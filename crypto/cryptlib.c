@@ -36,6 +36,31 @@
 unsigned int OPENSSL_ia32cap_P[4] = { 0 };
 #endif
 
+/*
+ * The capability vector is filled in by a constructor in this file rather
+ * than in a file of its own: nothing references such a file, so a static
+ * link would drop it and every assembly path would see a zero vector.
+ */
+#if defined(VIGORTLS_MSVC)
+#define VIGORTLS_CDECL __cdecl
+
+#pragma section(".CRT$XCU", read)
+static void __cdecl do_crypto_init(void);
+__declspec(allocate(".CRT$XCU"))
+    void(*crypto_init_constructor)(void) = do_crypto_init;
+#else
+#define VIGORTLS_CDECL
+
+static void do_crypto_init(void) __attribute__ ((constructor));
+#endif
+
+static void VIGORTLS_CDECL do_crypto_init(void)
+{
+#if defined(VIGORTLS_X86_64) || defined(VIGORTLS_X86) || defined(VIGORTLS_ARM)
+    OPENSSL_cpuid_setup();
+#endif
+}
+
 static void OPENSSL_showfatal(const char *fmta, ...)
 {
     va_list ap;
@@ -11,6 +11,8 @@
 #include <openssl/bn.h>
 #include <openssl/dh.h>
 
+#include "dh_locl.h"
+
 /* Check that p is a safe prime and
  * if g is 2, 3 or 5, check that it is a suitable generator
  * where
@@ -91,9 +93,11 @@ int DH_check_pub_key(const DH *dh, const BIGNUM *pub_key, int *ret)
     int ok = 0;
     BIGNUM *tmp = NULL;
     BN_CTX *ctx = NULL;
+    BN_MONT_CTX *mont;
+    const DH_FIXED_BASE *fb;
 
     *ret = 0;
-    ctx = BN_CTX_new();
+    ctx = BN_CTX_new_cached();
     if (ctx == NULL)
         goto err;
     BN_CTX_start(ctx);
@@ -108,8 +112,15 @@ int DH_check_pub_key(const DH *dh, const BIGNUM *pub_key, int *ret)
         *ret |= DH_CHECK_PUBKEY_TOO_LARGE;
 
     if (dh->q != NULL) {
-        /* Check pub_key^q == 1 mod p */
-        if (!BN_mod_exp(tmp, pub_key, dh->q, dh->p, ctx))
+        /* Check pub_key^q == 1 mod p, with the Montgomery context already
+         * kept for p if there is one */
+        mont = dh->method_mont_p;
+        if (mont == NULL && (fb = dh_fixed_base_get(dh)) != NULL)
+            mont = dh_fixed_base_mont(fb);
+        if (mont != NULL) {
+            if (!BN_mod_exp_mont(tmp, pub_key, dh->q, dh->p, ctx, mont))
+                goto err;
+        } else if (!BN_mod_exp(tmp, pub_key, dh->q, dh->p, ctx))
             goto err;
         if (!BN_is_one(tmp))
             *ret |= DH_CHECK_PUBKEY_INVALID;
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Fixed-base exponentiation for the well-known DH groups, using the comb
+ * method of Lim and Lee. An exponent of n bits is written as DH_COMB_TEETH
+ * rows of d = n / DH_COMB_TEETH bits. The table holds, for every combination
+ * of rows, the product of g^(2^(row * d)), so g^x takes d squarings and d
+ * multiplications instead of a squaring for every bit of x.
+ */
+
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/dh.h>
+
+#include "dh_locl.h"
+#include "internal/threads.h"
+#include "../constant_time_locl.h"
+
+#define DH_COMB_TEETH 5
+#define DH_COMB_ENTRIES (1 << DH_COMB_TEETH)
+
+struct dh_fixed_base_st {
+    BN_MONT_CTX *mont;
+    /* Exponents of up to 'bits' bits are handled */
+    int bits;
+    /* The number of columns of the comb, 'bits' / DH_COMB_TEETH rounded up */
+    int cols;
+    /* The words in each table entry, which is the length of p */
+    int top;
+    /* DH_COMB_ENTRIES entries in Montgomery form */
+    BN_ULONG *table;
+};
+
+typedef struct dh_known_group_st {
+    BIGNUM *p;
+    BIGNUM *g;
+    int exponent_bits;
+    DH_FIXED_BASE *fb;
+} DH_KNOWN_GROUP;
+
+/*
+ * The groups whose primes are safe are given short exponents of the length
+ * RFC 7919 recommends for their security level, extended down to the
+ * smaller RFC 2409 and RFC 3526 groups. The RFC 5114 groups use their
+ * subgroup order instead.
+ */
+static const struct {
+    BIGNUM *(*get_prime)(BIGNUM *);
+    int exponent_bits;
+} dh_safe_primes[] = {
+    { get_rfc2409_prime_1024, 160 },
+    { get_rfc3526_prime_1536, 180 },
+    { get_rfc3526_prime_2048, 225 },
+    { get_rfc3526_prime_3072, 275 },
+    { get_rfc3526_prime_4096, 325 },
+    { get_rfc3526_prime_6144, 375 },
+    { get_rfc3526_prime_8192, 400 },
+};
+
+#define DH_NUM_SAFE_PRIMES (sizeof(dh_safe_primes) / sizeof(dh_safe_primes[0]))
+
+static DH *(*const dh_subgroups[])(void) = {
+    DH_get_1024_160,
+    DH_get_2048_224,
+    DH_get_2048_256,
+};
+
+#define DH_NUM_SUBGROUPS (sizeof(dh_subgroups) / sizeof(dh_subgroups[0]))
+
+static DH_KNOWN_GROUP dh_known_groups[DH_NUM_SAFE_PRIMES + DH_NUM_SUBGROUPS];
+static int dh_num_known_groups;
+static CRYPTO_MUTEX *dh_comb_lock;
+static CRYPTO_ONCE dh_comb_once = CRYPTO_ONCE_STATIC_INIT;
+
+static void dh_known_groups_init(void)
+{
+    DH_KNOWN_GROUP *kg;
+    DH *dh;
+    size_t i;
+
+    dh_comb_lock = CRYPTO_thread_new();
+    for (i = 0; i < DH_NUM_SAFE_PRIMES; i++) {
+        kg = &dh_known_groups[dh_num_known_groups];
+        kg->p = dh_safe_primes[i].get_prime(NULL);
+        kg->g = BN_new();
+        if (kg->p == NULL || kg->g == NULL || !BN_set_word(kg->g, 2)) {
+            BN_free(kg->p);
+            BN_free(kg->g);
+            continue;
+        }
+        kg->exponent_bits = dh_safe_primes[i].exponent_bits;
+        dh_num_known_groups++;
+    }
+    for (i = 0; i < DH_NUM_SUBGROUPS; i++) {
+        if ((dh = dh_subgroups[i]()) == NULL)
+            continue;
+        kg = &dh_known_groups[dh_num_known_groups++];
+        kg->p = dh->p;
+        kg->g = dh->g;
+        kg->exponent_bits = BN_num_bits(dh->q);
+        dh->p = NULL;
+        dh->g = NULL;
+        DH_free(dh);
+    }
+}
+
+static void dh_fixed_base_free(DH_FIXED_BASE *fb)
+{
+    if (fb == NULL)
+        return;
+    BN_MONT_CTX_free(fb->mont);
+    free(fb->table);
+    free(fb);
+}
+
+static int dh_fixed_base_load(const DH_FIXED_BASE *fb, BIGNUM *r, int i)
+{
+    if (bn_wexpand(r, fb->top) == NULL)
+        return 0;
+    memcpy(r->d, fb->table + i * fb->top, fb->top * sizeof(BN_ULONG));
+    r->top = fb->top;
+    r->neg = 0;
+    bn_correct_top(r);
+    return 1;
+}
+
+static void dh_fixed_base_store(DH_FIXED_BASE *fb, const BIGNUM *a, int i)
+{
+    BN_ULONG *entry = fb->table + i * fb->top;
+
+    memset(entry, 0, fb->top * sizeof(BN_ULONG));
+    memcpy(entry, a->d, a->top * sizeof(BN_ULONG));
+}
+
+/*
+ * dh_fixed_base_select sets |r| to entry |i| of the table while reading every
+ * entry, so the memory access pattern does not depend on |i|.
+ */
+static int dh_fixed_base_select(const DH_FIXED_BASE *fb, BIGNUM *r, int i)
+{
+    const BN_ULONG *entry = fb->table;
+    BN_ULONG mask;
+    int j, k;
+
+    if (bn_wexpand(r, fb->top) == NULL)
+        return 0;
+    memset(r->d, 0, fb->top * sizeof(BN_ULONG));
+    for (j = 0; j < DH_COMB_ENTRIES; j++, entry += fb->top) {
+        mask = (BN_ULONG)0 - (BN_ULONG)(constant_time_eq_int(i, j) & 1);
+        for (k = 0; k < fb->top; k++)
+            r->d[k] |= entry[k] & mask;
+    }
+    r->top = fb->top;
+    r->neg = 0;
+    bn_correct_top(r);
+    return 1;
+}
+
+static DH_FIXED_BASE *dh_fixed_base_new(const BIGNUM *p, const BIGNUM *g,
+                                        int bits)
+{
+    DH_FIXED_BASE *fb;
+    BN_CTX *ctx;
+    BIGNUM *base, *acc;
+    int i, j, k, ok = 0;
+
+    if ((ctx = BN_CTX_new()) == NULL)
+        return NULL;
+    BN_CTX_start(ctx);
+    base = BN_CTX_get(ctx);
+    acc = BN_CTX_get(ctx);
+    if ((fb = calloc(1, sizeof(*fb))) == NULL || acc == NULL)
+        goto err;
+    fb->bits = bits;
+    fb->cols = (bits + DH_COMB_TEETH - 1) / DH_COMB_TEETH;
+    fb->top = p->top;
+    fb->table = calloc(DH_COMB_ENTRIES * fb->top, sizeof(BN_ULONG));
+    if (fb->table == NULL)
+        goto err;
+    if ((fb->mont = BN_MONT_CTX_new()) == NULL ||
+        !BN_MONT_CTX_set(fb->mont, p, ctx))
+        goto err;
+
+    /* Entry zero is one, and 'base' is g^(2^(row * cols)) for each row */
+    if (!BN_to_montgomery(acc, BN_value_one(), fb->mont, ctx) ||
+        !BN_to_montgomery(base, g, fb->mont, ctx))
+        goto err;
+    dh_fixed_base_store(fb, acc, 0);
+    for (j = 0; j < DH_COMB_TEETH; j++) {
+        for (k = 0; j > 0 && k < fb->cols; k++) {
+            if (!BN_mod_mul_montgomery(base, base, base, fb->mont, ctx))
+                goto err;
+        }
+        for (i = 1 << j; i < 2 << j; i++) {
+            if (!dh_fixed_base_load(fb, acc, i - (1 << j)) ||
+                !BN_mod_mul_montgomery(acc, acc, base, fb->mont, ctx))
+                goto err;
+            dh_fixed_base_store(fb, acc, i);
+        }
+    }
+    ok = 1;
+
+err:
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    if (!ok) {
+        dh_fixed_base_free(fb);
+        return NULL;
+    }
+    return fb;
+}
+
+const DH_FIXED_BASE *dh_fixed_base_get(const DH *dh)
+{
+    DH_KNOWN_GROUP *kg = NULL;
+    DH_FIXED_BASE *fb;
+    int i;
+
+    if (dh->p == NULL || dh->g == NULL)
+        return NULL;
+    CRYPTO_thread_run_once(&dh_comb_once, dh_known_groups_init);
+    for (i = 0; i < dh_num_known_groups; i++) {
+        if (BN_cmp(dh->p, dh_known_groups[i].p) == 0 &&
+            BN_cmp(dh->g, dh_known_groups[i].g) == 0) {
+            kg = &dh_known_groups[i];
+            break;
+        }
+    }
+    if (kg == NULL)
+        return NULL;
+
+    fb = CRYPTO_atomic_get_ptr((void **)&kg->fb, dh_comb_lock);
+    if (fb != NULL)
+        return fb;
+    CRYPTO_thread_write_lock(dh_comb_lock);
+    if ((fb = kg->fb) == NULL) {
+        fb = dh_fixed_base_new(kg->p, kg->g, kg->exponent_bits);
+        if (fb != NULL)
+            CRYPTO_atomic_set_ptr((void **)&kg->fb, fb, NULL);
+    }
+    CRYPTO_thread_unlock(dh_comb_lock);
+    return fb;
+}
+
+int dh_fixed_base_exponent_bits(const DH_FIXED_BASE *fb)
+{
+    return fb->bits;
+}
+
+BN_MONT_CTX *dh_fixed_base_mont(const DH_FIXED_BASE *fb)
+{
+    return fb->mont;
+}
+
+int dh_fixed_base_exp(const DH_FIXED_BASE *fb, BIGNUM *r, const BIGNUM *e,
+                      BN_CTX *ctx)
+{
+    BIGNUM *acc, *entry;
+    BN_ULONG *ex;
+    int ewords, i, j, bit, col, ret = 0;
+
+    if (BN_is_negative(e) || BN_num_bits(e) > fb->bits)
+        return 0;
+
+    /* Copy the exponent to a fixed number of words so that reading its bits
+     * does not depend on its length */
+    ewords = (fb->cols * DH_COMB_TEETH + BN_BITS2 - 1) / BN_BITS2;
+    if ((ex = calloc(ewords, sizeof(BN_ULONG))) == NULL)
+        return 0;
+    memcpy(ex, e->d, e->top * sizeof(BN_ULONG));
+
+    BN_CTX_start(ctx);
+    acc = BN_CTX_get(ctx);
+    entry = BN_CTX_get(ctx);
+    if (entry == NULL || !dh_fixed_base_load(fb, acc, 0))
+        goto err;
+    for (col = fb->cols - 1; col >= 0; col--) {
+        if (col != fb->cols - 1 &&
+            !BN_mod_mul_montgomery(acc, acc, acc, fb->mont, ctx))
+            goto err;
+        for (i = 0, j = 0; j < DH_COMB_TEETH; j++) {
+            bit = j * fb->cols + col;
+            i |= (int)((ex[bit / BN_BITS2] >> (bit % BN_BITS2)) & 1) << j;
+        }
+        if (!dh_fixed_base_select(fb, entry, i) ||
+            !BN_mod_mul_montgomery(acc, acc, entry, fb->mont, ctx))
+            goto err;
+    }
+    if (!BN_from_montgomery(r, acc, fb->mont, ctx))
+        goto err;
+    ret = 1;
+
+err:
+    BN_CTX_end(ctx);
+    vigortls_zeroize(ex, ewords * sizeof(BN_ULONG));
+    free(ex);
+    return ret;
+}
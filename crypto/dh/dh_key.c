@@ -14,6 +14,8 @@
 #include <openssl/err.h>
 #include <openssl/rand.h>
 
+#include "dh_locl.h"
+
 static int generate_key(DH *dh);
 static int compute_key(uint8_t *key, const BIGNUM *pub_key, DH *dh);
 static int dh_bn_mod_exp(const DH *dh, BIGNUM *r,
@@ -74,8 +76,9 @@ static int generate_key(DH *dh)
     BN_CTX *ctx;
     BN_MONT_CTX *mont = NULL;
     BIGNUM *pub_key = NULL, *priv_key = NULL;
+    const DH_FIXED_BASE *fb = NULL;
 
-    ctx = BN_CTX_new();
+    ctx = BN_CTX_new_cached();
     if (ctx == NULL)
         goto err;
 
@@ -94,7 +97,12 @@ static int generate_key(DH *dh)
     } else
         pub_key = dh->pub_key;
 
-    if (dh->flags & DH_FLAG_CACHE_MONT_P) {
+    /* The well-known groups have a shared table of powers of g, unless the
+     * method does its own exponentiation. */
+    if (dh->meth->bn_mod_exp == dh_bn_mod_exp)
+        fb = dh_fixed_base_get(dh);
+
+    if (fb == NULL && (dh->flags & DH_FLAG_CACHE_MONT_P)) {
         mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
                                       dh->lock, dh->p, ctx);
         if (!mont)
@@ -108,8 +116,14 @@ static int generate_key(DH *dh)
                     goto err;
             } while (BN_is_zero(priv_key) || BN_is_one(priv_key));
         } else {
-            /* secret exponent length */
-            l = dh->length ? dh->length : BN_num_bits(dh->p) - 1;
+            /* secret exponent length, which for a well-known group is only
+             * as long as its security level needs */
+            if (dh->length)
+                l = dh->length;
+            else if (fb != NULL)
+                l = dh_fixed_base_exponent_bits(fb);
+            else
+                l = BN_num_bits(dh->p) - 1;
             if (!BN_rand(priv_key, l, 0, 0))
                 goto err;
         }
@@ -126,8 +140,17 @@ static int generate_key(DH *dh)
         } else
             prk = priv_key;
 
-        if (!dh->meth->bn_mod_exp(dh, pub_key, dh->g, prk, dh->p, ctx, mont))
-            goto err;
+        if (fb != NULL &&
+            BN_num_bits(priv_key) <= dh_fixed_base_exponent_bits(fb)) {
+            if (!dh_fixed_base_exp(fb, pub_key, prk, ctx))
+                goto err;
+        } else {
+            if (fb != NULL)
+                mont = dh_fixed_base_mont(fb);
+            if (!dh->meth->bn_mod_exp(dh, pub_key, dh->g, prk, dh->p, ctx,
+                                      mont))
+                goto err;
+        }
     }
 
     dh->pub_key = pub_key;
@@ -149,6 +172,7 @@ static int compute_key(uint8_t *key, const BIGNUM *pub_key, DH *dh)
 {
     BN_CTX *ctx = NULL;
     BN_MONT_CTX *mont = NULL;
+    const DH_FIXED_BASE *fb;
     BIGNUM *tmp;
     int ret = -1;
     int check_result;
@@ -158,7 +182,7 @@ static int compute_key(uint8_t *key, const BIGNUM *pub_key, DH *dh)
         goto err;
     }
 
-    ctx = BN_CTX_new();
+    ctx = BN_CTX_new_cached();
     if (ctx == NULL)
         goto err;
     BN_CTX_start(ctx);
@@ -172,8 +196,12 @@ static int compute_key(uint8_t *key, const BIGNUM *pub_key, DH *dh)
     }
 
     if (dh->flags & DH_FLAG_CACHE_MONT_P) {
-        mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
-                                      dh->lock, dh->p, ctx);
+        /* A well-known group's Montgomery context is shared */
+        if ((fb = dh_fixed_base_get(dh)) != NULL)
+            mont = dh_fixed_base_mont(fb);
+        else
+            mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
+                                          dh->lock, dh->p, ctx);
         if ((dh->flags & DH_FLAG_NO_EXP_CONSTTIME) == 0) {
             /* XXX */
             BN_set_flags(dh->priv_key, BN_FLG_CONSTTIME);
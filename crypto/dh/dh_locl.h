@@ -0,0 +1,46 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef HEADER_DH_LOCL_H
+#define HEADER_DH_LOCL_H
+
+#include <openssl/bn.h>
+#include <openssl/dh.h>
+
+/*
+ * A DH_FIXED_BASE is a table of powers of the generator of one of the
+ * well-known groups, shared by every DH object that uses the group, with
+ * which g^x is computed by a comb method in constant time.
+ */
+typedef struct dh_fixed_base_st DH_FIXED_BASE;
+
+/*
+ * dh_fixed_base_get returns the table for |dh|'s group, building it on first
+ * use, or NULL if the group is not one of the well-known ones.
+ */
+const DH_FIXED_BASE *dh_fixed_base_get(const DH *dh);
+
+/*
+ * dh_fixed_base_exponent_bits returns the length of the private exponents the
+ * table handles. For a group without a subgroup order, this is the short
+ * exponent length recommended for its security level.
+ */
+int dh_fixed_base_exponent_bits(const DH_FIXED_BASE *fb);
+
+/* dh_fixed_base_mont returns the shared Montgomery context of the group. */
+BN_MONT_CTX *dh_fixed_base_mont(const DH_FIXED_BASE *fb);
+
+/*
+ * dh_fixed_base_exp sets |r| to g^|e| mod p. |e| must be no longer than
+ * dh_fixed_base_exponent_bits.
+ */
+int dh_fixed_base_exp(const DH_FIXED_BASE *fb, BIGNUM *r, const BIGNUM *e,
+                      BN_CTX *ctx);
+
+#endif
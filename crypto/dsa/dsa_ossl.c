@@ -98,7 +98,7 @@ static DSA_SIG *dsa_do_sign(const uint8_t *dgst, int dlen, DSA *dsa)
     s = BN_new();
     if (s == NULL)
         goto err;
-    ctx = BN_CTX_new();
+    ctx = BN_CTX_new_cached();
     if (ctx == NULL)
         goto err;
 redo:
@@ -176,7 +176,7 @@ static int dsa_sign_setup(DSA *dsa, BN_CTX *ctx_in, BIGNUM **kinvp, BIGNUM **rp)
     BN_init(&kq);
 
     if (ctx_in == NULL) {
-        if ((ctx = BN_CTX_new()) == NULL)
+        if ((ctx = BN_CTX_new_cached()) == NULL)
             goto err;
     } else
         ctx = ctx_in;
@@ -280,7 +280,7 @@ static int dsa_do_verify(const uint8_t *dgst, int dgst_len, DSA_SIG *sig,
     BN_init(&u2);
     BN_init(&t1);
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
 
     if (BN_is_zero(sig->r) || BN_is_negative(sig->r) || BN_ucmp(sig->r, dsa->q) >= 0) {
@@ -16,6 +16,8 @@
 #include "ec_lcl.h"
 #include <openssl/err.h>
 
+#include "internal/ec_int.h"
+
 EC_KEY *EC_KEY_new(void)
 {
     EC_KEY *ret;
@@ -130,6 +132,8 @@ EC_KEY *EC_KEY_copy(EC_KEY *dest, const EC_KEY *src)
     dest->conv_form = src->conv_form;
     dest->version = src->version;
     dest->flags = src->flags;
+    dest->precompute_threshold = src->precompute_threshold;
+    dest->key_table = src->key_table;
 
     return dest;
 }
@@ -170,7 +174,7 @@ int EC_KEY_generate_key(EC_KEY *eckey)
 
     if ((order = BN_new()) == NULL)
         goto err;
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
 
     if (eckey->priv_key == NULL) {
@@ -457,6 +461,58 @@ int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx)
     return EC_GROUP_precompute_mult(key->group, ctx);
 }
 
+int EC_KEY_precompute_public_mult(EC_KEY *key, BN_CTX *ctx)
+{
+    if (key->group == NULL || key->pub_key == NULL)
+        return 0;
+    if (key->group->meth->key_precompute_mult == 0)
+        return 1;
+    return key->group->meth->key_precompute_mult(key, ctx);
+}
+
+void EC_KEY_set_precompute_threshold(EC_KEY *key, int uses)
+{
+    key->precompute_threshold = uses > 0 ? uses : 0;
+}
+
+size_t EC_KEY_get_precompute_size(const EC_KEY *key)
+{
+    if (key->group == NULL || key->group->meth->key_precompute_size == 0)
+        return 0;
+    return key->group->meth->key_precompute_size(key);
+}
+
+/*
+ * ec_key_do_verify_mul sets |r| to |g_scalar| * generator + |p_scalar| *
+ * public key, using a table of multiples of the public key if one has been
+ * built, and returns one on success. The table is built on the call that
+ * reaches the key's precompute threshold.
+ */
+int ec_key_do_verify_mul(EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+                         const BIGNUM *p_scalar, BN_CTX *ctx)
+{
+    const EC_METHOD *meth = key->group->meth;
+    int uses;
+
+    if (meth->key_points_mul == 0)
+        return EC_POINT_mul(key->group, r, g_scalar, key->pub_key, p_scalar, ctx);
+
+    /* The count stops at the threshold, so a key whose table cannot be
+     * built is not retried and the count cannot overflow. */
+    if (key->precompute_threshold > 0 &&
+        meth->key_precompute_size(key) == 0 &&
+        CRYPTO_atomic_add_unless(&key->precompute_uses, 1,
+                                 key->precompute_threshold, &uses, key->lock) &&
+        uses == key->precompute_threshold) {
+        /* A failure here only costs speed, so leave no error behind. */
+        ERR_set_mark();
+        meth->key_precompute_mult(key, ctx);
+        ERR_pop_to_mark();
+    }
+
+    return meth->key_points_mul(key, r, g_scalar, p_scalar, ctx);
+}
+
 int EC_KEY_get_flags(const EC_KEY *key)
 {
     return key->flags;
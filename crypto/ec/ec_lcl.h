@@ -119,6 +119,19 @@ struct ec_method_st {
     int (*field_encode)(const EC_GROUP *, BIGNUM *r, const BIGNUM *a, BN_CTX *); /* e.g. to Montgomery */
     int (*field_decode)(const EC_GROUP *, BIGNUM *r, const BIGNUM *a, BN_CTX *); /* e.g. from Montgomery */
     int (*field_set_to_one)(const EC_GROUP *, BIGNUM *r, BN_CTX *);
+
+    /* used by ec_group_do_order_mul, ec_group_do_inverse_ord (ECDSA scalar
+     * arithmetic modulo the group order; generic BN code is used if these
+     * pointers are 0): */
+    int (*order_mul)(const EC_GROUP *, BIGNUM *r, const BIGNUM *a, const BIGNUM *b, BN_CTX *);
+    int (*order_inverse)(const EC_GROUP *, BIGNUM *r, const BIGNUM *a, BN_CTX *);
+
+    /* used by EC_KEY_precompute_public_mult, EC_KEY_get_precompute_size and
+     * ec_key_do_verify_mul (multiples of a fixed public key; EC_POINT_mul
+     * is used if these pointers are 0): */
+    int (*key_precompute_mult)(EC_KEY *, BN_CTX *);
+    size_t (*key_precompute_size)(const EC_KEY *);
+    int (*key_points_mul)(const EC_KEY *, EC_POINT *r, const BIGNUM *g_scalar, const BIGNUM *p_scalar, BN_CTX *);
 } /* EC_METHOD */;
 
 typedef struct ec_extra_data_st {
@@ -197,6 +210,15 @@ struct ec_key_st {
     CRYPTO_MUTEX *lock;
     int flags;
 
+    /* number of verifications after which the public key table is built,
+     * 0 if disabled, and the number done so far */
+    int precompute_threshold;
+    int precompute_uses;
+    /* non-NULL once the method may have kept a table of multiples of the
+     * public key in method_data, so that verifiers of a key without one
+     * need not take the lock; read and set atomically, never dereferenced */
+    void *key_table;
+
     EC_EXTRA_DATA *method_data;
 } /* EC_KEY */;
 
@@ -377,6 +399,13 @@ void ec_GFp_nistp_recode_scalar_bits(uint8_t *sign, uint8_t *digit, uint8_t in);
 #endif
 int ec_precompute_mont_data(EC_GROUP *);
 
+/* generic scalar arithmetic modulo the group order in ec_lib.c
+ * (used if group->method->order_mul/order_inverse are 0) */
+int ec_group_simple_order_mul(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                              const BIGNUM *b, BN_CTX *ctx);
+int ec_group_simple_order_inverse(const EC_GROUP *group, BIGNUM *r,
+                                  const BIGNUM *a, BN_CTX *ctx);
+
 #ifdef ECP_NISTZ256_ASM
 /** Returns GFp methods using montgomery multiplication, with x86-64 optimized
  * P256. See http://eprint.iacr.org/2013/816.
@@ -18,6 +18,7 @@
 #include <openssl/opensslv.h>
 
 #include "ec_lcl.h"
+#include "internal/ec_int.h"
 
 /* functions for EC_GROUP objects */
 
@@ -996,3 +997,84 @@ err:
     BN_CTX_free(ctx);
     return ret;
 }
+
+int ec_group_simple_order_mul(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                              const BIGNUM *b, BN_CTX *ctx)
+{
+    return BN_mod_mul(r, a, b, &group->order, ctx);
+}
+
+int ec_group_simple_order_inverse(const EC_GROUP *group, BIGNUM *r,
+                                  const BIGNUM *a, BN_CTX *ctx)
+{
+    BIGNUM *e;
+    int ret = 0;
+
+    if (group->mont_data == NULL)
+        return BN_mod_inverse(r, a, &group->order, ctx) != NULL;
+
+    BN_CTX_start(ctx);
+    if ((e = BN_CTX_get(ctx)) == NULL)
+        goto err;
+
+    /*
+     * We want the inverse in constant time, therefore we utilize the fact
+     * that the order must be prime and use Fermat's Little Theorem instead.
+     */
+    if (!BN_set_word(e, 2))
+        goto err;
+    if (!BN_sub(e, &group->order, e))
+        goto err;
+    BN_set_flags(e, BN_FLG_CONSTTIME);
+    if (!BN_mod_exp_mont_consttime(r, a, e, &group->order, ctx,
+                                   group->mont_data))
+        goto err;
+
+    ret = 1;
+
+err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*
+ * ec_group_do_order_mul sets |r| to |a| * |b| modulo the order of |group|
+ * and returns one on success. |a| and |b| must be non-negative.
+ */
+int ec_group_do_order_mul(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                          const BIGNUM *b, BN_CTX *ctx)
+{
+    if (group->meth->order_mul != 0)
+        return group->meth->order_mul(group, r, a, b, ctx);
+
+    return ec_group_simple_order_mul(group, r, a, b, ctx);
+}
+
+/*
+ * ec_group_do_inverse_ord sets |r| to the inverse of |a| modulo the order of
+ * |group|, in constant time where the group allows it, and returns one on
+ * success.
+ */
+int ec_group_do_inverse_ord(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                            BN_CTX *ctx)
+{
+    if (group->meth->order_inverse != 0)
+        return group->meth->order_inverse(group, r, a, ctx);
+
+    return ec_group_simple_order_inverse(group, r, a, ctx);
+}
+
+/*
+ * ec_group_do_public_inverse_ord is ec_group_do_inverse_ord for a public |a|,
+ * such as the s of a signature being verified. Without a fixed-width
+ * inverse from the group's method it uses BN_mod_inverse, which is faster
+ * than the constant-time exponentiation but leaks |a|.
+ */
+int ec_group_do_public_inverse_ord(const EC_GROUP *group, BIGNUM *r,
+                                   const BIGNUM *a, BN_CTX *ctx)
+{
+    if (group->meth->order_inverse != 0)
+        return group->meth->order_inverse(group, r, a, ctx);
+
+    return BN_mod_inverse(r, a, &group->order, ctx) != NULL;
+}
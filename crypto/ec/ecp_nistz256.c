@@ -36,6 +36,10 @@
 #include "cryptlib.h"
 #include "ec_lcl.h"
 
+#if !defined(BN_ULLONG) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #if BN_BITS2 != 64
 #define TOBN(hi, lo) lo, hi
 #else
@@ -575,6 +579,253 @@ static int ecp_nistz256_bignum_to_field_elem(BN_ULONG out[P256_LIMBS],
     return 1;
 }
 
+/*
+ * Arithmetic modulo the group order n, used by ECDSA. These functions keep
+ * operands as fixed-width arrays in the Montgomery domain (R = 2^256) and
+ * run in time independent of their values.
+ */
+
+/* The order: ffffffff 00000000 ffffffff ffffffff bce6faad a7179e84 f3b9cac2
+ * fc632551 */
+static const BN_ULONG ORD[P256_LIMBS]
+    = { TOBN(0xf3b9cac2, 0xfc632551), TOBN(0xbce6faad, 0xa7179e84),
+        TOBN(0xffffffff, 0xffffffff), TOBN(0xffffffff, 0x00000000) };
+
+/* RR = 2^512 mod n */
+static const BN_ULONG ORD_RR[P256_LIMBS]
+    = { TOBN(0x83244c95, 0xbe79eea2), TOBN(0x4699799c, 0x49bd6fa6),
+        TOBN(0x2845b239, 0x2b6bec59), TOBN(0x66e12d94, 0xf3d95620) };
+
+/* -n^-1 mod 2^BN_BITS2 */
+#if BN_BITS2 == 64
+static const BN_ULONG ORD_K0 = TOBN(0xccd1c8aa, 0xee00bc4f);
+#else
+static const BN_ULONG ORD_K0 = 0xee00bc4f;
+#endif
+
+/* ecp_nistz256_ord_mac returns the high word of a*b + c + d and writes the
+ * low word to |*lo|. */
+static BN_ULONG ecp_nistz256_ord_mac(BN_ULONG *lo, BN_ULONG a, BN_ULONG b,
+                                     BN_ULONG c, BN_ULONG d)
+{
+#if defined(BN_ULLONG)
+    BN_ULLONG t = (BN_ULLONG)a * b + c + d;
+
+    *lo = (BN_ULONG)t;
+    return (BN_ULONG)(t >> BN_BITS2);
+#else
+    BN_ULONG l, h;
+
+    l = _umul128(a, b, &h);
+    l += c;
+    h += (l < c);
+    l += d;
+    h += (l < d);
+    *lo = l;
+    return h;
+#endif
+}
+
+/* ecp_nistz256_ord_sub_cond sets |r| to (|hi|:|a|) - n if that does not
+ * underflow and to |a| otherwise. It returns the new top word. */
+static BN_ULONG ecp_nistz256_ord_sub_cond(BN_ULONG r[P256_LIMBS],
+                                          const BN_ULONG a[P256_LIMBS],
+                                          BN_ULONG hi)
+{
+    BN_ULONG d[P256_LIMBS], borrow = 0, t, mask;
+    size_t i;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        t = a[i] - ORD[i];
+        d[i] = t - borrow;
+        borrow = (t > a[i]) | (d[i] > t);
+    }
+
+    /* Keep |a| if the borrow propagates out of |hi|. */
+    mask = 0 - (borrow & (hi ^ 1));
+    for (i = 0; i < P256_LIMBS; i++)
+        r[i] = (a[i] & mask) | (d[i] & ~mask);
+
+    return (hi & mask) | ((hi - borrow) & ~mask);
+}
+
+/* Montgomery mul modulo n: res = a*b*2^-256 mod n, for a, b < n */
+static void ecp_nistz256_ord_mul_mont(BN_ULONG res[P256_LIMBS],
+                                      const BN_ULONG a[P256_LIMBS],
+                                      const BN_ULONG b[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS + 2], c, m, lo;
+    size_t i, j;
+
+    memset(t, 0, sizeof(t));
+    for (i = 0; i < P256_LIMBS; i++) {
+        c = 0;
+        for (j = 0; j < P256_LIMBS; j++)
+            c = ecp_nistz256_ord_mac(&t[j], a[j], b[i], t[j], c);
+        t[P256_LIMBS] += c;
+        t[P256_LIMBS + 1] = (t[P256_LIMBS] < c);
+
+        m = t[0] * ORD_K0;
+        c = ecp_nistz256_ord_mac(&lo, m, ORD[0], t[0], 0);
+        for (j = 1; j < P256_LIMBS; j++)
+            c = ecp_nistz256_ord_mac(&t[j - 1], m, ORD[j], t[j], c);
+        t[P256_LIMBS - 1] = t[P256_LIMBS] + c;
+        t[P256_LIMBS] = t[P256_LIMBS + 1] + (t[P256_LIMBS - 1] < c);
+    }
+
+    /* t < 2n, so a single conditional subtraction fully reduces it. */
+    ecp_nistz256_ord_sub_cond(res, t, t[P256_LIMBS]);
+}
+
+/* Montgomery sqr modulo n: res = a*a*2^-256 mod n */
+static void ecp_nistz256_ord_sqr_mont(BN_ULONG res[P256_LIMBS],
+                                      const BN_ULONG a[P256_LIMBS], int rep)
+{
+    int i;
+
+    ecp_nistz256_ord_mul_mont(res, a, a);
+    for (i = 1; i < rep; i++)
+        ecp_nistz256_ord_mul_mont(res, res, res);
+}
+
+/* r = in^-1 mod n, both in the Montgomery domain */
+static void ecp_nistz256_ord_inverse_mont(BN_ULONG r[P256_LIMBS],
+                                          const BN_ULONG in[P256_LIMBS])
+{
+    /*
+     * The exponent is n-2:
+     *   ffffffff 00000000 ffffffff ffffffff bce6faad a7179e84 f3b9cac2
+     *   fc63254f
+     * The upper half is built from x^(2^32-1) with an addition chain and the
+     * lower half is processed in fixed 4-bit windows over a table of x^1 to
+     * x^15. The exponent is public, so neither leaks anything about |in|.
+     */
+    static const uint8_t ord_minus_2_lo[32] = {
+        0xb, 0xc, 0xe, 0x6, 0xf, 0xa, 0xa, 0xd, 0xa, 0x7, 0x1, 0x7, 0x9, 0xe,
+        0x8, 0x4, 0xf, 0x3, 0xb, 0x9, 0xc, 0xa, 0xc, 0x2, 0xf, 0xc, 0x6, 0x3,
+        0x2, 0x5, 0x4, 0xf
+    };
+    BN_ULONG table[16][P256_LIMBS];
+    BN_ULONG x8[P256_LIMBS], x16[P256_LIMBS], x32[P256_LIMBS];
+    BN_ULONG res[P256_LIMBS];
+    int i;
+
+    memcpy(table[1], in, sizeof(table[1]));
+    for (i = 2; i < 16; i++)
+        ecp_nistz256_ord_mul_mont(table[i], table[i - 1], in);
+
+    /* table[15] is x^(2^4-1) */
+    ecp_nistz256_ord_sqr_mont(res, table[15], 4);
+    ecp_nistz256_ord_mul_mont(x8, res, table[15]); /* x^(2^8-1) */
+    ecp_nistz256_ord_sqr_mont(res, x8, 8);
+    ecp_nistz256_ord_mul_mont(x16, res, x8);       /* x^(2^16-1) */
+    ecp_nistz256_ord_sqr_mont(res, x16, 16);
+    ecp_nistz256_ord_mul_mont(x32, res, x16);      /* x^(2^32-1) */
+
+    /* ffffffff 00000000 ffffffff */
+    ecp_nistz256_ord_sqr_mont(res, x32, 64);
+    ecp_nistz256_ord_mul_mont(res, res, x32);
+    /* ffffffff 00000000 ffffffff ffffffff */
+    ecp_nistz256_ord_sqr_mont(res, res, 32);
+    ecp_nistz256_ord_mul_mont(res, res, x32);
+
+    for (i = 0; i < 32; i++) {
+        ecp_nistz256_ord_sqr_mont(res, res, 4);
+        if (ord_minus_2_lo[i] != 0)
+            ecp_nistz256_ord_mul_mont(res, res, table[ord_minus_2_lo[i]]);
+    }
+
+    memcpy(r, res, sizeof(res));
+    vigortls_zeroize(table, sizeof(table));
+    vigortls_zeroize(x8, sizeof(x8));
+    vigortls_zeroize(x16, sizeof(x16));
+    vigortls_zeroize(x32, sizeof(x32));
+}
+
+/* ecp_nistz256_group_has_ord returns one if |group| has the P-256 order,
+ * which the functions above are hardwired for. */
+static int ecp_nistz256_group_has_ord(const EC_GROUP *group)
+{
+    return group->order.top == P256_LIMBS &&
+           memcmp(group->order.d, ORD, sizeof(ORD)) == 0;
+}
+
+/* ecp_nistz256_ord_from_bignum sets |out| to |in| mod n in the Montgomery
+ * domain and returns one, or returns zero if |in| is negative or wider than
+ * 257 bits. */
+static int ecp_nistz256_ord_from_bignum(BN_ULONG out[P256_LIMBS],
+                                        const BIGNUM *in)
+{
+    BN_ULONG w[P256_LIMBS + 1], hi;
+
+    if (BN_is_negative(in) || BN_num_bits(in) > 257)
+        return 0;
+
+    memset(w, 0, sizeof(w));
+    memcpy(w, in->d, sizeof(BN_ULONG) * in->top);
+
+    /* |in| < 2^257 < 3n, so two conditional subtractions fully reduce it. */
+    hi = ecp_nistz256_ord_sub_cond(w, w, w[P256_LIMBS]);
+    ecp_nistz256_ord_sub_cond(w, w, hi);
+
+    ecp_nistz256_ord_mul_mont(out, w, ORD_RR);
+    vigortls_zeroize(w, sizeof(w));
+    return 1;
+}
+
+/* ecp_nistz256_ord_to_bignum converts |in| out of the Montgomery domain and
+ * stores it in |out|. */
+static int ecp_nistz256_ord_to_bignum(BIGNUM *out, const BN_ULONG in[P256_LIMBS])
+{
+    static const BN_ULONG one[P256_LIMBS] = { 1 };
+    BN_ULONG t[P256_LIMBS];
+    int ret;
+
+    ecp_nistz256_ord_mul_mont(t, in, one);
+    ret = ecp_nistz256_set_words(out, t);
+    vigortls_zeroize(t, sizeof(t));
+    return ret;
+}
+
+/* r = a*b mod n */
+static int ecp_nistz256_order_mul(const EC_GROUP *group, BIGNUM *r,
+                                  const BIGNUM *a, const BIGNUM *b, BN_CTX *ctx)
+{
+    BN_ULONG a_[P256_LIMBS], b_[P256_LIMBS];
+    int ret;
+
+    if (!ecp_nistz256_group_has_ord(group) ||
+        !ecp_nistz256_ord_from_bignum(a_, a) ||
+        !ecp_nistz256_ord_from_bignum(b_, b))
+        return ec_group_simple_order_mul(group, r, a, b, ctx);
+
+    /* (aR)(bR)R^-1 = abR, which ecp_nistz256_ord_to_bignum brings back */
+    ecp_nistz256_ord_mul_mont(a_, a_, b_);
+    ret = ecp_nistz256_ord_to_bignum(r, a_);
+
+    vigortls_zeroize(a_, sizeof(a_));
+    vigortls_zeroize(b_, sizeof(b_));
+    return ret;
+}
+
+/* r = a^-1 mod n */
+static int ecp_nistz256_order_inverse(const EC_GROUP *group, BIGNUM *r,
+                                      const BIGNUM *a, BN_CTX *ctx)
+{
+    BN_ULONG t[P256_LIMBS];
+    int ret;
+
+    if (!ecp_nistz256_group_has_ord(group) ||
+        !ecp_nistz256_ord_from_bignum(t, a))
+        return ec_group_simple_order_inverse(group, r, a, ctx);
+
+    ecp_nistz256_ord_inverse_mont(t, t);
+    ret = ecp_nistz256_ord_to_bignum(r, t);
+
+    vigortls_zeroize(t, sizeof(t));
+    return ret;
+}
+
 /* r = sum(scalar[i]*point[i]) */
 static int ecp_nistz256_windowed_mul(const EC_GROUP *group, P256_POINT *r,
                                      const BIGNUM **scalar, const EC_POINT **point,
@@ -749,21 +1000,132 @@ static int ecp_nistz256_is_affine_G(const EC_POINT *generator)
            is_one(&generator->Z);
 }
 
+/*
+ * ecp_nistz256_point_get_affine_mont sets |out| to the affine coordinates of
+ * |point|, in the Montgomery domain, and returns one, or returns zero if
+ * |point| is at infinity or its coordinates are out of range.
+ */
+static int ecp_nistz256_point_get_affine_mont(P256_POINT_AFFINE *out,
+                                              const EC_POINT *point)
+{
+    BN_ULONG z[P256_LIMBS], z_inv2[P256_LIMBS], z_inv3[P256_LIMBS];
+
+    if (point->Z.top == 0)
+        return 0;
+
+    if (!ecp_nistz256_bignum_to_field_elem(out->X, &point->X) ||
+        !ecp_nistz256_bignum_to_field_elem(out->Y, &point->Y) ||
+        !ecp_nistz256_bignum_to_field_elem(z, &point->Z))
+        return 0;
+
+    if (point->Z_is_one)
+        return 1;
+
+    ecp_nistz256_mod_inverse(z_inv3, z);
+    ecp_nistz256_sqr_mont(z_inv2, z_inv3);
+    ecp_nistz256_mul_mont(z_inv3, z_inv3, z_inv2);
+    ecp_nistz256_mul_mont(out->X, out->X, z_inv2);
+    ecp_nistz256_mul_mont(out->Y, out->Y, z_inv3);
+
+    return 1;
+}
+
+/*
+ * ecp_nistz256_build_table fills the 37 rows of |table| for the Booth
+ * encoded, 7-bit window multiplication by |base|: row j holds
+ * 1*2^(7j)*base ... 64*2^(7j)*base in affine form. Each row is computed
+ * in Jacobian coordinates, together with the base of the next row, and
+ * then converted to affine form with a single field inversion.
+ */
+static void ecp_nistz256_build_table(PRECOMP256_ROW *table,
+                                     const P256_POINT_AFFINE *base)
+{
+    ALIGN32 P256_POINT row[65];
+    ALIGN32 P256_POINT_AFFINE b;
+    BN_ULONG prod[65][P256_LIMBS];
+    BN_ULONG inv[P256_LIMBS], z_inv[P256_LIMBS], z_inv2[P256_LIMBS];
+    int i, j;
+
+    memcpy(&b, base, sizeof(b));
+
+    for (j = 0; j < 37; j++) {
+        memcpy(row[0].X, b.X, sizeof(b.X));
+        memcpy(row[0].Y, b.Y, sizeof(b.Y));
+        memcpy(row[0].Z, ONE, sizeof(ONE));
+        /* The affine addition cannot double, so start with 2*b. */
+        ecp_nistz256_point_double(&row[1], &row[0]);
+        for (i = 2; i < 64; i++)
+            ecp_nistz256_point_add_affine(&row[i], &row[i - 1], &b);
+        /* 128*b, the base of the next row */
+        ecp_nistz256_point_double(&row[64], &row[63]);
+
+        memcpy(prod[0], row[0].Z, sizeof(prod[0]));
+        for (i = 1; i < 65; i++)
+            ecp_nistz256_mul_mont(prod[i], prod[i - 1], row[i].Z);
+
+        ecp_nistz256_mod_inverse(inv, prod[64]);
+
+        for (i = 64; i >= 0; i--) {
+            if (i > 0) {
+                ecp_nistz256_mul_mont(z_inv, inv, prod[i - 1]);
+                ecp_nistz256_mul_mont(inv, inv, row[i].Z);
+            } else {
+                memcpy(z_inv, inv, sizeof(z_inv));
+            }
+            ecp_nistz256_sqr_mont(z_inv2, z_inv);
+            ecp_nistz256_mul_mont(row[i].X, row[i].X, z_inv2);
+            ecp_nistz256_mul_mont(z_inv2, z_inv2, z_inv);
+            ecp_nistz256_mul_mont(row[i].Y, row[i].Y, z_inv2);
+        }
+
+        for (i = 0; i < 64; i++) {
+            memcpy(table[j][i].X, row[i].X, sizeof(row[i].X));
+            memcpy(table[j][i].Y, row[i].Y, sizeof(row[i].Y));
+        }
+        memcpy(b.X, row[64].X, sizeof(b.X));
+        memcpy(b.Y, row[64].Y, sizeof(b.Y));
+    }
+
+    vigortls_zeroize(row, sizeof(row));
+}
+
+/*
+ * ecp_nistz256_table_new returns a new EC_PRE_COMP holding the table of
+ * multiples of |base| for |group|, or NULL on allocation failure.
+ */
+static EC_PRE_COMP *ecp_nistz256_table_new(const EC_GROUP *group,
+                                           const P256_POINT_AFFINE *base)
+{
+    EC_PRE_COMP *pre_comp;
+    uint8_t *precomp_storage;
+
+    if ((pre_comp = ecp_nistz256_pre_comp_new(group)) == NULL)
+        return NULL;
+
+    if ((precomp_storage = malloc(37 * sizeof(PRECOMP256_ROW) + 64)) == NULL) {
+        ECerr(EC_F_ECP_NISTZ256_PRE_COMP_NEW, ERR_R_MALLOC_FAILURE);
+        ecp_nistz256_pre_comp_free(pre_comp);
+        return NULL;
+    }
+
+    pre_comp->w = 7;
+    pre_comp->precomp = (void *)ALIGNPTR(precomp_storage, 64);
+    pre_comp->precomp_storage = precomp_storage;
+
+    ecp_nistz256_build_table(pre_comp->precomp, base);
+
+    return pre_comp;
+}
+
 static int ecp_nistz256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
 {
     /* We precompute a table for a Booth encoded exponent (wNAF) based
      * computation. Each table holds 64 values for safe access, with an
      * implicit value of infinity at index zero. We use window of size 7,
      * and therefore require ceil(256/7) = 37 tables. */
-    BIGNUM *order;
-    EC_POINT *P = NULL, *T = NULL;
     const EC_POINT *generator;
     EC_PRE_COMP *pre_comp;
-    int i, j, k, ret = 0;
-    size_t w;
-
-    PRECOMP256_ROW *preComputedTable = NULL;
-    uint8_t *precomp_storage = NULL;
+    P256_POINT_AFFINE base;
 
     /* if there is an old EC_PRE_COMP object, throw it away */
     EC_EX_DATA_free_data(&group->extra_data, ecp_nistz256_pre_comp_dup, ecp_nistz256_pre_comp_free,
@@ -781,97 +1143,26 @@ static int ecp_nistz256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
         return 1;
     }
 
-    if ((pre_comp = ecp_nistz256_pre_comp_new(group)) == NULL)
-        return 0;
-
-    if (ctx == NULL) {
-        ctx = BN_CTX_new();
-        if (ctx == NULL)
-            goto err;
-    }
-
-    BN_CTX_start(ctx);
-    order = BN_CTX_get(ctx);
-
-    if (order == NULL)
-        goto err;
-
-    if (!EC_GROUP_get_order(group, order, ctx))
-        goto err;
-
-    if (BN_is_zero(order)) {
+    if (BN_is_zero(&group->order)) {
         ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE, EC_R_UNKNOWN_ORDER);
-        goto err;
-    }
-
-    w = 7;
-
-    if ((precomp_storage = malloc(37 * 64 * sizeof(P256_POINT_AFFINE) + 64)) == NULL) {
-        ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE, ERR_R_MALLOC_FAILURE);
-        goto err;
-    } else {
-        preComputedTable = (void *)ALIGNPTR(precomp_storage, 64);
+        return 0;
     }
 
-    P = EC_POINT_new(group);
-    T = EC_POINT_new(group);
-    if (P == NULL || T == NULL)
-        goto err;
-
-    /* The zero entry is implicitly infinity, and we skip it,
-     * storing other values with -1 offset. */
-    if (EC_POINT_copy(T, generator) == 0)
-        goto err;
-
-    for (k = 0; k < 64; k++) {
-        if (EC_POINT_copy(P, T) == 0)
-            goto err;
-        for (j = 0; j < 37; j++) {
-            /* 
-             * It would be faster to use EC_POINTs_make_affine and make multiple
-             * points affine at the same time.
-             */
-            if (!EC_POINT_make_affine(group, P, ctx))
-                goto err;
-            if (!ecp_nistz256_bignum_to_field_elem(preComputedTable[j][k].X, &P->X) ||
-                !ecp_nistz256_bignum_to_field_elem(preComputedTable[j][k].Y, &P->Y)) {
-                ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE,
-                      EC_R_COORDINATES_OUT_OF_RANGE);
-                goto err;
-            }
-            for (i = 0; i < 7; i++) {
-                if (!EC_POINT_dbl(group, P, P, ctx))
-                    goto err;
-            }
-        }
-        if (!EC_POINT_add(group, T, T, generator, ctx))
-            goto err;
+    if (!ecp_nistz256_point_get_affine_mont(&base, generator)) {
+        ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
     }
 
-    pre_comp->group = group;
-    pre_comp->w = w;
-    pre_comp->precomp = preComputedTable;
-    pre_comp->precomp_storage = precomp_storage;
-
-    precomp_storage = NULL;
+    if ((pre_comp = ecp_nistz256_table_new(group, &base)) == NULL)
+        return 0;
 
     if (!EC_EX_DATA_set_data(&group->extra_data, pre_comp, ecp_nistz256_pre_comp_dup,
                              ecp_nistz256_pre_comp_free, ecp_nistz256_pre_comp_clear_free)) {
-        goto err;
+        ecp_nistz256_pre_comp_free(pre_comp);
+        return 0;
     }
 
-    pre_comp = NULL;
-
-    ret = 1;
-
-err:
-    BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
-    ecp_nistz256_pre_comp_free(pre_comp);
-    free(precomp_storage);
-    EC_POINT_free(P);
-    EC_POINT_free(T);
-    return ret;
+    return 1;
 }
 
 /*
@@ -1071,6 +1362,114 @@ static void ecp_nistz256_avx2_mul_g(P256_POINT *r, uint8_t p_str[33],
 #endif
 #endif
 
+/*
+ * ecp_nistz256_scalar_to_str writes |scalar|, which must be non-negative and
+ * at most 256 bits long, to |p_str| in little-endian order, padded with
+ * zeros for the window extraction of ecp_nistz256_mul_table.
+ */
+static void ecp_nistz256_scalar_to_str(uint8_t p_str[33], const BIGNUM *scalar)
+{
+    int i;
+
+    for (i = 0; i < scalar->top * BN_BYTES; i += BN_BYTES) {
+        BN_ULONG d = scalar->d[i / BN_BYTES];
+
+        p_str[i + 0] = d & 0xff;
+        p_str[i + 1] = (d >> 8) & 0xff;
+        p_str[i + 2] = (d >> 16) & 0xff;
+        p_str[i + 3] = (d >>= 24) & 0xff;
+        if (BN_BYTES == 8) {
+            d >>= 8;
+            p_str[i + 4] = d & 0xff;
+            p_str[i + 5] = (d >> 8) & 0xff;
+            p_str[i + 6] = (d >> 16) & 0xff;
+            p_str[i + 7] = (d >> 24) & 0xff;
+        }
+    }
+
+    for (; i < 33; i++)
+        p_str[i] = 0;
+}
+
+/*
+ * ecp_nistz256_mul_table sets |r| to the scalar in |p_str| times the point
+ * for which |preComputedTable| was built, see ecp_nistz256_build_table.
+ */
+static void ecp_nistz256_mul_table(P256_POINT *r, uint8_t p_str[33],
+                                   const PRECOMP256_ROW *preComputedTable)
+{
+    const unsigned int window_size = 7;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue, index = 0;
+    ALIGN32 union {
+        P256_POINT p;
+        P256_POINT_AFFINE a;
+    } t, p;
+    int i;
+
+#if defined(ECP_NISTZ256_AVX2)
+    if (ecp_nistz_avx2_eligible()) {
+        ecp_nistz256_avx2_mul_g(&p.p, p_str, preComputedTable);
+    } else
+#endif
+    {
+        BN_ULONG infty;
+        /* First window */
+        wvalue = (p_str[0] << 1) & mask;
+        index += window_size;
+
+        wvalue = _booth_recode_w7(wvalue);
+
+        ecp_nistz256_select_w7(&p.a, preComputedTable[0], wvalue >> 1);
+
+        ecp_nistz256_neg(p.p.Z, p.p.Y);
+        copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
+
+        /*
+         * Since affine infinity is encoded as (0,0) and
+         * Jacobian ias (,,0), we need to harmonize them
+         * by assigning "one" or zero to Z.
+         */
+        infty = (p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3] |
+                 p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3]);
+        if (P256_LIMBS == 8)
+            infty |= (p.p.X[4] | p.p.X[5] | p.p.X[6] | p.p.X[7] |
+                      p.p.Y[4] | p.p.Y[5] | p.p.Y[6] | p.p.Y[7]);
+
+        infty = 0 - is_zero(infty);
+        infty = ~infty;
+
+        p.p.Z[0] = ONE[0] & infty;
+        p.p.Z[1] = ONE[1] & infty;
+        p.p.Z[2] = ONE[2] & infty;
+        p.p.Z[3] = ONE[3] & infty;
+        if (P256_LIMBS == 8) {
+            p.p.Z[4] = ONE[4] & infty;
+            p.p.Z[5] = ONE[5] & infty;
+            p.p.Z[6] = ONE[6] & infty;
+            p.p.Z[7] = ONE[7] & infty;
+        }
+
+        for (i = 1; i < 37; i++) {
+            unsigned int off = (index - 1) / 8;
+            wvalue = p_str[off] | p_str[off + 1] << 8;
+            wvalue = (wvalue >> ((index - 1) % 8)) & mask;
+            index += window_size;
+
+            wvalue = _booth_recode_w7(wvalue);
+
+            ecp_nistz256_select_w7(&t.a, preComputedTable[i], wvalue >> 1);
+
+            ecp_nistz256_neg(t.p.Z, t.a.Y);
+            copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
+
+            ecp_nistz256_point_add_affine(&p.p, &p.p, &t.a);
+        }
+    }
+
+    memcpy(r, &p.p, sizeof(p.p));
+}
+
 static int ecp_nistz256_set_from_affine(EC_POINT *out, const EC_GROUP *group,
                                         const P256_POINT_AFFINE *in, BN_CTX *ctx)
 {
@@ -1101,19 +1500,15 @@ static int ecp_nistz256_points_mul(const EC_GROUP *group, EC_POINT *r,
                                    const EC_POINT *points[],
                                    const BIGNUM *scalars[], BN_CTX *ctx)
 {
-    int i = 0, ret = 0, no_precomp_for_generator = 0, p_is_infinity = 0;
+    int ret = 0, no_precomp_for_generator = 0, p_is_infinity = 0;
     size_t j;
     uint8_t p_str[33] = { 0 };
     const PRECOMP256_ROW *preComputedTable = NULL;
     const EC_PRE_COMP *pre_comp = NULL;
     const EC_POINT *generator = NULL;
-    unsigned int index = 0;
     BN_CTX *new_ctx = NULL;
     const BIGNUM **new_scalars = NULL;
     const EC_POINT **new_points = NULL;
-    const unsigned int window_size = 7;
-    const unsigned int mask = (1 << (window_size + 1)) - 1;
-    unsigned int wvalue;
     ALIGN32 union {
         P256_POINT p;
         P256_POINT_AFFINE a;
@@ -1194,84 +1589,8 @@ static int ecp_nistz256_points_mul(const EC_GROUP *group, EC_POINT *r,
                 scalar = tmp_scalar;
             }
 
-            for (i = 0; i < scalar->top * BN_BYTES; i += BN_BYTES) {
-                BN_ULONG d = scalar->d[i / BN_BYTES];
-
-                p_str[i + 0] = d & 0xff;
-                p_str[i + 1] = (d >> 8) & 0xff;
-                p_str[i + 2] = (d >> 16) & 0xff;
-                p_str[i + 3] = (d >>= 24) & 0xff;
-                if (BN_BYTES == 8) {
-                    d >>= 8;
-                    p_str[i + 4] = d & 0xff;
-                    p_str[i + 5] = (d >> 8) & 0xff;
-                    p_str[i + 6] = (d >> 16) & 0xff;
-                    p_str[i + 7] = (d >> 24) & 0xff;
-                }
-            }
-
-            for (; i < 33; i++)
-                p_str[i] = 0;
-
-#if defined(ECP_NISTZ256_AVX2)
-            if (ecp_nistz_avx2_eligible()) {
-                ecp_nistz256_avx2_mul_g(&p.p, p_str, preComputedTable);
-            } else
-#endif
-            {
-                BN_ULONG infty;
-                /* First window */
-                wvalue = (p_str[0] << 1) & mask;
-                index += window_size;
-
-                wvalue = _booth_recode_w7(wvalue);
-
-                ecp_nistz256_select_w7(&p.a, preComputedTable[0], wvalue >> 1);
-
-                ecp_nistz256_neg(p.p.Z, p.p.Y);
-                copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
-
-                /*
-                 * Since affine infinity is encoded as (0,0) and
-                 * Jacobian ias (,,0), we need to harmonize them
-                 * by assigning "one" or zero to Z.
-                 */
-                infty = (p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3] |
-                         p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3]);
-                if (P256_LIMBS == 8)
-                    infty |= (p.p.X[4] | p.p.X[5] | p.p.X[6] | p.p.X[7] |
-                              p.p.Y[4] | p.p.Y[5] | p.p.Y[6] | p.p.Y[7]);
-
-                infty = 0 - is_zero(infty);
-                infty = ~infty;
-
-                p.p.Z[0] = ONE[0] & infty;
-                p.p.Z[1] = ONE[1] & infty;
-                p.p.Z[2] = ONE[2] & infty;
-                p.p.Z[3] = ONE[3] & infty;
-                if (P256_LIMBS == 8) {
-                    p.p.Z[4] = ONE[4] & infty;
-                    p.p.Z[5] = ONE[5] & infty;
-                    p.p.Z[6] = ONE[6] & infty;
-                    p.p.Z[7] = ONE[7] & infty;
-                }
-
-                for (i = 1; i < 37; i++) {
-                    unsigned int off = (index - 1) / 8;
-                    wvalue = p_str[off] | p_str[off + 1] << 8;
-                    wvalue = (wvalue >> ((index - 1) % 8)) & mask;
-                    index += window_size;
-
-                    wvalue = _booth_recode_w7(wvalue);
-
-                    ecp_nistz256_select_w7(&t.a, preComputedTable[i], wvalue >> 1);
-
-                    ecp_nistz256_neg(t.p.Z, t.a.Y);
-                    copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
-
-                    ecp_nistz256_point_add_affine(&p.p, &p.p, &t.a);
-                }
-            }
+            ecp_nistz256_scalar_to_str(p_str, scalar);
+            ecp_nistz256_mul_table(&p.p, p_str, preComputedTable);
         } else {
             p_is_infinity = 1;
             no_precomp_for_generator = 1;
@@ -1358,6 +1677,21 @@ static int ecp_nistz256_get_affine(const EC_GROUP *group, const EC_POINT *point,
         return 0;
     }
 
+    if (point->Z_is_one) {
+        /* Already affine, e.g. after EC_POINTs_make_affine. */
+        if (x != NULL) {
+            ecp_nistz256_from_mont(x_ret, point_x);
+            if (!ecp_nistz256_set_words(x, x_ret))
+                return 0;
+        }
+        if (y != NULL) {
+            ecp_nistz256_from_mont(y_ret, point_y);
+            if (!ecp_nistz256_set_words(y, y_ret))
+                return 0;
+        }
+        return 1;
+    }
+
     ecp_nistz256_mod_inverse(z_inv3, point_z);
     ecp_nistz256_sqr_mont(z_inv2, z_inv3);
     ecp_nistz256_mul_mont(x_aff, z_inv2, point_x);
@@ -1427,7 +1761,7 @@ static void ecp_nistz256_pre_comp_free(void *pre_)
     if (pre == NULL)
         return;
 
-    CRYPTO_atomic_add(&pre->references, 1, &i, pre->lock);
+    CRYPTO_atomic_add(&pre->references, -1, &i, pre->lock);
     if (i > 0)
         return;
 
@@ -1450,8 +1784,7 @@ static void ecp_nistz256_pre_comp_clear_free(void *pre_)
 
     CRYPTO_thread_cleanup(pre->lock);
     if (pre->precomp_storage) {
-        vigortls_zeroize(pre->precomp,
-                         32 * sizeof(uint8_t) * ((size_t)1 << pre->w) * 2 * 37);
+        vigortls_zeroize(pre->precomp, 37 * sizeof(PRECOMP256_ROW));
         free(pre->precomp_storage);
     }
     vigortls_zeroize(pre, sizeof *pre);
@@ -1472,6 +1805,134 @@ static int ecp_nistz256_window_have_precompute_mult(const EC_GROUP *group)
                                ecp_nistz256_pre_comp_clear_free) != NULL;
 }
 
+/*
+ * ecp_nistz256_key_table_get returns a reference to the table of multiples
+ * of the public key of |key|, or NULL if none has been built. The caller
+ * must release it with ecp_nistz256_pre_comp_free.
+ */
+static EC_PRE_COMP *ecp_nistz256_key_table_get(const EC_KEY *key)
+{
+    EC_PRE_COMP *pre_comp;
+
+    if (CRYPTO_atomic_get_ptr((void **)&key->key_table, key->lock) == NULL)
+        return NULL;
+
+    CRYPTO_thread_read_lock(key->lock);
+    pre_comp = EC_EX_DATA_get_data(key->method_data, ecp_nistz256_pre_comp_dup,
+                                   ecp_nistz256_pre_comp_free,
+                                   ecp_nistz256_pre_comp_clear_free);
+    if (pre_comp != NULL)
+        ecp_nistz256_pre_comp_dup(pre_comp);
+    CRYPTO_thread_unlock(key->lock);
+
+    return pre_comp;
+}
+
+static int ecp_nistz256_key_precompute_mult(EC_KEY *key, BN_CTX *ctx)
+{
+    P256_POINT_AFFINE base;
+    EC_PRE_COMP *pre_comp;
+    int ret;
+
+    if (key->group->meth != key->pub_key->meth) {
+        ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE, EC_R_INCOMPATIBLE_OBJECTS);
+        return 0;
+    }
+
+    if (!ecp_nistz256_point_get_affine_mont(&base, key->pub_key)) {
+        ECerr(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+
+    if ((pre_comp = ecp_nistz256_table_new(key->group, &base)) == NULL)
+        return 0;
+
+    /* Replace any table built for a previous public key. Users of the old
+     * table hold their own reference to it. */
+    CRYPTO_thread_write_lock(key->lock);
+    EC_EX_DATA_free_data(&key->method_data, ecp_nistz256_pre_comp_dup,
+                         ecp_nistz256_pre_comp_free,
+                         ecp_nistz256_pre_comp_clear_free);
+    ret = EC_EX_DATA_set_data(&key->method_data, pre_comp,
+                              ecp_nistz256_pre_comp_dup,
+                              ecp_nistz256_pre_comp_free,
+                              ecp_nistz256_pre_comp_clear_free);
+    if (ret)
+        CRYPTO_atomic_set_ptr(&key->key_table, pre_comp, NULL);
+    CRYPTO_thread_unlock(key->lock);
+
+    if (!ret)
+        ecp_nistz256_pre_comp_free(pre_comp);
+
+    return ret;
+}
+
+static size_t ecp_nistz256_key_precompute_size(const EC_KEY *key)
+{
+    EC_PRE_COMP *pre_comp;
+
+    if ((pre_comp = ecp_nistz256_key_table_get(key)) == NULL)
+        return 0;
+    ecp_nistz256_pre_comp_free(pre_comp);
+
+    return 37 * sizeof(PRECOMP256_ROW);
+}
+
+/* r = g_scalar*G + p_scalar*pub_key, using the public key table if any */
+static int ecp_nistz256_key_points_mul(const EC_KEY *key, EC_POINT *r,
+                                       const BIGNUM *g_scalar,
+                                       const BIGNUM *p_scalar, BN_CTX *ctx)
+{
+    const EC_POINT *pub_key = key->pub_key;
+    EC_PRE_COMP *pre_comp;
+    P256_POINT_AFFINE pub;
+    ALIGN32 P256_POINT acc, out;
+    uint8_t p_str[33];
+    int ret = 0;
+
+    pre_comp = ecp_nistz256_key_table_get(key);
+
+    /* The table is only used if it was built for the current public key,
+     * which is its first entry. */
+    if (pre_comp == NULL || p_scalar == NULL ||
+        BN_is_negative(p_scalar) || BN_num_bits(p_scalar) > 256 ||
+        r->meth != key->group->meth || pub_key->meth != key->group->meth ||
+        !ecp_nistz256_point_get_affine_mont(&pub, pub_key) ||
+        !is_equal(pub.X, pre_comp->precomp[0][0].X) ||
+        !is_equal(pub.Y, pre_comp->precomp[0][0].Y)) {
+        ecp_nistz256_pre_comp_free(pre_comp);
+        return ecp_nistz256_points_mul(key->group, r, g_scalar,
+                                       pub_key != NULL, &pub_key, &p_scalar,
+                                       ctx);
+    }
+
+    if (!ecp_nistz256_points_mul(key->group, r, g_scalar, 0, NULL, NULL, ctx))
+        goto err;
+
+    if (!ecp_nistz256_bignum_to_field_elem(acc.X, &r->X) ||
+        !ecp_nistz256_bignum_to_field_elem(acc.Y, &r->Y) ||
+        !ecp_nistz256_bignum_to_field_elem(acc.Z, &r->Z)) {
+        ECerr(EC_F_ECP_NISTZ256_POINTS_MUL, EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+
+    ecp_nistz256_scalar_to_str(p_str, p_scalar);
+    ecp_nistz256_mul_table(&out, p_str, pre_comp->precomp);
+    ecp_nistz256_point_add(&acc, &acc, &out);
+
+    if (!ecp_nistz256_set_words(&r->X, acc.X) ||
+        !ecp_nistz256_set_words(&r->Y, acc.Y) ||
+        !ecp_nistz256_set_words(&r->Z, acc.Z))
+        goto err;
+    r->Z_is_one = is_one(&r->Z) & 1;
+
+    ret = 1;
+
+err:
+    ecp_nistz256_pre_comp_free(pre_comp);
+    return ret;
+}
+
 const EC_METHOD *EC_GFp_nistz256_method(void)
 {
     static const EC_METHOD ret = { 
@@ -1493,7 +1954,12 @@ const EC_METHOD *EC_GFp_nistz256_method(void)
             ecp_nistz256_window_have_precompute_mult, /* have_precompute_mult */
             ec_GFp_mont_field_mul, ec_GFp_mont_field_sqr, 0, /* field_div */
             ec_GFp_mont_field_encode, ec_GFp_mont_field_decode,
-            ec_GFp_mont_field_set_to_one
+            ec_GFp_mont_field_set_to_one,
+            ecp_nistz256_order_mul,     /* order_mul */
+            ecp_nistz256_order_inverse, /* order_inverse */
+            ecp_nistz256_key_precompute_mult, /* key_precompute_mult */
+            ecp_nistz256_key_precompute_size, /* key_precompute_size */
+            ecp_nistz256_key_points_mul       /* key_points_mul */
     };
 
     return &ret;
@@ -59,7 +59,7 @@ static int ecdh_compute_key(void *out, size_t outlen, const EC_POINT *pub_key,
         return -1;
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
     BN_CTX_start(ctx);
     x = BN_CTX_get(ctx);
@@ -54,6 +54,14 @@ typedef struct ecdsa_data_st {
  */
 ECDSA_DATA *ecdsa_check(EC_KEY *eckey);
 
+/** ecdsa_verify_batch
+ * verifies a batch of signatures with the built-in method, see
+ * ECDSA_do_verify_batch.
+ */
+int ecdsa_verify_batch(size_t num, const uint8_t *const *dgsts,
+                       const int *dgst_lens, const ECDSA_SIG *const *sigs,
+                       EC_KEY *const *eckeys, int *results);
+
 #ifdef __cplusplus
 }
 #endif
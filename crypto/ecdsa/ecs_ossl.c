@@ -12,6 +12,8 @@
 #include <openssl/obj_mac.h>
 #include <openssl/bn.h>
 
+#include "internal/ec_int.h"
+
 static ECDSA_SIG *ecdsa_do_sign(const uint8_t *dgst, int dlen,
                                 const BIGNUM *, const BIGNUM *, EC_KEY *eckey);
 static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in, BIGNUM **kinvp,
@@ -46,17 +48,18 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in, BIGNUM **kinvp,
     }
 
     if (ctx_in == NULL) {
-        if ((ctx = BN_CTX_new()) == NULL) {
+        if ((ctx = BN_CTX_new_cached()) == NULL) {
             ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_MALLOC_FAILURE);
             return 0;
         }
     } else
         ctx = ctx_in;
+    BN_CTX_start(ctx);
 
     k = BN_new(); /* this value is later returned in *kinvp */
     r = BN_new(); /* this value is later returned in *rp    */
-    order = BN_new();
-    X = BN_new();
+    order = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
     if (!k || !r || !order || !X) {
         ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_MALLOC_FAILURE);
         goto err;
@@ -119,30 +122,9 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in, BIGNUM **kinvp,
     } while (BN_is_zero(r));
 
     /* compute the inverse of k */
-    if (EC_GROUP_get_mont_data(group) != NULL) {
-        /*
-         * We want inverse in constant time, therefore we utilize the fact
-         * order must be prime and use Fermats Little Theorem instead.
-         */
-        if (!BN_set_word(X, 2)) {
-            ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_BN_LIB);
-            goto err;
-        }
-        if (!BN_mod_sub(X, order, X, order, ctx)) {
-            ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_BN_LIB);
-            goto err;
-        }
-        BN_set_flags(X, BN_FLG_CONSTTIME);
-        if (!BN_mod_exp_mont_consttime
-            (k, k, X, order, ctx, EC_GROUP_get_mont_data(group))) {
-            ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_BN_LIB);
-            goto err;
-        }
-    } else {
-        if (!BN_mod_inverse(k, k, order, ctx)) {
-            ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_BN_LIB);
-            goto err;
-        }
+    if (!ec_group_do_inverse_ord(group, k, k, ctx)) {
+        ECDSAerr(ECDSA_F_ECDSA_SIGN_SETUP, ERR_R_BN_LIB);
+        goto err;
     }
 
     /* clear old values if necessary */
@@ -157,11 +139,10 @@ err:
         BN_clear_free(k);
         BN_clear_free(r);
     }
+    BN_CTX_end(ctx);
     if (ctx_in == NULL)
         BN_CTX_free(ctx);
-    BN_free(order);
     EC_POINT_free(tmp_point);
-    BN_clear_free(X);
     return (ret);
 }
 
@@ -193,7 +174,13 @@ static ECDSA_SIG *ecdsa_do_sign(const uint8_t *dgst, int dgst_len,
     }
     s = ret->s;
 
-    if ((ctx = BN_CTX_new()) == NULL || (order = BN_new()) == NULL || (tmp = BN_new()) == NULL || (m = BN_new()) == NULL) {
+    if ((ctx = BN_CTX_new_cached()) == NULL) {
+        ECDSAerr(ECDSA_F_ECDSA_DO_SIGN, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    BN_CTX_start(ctx);
+    if ((order = BN_CTX_get(ctx)) == NULL || (tmp = BN_CTX_get(ctx)) == NULL ||
+        (m = BN_CTX_get(ctx)) == NULL) {
         ECDSAerr(ECDSA_F_ECDSA_DO_SIGN, ERR_R_MALLOC_FAILURE);
         goto err;
     }
@@ -232,7 +219,7 @@ static ECDSA_SIG *ecdsa_do_sign(const uint8_t *dgst, int dgst_len,
             }
         }
 
-        if (!BN_mod_mul(tmp, priv_key, ret->r, order, ctx)) {
+        if (!ec_group_do_order_mul(group, tmp, priv_key, ret->r, ctx)) {
             ECDSAerr(ECDSA_F_ECDSA_DO_SIGN, ERR_R_BN_LIB);
             goto err;
         }
@@ -240,7 +227,7 @@ static ECDSA_SIG *ecdsa_do_sign(const uint8_t *dgst, int dgst_len,
             ECDSAerr(ECDSA_F_ECDSA_DO_SIGN, ERR_R_BN_LIB);
             goto err;
         }
-        if (!BN_mod_mul(s, s, ckinv, order, ctx)) {
+        if (!ec_group_do_order_mul(group, s, s, ckinv, ctx)) {
             ECDSAerr(ECDSA_F_ECDSA_DO_SIGN, ERR_R_BN_LIB);
             goto err;
         }
@@ -262,14 +249,10 @@ err:
         ECDSA_SIG_free(ret);
         ret = NULL;
     }
-    if (ctx)
+    if (ctx) {
+        BN_CTX_end(ctx);
         BN_CTX_free(ctx);
-    if (m)
-        BN_clear_free(m);
-    if (tmp)
-        BN_clear_free(tmp);
-    if (order)
-        BN_free(order);
+    }
     if (kinv)
         BN_clear_free(kinv);
     return ret;
@@ -291,7 +274,7 @@ static int ecdsa_do_verify(const uint8_t *dgst, int dgst_len,
         return -1;
     }
 
-    ctx = BN_CTX_new();
+    ctx = BN_CTX_new_cached();
     if (!ctx) {
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
         return -1;
@@ -318,7 +301,7 @@ static int ecdsa_do_verify(const uint8_t *dgst, int dgst_len,
         goto err;
     }
     /* calculate tmp1 = inv(S) mod order */
-    if (!BN_mod_inverse(u2, sig->s, order, ctx)) {
+    if (!ec_group_do_public_inverse_ord(group, u2, sig->s, ctx)) {
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
         goto err;
     }
@@ -339,12 +322,12 @@ static int ecdsa_do_verify(const uint8_t *dgst, int dgst_len,
         goto err;
     }
     /* u1 = m * tmp mod order */
-    if (!BN_mod_mul(u1, m, u2, order, ctx)) {
+    if (!ec_group_do_order_mul(group, u1, m, u2, ctx)) {
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
         goto err;
     }
     /* u2 = r * w mod q */
-    if (!BN_mod_mul(u2, sig->r, u2, order, ctx)) {
+    if (!ec_group_do_order_mul(group, u2, sig->r, u2, ctx)) {
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
         goto err;
     }
@@ -353,7 +336,7 @@ static int ecdsa_do_verify(const uint8_t *dgst, int dgst_len,
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
         goto err;
     }
-    if (!EC_POINT_mul(group, point, u1, pub_key, u2, ctx)) {
+    if (!ec_key_do_verify_mul(eckey, point, u1, u2, ctx)) {
         ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_EC_LIB);
         goto err;
     }
@@ -387,3 +370,303 @@ err:
         EC_POINT_free(point);
     return ret;
 }
+
+/* ecdsa_digest_to_bn sets |m| to the leftmost bits of |dgst|, truncated to
+ * the length of |order|. */
+static int ecdsa_digest_to_bn(BIGNUM *m, const uint8_t *dgst, int dgst_len,
+                              const BIGNUM *order)
+{
+    int i = BN_num_bits(order);
+
+    /* Need to truncate digest if it is too long: first truncate whole
+     * bytes. */
+    if (8 * dgst_len > i)
+        dgst_len = (i + 7) / 8;
+    if (!BN_bin2bn(dgst, dgst_len, m))
+        return 0;
+    /* If still too long truncate remaining bits with a shift */
+    if ((8 * dgst_len > i) && !BN_rshift(m, m, 8 - (i & 0x7)))
+        return 0;
+    return 1;
+}
+
+/* ecdsa_batch_invert replaces each of the |num| values |v[idx[k]]| with its
+ * inverse modulo the order of |group|, using a single inversion
+ * (Montgomery's trick). The values must be non-zero and reduced. */
+static int ecdsa_batch_invert(const EC_GROUP *group, BIGNUM **v,
+                              const size_t *idx, size_t num, BIGNUM **prefix,
+                              BN_CTX *ctx)
+{
+    BIGNUM *inv, *t;
+    size_t k;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    inv = BN_CTX_get(ctx);
+    t = BN_CTX_get(ctx);
+    if (t == NULL)
+        goto err;
+
+    /* prefix[k] = v[idx[0]] * ... * v[idx[k]] */
+    if (BN_copy(prefix[0], v[idx[0]]) == NULL)
+        goto err;
+    for (k = 1; k < num; k++) {
+        if (!ec_group_do_order_mul(group, prefix[k], prefix[k - 1], v[idx[k]], ctx))
+            goto err;
+    }
+
+    if (!ec_group_do_public_inverse_ord(group, inv, prefix[num - 1], ctx))
+        goto err;
+
+    for (k = num - 1; k > 0; k--) {
+        /* inv = (v[idx[0]] * ... * v[idx[k]])^-1 */
+        if (!ec_group_do_order_mul(group, t, inv, prefix[k - 1], ctx) ||
+            !ec_group_do_order_mul(group, inv, inv, v[idx[k]], ctx) ||
+            BN_copy(v[idx[k]], t) == NULL)
+            goto err;
+    }
+    if (BN_copy(v[idx[0]], inv) == NULL)
+        goto err;
+
+    ret = 1;
+
+err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/* Processing state of each batch entry in ecdsa_verify_batch */
+#define BATCH_PENDING    0 /* input checked */
+#define BATCH_INVERTED   1 /* w = inv(s) computed */
+#define BATCH_MULTIPLIED 2 /* u1 * generator + u2 * pub_key computed */
+#define BATCH_AFFINE     3 /* point converted to affine form */
+#define BATCH_DONE       4 /* result known */
+
+/* ecdsa_same_curve returns one if |a| and |b| are the same named curve
+ * implemented by the same method. */
+static int ecdsa_same_curve(const EC_GROUP *a, const EC_GROUP *b)
+{
+    return EC_GROUP_get_curve_name(a) != NID_undef &&
+           EC_GROUP_get_curve_name(a) == EC_GROUP_get_curve_name(b) &&
+           EC_GROUP_method_of(a) == EC_GROUP_method_of(b);
+}
+
+int ecdsa_verify_batch(size_t num, const uint8_t *const *dgsts,
+                       const int *dgst_lens, const ECDSA_SIG *const *sigs,
+                       EC_KEY *const *eckeys, int *results)
+{
+    BN_CTX *ctx = NULL;
+    BIGNUM **w = NULL, **prefix = NULL;
+    BIGNUM *order, *other, *u1, *u2, *m, *X;
+    EC_POINT **points = NULL, **run_points = NULL;
+    const EC_GROUP *group;
+    size_t *run = NULL;
+    uint8_t *state = NULL;
+    size_t i, j, nrun;
+    int ret = -1;
+
+    if (num == 0)
+        return 1;
+
+    for (i = 0; i < num; i++)
+        results[i] = -1;
+
+    if ((ctx = BN_CTX_new_cached()) == NULL) {
+        ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
+        return -1;
+    }
+    BN_CTX_start(ctx);
+
+    if ((w = calloc(num, sizeof(BIGNUM *))) == NULL ||
+        (prefix = calloc(num, sizeof(BIGNUM *))) == NULL ||
+        (points = calloc(num, sizeof(EC_POINT *))) == NULL ||
+        (run_points = calloc(num, sizeof(EC_POINT *))) == NULL ||
+        (run = calloc(num, sizeof(size_t))) == NULL ||
+        (state = calloc(num, 1)) == NULL) {
+        ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    order = BN_CTX_get(ctx);
+    other = BN_CTX_get(ctx);
+    u1 = BN_CTX_get(ctx);
+    u2 = BN_CTX_get(ctx);
+    m = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
+    if (X == NULL) {
+        ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+        goto err;
+    }
+    for (i = 0; i < num; i++) {
+        if ((w[i] = BN_new()) == NULL || (prefix[i] = BN_new()) == NULL) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+    }
+
+    /* check input values */
+    for (i = 0; i < num; i++) {
+        state[i] = BATCH_DONE;
+        if (eckeys[i] == NULL || sigs[i] == NULL ||
+            (group = EC_KEY_get0_group(eckeys[i])) == NULL ||
+            EC_KEY_get0_public_key(eckeys[i]) == NULL) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ECDSA_R_MISSING_PARAMETERS);
+            continue;
+        }
+        if (!EC_GROUP_get_order(group, order, ctx)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_EC_LIB);
+            continue;
+        }
+        if (BN_is_zero(sigs[i]->r) || BN_is_negative(sigs[i]->r) ||
+            BN_ucmp(sigs[i]->r, order) >= 0 || BN_is_zero(sigs[i]->s) ||
+            BN_is_negative(sigs[i]->s) || BN_ucmp(sigs[i]->s, order) >= 0) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ECDSA_R_BAD_SIGNATURE);
+            results[i] = 0; /* signature is invalid */
+            continue;
+        }
+        if (BN_copy(w[i], sigs[i]->s) == NULL) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+            continue;
+        }
+        state[i] = BATCH_PENDING;
+    }
+
+    /* w = inv(s) mod order, inverting the s values of all entries with the
+     * same order together */
+    for (i = 0; i < num; i++) {
+        if (state[i] != BATCH_PENDING)
+            continue;
+        group = EC_KEY_get0_group(eckeys[i]);
+        if (!EC_GROUP_get_order(group, order, ctx))
+            goto err;
+        nrun = 0;
+        for (j = i; j < num; j++) {
+            if (state[j] != BATCH_PENDING)
+                continue;
+            if (j != i &&
+                (!EC_GROUP_get_order(EC_KEY_get0_group(eckeys[j]), other, ctx) ||
+                 BN_cmp(order, other) != 0))
+                continue;
+            run[nrun++] = j;
+        }
+        if (!ecdsa_batch_invert(group, w, run, nrun, prefix, ctx)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+            for (j = 0; j < nrun; j++)
+                state[run[j]] = BATCH_DONE;
+            continue;
+        }
+        for (j = 0; j < nrun; j++)
+            state[run[j]] = BATCH_INVERTED;
+    }
+
+    /* point = u1 * generator + u2 * pub_key */
+    for (i = 0; i < num; i++) {
+        if (state[i] != BATCH_INVERTED)
+            continue;
+        state[i] = BATCH_DONE;
+        group = EC_KEY_get0_group(eckeys[i]);
+        if (!EC_GROUP_get_order(group, order, ctx) ||
+            !ecdsa_digest_to_bn(m, dgsts[i], dgst_lens[i], order)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+            continue;
+        }
+        /* u1 = m * w mod order, u2 = r * w mod order */
+        if (!ec_group_do_order_mul(group, u1, m, w[i], ctx) ||
+            !ec_group_do_order_mul(group, u2, sigs[i]->r, w[i], ctx)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+            continue;
+        }
+        if ((points[i] = EC_POINT_new(group)) == NULL) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_MALLOC_FAILURE);
+            continue;
+        }
+        if (!ec_key_do_verify_mul(eckeys[i], points[i], u1, u2, ctx)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_EC_LIB);
+            continue;
+        }
+        if (EC_POINT_is_at_infinity(group, points[i])) {
+            results[i] = 0;
+            continue;
+        }
+        state[i] = BATCH_MULTIPLIED;
+    }
+
+    /* Convert the points on each named curve to affine form together, which
+     * costs one field inversion per curve rather than one per point. */
+    for (i = 0; i < num; i++) {
+        if (state[i] != BATCH_MULTIPLIED)
+            continue;
+        group = EC_KEY_get0_group(eckeys[i]);
+        nrun = 0;
+        for (j = i; j < num; j++) {
+            if (state[j] != BATCH_MULTIPLIED)
+                continue;
+            if (j != i && !ecdsa_same_curve(group, EC_KEY_get0_group(eckeys[j])))
+                continue;
+            run[nrun] = j;
+            run_points[nrun++] = points[j];
+        }
+        /* On failure each point is simply converted on its own below. */
+        if (nrun > 1 && !EC_POINTs_make_affine(group, nrun, run_points, ctx))
+            ERR_clear_error();
+        for (j = 0; j < nrun; j++)
+            state[run[j]] = BATCH_AFFINE;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (state[i] != BATCH_AFFINE)
+            continue;
+        state[i] = BATCH_DONE;
+        group = EC_KEY_get0_group(eckeys[i]);
+        if (EC_METHOD_get_field_type(EC_GROUP_method_of(group)) == NID_X9_62_prime_field) {
+            if (!EC_POINT_get_affine_coordinates_GFp(group, points[i], X, NULL, ctx)) {
+                ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_EC_LIB);
+                continue;
+            }
+        }
+#ifndef OPENSSL_NO_EC2M
+        else /* NID_X9_62_characteristic_two_field */
+        {
+            if (!EC_POINT_get_affine_coordinates_GF2m(group, points[i], X, NULL, ctx)) {
+                ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_EC_LIB);
+                continue;
+            }
+        }
+#endif
+        if (!EC_GROUP_get_order(group, order, ctx) ||
+            !BN_nnmod(u1, X, order, ctx)) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_BN_LIB);
+            continue;
+        }
+        /*  if the signature is correct u1 is equal to sig->r */
+        results[i] = (BN_ucmp(u1, sigs[i]->r) == 0);
+    }
+
+    ret = 1;
+    for (i = 0; i < num; i++) {
+        if (results[i] < 0) {
+            ret = -1;
+            break;
+        }
+        if (results[i] == 0)
+            ret = 0;
+    }
+
+err:
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    for (i = 0; i < num; i++) {
+        if (w != NULL)
+            BN_free(w[i]);
+        if (prefix != NULL)
+            BN_free(prefix[i]);
+        if (points != NULL)
+            EC_POINT_free(points[i]);
+    }
+    free(w);
+    free(prefix);
+    free(points);
+    free(run_points);
+    free(run);
+    free(state);
+    return ret;
+}
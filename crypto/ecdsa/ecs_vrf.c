@@ -28,6 +28,46 @@ int ECDSA_do_verify(const uint8_t *dgst, int dgst_len,
     return ecdsa->meth->ecdsa_do_verify(dgst, dgst_len, sig, eckey);
 }
 
+/* returns
+ *      1: all signatures correct
+ *      0: some signature incorrect
+ *     -1: error
+ */
+int ECDSA_do_verify_batch(size_t num, const uint8_t *const *dgsts,
+                          const int *dgst_lens, const ECDSA_SIG *const *sigs,
+                          EC_KEY *const *eckeys, int *results)
+{
+    ECDSA_DATA *ecdsa;
+    size_t i;
+    int ret = 1;
+
+    for (i = 0; i < num; i++) {
+        if (dgsts[i] == NULL || sigs[i] == NULL || eckeys[i] == NULL)
+            break;
+        ecdsa = ecdsa_check(eckeys[i]);
+        if (ecdsa == NULL || ecdsa->meth != ECDSA_OpenSSL())
+            break;
+    }
+    if (i == num)
+        return ecdsa_verify_batch(num, dgsts, dgst_lens, sigs, eckeys, results);
+
+    /* Some entry is missing or uses a custom method: verify one at a time. */
+    for (i = 0; i < num; i++) {
+        if (dgsts[i] == NULL || sigs[i] == NULL || eckeys[i] == NULL) {
+            ECDSAerr(ECDSA_F_ECDSA_DO_VERIFY, ERR_R_PASSED_NULL_PARAMETER);
+            results[i] = -1;
+        } else {
+            results[i] = ECDSA_do_verify(dgsts[i], dgst_lens[i], sigs[i],
+                                         eckeys[i]);
+        }
+        if (results[i] < 0)
+            ret = -1;
+        else if (results[i] == 0 && ret == 1)
+            ret = 0;
+    }
+    return ret;
+}
+
 /* returns
  *      1: correct signature
  *      0: incorrect signature
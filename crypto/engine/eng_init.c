@@ -13,7 +13,7 @@
  * if it's already in use). This version is only used internally. */
 int engine_unlocked_init(ENGINE *e)
 {
-    int to_return = 1;
+    int to_return = 1, i;
 
     if ((e->funct_ref == 0) && e->init)
         /* This is the first functional reference and the engine
@@ -22,8 +22,8 @@ int engine_unlocked_init(ENGINE *e)
     if (to_return) {
         /* OK, we return a functional reference which is also a
          * structural reference. */
-        e->struct_ref++;
-        e->funct_ref++;
+        CRYPTO_atomic_add(&e->struct_ref, 1, &i, NULL);
+        CRYPTO_atomic_add(&e->funct_ref, 1, &i, NULL);
         engine_ref_debug(e, 0, 1)
             engine_ref_debug(e, 1, 1)
     }
@@ -34,17 +34,18 @@ int engine_unlocked_init(ENGINE *e)
  * internally. */
 int engine_unlocked_finish(ENGINE *e, int unlock_for_handlers)
 {
-    int to_return = 1;
+    int to_return = 1, i;
 
     /* Reduce the functional reference count here so if it's the terminating
      * case, we can release the lock safely and call the finish() handler
      * without risk of a race. We get a race if we leave the count until
      * after and something else is calling "finish" at the same time -
      * there's a chance that both threads will together take the count from
-     * 2 to 0 without either calling finish(). */
-    e->funct_ref--;
+     * 2 to 0 without either calling finish(). The count is changed
+     * atomically because engine_table_select() raises it without the lock. */
+    CRYPTO_atomic_add(&e->funct_ref, -1, &i, NULL);
     engine_ref_debug(e, 1, -1);
-    if ((e->funct_ref == 0) && e->finish) {
+    if ((i == 0) && e->finish) {
         if (unlock_for_handlers)
             CRYPTO_thread_unlock(global_engine_lock);
         to_return = e->finish(e);
@@ -81,12 +82,19 @@ int ENGINE_init(ENGINE *e)
 /* The API (locked) version of "finish" */
 int ENGINE_finish(ENGINE *e)
 {
-    int to_return = 1;
+    int to_return = 1, i;
 
     if (e == NULL) {
         ENGINEerr(ENGINE_F_ENGINE_FINISH, ERR_R_PASSED_NULL_PARAMETER);
         return 0;
     }
+    /* Only the last functional reference calls finish(), so any other can be
+     * released without the lock. */
+    if (CRYPTO_atomic_add_unless(&e->funct_ref, -1, 1, &i,
+                                 global_engine_lock)) {
+        engine_ref_debug(e, 1, -1)
+        return engine_free_util(e, 1);
+    }
     CRYPTO_thread_write_lock(global_engine_lock);
     to_return = engine_unlocked_finish(e, 1);
     CRYPTO_thread_unlock(global_engine_lock);
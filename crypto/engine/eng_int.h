@@ -68,7 +68,9 @@ DECLARE_STACK_OF(ENGINE)
 /* #define ENGINE_TABLE_DEBUG */
 
 /* This represents an implementation table. Dependent code should instantiate it
- * as a (ENGINE_TABLE *) pointer value set initially to NULL. */
+ * as a (ENGINE_TABLE *) pointer value set initially to NULL. Once a 'nid' has
+ * been looked up, engine_table_select() answers it from a snapshot without
+ * taking global_engine_lock until the table is next changed. */
 typedef struct st_engine_table ENGINE_TABLE;
 int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
                           ENGINE *e, const int *nids, int num_nids, int setdefault);
@@ -77,7 +77,7 @@ int engine_free_util(ENGINE *e, int locked)
     if (locked)
         CRYPTO_atomic_add(&e->struct_ref, -1, &i, global_engine_lock);
     else
-        i = --e->struct_ref;
+        CRYPTO_atomic_add(&e->struct_ref, -1, &i, NULL);
     engine_ref_debug(e, 0, -1) if (i > 0) return 1;
 
     /* Free up any dynamically allocated public key methods */
@@ -49,7 +49,7 @@ static void engine_list_cleanup(void)
  * take place when global_engine_lock has been locked up. */
 static int engine_list_add(ENGINE *e)
 {
-    int conflict = 0;
+    int conflict = 0, i;
     ENGINE *iterator = NULL;
 
     if (e == NULL) {
@@ -91,7 +91,7 @@ static int engine_list_add(ENGINE *e)
     }
     /* Having the engine in the list assumes a structural
      * reference. */
-    e->struct_ref++;
+    CRYPTO_atomic_add(&e->struct_ref, 1, &i, NULL);
     engine_ref_debug(e, 0, 1)
         /* However it came to be, e is the last item in the list. */
         engine_list_tail = e;
@@ -135,12 +135,13 @@ static int engine_list_remove(ENGINE *e)
 ENGINE *ENGINE_get_first(void)
 {
     ENGINE *ret;
+    int i;
 
     CRYPTO_thread_run_once(&engine_lock_init, do_engine_lock_init);
     CRYPTO_thread_write_lock(global_engine_lock);
     ret = engine_list_head;
     if (ret) {
-        ret->struct_ref++;
+        CRYPTO_atomic_add(&ret->struct_ref, 1, &i, NULL);
         engine_ref_debug(ret, 0, 1)
     }
     CRYPTO_thread_unlock(global_engine_lock);
@@ -150,12 +151,13 @@ ENGINE *ENGINE_get_first(void)
 ENGINE *ENGINE_get_last(void)
 {
     ENGINE *ret;
+    int i;
 
     CRYPTO_thread_run_once(&engine_lock_init, do_engine_lock_init);
     CRYPTO_thread_write_lock(global_engine_lock);
     ret = engine_list_tail;
     if (ret) {
-        ret->struct_ref++;
+        CRYPTO_atomic_add(&ret->struct_ref, 1, &i, NULL);
         engine_ref_debug(ret, 0, 1)
     }
     CRYPTO_thread_unlock(global_engine_lock);
@@ -166,6 +168,7 @@ ENGINE *ENGINE_get_last(void)
 ENGINE *ENGINE_get_next(ENGINE *e)
 {
     ENGINE *ret = NULL;
+    int i;
 
     if (e == NULL) {
         ENGINEerr(ENGINE_F_ENGINE_GET_NEXT,
@@ -176,7 +179,7 @@ ENGINE *ENGINE_get_next(ENGINE *e)
     ret = e->next;
     if (ret) {
         /* Return a valid structural refernce to the next ENGINE */
-        ret->struct_ref++;
+        CRYPTO_atomic_add(&ret->struct_ref, 1, &i, NULL);
         engine_ref_debug(ret, 0, 1)
     }
     CRYPTO_thread_unlock(global_engine_lock);
@@ -188,6 +191,7 @@ ENGINE *ENGINE_get_next(ENGINE *e)
 ENGINE *ENGINE_get_prev(ENGINE *e)
 {
     ENGINE *ret = NULL;
+    int i;
 
     if (e == NULL) {
         ENGINEerr(ENGINE_F_ENGINE_GET_PREV,
@@ -198,7 +202,7 @@ ENGINE *ENGINE_get_prev(ENGINE *e)
     ret = e->prev;
     if (ret) {
         /* Return a valid structural reference to the next ENGINE */
-        ret->struct_ref++;
+        CRYPTO_atomic_add(&ret->struct_ref, 1, &i, NULL);
         engine_ref_debug(ret, 0, 1)
     }
     CRYPTO_thread_unlock(global_engine_lock);
@@ -280,6 +284,7 @@ static void engine_cpy(ENGINE *dest, const ENGINE *src)
 ENGINE *ENGINE_by_id(const char *id)
 {
     ENGINE *iterator;
+    int i;
 
     if (id == NULL) {
         ENGINEerr(ENGINE_F_ENGINE_BY_ID, ERR_R_PASSED_NULL_PARAMETER);
@@ -303,7 +308,7 @@ ENGINE *ENGINE_by_id(const char *id)
                 iterator = cp;
             }
         } else {
-            iterator->struct_ref++;
+            CRYPTO_atomic_add(&iterator->struct_ref, 1, &i, NULL);
             engine_ref_debug(iterator, 0, 1)
         }
     }
@@ -7,8 +7,11 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <stdint.h>
+
 #include <openssl/evp.h>
 #include <openssl/lhash.h>
+#include <openssl/objects.h>
 
 #include "eng_int.h"
 
@@ -26,9 +29,34 @@ typedef struct st_engine_pile {
 
 DECLARE_LHASH_OF(ENGINE_PILE);
 
+/* A copy of one ENGINE_PILE's result for engine_table_select() */
+typedef struct st_engine_dispatch_slot {
+    /* The 'nid' of this algorithm/mode, or NID_undef if the slot is empty */
+    int nid;
+    /* Non-zero if 'funct' is what a locked lookup of 'nid' would return */
+    int resolved;
+    /* The default ENGINE, on which the snapshot holds a structural reference */
+    ENGINE *funct;
+} ENGINE_DISPATCH_SLOT;
+
+/* An immutable snapshot of the piles, read by engine_table_select() without
+ * taking global_engine_lock. Any change to the piles replaces the snapshot
+ * and puts the old one on a retired list, because a reader may still be
+ * using it. Retired snapshots are freed as soon as a writer sees no reader
+ * in dispatch_select(), and at the latest by engine_table_cleanup(). */
+typedef struct st_engine_dispatch {
+    struct st_engine_dispatch *next;
+    size_t mask;
+    ENGINE_DISPATCH_SLOT *slots;
+} ENGINE_DISPATCH;
+
 /* The type exposed in eng_int.h */
 struct st_engine_table {
-    LHASH_OF(ENGINE_PILE) piles;
+    LHASH_OF(ENGINE_PILE) *piles;
+    ENGINE_DISPATCH *dispatch;
+    ENGINE_DISPATCH *retired;
+    /* The number of threads in dispatch_select() */
+    int readers;
 }; /* ENGINE_TABLE */
 
 typedef struct st_engine_pile_doall {
@@ -64,18 +92,186 @@ static IMPLEMENT_LHASH_HASH_FN(engine_pile, ENGINE_PILE) static IMPLEMENT_LHASH_
 
 static int int_table_check(ENGINE_TABLE **t, int create)
 {
-    LHASH_OF(ENGINE_PILE) *lh;
+    ENGINE_TABLE *table;
 
     if (*t)
         return 1;
     if (!create)
         return 0;
-    if ((lh = lh_ENGINE_PILE_new()) == NULL)
+    if ((table = calloc(1, sizeof(ENGINE_TABLE))) == NULL)
+        return 0;
+    if ((table->piles = lh_ENGINE_PILE_new()) == NULL) {
+        free(table);
+        return 0;
+    }
+    /* engine_table_select() reads the table pointer without the lock */
+    CRYPTO_atomic_set_ptr((void **)t, table, NULL);
+    return 1;
+}
+
+/* Functions for the lock-free dispatch snapshot. Those that change it must be
+ * called with global_engine_lock held. */
+static size_t dispatch_slot(int nid, size_t mask)
+{
+    uint32_t h = (uint32_t)nid * 0x9e3779b1U;
+
+    return (h ^ (h >> 15)) & mask;
+}
+
+static const ENGINE_DISPATCH_SLOT *dispatch_find(const ENGINE_DISPATCH *d,
+                                                 int nid)
+{
+    size_t i;
+
+    for (i = dispatch_slot(nid, d->mask); d->slots[i].nid != NID_undef;
+         i = (i + 1) & d->mask) {
+        if (d->slots[i].nid == nid)
+            return &d->slots[i];
+    }
+    return NULL;
+}
+
+static void int_dispatch_add_doall_arg(ENGINE_PILE *pile, ENGINE_DISPATCH *d)
+{
+    size_t i;
+    int ref;
+
+    /* NID_undef marks empty slots, so it is only ever looked up locked */
+    if (pile->nid == NID_undef)
+        return;
+    for (i = dispatch_slot(pile->nid, d->mask); d->slots[i].nid != NID_undef;
+         i = (i + 1) & d->mask)
+        ;
+    d->slots[i].nid = pile->nid;
+    /* These are the cases in which engine_table_select() returns 'funct'
+     * without trying any other ENGINE. */
+    d->slots[i].resolved = pile->funct != NULL || pile->uptodate;
+    d->slots[i].funct = pile->funct;
+    if (pile->funct != NULL)
+        CRYPTO_atomic_add(&pile->funct->struct_ref, 1, &ref, NULL);
+}
+static IMPLEMENT_LHASH_DOALL_ARG_FN(int_dispatch_add, ENGINE_PILE,
+                                    ENGINE_DISPATCH)
+
+static void dispatch_build(ENGINE_TABLE *t)
+{
+    ENGINE_DISPATCH *d;
+    size_t size = 16;
+
+    while (size < 2 * lh_ENGINE_PILE_num_items(t->piles))
+        size <<= 1;
+    if ((d = calloc(1, sizeof(*d))) == NULL)
+        return;
+    if ((d->slots = calloc(size, sizeof(*d->slots))) == NULL) {
+        free(d);
+        return;
+    }
+    d->mask = size - 1;
+    lh_ENGINE_PILE_doall_arg(t->piles, LHASH_DOALL_ARG_FN(int_dispatch_add),
+                             ENGINE_DISPATCH, d);
+
+    CRYPTO_atomic_set_ptr((void **)&t->dispatch, d, NULL);
+}
+
+static void dispatch_free(ENGINE_DISPATCH *d)
+{
+    size_t i;
+
+    for (i = 0; i <= d->mask; i++) {
+        if (d->slots[i].funct != NULL)
+            engine_free_util(d->slots[i].funct, 0);
+    }
+    free(d->slots);
+    free(d);
+}
+
+/* dispatch_reclaim frees the retired snapshots if no thread is reading any
+ * snapshot. Every retired snapshot has already been unpublished, so a reader
+ * that arrives after the count is read here can only find a newer one. */
+static void dispatch_reclaim(ENGINE_TABLE *t)
+{
+    ENGINE_DISPATCH *d;
+    int readers;
+
+    if (t->retired == NULL)
+        return;
+    /* Pairs with the first fence in dispatch_select(): either the reader's
+     * count is seen here, or the reader sees the snapshot unpublished. */
+    CRYPTO_atomic_fence();
+    CRYPTO_atomic_add(&t->readers, 0, &readers, NULL);
+    if (readers != 0)
+        return;
+    /* Pairs with the second fence in dispatch_select(), so that the last
+     * reader has finished with the slots before they are freed. */
+    CRYPTO_atomic_fence();
+    while ((d = t->retired) != NULL) {
+        t->retired = d->next;
+        dispatch_free(d);
+    }
+}
+
+static void dispatch_drop(ENGINE_TABLE *t)
+{
+    ENGINE_DISPATCH *d = t->dispatch;
+
+    if (d == NULL)
+        return;
+    CRYPTO_atomic_set_ptr((void **)&t->dispatch, NULL, NULL);
+    d->next = t->retired;
+    t->retired = d;
+    dispatch_reclaim(t);
+}
+
+static int dispatch_lookup(const ENGINE_DISPATCH *d, int nid, ENGINE **ret)
+{
+    const ENGINE_DISPATCH_SLOT *slot;
+    int ref;
+
+    if ((slot = dispatch_find(d, nid)) == NULL) {
+        /* Nothing is registered for 'nid' */
+        *ret = NULL;
+        return 1;
+    }
+    if (!slot->resolved)
         return 0;
-    *t = (ENGINE_TABLE *)lh;
+    if (slot->funct != NULL) {
+        /* A functional reference can only be copied while the pile still
+         * holds one. Otherwise the ENGINE may need to be initialised again,
+         * which has to be done under the lock. */
+        if (!CRYPTO_atomic_add_unless(&slot->funct->funct_ref, 1, 0, &ref,
+                                      global_engine_lock))
+            return 0;
+        CRYPTO_atomic_add(&slot->funct->struct_ref, 1, &ref,
+                          global_engine_lock);
+        engine_ref_debug(slot->funct, 0, 1)
+            engine_ref_debug(slot->funct, 1, 1)
+    }
+    *ret = slot->funct;
     return 1;
 }
 
+/* dispatch_select answers a lookup of 'nid' from the snapshot, if it can,
+ * without taking global_engine_lock. It returns zero if the caller must take
+ * the lock and look in the piles instead. */
+static int dispatch_select(ENGINE_TABLE *t, int nid, ENGINE **ret)
+{
+    const ENGINE_DISPATCH *d;
+    int ok = 0, ref;
+
+    if (nid == NID_undef)
+        return 0;
+    /* Count this thread as a reader before loading the snapshot, so that
+     * dispatch_reclaim() cannot free it underneath. */
+    CRYPTO_atomic_add(&t->readers, 1, &ref, global_engine_lock);
+    CRYPTO_atomic_fence();
+    d = CRYPTO_atomic_get_ptr((void **)&t->dispatch, global_engine_lock);
+    if (d != NULL)
+        ok = dispatch_lookup(d, nid, ret);
+    CRYPTO_atomic_fence();
+    CRYPTO_atomic_add(&t->readers, -1, &ref, global_engine_lock);
+    return ok;
+}
+
 /* Privately exposed (via eng_int.h) functions for adding and/or removing
  * ENGINEs from the implementation table */
 int
@@ -95,7 +291,7 @@ engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
         engine_cleanup_add_first(cleanup);
     while (num_nids--) {
         tmplate.nid = *nids;
-        fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+        fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
         if (!fnd) {
             fnd = malloc(sizeof(ENGINE_PILE));
             if (fnd == NULL)
@@ -108,7 +304,7 @@ engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
                 goto end;
             }
             fnd->funct = NULL;
-            (void)lh_ENGINE_PILE_insert(&(*table)->piles, fnd);
+            (void)lh_ENGINE_PILE_insert((*table)->piles, fnd);
         }
         /* A registration shouldn't add duplciate entries */
         (void)sk_ENGINE_delete_ptr(fnd->sk, e);
@@ -132,6 +328,8 @@ engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
     }
     ret = 1;
 end:
+    if (*table)
+        dispatch_drop(*table);
     CRYPTO_thread_unlock(global_engine_lock);
     return ret;
 }
@@ -155,9 +353,11 @@ static IMPLEMENT_LHASH_DOALL_ARG_FN(int_unregister_cb, ENGINE_PILE, ENGINE)
     void engine_table_unregister(ENGINE_TABLE **table, ENGINE *e)
 {
     CRYPTO_thread_write_lock(global_engine_lock);
-    if (int_table_check(table, 0))
-        lh_ENGINE_PILE_doall_arg(&(*table)->piles,
+    if (int_table_check(table, 0)) {
+        lh_ENGINE_PILE_doall_arg((*table)->piles,
                                  LHASH_DOALL_ARG_FN(int_unregister_cb), ENGINE, e);
+        dispatch_drop(*table);
+    }
     CRYPTO_thread_unlock(global_engine_lock);
 }
 
@@ -172,12 +372,20 @@ static IMPLEMENT_LHASH_DOALL_FN(int_cleanup_cb, ENGINE_PILE)
 
 void engine_table_cleanup(ENGINE_TABLE **table)
 {
+    ENGINE_TABLE *t;
+    ENGINE_DISPATCH *d;
+
     CRYPTO_thread_write_lock(global_engine_lock);
-    if (*table) {
-        lh_ENGINE_PILE_doall(&(*table)->piles,
-                             LHASH_DOALL_FN(int_cleanup_cb));
-        lh_ENGINE_PILE_free(&(*table)->piles);
-        *table = NULL;
+    if ((t = *table) != NULL) {
+        CRYPTO_atomic_set_ptr((void **)table, NULL, NULL);
+        lh_ENGINE_PILE_doall(t->piles, LHASH_DOALL_FN(int_cleanup_cb));
+        lh_ENGINE_PILE_free(t->piles);
+        dispatch_drop(t);
+        while ((d = t->retired) != NULL) {
+            t->retired = d->next;
+            dispatch_free(d);
+        }
+        free(t);
     }
     CRYPTO_thread_unlock(global_engine_lock);
 }
@@ -190,10 +398,13 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f, in
 #endif
 {
     ENGINE *ret = NULL;
+    ENGINE_TABLE *t;
     ENGINE_PILE tmplate, *fnd = NULL;
+    const ENGINE_DISPATCH_SLOT *slot;
     int initres, loop = 0;
 
-    if (!(*table)) {
+    t = CRYPTO_atomic_get_ptr((void **)table, global_engine_lock);
+    if (t == NULL) {
 #ifdef ENGINE_TABLE_DEBUG
         fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, nothing "
                         "registered!\n",
@@ -201,6 +412,14 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f, in
 #endif
         return NULL;
     }
+    if (dispatch_select(t, nid, &ret)) {
+#ifdef ENGINE_TABLE_DEBUG
+        fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, using "
+                        "'%s' from the snapshot\n",
+                f, l, nid, ret ? ret->id : "no matching ENGINE");
+#endif
+        return ret;
+    }
     ERR_set_mark();
     CRYPTO_thread_write_lock(global_engine_lock);
     /* Check again inside the lock otherwise we could race against cleanup
@@ -208,7 +427,7 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f, in
     if (!int_table_check(table, 0))
         goto end;
     tmplate.nid = nid;
-    fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+    fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
     if (!fnd)
         goto end;
     if (fnd->funct && engine_unlocked_init(fnd->funct)) {
@@ -265,6 +484,18 @@ end:
      * registrations have taken place. In all cases, we cache. */
     if (fnd)
         fnd->uptodate = 1;
+    /* Bring the snapshot up to date so that the next lookup needs no lock */
+    if (*table) {
+        t = *table;
+        if (fnd && t->dispatch &&
+            ((slot = dispatch_find(t->dispatch, nid)) == NULL ||
+             !slot->resolved || slot->funct != fnd->funct))
+            dispatch_drop(t);
+        if (!t->dispatch)
+            dispatch_build(t);
+        /* Free what an earlier change could not while readers were busy */
+        dispatch_reclaim(t);
+    }
 #ifdef ENGINE_TABLE_DEBUG
     if (ret)
         fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, caching "
@@ -294,8 +525,10 @@ void engine_table_doall(ENGINE_TABLE *table, engine_table_doall_cb *cb, void *ar
 {
     ENGINE_PILE_DOALL dall;
 
+    if (table == NULL)
+        return;
     dall.cb = cb;
     dall.arg = arg;
-    lh_ENGINE_PILE_doall_arg(&table->piles, LHASH_DOALL_ARG_FN(int_cb),
+    lh_ENGINE_PILE_doall_arg(table->piles, LHASH_DOALL_ARG_FN(int_cb),
                              ENGINE_PILE_DOALL, &dall);
 }
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <strings.h>
 
+#include <openssl/asn1.h>
 #include <openssl/err.h>
 
 #include "internal/asn1_int.h"
@@ -183,6 +184,7 @@ const EVP_PKEY_ASN1_METHOD *ENGINE_pkey_asn1_find_str(ENGINE **pe,
                                                       int len)
 {
     ENGINE_FIND_STR fstr;
+    int i;
 
     fstr.e = NULL;
     fstr.ameth = NULL;
@@ -195,7 +197,7 @@ const EVP_PKEY_ASN1_METHOD *ENGINE_pkey_asn1_find_str(ENGINE **pe,
     engine_table_doall(pkey_asn1_meth_table, look_str_cb, &fstr);
     /* If found obtain a structural reference to engine */
     if (fstr.e) {
-        fstr.e->struct_ref++;
+        CRYPTO_atomic_add(&fstr.e->struct_ref, 1, &i, NULL);
         engine_ref_debug(fstr.e, 0, 1)
     }
     *pe = fstr.e;
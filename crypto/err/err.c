@@ -124,9 +124,27 @@ static CRYPTO_THREAD_LOCAL err_thread_local;
 static CRYPTO_ONCE err_string_init = CRYPTO_ONCE_STATIC_INIT;
 static CRYPTO_MUTEX *err_string_lock;
 
+/*
+ * Lookups read an immutable open-addressed copy of int_error_hash, so
+ * formatting an error takes no lock. Loading or unloading strings drops the
+ * copy and the next lookup that finds a string in int_error_hash builds a
+ * new one. The checks made by the ERR_load_*_strings functions before
+ * loading miss, so loading the strings of every library builds the table
+ * once. A dropped table may still be read by other threads and is only freed
+ * by ERR_free_strings.
+ */
+typedef struct err_string_table_st {
+    struct err_string_table_st *next;
+    size_t mask;
+    ERR_STRING_DATA *slots;
+} ERR_STRING_TABLE;
+
+static ERR_STRING_TABLE *err_string_table;
+static ERR_STRING_TABLE *err_string_retired;
+static CRYPTO_MUTEX *err_table_lock;
+
 /* Predeclarations of the "err_defaults" functions */
 static LHASH_OF(ERR_STRING_DATA) *get_hash(int create, int lockit);
-static ERR_STRING_DATA *int_err_get_item(const ERR_STRING_DATA *);
 
 /* The internal state */
 static LHASH_OF(ERR_STRING_DATA) *int_error_hash = NULL;
@@ -176,18 +194,96 @@ static LHASH_OF(ERR_STRING_DATA) *get_hash(int create, int lockit)
     return ret;
 }
 
-static ERR_STRING_DATA *int_err_get_item(const ERR_STRING_DATA *d)
+static size_t err_string_slot(unsigned long e, size_t mask)
 {
-    ERR_STRING_DATA *p = NULL;
-    LHASH_OF(ERR_STRING_DATA) *hash;
+    uint32_t h = (uint32_t)e * 0x9e3779b1U;
+
+    return (h ^ (h >> 15)) & mask;
+}
+
+static void err_string_table_add_doall_arg(ERR_STRING_DATA *d,
+                                           ERR_STRING_TABLE *t)
+{
+    size_t i;
+
+    for (i = err_string_slot(d->error, t->mask); t->slots[i].error != 0;
+         i = (i + 1) & t->mask)
+        ;
+    t->slots[i] = *d;
+}
+
+static IMPLEMENT_LHASH_DOALL_ARG_FN(err_string_table_add, ERR_STRING_DATA,
+                                    ERR_STRING_TABLE)
+
+static const char *err_string_table_find(const ERR_STRING_TABLE *t,
+                                         unsigned long e)
+{
+    size_t i;
+
+    for (i = err_string_slot(e, t->mask); t->slots[i].error != 0;
+         i = (i + 1) & t->mask) {
+        if (t->slots[i].error == e)
+            return t->slots[i].string;
+    }
+    return NULL;
+}
+
+/* err_string_table_build must be called with err_string_lock held. */
+static void err_string_table_build(void)
+{
+    ERR_STRING_TABLE *t;
+    size_t size = 16;
 
+    while (size < 2 * lh_ERR_STRING_DATA_num_items(int_error_hash))
+        size <<= 1;
+    if ((t = calloc(1, sizeof(*t))) == NULL)
+        return;
+    if ((t->slots = calloc(size, sizeof(*t->slots))) == NULL) {
+        free(t);
+        return;
+    }
+    t->mask = size - 1;
+    lh_ERR_STRING_DATA_doall_arg(int_error_hash,
+                                 LHASH_DOALL_ARG_FN(err_string_table_add),
+                                 ERR_STRING_TABLE, t);
+
+    CRYPTO_atomic_set_ptr((void **)&err_string_table, t, err_table_lock);
+}
+
+/* err_string_table_drop must be called with err_string_lock held. */
+static void err_string_table_drop(void)
+{
+    ERR_STRING_TABLE *t = err_string_table;
+
+    if (t == NULL)
+        return;
+    CRYPTO_atomic_set_ptr((void **)&err_string_table, NULL, err_table_lock);
+    t->next = err_string_retired;
+    err_string_retired = t;
+}
+
+static const char *err_string_lookup(unsigned long e)
+{
+    ERR_STRING_TABLE *t;
+    ERR_STRING_DATA d, *p;
+    const char *ret = NULL;
+
+    t = CRYPTO_atomic_get_ptr((void **)&err_string_table, err_table_lock);
+    if (t != NULL)
+        return err_string_table_find(t, e);
+
+    d.error = e;
     CRYPTO_thread_write_lock(err_string_lock);
-    hash = get_hash(0, 0);
-    if (hash)
-        p = lh_ERR_STRING_DATA_retrieve(hash, d);
+    if (err_string_table != NULL) {
+        ret = err_string_table_find(err_string_table, e);
+    } else if (int_error_hash != NULL &&
+               (p = lh_ERR_STRING_DATA_retrieve(int_error_hash, &d)) != NULL) {
+        ret = p->string;
+        err_string_table_build();
+    }
     CRYPTO_thread_unlock(err_string_lock);
 
-    return p;
+    return ret;
 }
 
 #ifndef OPENSSL_NO_ERR
@@ -246,8 +342,8 @@ static void build_SYS_str_reasons(void)
     do {                                                                               \
         if (((p)->err_data[i] != NULL) && (p)->err_data_flags[i] & ERR_TXT_MALLOCED) { \
             free((p)->err_data[i]);                                                    \
-            (p)->err_data[i] = NULL;                                                   \
         }                                                                              \
+        (p)->err_data[i] = NULL;                                                       \
         (p)->err_data_flags[i] = 0;                                                    \
     } while (0)
 
@@ -267,8 +363,10 @@ static void ERR_STATE_free(ERR_STATE *s)
     if (s == NULL)
         return;
 
-    for (i = 0; i < ERR_NUM_ERRORS; i++)
+    for (i = 0; i < ERR_NUM_ERRORS; i++) {
         err_clear_data(s, i);
+        free(s->err_data_buf[i]);
+    }
 
     free(s);
 }
@@ -276,6 +374,7 @@ static void ERR_STATE_free(ERR_STATE *s)
 static void do_err_strings_init(void)
 {
     err_string_lock = CRYPTO_thread_new();
+    err_table_lock = CRYPTO_thread_new();
 }
 
 void ERR_load_ERR_strings(void)
@@ -303,6 +402,7 @@ static void err_load_strings(int lib, ERR_STRING_DATA *str)
                 str->error |= ERR_PACK(lib, 0, 0);
             (void)lh_ERR_STRING_DATA_insert(hash, str);
         }
+        err_string_table_drop();
     }
     CRYPTO_thread_unlock(err_string_lock);
 }
@@ -327,12 +427,15 @@ void ERR_unload_strings(int lib, ERR_STRING_DATA *str)
                 str->error |= ERR_PACK(lib, 0, 0);
             (void)lh_ERR_STRING_DATA_delete(hash, str);
         }
+        err_string_table_drop();
     }
     CRYPTO_thread_unlock(err_string_lock);
 }
 
 void ERR_free_strings(void)
 {
+    ERR_STRING_TABLE *t;
+
     CRYPTO_thread_run_once(&err_string_init, do_err_strings_init);
 
     CRYPTO_thread_write_lock(err_string_lock);
@@ -340,6 +443,12 @@ void ERR_free_strings(void)
         lh_ERR_STRING_DATA_free(int_error_hash);
         int_error_hash = NULL;
     }
+    err_string_table_drop();
+    while ((t = err_string_retired) != NULL) {
+        err_string_retired = t->next;
+        free(t->slots);
+        free(t);
+    }
     CRYPTO_thread_unlock(err_string_lock);
 }
 
@@ -562,47 +671,37 @@ LHASH_OF(ERR_STRING_DATA) *ERR_get_string_table(void)
 
 const char *ERR_lib_error_string(unsigned long e)
 {
-    ERR_STRING_DATA d, *p;
     unsigned long l;
 
     CRYPTO_thread_run_once(&err_string_init, do_err_strings_init);
 
     l = ERR_GET_LIB(e);
-    d.error = ERR_PACK(l, 0, 0);
-    p = int_err_get_item(&d);
-    return ((p == NULL) ? NULL : p->string);
+    return err_string_lookup(ERR_PACK(l, 0, 0));
 }
 
 const char *ERR_func_error_string(unsigned long e)
 {
-    ERR_STRING_DATA d, *p;
     unsigned long l, f;
 
     CRYPTO_thread_run_once(&err_string_init, do_err_strings_init);
 
     l = ERR_GET_LIB(e);
     f = ERR_GET_FUNC(e);
-    d.error = ERR_PACK(l, f, 0);
-    p = int_err_get_item(&d);
-    return ((p == NULL) ? NULL : p->string);
+    return err_string_lookup(ERR_PACK(l, f, 0));
 }
 
 const char *ERR_reason_error_string(unsigned long e)
 {
-    ERR_STRING_DATA d, *p = NULL;
+    const char *p;
     unsigned long l, r;
 
     CRYPTO_thread_run_once(&err_string_init, do_err_strings_init);
 
     l = ERR_GET_LIB(e);
     r = ERR_GET_REASON(e);
-    d.error = ERR_PACK(l, 0, r);
-    p = int_err_get_item(&d);
-    if (!p) {
-        d.error = ERR_PACK(0, 0, r);
-        p = int_err_get_item(&d);
-    }
-    return ((p == NULL) ? NULL : p->string);
+    if ((p = err_string_lookup(ERR_PACK(l, 0, r))) == NULL)
+        p = err_string_lookup(ERR_PACK(0, 0, r));
+    return p;
 }
 
 void ERR_remove_thread_state(const void *dummy)
@@ -668,27 +767,70 @@ void ERR_set_error_data(const char *data, int flags)
     es = ERR_get_state();
 
     i = es->top;
-    if (i == 0)
-        i = ERR_NUM_ERRORS - 1;
 
     err_clear_data(es, i);
     es->err_data[i] = (char *)data;
     es->err_data_flags[i] = flags;
 }
 
+/*
+ * err_set_error_vdata formats the error data into a buffer that the slot
+ * keeps from one error to the next, so errors that carry data only allocate
+ * the first time a slot sees a longer string.
+ */
+static void err_set_error_vdata(const char *format, va_list args)
+{
+    ERR_STATE *es;
+    va_list copy;
+    char *buf;
+    int i, len;
+
+    es = ERR_get_state();
+
+    i = es->top;
+
+    /*
+     * The arguments may point into the current data, so it is only released
+     * once the new data has been formatted. If the current data is the
+     * buffer, format into a fresh allocation instead.
+     */
+    if (es->err_data[i] == es->err_data_buf[i] && es->err_data[i] != NULL) {
+        if (vasprintf(&buf, format, args) == -1)
+            ERR_set_error_data("malloc failure", ERR_TXT_STRING);
+        else
+            ERR_set_error_data(buf, ERR_TXT_MALLOCED | ERR_TXT_STRING);
+        return;
+    }
+
+    va_copy(copy, args);
+    len = vsnprintf(es->err_data_buf[i], es->err_data_buf_len[i], format,
+                    copy);
+    va_end(copy);
+    if (len < 0) {
+        ERR_set_error_data("malloc failure", ERR_TXT_STRING);
+        return;
+    }
+    if ((size_t)len >= es->err_data_buf_len[i]) {
+        if ((buf = realloc(es->err_data_buf[i], len + 1)) == NULL) {
+            ERR_set_error_data("malloc failure", ERR_TXT_STRING);
+            return;
+        }
+        es->err_data_buf[i] = buf;
+        es->err_data_buf_len[i] = len + 1;
+        vsnprintf(buf, len + 1, format, args);
+    }
+    err_clear_data(es, i);
+    es->err_data[i] = es->err_data_buf[i];
+    es->err_data_flags[i] = ERR_TXT_STRING;
+}
+
 void ERR_asprintf_error_data(const char *format, ...)
 {
-    char *errbuf;
-    int ret;
     va_list ap;
 
     va_start(ap, format);
-    ret = vasprintf(&errbuf, format, ap);
+    err_set_error_vdata(format, ap);
     va_end(ap);
-    if (ret == -1)
-        ERR_set_error_data("malloc failure", ERR_TXT_STRING);
-    else
-        ERR_set_error_data(errbuf, ERR_TXT_MALLOCED | ERR_TXT_STRING);
 }
 
 void ERR_add_error_data(int num, ...)
@@ -702,7 +844,6 @@ void ERR_add_error_data(int num, ...)
 void ERR_add_error_vdata(int num, va_list args)
 {
     char str[90];
-    char *buf;
     int i;
     str[0] = '\0';
 
@@ -713,10 +854,7 @@ void ERR_add_error_vdata(int num, va_list args)
             return;
         }
     }
-    if (vasprintf(&buf, str, args) == -1)
-        ERR_set_error_data("malloc failure", ERR_TXT_STRING);
-    else
-        ERR_set_error_data(buf, ERR_TXT_MALLOCED | ERR_TXT_STRING);
+    err_set_error_vdata(str, args);
 }
 
 int ERR_set_mark(void)
@@ -83,33 +83,48 @@ static void poly1305_update_length(poly1305_state *poly1305, size_t data_len)
     CRYPTO_poly1305_update(poly1305, length_bytes, sizeof(length_bytes));
 }
 
-typedef void (*aead_poly1305_update)(poly1305_state *ctx, const uint8_t *ad,
-                                     size_t ad_len, const uint8_t *ciphertext,
-                                     size_t ciphertext_len);
+/*
+ * Records are encrypted and authenticated in chunks of this many bytes, so
+ * that Poly1305 reads each chunk of ciphertext while it is still in L1 after
+ * ChaCha20 has written it. It must be a multiple of the ChaCha20 block size.
+ */
+#define CHACHA20_POLY1305_CHUNK 2048
+
+/*
+ * An aead_poly1305_format describes how a construction lays out its
+ * authenticated data: |ad| absorbs the additional data before the
+ * ciphertext and |tail| whatever follows it.
+ */
+typedef struct {
+    void (*ad)(poly1305_state *poly1305, const uint8_t *ad, size_t ad_len);
+    void (*tail)(poly1305_state *poly1305, size_t ad_len,
+                 size_t ciphertext_len);
+} aead_poly1305_format;
 
 /*
- * aead_poly1305 fills |tag| with the authentication tag for the given
- * inputs, using |update| to control the order and format that the inputs are
- * signed/authenticated.
+ * aead_chacha20_first runs ChaCha20 over block zero of |nonce| followed by
+ * the first bytes of |in|, so that the Poly1305 key and the start of the
+ * record cost a single call. On return |block| holds the one-time key in its
+ * first 32 bytes and the transformed input from offset 64. It returns the
+ * number of input bytes processed.
  */
-static void aead_poly1305(aead_poly1305_update update,
-                          uint8_t tag[POLY1305_TAG_LEN],
-                          const struct aead_chacha20_poly1305_ctx *c20_ctx,
-                          const uint8_t nonce[12], const uint8_t *ad,
-                          size_t ad_len, const uint8_t *ciphertext,
-                          size_t ciphertext_len)
+static size_t aead_chacha20_first(uint8_t block[CHACHA20_POLY1305_CHUNK],
+                                  const struct aead_chacha20_poly1305_ctx *c20_ctx,
+                                  const uint8_t nonce[12], const uint8_t *in,
+                                  size_t in_len)
 {
-    uint8_t poly1305_key[32];
-    memset(poly1305_key, 0, sizeof(poly1305_key));
-    CRYPTO_chacha_20(poly1305_key, poly1305_key, sizeof(poly1305_key),
-                     c20_ctx->key, nonce, 0);
-    poly1305_state ctx;
-    CRYPTO_poly1305_init(&ctx, poly1305_key);
-    update(&ctx, ad, ad_len, ciphertext, ciphertext_len);
-    CRYPTO_poly1305_finish(&ctx, tag);
+    size_t todo = in_len;
+
+    if (todo > CHACHA20_POLY1305_CHUNK - 64)
+        todo = CHACHA20_POLY1305_CHUNK - 64;
+    memset(block, 0, 64);
+    memcpy(block + 64, in, todo);
+    CRYPTO_chacha_20(block, block, 64 + todo, c20_ctx->key, nonce, 0);
+
+    return todo;
 }
 
-static int seal_impl(aead_poly1305_update poly1305_update,
+static int seal_impl(const aead_poly1305_format *format,
                      const EVP_AEAD_CTX *ctx, uint8_t *out, size_t *out_len,
                      size_t max_out_len, const uint8_t nonce[12],
                      const uint8_t *in, size_t in_len, const uint8_t *ad,
@@ -117,6 +132,9 @@ static int seal_impl(aead_poly1305_update poly1305_update,
 {
     const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
     const uint64_t in_len_64 = in_len;
+    poly1305_state poly1305;
+    uint8_t block[CHACHA20_POLY1305_CHUNK], tag[POLY1305_TAG_LEN];
+    size_t off, todo;
 
     /*
      * |CRYPTO_chacha_20| uses a 32-bit block counter. Therefore we disallow
@@ -141,26 +159,40 @@ static int seal_impl(aead_poly1305_update poly1305_update,
         return 0;
     }
 
-    CRYPTO_chacha_20(out, in, in_len, c20_ctx->key, nonce, 1);
-
-    uint8_t tag[POLY1305_TAG_LEN];
-    aead_poly1305(poly1305_update, tag, c20_ctx, nonce, ad, ad_len, out,
-                  in_len);
+    off = aead_chacha20_first(block, c20_ctx, nonce, in, in_len);
+    CRYPTO_poly1305_init(&poly1305, block);
+    format->ad(&poly1305, ad, ad_len);
+    memcpy(out, block + 64, off);
+    CRYPTO_poly1305_update(&poly1305, out, off);
+    vigortls_zeroize(block, 64 + off);
+
+    for (; off < in_len; off += todo) {
+        todo = in_len - off;
+        if (todo > CHACHA20_POLY1305_CHUNK)
+            todo = CHACHA20_POLY1305_CHUNK;
+        CRYPTO_chacha_20(out + off, in + off, todo, c20_ctx->key, nonce,
+                         1 + (uint32_t)(off / 64));
+        CRYPTO_poly1305_update(&poly1305, out + off, todo);
+    }
+    format->tail(&poly1305, ad_len, in_len);
+    CRYPTO_poly1305_finish(&poly1305, tag);
 
     memcpy(out + in_len, tag, c20_ctx->tag_len);
     *out_len = in_len + c20_ctx->tag_len;
     return 1;
 }
 
-static int open_impl(aead_poly1305_update poly1305_update,
+static int open_impl(const aead_poly1305_format *format,
                      const EVP_AEAD_CTX *ctx, uint8_t *out, size_t *out_len,
                      size_t max_out_len, const uint8_t nonce[12],
                      const uint8_t *in, size_t in_len, const uint8_t *ad,
                      size_t ad_len)
 {
     const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
-    size_t plaintext_len;
+    size_t plaintext_len, off, todo;
     const uint64_t in_len_64 = in_len;
+    poly1305_state poly1305;
+    uint8_t block[CHACHA20_POLY1305_CHUNK], tag[POLY1305_TAG_LEN];
 
     if (in_len < c20_ctx->tag_len) {
         EVPerr(EVP_F_AEAD_CHACHA20_POLY1305_OPEN, EVP_R_BAD_DECRYPT);
@@ -181,15 +213,39 @@ static int open_impl(aead_poly1305_update poly1305_update,
     }
 
     plaintext_len = in_len - c20_ctx->tag_len;
-    uint8_t tag[POLY1305_TAG_LEN];
-    aead_poly1305(poly1305_update, tag, c20_ctx, nonce, ad, ad_len, in,
-                  plaintext_len);
+    if (max_out_len < plaintext_len) {
+        EVPerr(EVP_F_AEAD_CHACHA20_POLY1305_OPEN, EVP_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+
+    /*
+     * Each chunk is authenticated before it is decrypted, which keeps
+     * in-place operation working. If the tag turns out not to match,
+     * EVP_AEAD_CTX_open wipes the plaintext written so far.
+     */
+    off = aead_chacha20_first(block, c20_ctx, nonce, in, plaintext_len);
+    CRYPTO_poly1305_init(&poly1305, block);
+    format->ad(&poly1305, ad, ad_len);
+    CRYPTO_poly1305_update(&poly1305, in, off);
+    memcpy(out, block + 64, off);
+    vigortls_zeroize(block, 64 + off);
+
+    for (; off < plaintext_len; off += todo) {
+        todo = plaintext_len - off;
+        if (todo > CHACHA20_POLY1305_CHUNK)
+            todo = CHACHA20_POLY1305_CHUNK;
+        CRYPTO_poly1305_update(&poly1305, in + off, todo);
+        CRYPTO_chacha_20(out + off, in + off, todo, c20_ctx->key, nonce,
+                         1 + (uint32_t)(off / 64));
+    }
+    format->tail(&poly1305, ad_len, plaintext_len);
+    CRYPTO_poly1305_finish(&poly1305, tag);
+
     if (CRYPTO_memcmp(tag, in + plaintext_len, c20_ctx->tag_len) != 0) {
         EVPerr(EVP_F_AEAD_CHACHA20_POLY1305_OPEN, EVP_R_BAD_DECRYPT);
         return 0;
     }
 
-    CRYPTO_chacha_20(out, in, plaintext_len, c20_ctx->key, nonce, 1);
     *out_len = plaintext_len;
     return 1;
 }
@@ -205,16 +261,29 @@ static void poly1305_update_padded_16(poly1305_state *poly1305,
     }
 }
 
-static void poly1305_update(poly1305_state *ctx, const uint8_t *ad,
-                            size_t ad_len, const uint8_t *ciphertext,
-                            size_t ciphertext_len)
+static void poly1305_update_ad(poly1305_state *ctx, const uint8_t *ad,
+                               size_t ad_len)
 {
     poly1305_update_padded_16(ctx, ad, ad_len);
-    poly1305_update_padded_16(ctx, ciphertext, ciphertext_len);
+}
+
+static void poly1305_update_tail(poly1305_state *ctx, size_t ad_len,
+                                 size_t ciphertext_len)
+{
+    static const uint8_t padding[16] = { 0 }; /* Padding is all zeros. */
+
+    if (ciphertext_len % 16 != 0) {
+        CRYPTO_poly1305_update(ctx, padding,
+                               sizeof(padding) - (ciphertext_len % 16));
+    }
     poly1305_update_length(ctx, ad_len);
     poly1305_update_length(ctx, ciphertext_len);
 }
 
+static const aead_poly1305_format poly1305_format = {
+    poly1305_update_ad, poly1305_update_tail,
+};
+
 static int aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, uint8_t *out,
                                        size_t *out_len, size_t max_out_len,
                                        const uint8_t *nonce, size_t nonce_len,
@@ -225,7 +294,7 @@ static int aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, uint8_t *out,
         EVPerr(EVP_F_AEAD_CHACHA20_POLY1305_SEAL, EVP_R_IV_TOO_LARGE);
         return 0;
     }
-    return seal_impl(poly1305_update, ctx, out, out_len, max_out_len, nonce, in,
+    return seal_impl(&poly1305_format, ctx, out, out_len, max_out_len, nonce, in,
                      in_len, ad, ad_len);
 }
 
@@ -239,20 +308,27 @@ static int aead_chacha20_poly1305_open(const EVP_AEAD_CTX *ctx, uint8_t *out,
         EVPerr(EVP_F_AEAD_CHACHA20_POLY1305_SEAL, EVP_R_IV_TOO_LARGE);
         return 0;
     }
-    return open_impl(poly1305_update, ctx, out, out_len, max_out_len, nonce, in,
+    return open_impl(&poly1305_format, ctx, out, out_len, max_out_len, nonce, in,
                      in_len, ad, ad_len);
 }
 
-static void poly1305_update_old(poly1305_state *ctx, const uint8_t *ad,
-                                size_t ad_len, const uint8_t *ciphertext,
-                                size_t ciphertext_len)
+static void poly1305_update_ad_old(poly1305_state *ctx, const uint8_t *ad,
+                                   size_t ad_len)
 {
     CRYPTO_poly1305_update(ctx, ad, ad_len);
     poly1305_update_length(ctx, ad_len);
-    CRYPTO_poly1305_update(ctx, ciphertext, ciphertext_len);
+}
+
+static void poly1305_update_tail_old(poly1305_state *ctx, size_t ad_len,
+                                     size_t ciphertext_len)
+{
     poly1305_update_length(ctx, ciphertext_len);
 }
 
+static const aead_poly1305_format poly1305_format_old = {
+    poly1305_update_ad_old, poly1305_update_tail_old,
+};
+
 static int aead_chacha20_poly1305_old_seal(
     const EVP_AEAD_CTX *ctx, uint8_t *out, size_t *out_len, size_t max_out_len,
     const uint8_t *nonce, size_t nonce_len, const uint8_t *in, size_t in_len,
@@ -265,7 +341,7 @@ static int aead_chacha20_poly1305_old_seal(
     uint8_t nonce_96[12];
     memset(nonce_96, 0, 4);
     memcpy(nonce_96 + 4, nonce, 8);
-    return seal_impl(poly1305_update_old, ctx, out, out_len, max_out_len,
+    return seal_impl(&poly1305_format_old, ctx, out, out_len, max_out_len,
                      nonce_96, in, in_len, ad, ad_len);
 }
 
@@ -281,7 +357,7 @@ static int aead_chacha20_poly1305_old_open(
     uint8_t nonce_96[12];
     memset(nonce_96, 0, 4);
     memcpy(nonce_96 + 4, nonce, 8);
-    return open_impl(poly1305_update_old, ctx, out, out_len, max_out_len,
+    return open_impl(&poly1305_format_old, ctx, out, out_len, max_out_len,
                      nonce_96, in, in_len, ad, ad_len);
 }
 
@@ -13,6 +13,14 @@
 
 #include <openssl/evp.h>
 
+#if defined(VIGORTLS_X86_64) && !defined(OPENSSL_NO_ASM) && defined(__GNUC__)
+#include <tmmintrin.h>
+
+#include "cryptlib.h"
+
+#define B64_SSSE3
+#endif
+
 static unsigned char conv_ascii2bin(unsigned char a);
 #define conv_bin2ascii(a) (data_bin2ascii[(a)&0x3f])
 
@@ -71,6 +79,99 @@ static unsigned char conv_ascii2bin(unsigned char a)
     return data_ascii2bin[a];
 }
 
+/*
+ * The fast paths below decode one full PEM line, 64 characters, at a time.
+ * They only accept characters from the base64 alphabet proper (no padding,
+ * whitespace or line breaks) and return 0 without writing anything
+ * otherwise, leaving the caller to handle the line byte by byte. All input is
+ * read before any output is written, so |t| may alias |f| as long as it does
+ * not start after it.
+ */
+#define B64_QUANTUM 64
+
+static int b64_decode_quantum_c(uint8_t *t, const uint8_t *f)
+{
+    uint8_t v[B64_QUANTUM];
+    unsigned int bad = 0;
+    int i;
+
+    for (i = 0; i < B64_QUANTUM; i++) {
+        v[i] = conv_ascii2bin(f[i]);
+        bad |= v[i] | ((f[i] == '=') << 7);
+    }
+    if (bad & 0x80)
+        return 0;
+
+    for (i = 0; i < B64_QUANTUM; i += 4) {
+        *(t++) = (v[i] << 2) | (v[i + 1] >> 4);
+        *(t++) = (v[i + 1] << 4) | (v[i + 2] >> 2);
+        *(t++) = (v[i + 2] << 6) | v[i + 3];
+    }
+    return 1;
+}
+
+#ifdef B64_SSSE3
+/*
+ * Vectorised lookup after Wojciech Mula's SSSE3 base64 decoder: the high and
+ * low nibbles of each character index two bit-class tables whose AND is
+ * non-zero exactly for characters outside the alphabet, and a third table
+ * gives the offset from ASCII to the 6-bit value.
+ */
+__attribute__((target("ssse3")))
+static int b64_decode_quantum_ssse3(uint8_t *t, const uint8_t *f)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                                         0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                         0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                       -1, -1, -1, -1);
+    const __m128i mask_2f = _mm_set1_epi8(0x2F);
+    __m128i in[4], hi, lo, bad = _mm_setzero_si128();
+    uint8_t last[16];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        in[i] = _mm_loadu_si128((const __m128i *)(f + 16 * i));
+        hi = _mm_and_si128(_mm_srli_epi32(in[i], 4), mask_2f);
+        lo = _mm_and_si128(in[i], mask_2f);
+        bad = _mm_or_si128(bad, _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo),
+                                              _mm_shuffle_epi8(lut_hi, hi)));
+        in[i] = _mm_add_epi8(in[i], _mm_shuffle_epi8(lut_roll,
+            _mm_add_epi8(_mm_cmpeq_epi8(in[i], mask_2f), hi)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) != 0xFFFF)
+        return 0;
+
+    for (i = 0; i < 4; i++) {
+        /* Merge four 6-bit values into 24 bits, then gather the bytes. */
+        in[i] = _mm_maddubs_epi16(in[i], _mm_set1_epi32(0x01400140));
+        in[i] = _mm_madd_epi16(in[i], _mm_set1_epi32(0x00011000));
+        in[i] = _mm_shuffle_epi8(in[i], pack);
+    }
+    /* Each store spills four zero bytes that the next one overwrites. */
+    _mm_storeu_si128((__m128i *)t, in[0]);
+    _mm_storeu_si128((__m128i *)(t + 12), in[1]);
+    _mm_storeu_si128((__m128i *)(t + 24), in[2]);
+    _mm_storeu_si128((__m128i *)last, in[3]);
+    memcpy(t + 36, last, 12);
+    return 1;
+}
+#endif
+
+static int b64_decode_quantum(uint8_t *t, const uint8_t *f)
+{
+#ifdef B64_SSSE3
+    if (OPENSSL_ia32cap_P[1] & (1 << 9)) /* SSSE3 */
+        return b64_decode_quantum_ssse3(t, f);
+#endif
+    return b64_decode_quantum_c(t, f);
+}
+
 void EVP_EncodeInit(EVP_ENCODE_CTX *ctx)
 {
     ctx->length = 48;
@@ -218,6 +319,27 @@ int EVP_DecodeUpdate(EVP_ENCODE_CTX *ctx, uint8_t *out, int *outl,
     }
 
     for (i = 0; i < inl; i++) {
+        /*
+         * Full lines of plain base64 at the start of an empty buffer are
+         * decoded straight from the input; this is exactly what the code
+         * below would do after copying them into |d|. Line breaks between
+         * them would be ignored below as well.
+         */
+        while (n == 0 && eof == 0) {
+            while (i < inl && (*in == '\n' || *in == '\r')) {
+                in++;
+                i++;
+            }
+            if (inl - i < B64_QUANTUM || !b64_decode_quantum(out, in))
+                break;
+            in += B64_QUANTUM;
+            i += B64_QUANTUM;
+            out += B64_QUANTUM / 4 * 3;
+            ret += B64_QUANTUM / 4 * 3;
+        }
+        if (i == inl)
+            break;
+
         tmp = *(in++);
         v = conv_ascii2bin(tmp);
         if (v == B64_ERROR) {
@@ -319,7 +441,13 @@ int EVP_DecodeBlock(uint8_t *t, const uint8_t *f, int n)
     if (n % 4 != 0)
         return (-1);
 
-    for (i = 0; i < n; i += 4) {
+    for (i = 0; i + B64_QUANTUM <= n && b64_decode_quantum(t, f);
+         i += B64_QUANTUM) {
+        f += B64_QUANTUM;
+        t += B64_QUANTUM / 4 * 3;
+        ret += B64_QUANTUM / 4 * 3;
+    }
+    for (; i < n; i += 4) {
         a = conv_ascii2bin(*(f++));
         b = conv_ascii2bin(*(f++));
         c = conv_ascii2bin(*(f++));
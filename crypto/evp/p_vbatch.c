@@ -0,0 +1,163 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/ecdsa.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+
+/* evp_verify_one checks a single item with a fresh EVP_PKEY_CTX. */
+static int evp_verify_one(const EVP_PKEY_VERIFY_ITEM *item)
+{
+    EVP_PKEY_CTX *pkctx;
+    int ret = -1;
+
+    if ((pkctx = EVP_PKEY_CTX_new(item->pkey, NULL)) == NULL)
+        return -1;
+    if (EVP_PKEY_verify_init(pkctx) <= 0)
+        goto err;
+    if (item->md != NULL && EVP_PKEY_CTX_set_signature_md(pkctx, item->md) <= 0)
+        goto err;
+    ret = EVP_PKEY_verify(pkctx, item->sig, item->siglen, item->tbs,
+                          item->tbslen);
+
+err:
+    EVP_PKEY_CTX_free(pkctx);
+    return ret;
+}
+
+/* evp_decode_ecdsa_sig parses a DER ECDSA signature, rejecting any other
+ * encoding just like ECDSA_verify. */
+static ECDSA_SIG *evp_decode_ecdsa_sig(const uint8_t *sig, size_t siglen)
+{
+    ECDSA_SIG *s;
+    const uint8_t *p = sig;
+    uint8_t *der = NULL;
+    int derlen;
+
+    if (siglen > INT_MAX || (s = d2i_ECDSA_SIG(NULL, &p, (long)siglen)) == NULL)
+        return NULL;
+    derlen = i2d_ECDSA_SIG(s, &der);
+    if (derlen != (int)siglen || memcmp(sig, der, derlen) != 0) {
+        ECDSA_SIG_free(s);
+        s = NULL;
+    }
+    free(der);
+    return s;
+}
+
+int EVP_PKEY_verify_batch(EVP_PKEY_VERIFY_ITEM *items, size_t num)
+{
+    const uint8_t **dgsts = NULL;
+    int *dgst_lens = NULL, *results = NULL;
+    ECDSA_SIG **sigs = NULL;
+    EC_KEY **eckeys = NULL;
+    size_t *idx = NULL;
+    size_t i, n_ec = 0;
+    int ret = 1;
+
+    if (num == 0)
+        return 1;
+
+    if ((dgsts = calloc(num, sizeof(*dgsts))) == NULL ||
+        (dgst_lens = calloc(num, sizeof(*dgst_lens))) == NULL ||
+        (results = calloc(num, sizeof(*results))) == NULL ||
+        (sigs = calloc(num, sizeof(*sigs))) == NULL ||
+        (eckeys = calloc(num, sizeof(*eckeys))) == NULL ||
+        (idx = calloc(num, sizeof(*idx))) == NULL) {
+        EVPerr(EVP_F_EVP_PKEY_VERIFY, ERR_R_MALLOC_FAILURE);
+        ret = -1;
+        goto err;
+    }
+
+    for (i = 0; i < num; i++) {
+        EVP_PKEY_VERIFY_ITEM *item = &items[i];
+
+        item->result = -1;
+        if (item->pkey == NULL) {
+            EVPerr(EVP_F_EVP_PKEY_VERIFY, ERR_R_PASSED_NULL_PARAMETER);
+            continue;
+        }
+
+        /* Keys bound to an ENGINE take the regular EVP_PKEY_CTX path. */
+        if (item->pkey->engine != NULL) {
+            item->result = evp_verify_one(item);
+            continue;
+        }
+
+        switch (EVP_PKEY_base_id(item->pkey)) {
+            case EVP_PKEY_EC:
+                if (item->tbslen > INT_MAX)
+                    break;
+                if ((sigs[n_ec] = evp_decode_ecdsa_sig(item->sig,
+                                                       item->siglen)) == NULL)
+                    break;
+                dgsts[n_ec] = item->tbs;
+                dgst_lens[n_ec] = (int)item->tbslen;
+                eckeys[n_ec] = item->pkey->pkey.ec;
+                idx[n_ec++] = i;
+                break;
+
+#ifndef OPENSSL_NO_RSA
+            case EVP_PKEY_RSA:
+                if (item->md == NULL || item->siglen > UINT_MAX) {
+                    item->result = evp_verify_one(item);
+                    break;
+                }
+                if (item->tbslen != (size_t)EVP_MD_size(item->md)) {
+                    EVPerr(EVP_F_EVP_PKEY_VERIFY, EVP_R_INVALID_DIGEST);
+                    break;
+                }
+                item->result = RSA_verify(EVP_MD_type(item->md), item->tbs,
+                                          (unsigned int)item->tbslen,
+                                          item->sig, (unsigned int)item->siglen,
+                                          item->pkey->pkey.rsa);
+                break;
+#endif
+
+            default:
+                item->result = evp_verify_one(item);
+                break;
+        }
+    }
+
+    if (n_ec > 0) {
+        ECDSA_do_verify_batch(n_ec, dgsts, dgst_lens,
+                              (const ECDSA_SIG *const *)sigs, eckeys, results);
+        for (i = 0; i < n_ec; i++)
+            items[idx[i]].result = results[i];
+    }
+
+    for (i = 0; i < num; i++) {
+        if (items[i].result < 0) {
+            ret = -1;
+            break;
+        }
+        if (items[i].result == 0)
+            ret = 0;
+    }
+
+err:
+    if (sigs != NULL) {
+        for (i = 0; i < n_ec; i++)
+            ECDSA_SIG_free(sigs[i]);
+    }
+    free(dgsts);
+    free(dgst_lens);
+    free(results);
+    free(sigs);
+    free(eckeys);
+    free(idx);
+    return ret;
+}
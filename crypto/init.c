@@ -1,38 +0,0 @@
-/*
- * Copyright (c) 2016, Kurt Cancemi (kurt@x64architecture.com)
- *
- * Permission to use, copy, modify, and/or distribute this software for any
- * purpose with or without fee is hereby granted, provided that the above
- * copyright notice and this permission notice appear in all copies.
- *
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
- * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
- * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
- * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
- * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
- * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
- * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
- */
-
-#include <openssl/opensslconf.h>
-#include "cryptlib.h"
-
-#if defined(VIGORTLS_MSVC)
-#define VIGORTLS_CDECL __cdecl
-
-#pragma section(".CRT$XCU", read)
-static void __cdecl do_crypto_init(void);
-__declspec(allocate(".CRT$XCU"))
-    void(*crypto_init_constructor)(void) = do_crypto_init;
-#else
-#define VIGORTLS_CDECL
-
-static void do_crypto_init(void) __attribute__ ((constructor));
-#endif
-
-static void VIGORTLS_CDECL do_crypto_init(void)
-{
-#if defined(VIGORTLS_X86_64) || defined(VIGORTLS_X86) || defined(VIGORTLS_ARM)
-    OPENSSL_cpuid_setup();
-#endif
-}
@@ -26,7 +26,7 @@ ASN1_OBJECT *OBJ_dup(const ASN1_OBJECT *o)
 
     if (o == NULL)
         return (NULL);
-    if (!(o->flags & ASN1_OBJECT_FLAG_DYNAMIC))
+    if (!(o->flags & (ASN1_OBJECT_FLAG_DYNAMIC | ASN1_OBJECT_FLAG_ARENA)))
         return ((ASN1_OBJECT *)o); /* XXX: ugh! Why? What kind of
                          duplication is this??? */
 
@@ -62,7 +62,7 @@ ASN1_OBJECT *OBJ_dup(const ASN1_OBJECT *o)
         memcpy(sn, o->sn, i);
         r->sn = sn;
     }
-    r->flags = o->flags | (ASN1_OBJECT_FLAG_DYNAMIC | ASN1_OBJECT_FLAG_DYNAMIC_STRINGS | ASN1_OBJECT_FLAG_DYNAMIC_DATA);
+    r->flags = (o->flags & ~ASN1_OBJECT_FLAG_ARENA) | (ASN1_OBJECT_FLAG_DYNAMIC | ASN1_OBJECT_FLAG_DYNAMIC_STRINGS | ASN1_OBJECT_FLAG_DYNAMIC_DATA);
     return (r);
 err:
     OBJerr(OBJ_F_OBJ_DUP, ERR_R_MALLOC_FAILURE);
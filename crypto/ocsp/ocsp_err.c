@@ -32,6 +32,10 @@ static ERR_STRING_DATA OCSP_str_functs[] = {
     { ERR_FUNC(OCSP_F_OCSP_PARSE_URL), "OCSP_PARSE_URL" },
     { ERR_FUNC(OCSP_F_OCSP_REQUEST_SIGN), "OCSP_REQUEST_SIGN" },
     { ERR_FUNC(OCSP_F_OCSP_REQUEST_VERIFY), "OCSP_REQUEST_VERIFY" },
+    { ERR_FUNC(OCSP_F_OCSP_RESPONDER_LOAD_INDEX),
+     "OCSP_RESPONDER_LOAD_INDEX" },
+    { ERR_FUNC(OCSP_F_OCSP_RESPONDER_NEW), "OCSP_RESPONDER_NEW" },
+    { ERR_FUNC(OCSP_F_OCSP_RESPONDER_UPDATE), "OCSP_RESPONDER_UPDATE" },
     { ERR_FUNC(OCSP_F_OCSP_RESPONSE_GET1_BASIC), "OCSP_RESPONSE_GET1_BASIC" },
     { ERR_FUNC(OCSP_F_OCSP_SENDREQ_BIO), "OCSP_SENDREQ_BIO" },
     { ERR_FUNC(OCSP_F_OCSP_SENDREQ_NBIO), "OCSP_SENDREQ_NBIO" },
@@ -42,6 +46,7 @@ static ERR_STRING_DATA OCSP_str_functs[] = {
 
 static ERR_STRING_DATA OCSP_str_reasons[] = {
     { ERR_REASON(OCSP_R_BAD_DATA), "bad data" },
+    { ERR_REASON(OCSP_R_BAD_INDEX_ENTRY), "bad index entry" },
     { ERR_REASON(OCSP_R_CERTIFICATE_VERIFY_ERROR), "certificate verify error" },
     { ERR_REASON(OCSP_R_DIGEST_ERR), "digest err" },
     { ERR_REASON(OCSP_R_ERROR_IN_NEXTUPDATE_FIELD),
@@ -0,0 +1,534 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * A responder that answers from responses signed in advance, in the manner
+ * of the RFC 5019 lightweight profile. OCSP_RESPONDER_update signs one
+ * response for every serial number in the index, all valid for the same
+ * window, and publishes them together as a table keyed by serial number.
+ * Answering a request is then a parse of the request, a table lookup and a
+ * copy. Requests must ask about exactly one certificate, with a SHA-1
+ * CertID; nonces are ignored, since a pre-signed response cannot echo them.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#include <openssl/ocsp.h>
+#include <openssl/sha.h>
+#include <openssl/txt_db.h>
+#include <openssl/x509.h>
+#include <stdcompat.h>
+
+#include "bytestring.h"
+#include "internal/threads.h"
+
+/* The columns of an index file, as written by the ca command */
+#define INDEX_TYPE      0
+#define INDEX_EXP_DATE  1
+#define INDEX_REV_DATE  2
+#define INDEX_SERIAL    3
+#define INDEX_FILE      4
+#define INDEX_NAME      5
+#define INDEX_COLUMNS   6
+
+/* OCSPResponse with only a responseStatus, for the unsuccessful cases */
+#define OCSP_STATUS_ONLY(status) { 0x30, 0x03, 0x0a, 0x01, (status) }
+
+static const uint8_t resp_malformed[] =
+    OCSP_STATUS_ONLY(OCSP_RESPONSE_STATUS_MALFORMEDREQUEST);
+static const uint8_t resp_try_later[] =
+    OCSP_STATUS_ONLY(OCSP_RESPONSE_STATUS_TRYLATER);
+static const uint8_t resp_unauthorized[] =
+    OCSP_STATUS_ONLY(OCSP_RESPONSE_STATUS_UNAUTHORIZED);
+
+/* 1.3.14.3.2.26 */
+static const uint8_t oid_sha1[] = { 0x2b, 0x0e, 0x03, 0x02, 0x1a };
+
+typedef struct {
+    ASN1_INTEGER *serial;
+    int status;
+    int reason;
+    ASN1_TIME *revtime;
+} OCSP_RESPONDER_ENTRY;
+
+typedef struct {
+    uint32_t hash;
+    /* The DER serial number followed by the DER response */
+    uint8_t *data;
+    size_t serial_len;
+    size_t resp_len;
+} OCSP_RESPONDER_SLOT;
+
+/* A table is never modified once published */
+typedef struct {
+    OCSP_RESPONDER_SLOT *slots;
+    size_t mask;
+    time_t next_update;
+} OCSP_RESPONDER_TABLE;
+
+struct ocsp_responder_st {
+    X509 *issuer;
+    X509 *signer;
+    EVP_PKEY *key;
+    const EVP_MD *md;
+    uint8_t name_hash[SHA_DIGEST_LENGTH];
+    uint8_t key_hash[SHA_DIGEST_LENGTH];
+    OCSP_RESPONDER_ENTRY *entries;
+    size_t num_entries;
+    OCSP_RESPONDER_TABLE *table;
+    CRYPTO_MUTEX *lock;
+};
+
+static void responder_entries_free(OCSP_RESPONDER_ENTRY *entries, size_t num)
+{
+    size_t i;
+
+    for (i = 0; i < num; i++) {
+        ASN1_INTEGER_free(entries[i].serial);
+        ASN1_TIME_free(entries[i].revtime);
+    }
+    free(entries);
+}
+
+static void responder_table_free(OCSP_RESPONDER_TABLE *table)
+{
+    size_t i;
+
+    if (table == NULL)
+        return;
+    for (i = 0; i <= table->mask; i++)
+        free(table->slots[i].data);
+    free(table->slots);
+    free(table);
+}
+
+OCSP_RESPONDER *OCSP_RESPONDER_new(X509 *issuer, X509 *signer, EVP_PKEY *key,
+                                   const EVP_MD *md)
+{
+    OCSP_RESPONDER *r;
+    ASN1_BIT_STRING *issuer_key;
+    unsigned int len;
+
+    if ((r = calloc(1, sizeof(*r))) == NULL ||
+        (r->lock = CRYPTO_thread_new()) == NULL) {
+        OCSPerr(OCSP_F_OCSP_RESPONDER_NEW, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    issuer_key = X509_get0_pubkey_bitstr(issuer);
+    if (!X509_NAME_digest(X509_get_subject_name(issuer), EVP_sha1(),
+                          r->name_hash, &len) ||
+        !EVP_Digest(issuer_key->data, issuer_key->length, r->key_hash, &len,
+                    EVP_sha1(), NULL)) {
+        OCSPerr(OCSP_F_OCSP_RESPONDER_NEW, OCSP_R_DIGEST_ERR);
+        goto err;
+    }
+
+    X509_up_ref(issuer);
+    r->issuer = issuer;
+    X509_up_ref(signer);
+    r->signer = signer;
+    EVP_PKEY_up_ref(key);
+    r->key = key;
+    r->md = md;
+    return r;
+
+err:
+    OCSP_RESPONDER_free(r);
+    return NULL;
+}
+
+void OCSP_RESPONDER_free(OCSP_RESPONDER *r)
+{
+    if (r == NULL)
+        return;
+    X509_free(r->issuer);
+    X509_free(r->signer);
+    EVP_PKEY_free(r->key);
+    responder_entries_free(r->entries, r->num_entries);
+    responder_table_free(r->table);
+    CRYPTO_thread_cleanup(r->lock);
+    free(r);
+}
+
+/* Revocation reasons as written by the ca command, in CRL reason order */
+static const struct {
+    const char *name;
+    int reason;
+} responder_reasons[] = {
+    { "unspecified", OCSP_REVOKED_STATUS_UNSPECIFIED },
+    { "keyCompromise", OCSP_REVOKED_STATUS_KEYCOMPROMISE },
+    { "CACompromise", OCSP_REVOKED_STATUS_CACOMPROMISE },
+    { "affiliationChanged", OCSP_REVOKED_STATUS_AFFILIATIONCHANGED },
+    { "superseded", OCSP_REVOKED_STATUS_SUPERSEDED },
+    { "cessationOfOperation", OCSP_REVOKED_STATUS_CESSATIONOFOPERATION },
+    { "certificateHold", OCSP_REVOKED_STATUS_CERTIFICATEHOLD },
+    { "removeFromCRL", OCSP_REVOKED_STATUS_REMOVEFROMCRL },
+    { "holdInstruction", OCSP_REVOKED_STATUS_CERTIFICATEHOLD },
+    { "keyTime", OCSP_REVOKED_STATUS_KEYCOMPROMISE },
+    { "CAkeyTime", OCSP_REVOKED_STATUS_CACOMPROMISE },
+};
+
+#define NUM_REASONS (sizeof(responder_reasons) / sizeof(responder_reasons[0]))
+
+/*
+ * parse_revinfo parses a revocation column, "revtime[,reason[,extra]]",
+ * into |entry|. The extra argument of the hold and key time pseudo reasons
+ * is not included in responses.
+ */
+static int parse_revinfo(OCSP_RESPONDER_ENTRY *entry, const char *str)
+{
+    char buf[64], *reason;
+    size_t i;
+
+    if (strlcpy(buf, str, sizeof(buf)) >= sizeof(buf))
+        return 0;
+    if ((reason = strchr(buf, ',')) != NULL) {
+        *(reason++) = '\0';
+        reason[strcspn(reason, ",")] = '\0';
+    }
+
+    if ((entry->revtime = ASN1_UTCTIME_new()) == NULL ||
+        !ASN1_UTCTIME_set_string(entry->revtime, buf))
+        return 0;
+
+    entry->reason = OCSP_REVOKED_STATUS_NOSTATUS;
+    if (reason == NULL)
+        return 1;
+    for (i = 0; i < NUM_REASONS; i++) {
+        if (strcasecmp(reason, responder_reasons[i].name) == 0) {
+            entry->reason = responder_reasons[i].reason;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int parse_index_row(OCSP_RESPONDER_ENTRY *entry, char **row)
+{
+    BIGNUM *bn = NULL;
+
+    memset(entry, 0, sizeof(*entry));
+
+    switch (row[INDEX_TYPE][0]) {
+        case 'V':
+            entry->status = V_OCSP_CERTSTATUS_GOOD;
+            break;
+        case 'R':
+            entry->status = V_OCSP_CERTSTATUS_REVOKED;
+            if (!parse_revinfo(entry, row[INDEX_REV_DATE]))
+                return 0;
+            break;
+        default:
+            /* Expired certificates are not answered for */
+            return 1;
+    }
+
+    if (!BN_hex2bn(&bn, row[INDEX_SERIAL]))
+        return 0;
+    entry->serial = BN_to_ASN1_INTEGER(bn, NULL);
+    BN_free(bn);
+    return entry->serial != NULL;
+}
+
+int OCSP_RESPONDER_load_index(OCSP_RESPONDER *r, BIO *in)
+{
+    OCSP_RESPONDER_ENTRY *entries = NULL;
+    size_t i, num = 0;
+    TXT_DB *db;
+    char **row;
+
+    if ((db = TXT_DB_read(in, INDEX_COLUMNS)) == NULL) {
+        OCSPerr(OCSP_F_OCSP_RESPONDER_LOAD_INDEX, OCSP_R_BAD_INDEX_ENTRY);
+        return 0;
+    }
+    if (sk_OPENSSL_PSTRING_num(db->data) > 0 &&
+        (entries = reallocarray(NULL, sk_OPENSSL_PSTRING_num(db->data),
+                                sizeof(*entries))) == NULL) {
+        OCSPerr(OCSP_F_OCSP_RESPONDER_LOAD_INDEX, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i < (size_t)sk_OPENSSL_PSTRING_num(db->data); i++) {
+        row = sk_OPENSSL_PSTRING_value(db->data, i);
+        if (!parse_index_row(&entries[num], row)) {
+            /* Account for the partly parsed entry */
+            num++;
+            OCSPerr(OCSP_F_OCSP_RESPONDER_LOAD_INDEX, OCSP_R_BAD_INDEX_ENTRY);
+            goto err;
+        }
+        if (entries[num].serial != NULL)
+            num++;
+    }
+    TXT_DB_free(db);
+
+    /* Takes effect at the next OCSP_RESPONDER_update */
+    responder_entries_free(r->entries, r->num_entries);
+    r->entries = entries;
+    r->num_entries = num;
+    return 1;
+
+err:
+    responder_entries_free(entries, num);
+    TXT_DB_free(db);
+    return 0;
+}
+
+static uint32_t responder_hash(const uint8_t *serial, size_t len)
+{
+    uint32_t h = 2166136261U;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        h = (h ^ serial[i]) * 16777619U;
+    return h;
+}
+
+/*
+ * responder_sign_entry signs the response for |entry| and stores it, with
+ * its serial number, in |slot|.
+ */
+static int responder_sign_entry(OCSP_RESPONDER *r, OCSP_RESPONDER_ENTRY *entry,
+                                ASN1_TIME *thisupd, ASN1_TIME *nextupd,
+                                OCSP_RESPONDER_SLOT *slot)
+{
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_RESPONSE *resp = NULL;
+    OCSP_CERTID *cid = NULL;
+    unsigned long flags = 0;
+    uint8_t *p;
+    int serial_len, resp_len, ret = 0;
+
+    if (X509_cmp(r->signer, r->issuer) == 0)
+        flags |= OCSP_NOCERTS;
+
+    if ((cid = OCSP_cert_id_new(EVP_sha1(), X509_get_subject_name(r->issuer),
+                                X509_get0_pubkey_bitstr(r->issuer),
+                                entry->serial)) == NULL ||
+        (bs = OCSP_BASICRESP_new()) == NULL ||
+        OCSP_basic_add1_status(bs, cid, entry->status, entry->reason,
+                               entry->revtime, thisupd, nextupd) == NULL ||
+        !OCSP_basic_sign(bs, r->signer, r->key, r->md, NULL, flags) ||
+        (resp = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                                     bs)) == NULL)
+        goto err;
+
+    if ((serial_len = i2d_ASN1_INTEGER(entry->serial, NULL)) <= 0 ||
+        (resp_len = i2d_OCSP_RESPONSE(resp, NULL)) <= 0 ||
+        (slot->data = malloc(serial_len + resp_len)) == NULL)
+        goto err;
+    p = slot->data;
+    i2d_ASN1_INTEGER(entry->serial, &p);
+    i2d_OCSP_RESPONSE(resp, &p);
+    slot->serial_len = serial_len;
+    slot->resp_len = resp_len;
+    slot->hash = responder_hash(slot->data, serial_len);
+    ret = 1;
+
+err:
+    OCSP_CERTID_free(cid);
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(resp);
+    return ret;
+}
+
+static OCSP_RESPONDER_TABLE *responder_sign_all(OCSP_RESPONDER *r, time_t now,
+                                                long validity)
+{
+    OCSP_RESPONDER_TABLE *table;
+    OCSP_RESPONDER_SLOT slot, *dst;
+    ASN1_TIME *thisupd, *nextupd;
+    size_t i, size;
+
+    /* At most half full, so probes stay short */
+    for (size = 16; size < 2 * r->num_entries; size *= 2)
+        ;
+
+    thisupd = ASN1_GENERALIZEDTIME_set(NULL, now);
+    nextupd = ASN1_GENERALIZEDTIME_adj(NULL, now, 0, validity);
+    if ((table = calloc(1, sizeof(*table))) != NULL)
+        table->slots = calloc(size, sizeof(*table->slots));
+    if (thisupd == NULL || nextupd == NULL || table == NULL ||
+        table->slots == NULL)
+        goto err;
+    table->mask = size - 1;
+    table->next_update = now + validity;
+
+    for (i = 0; i < r->num_entries; i++) {
+        memset(&slot, 0, sizeof(slot));
+        if (!responder_sign_entry(r, &r->entries[i], thisupd, nextupd, &slot))
+            goto err;
+
+        dst = &table->slots[slot.hash & table->mask];
+        while (dst->data != NULL) {
+            /* A serial listed twice keeps its first entry */
+            if (dst->serial_len == slot.serial_len &&
+                memcmp(dst->data, slot.data, slot.serial_len) == 0)
+                break;
+            dst = &table->slots[(dst - table->slots + 1) & table->mask];
+        }
+        if (dst->data != NULL)
+            free(slot.data);
+        else
+            *dst = slot;
+    }
+
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    return table;
+
+err:
+    if (table != NULL && table->slots == NULL) {
+        free(table);
+        table = NULL;
+    }
+    responder_table_free(table);
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    return NULL;
+}
+
+int OCSP_RESPONDER_update(OCSP_RESPONDER *r, long validity, long margin)
+{
+    OCSP_RESPONDER_TABLE *table, *old;
+    time_t now = time(NULL);
+    int fresh;
+
+    CRYPTO_thread_read_lock(r->lock);
+    fresh = r->table != NULL && r->table->next_update - now > margin;
+    CRYPTO_thread_unlock(r->lock);
+    if (fresh)
+        return 1;
+
+    /* The whole batch is signed before any of it is served */
+    if ((table = responder_sign_all(r, now, validity)) == NULL) {
+        OCSPerr(OCSP_F_OCSP_RESPONDER_UPDATE, OCSP_R_SIGNATURE_FAILURE);
+        return 0;
+    }
+
+    CRYPTO_thread_write_lock(r->lock);
+    old = r->table;
+    r->table = table;
+    CRYPTO_thread_unlock(r->lock);
+
+    responder_table_free(old);
+    return 1;
+}
+
+time_t OCSP_RESPONDER_get_next_update(OCSP_RESPONDER *r)
+{
+    time_t ret = 0;
+
+    CRYPTO_thread_read_lock(r->lock);
+    if (r->table != NULL)
+        ret = r->table->next_update;
+    CRYPTO_thread_unlock(r->lock);
+    return ret;
+}
+
+/*
+ * parse_request finds the CertID of the single request in the DER
+ * OCSPRequest |in| and returns its issuer hashes and DER serial number.
+ */
+static int parse_request(CBS *in, CBS *name_hash, CBS *key_hash, CBS *serial)
+{
+    CBS req, tbs, list, one, cert_id, alg, oid;
+    int present;
+
+    if (!CBS_get_asn1(in, &req, CBS_ASN1_SEQUENCE) || CBS_len(in) != 0 ||
+        !CBS_get_asn1(&req, &tbs, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_optional_asn1(&tbs, NULL, &present,
+                               CBS_ASN1_CONTEXT_SPECIFIC |
+                               CBS_ASN1_CONSTRUCTED | 0) ||
+        !CBS_get_optional_asn1(&tbs, NULL, &present,
+                               CBS_ASN1_CONTEXT_SPECIFIC |
+                               CBS_ASN1_CONSTRUCTED | 1) ||
+        !CBS_get_asn1(&tbs, &list, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_asn1(&list, &one, CBS_ASN1_SEQUENCE) ||
+        CBS_len(&list) != 0 ||
+        !CBS_get_asn1(&one, &cert_id, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_asn1(&cert_id, &alg, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_asn1(&alg, &oid, CBS_ASN1_OBJECT) ||
+        !CBS_get_asn1(&cert_id, name_hash, CBS_ASN1_OCTETSTRING) ||
+        !CBS_get_asn1(&cert_id, key_hash, CBS_ASN1_OCTETSTRING) ||
+        !CBS_get_asn1_element(&cert_id, serial, CBS_ASN1_INTEGER) ||
+        CBS_len(&cert_id) != 0)
+        return 0;
+
+    /* Only SHA-1 CertIDs are answered; anything else is unknown */
+    if (!CBS_mem_equal(&oid, oid_sha1, sizeof(oid_sha1)))
+        CBS_init(name_hash, NULL, 0);
+    return 1;
+}
+
+static const OCSP_RESPONDER_SLOT *
+responder_lookup(const OCSP_RESPONDER_TABLE *table, const CBS *serial)
+{
+    const OCSP_RESPONDER_SLOT *slot;
+    uint32_t hash;
+    size_t i;
+
+    hash = responder_hash(CBS_data(serial), CBS_len(serial));
+    for (i = hash & table->mask; table->slots[i].data != NULL;
+         i = (i + 1) & table->mask) {
+        slot = &table->slots[i];
+        if (slot->hash == hash &&
+            CBS_mem_equal(serial, slot->data, slot->serial_len))
+            return slot;
+    }
+    return NULL;
+}
+
+static int responder_copy(BUF_MEM *out, const uint8_t *data, size_t len)
+{
+    if (!BUF_MEM_grow(out, len))
+        return 0;
+    memcpy(out->data, data, len);
+    return 1;
+}
+
+int OCSP_RESPONDER_respond(OCSP_RESPONDER *r, const uint8_t *req,
+                           size_t req_len, BUF_MEM *out)
+{
+    const OCSP_RESPONDER_SLOT *slot;
+    CBS in, name_hash, key_hash, serial;
+    int ret;
+
+    CBS_init(&in, req, req_len);
+    if (!parse_request(&in, &name_hash, &key_hash, &serial)) {
+        if (!responder_copy(out, resp_malformed, sizeof(resp_malformed)))
+            return -1;
+        return OCSP_RESPONSE_STATUS_MALFORMEDREQUEST;
+    }
+
+    CRYPTO_thread_read_lock(r->lock);
+    if (r->table == NULL || time(NULL) >= r->table->next_update) {
+        ret = OCSP_RESPONSE_STATUS_TRYLATER;
+        if (!responder_copy(out, resp_try_later, sizeof(resp_try_later)))
+            ret = -1;
+    } else if (!CBS_mem_equal(&name_hash, r->name_hash, sizeof(r->name_hash)) ||
+               !CBS_mem_equal(&key_hash, r->key_hash, sizeof(r->key_hash)) ||
+               (slot = responder_lookup(r->table, &serial)) == NULL) {
+        ret = OCSP_RESPONSE_STATUS_UNAUTHORIZED;
+        if (!responder_copy(out, resp_unauthorized, sizeof(resp_unauthorized)))
+            ret = -1;
+    } else {
+        ret = OCSP_RESPONSE_STATUS_SUCCESSFUL;
+        if (!responder_copy(out, slot->data + slot->serial_len,
+                            slot->resp_len))
+            ret = -1;
+    }
+    CRYPTO_thread_unlock(r->lock);
+
+    return ret;
+}
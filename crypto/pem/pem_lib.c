@@ -575,9 +575,78 @@ int PEM_read(FILE *fp, char **name, char **header, uint8_t **data,
     return (ret);
 }
 
+/*
+ * PEM_read_bio consumes its input one line at a time. When that input is a
+ * plain memory BIO, for instance a certificate bundle, the lines are found
+ * with memchr in the BIO's buffer and everything used is consumed with one
+ * BIO_read at the end, instead of a BIO_gets per line that (for a writable
+ * memory BIO) also moves the rest of the buffer down each time.
+ */
+typedef struct {
+    BIO *bio;
+    const char *data; /* NULL unless scanning a memory BIO in place */
+    size_t len;
+    size_t off;
+} PEM_LINE_SRC;
+
+static void pem_src_init(PEM_LINE_SRC *src, BIO *bp)
+{
+    char *p;
+    long n;
+
+    src->bio = bp;
+    src->data = NULL;
+    src->len = src->off = 0;
+    if (BIO_method_type(bp) != BIO_TYPE_MEM || BIO_get_callback(bp) != NULL)
+        return;
+    if ((n = BIO_get_mem_data(bp, &p)) <= 0)
+        return;
+    src->data = p;
+    src->len = n;
+}
+
+/* Behaves exactly like BIO_gets(src->bio, buf, size). */
+static int pem_src_gets(PEM_LINE_SRC *src, char *buf, int size)
+{
+    const char *p, *nl;
+    size_t n;
+
+    if (src->data == NULL)
+        return BIO_gets(src->bio, buf, size);
+
+    n = src->len - src->off;
+    if (n > (size_t)size - 1)
+        n = size - 1;
+    if (n == 0) {
+        *buf = '\0';
+        return 0;
+    }
+    p = src->data + src->off;
+    if ((nl = memchr(p, '\n', n)) != NULL)
+        n = nl - p + 1;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    src->off += n;
+    return (int)n;
+}
+
+static void pem_src_finish(PEM_LINE_SRC *src)
+{
+    char skip[4096];
+    int n;
+
+    while (src->off > 0) {
+        n = src->off < sizeof(skip) ? (int)src->off : (int)sizeof(skip);
+        if (BIO_read(src->bio, skip, n) != n)
+            break;
+        src->off -= n;
+    }
+}
+
 int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
                  long *len)
 {
+    PEM_LINE_SRC src;
     EVP_ENCODE_CTX ctx;
     int end = 0, i, k, bl = 0, hl = 0, nohead = 0;
     char buf[256];
@@ -595,10 +664,11 @@ int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
         PEMerr(PEM_F_PEM_READ_BIO, ERR_R_MALLOC_FAILURE);
         return (0);
     }
+    pem_src_init(&src, bp);
 
     buf[254] = '\0';
     for (;;) {
-        i = BIO_gets(bp, buf, 254);
+        i = pem_src_gets(&src, buf, 254);
 
         if (i <= 0) {
             PEMerr(PEM_F_PEM_READ_BIO, PEM_R_NO_START_LINE);
@@ -631,7 +701,7 @@ int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
     }
     headerB->data[0] = '\0';
     for (;;) {
-        i = BIO_gets(bp, buf, 254);
+        i = pem_src_gets(&src, buf, 254);
         if (i <= 0)
             break;
 
@@ -663,7 +733,7 @@ int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
     dataB->data[0] = '\0';
     if (!nohead) {
         for (;;) {
-            i = BIO_gets(bp, buf, 254);
+            i = pem_src_gets(&src, buf, 254);
             if (i <= 0)
                 break;
 
@@ -687,7 +757,7 @@ int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
             bl += i;
             if (end) {
                 buf[0] = '\0';
-                i = BIO_gets(bp, buf, 254);
+                i = pem_src_gets(&src, buf, 254);
                 if (i <= 0)
                     break;
 
@@ -735,8 +805,10 @@ int PEM_read_bio(BIO *bp, char **name, char **header, uint8_t **data,
     free(nameB);
     free(headerB);
     free(dataB);
+    pem_src_finish(&src);
     return (1);
 err:
+    pem_src_finish(&src);
     BUF_MEM_free(nameB);
     BUF_MEM_free(headerB);
     BUF_MEM_free(dataB);
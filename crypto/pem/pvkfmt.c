@@ -512,6 +512,9 @@ static int check_bitlen_rsa(RSA *rsa, int ispub, unsigned int *pmagic)
         return bitlen;
     } else {
         *pmagic = MS_RSA2MAGIC;
+        /* The format has no room for more than two primes */
+        if (RSA_get_multi_prime_extra_count(rsa) != 0)
+            goto badkey;
         /* For private key each component must fit within nbyte or
          * hnbyte.
          */
@@ -7,12 +7,15 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <stdio.h>
+
 #include <openssl/asn1t.h>
 #include <openssl/err.h>
 #include <openssl/x509.h>
 #include <openssl/rsa.h>
 #include <openssl/bn.h>
 #include "internal/asn1_int.h"
+#include "rsa_locl.h"
 
 static int rsa_pub_encode(X509_PUBKEY *pk, const EVP_PKEY *pkey)
 {
@@ -126,7 +129,9 @@ static int do_rsa_print(BIO *bp, const RSA *x, int off, int priv)
 {
     const char *s, *str;
     uint8_t *m = NULL;
-    int ret = 0, mod_len = 0;
+    RSA_PRIME_INFO *pinfo;
+    int ret = 0, mod_len = 0, ex_primes, i;
+    char name[32];
     size_t buf_len = 0;
 
     update_buflen(x->n, &buf_len);
@@ -140,6 +145,13 @@ static int do_rsa_print(BIO *bp, const RSA *x, int off, int priv)
         update_buflen(x->dmq1, &buf_len);
         update_buflen(x->iqmp, &buf_len);
     }
+    ex_primes = RSA_get_multi_prime_extra_count(x);
+    for (i = 0; priv && i < ex_primes; i++) {
+        pinfo = sk_RSA_PRIME_INFO_value(x->prime_infos, i);
+        update_buflen(pinfo->r, &buf_len);
+        update_buflen(pinfo->d, &buf_len);
+        update_buflen(pinfo->t, &buf_len);
+    }
 
     m = malloc(buf_len + 10);
     if (m == NULL) {
@@ -154,8 +166,12 @@ static int do_rsa_print(BIO *bp, const RSA *x, int off, int priv)
         goto err;
 
     if (priv && x->d) {
-        if (BIO_printf(bp, "Private-Key: (%d bit)\n", mod_len)
-            <= 0)
+        if (ex_primes > 0) {
+            if (BIO_printf(bp, "Private-Key: (%d bit, %d primes)\n",
+                           mod_len, ex_primes + 2) <= 0)
+                goto err;
+        } else if (BIO_printf(bp, "Private-Key: (%d bit)\n", mod_len)
+                   <= 0)
             goto err;
         str = "modulus:";
         s = "publicExponent:";
@@ -183,6 +199,18 @@ static int do_rsa_print(BIO *bp, const RSA *x, int off, int priv)
             goto err;
         if (!ASN1_bn_print(bp, "coefficient:", x->iqmp, m, off))
             goto err;
+        for (i = 0; i < ex_primes; i++) {
+            pinfo = sk_RSA_PRIME_INFO_value(x->prime_infos, i);
+            snprintf(name, sizeof(name), "prime%d:", i + 3);
+            if (!ASN1_bn_print(bp, name, pinfo->r, m, off))
+                goto err;
+            snprintf(name, sizeof(name), "exponent%d:", i + 3);
+            if (!ASN1_bn_print(bp, name, pinfo->d, m, off))
+                goto err;
+            snprintf(name, sizeof(name), "coefficient%d:", i + 3);
+            if (!ASN1_bn_print(bp, name, pinfo->t, m, off))
+                goto err;
+        }
     }
     ret = 1;
 err:
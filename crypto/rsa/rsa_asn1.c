@@ -13,6 +13,8 @@
 #include <openssl/x509.h>
 #include <openssl/asn1t.h>
 
+#include "rsa_locl.h"
+
 ASN1_SEQUENCE(RSA_OAEP_PARAMS) = {
     ASN1_EXP_OPT(RSA_OAEP_PARAMS, hashFunc, X509_ALGOR, 0),
     ASN1_EXP_OPT(RSA_OAEP_PARAMS, maskGenFunc, X509_ALGOR, 1),
@@ -34,10 +36,33 @@ static int rsa_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         RSA_free((RSA *)*pval);
         *pval = NULL;
         return 2;
+    } else if (operation == ASN1_OP_D2I_POST) {
+        RSA *rsa = (RSA *)*pval;
+
+        if (rsa->version != RSA_ASN1_VERSION_MULTI) {
+            /* Only multi-prime keys may carry further primes */
+            return rsa->prime_infos == NULL;
+        }
+        return rsa_multip_calc_product(rsa) == 1 ? 2 : 0;
     }
     return 1;
 }
 
+/* Free the members of each extra prime that are not encoded */
+static int rsa_mp_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
+                     void *exarg)
+{
+    if (operation == ASN1_OP_FREE_PRE)
+        rsa_multip_info_free_ex((RSA_PRIME_INFO *)*pval);
+    return 1;
+}
+
+ASN1_SEQUENCE_cb(RSA_PRIME_INFO, rsa_mp_cb) = {
+    ASN1_SIMPLE(RSA_PRIME_INFO, r, CBIGNUM),
+    ASN1_SIMPLE(RSA_PRIME_INFO, d, CBIGNUM),
+    ASN1_SIMPLE(RSA_PRIME_INFO, t, CBIGNUM),
+} ASN1_SEQUENCE_END_cb(RSA_PRIME_INFO, RSA_PRIME_INFO)
+
 ASN1_SEQUENCE_cb(RSAPrivateKey, rsa_cb) = {
     ASN1_SIMPLE(RSA, version, LONG),
     ASN1_SIMPLE(RSA, n, BIGNUM),
@@ -47,7 +72,8 @@ ASN1_SEQUENCE_cb(RSAPrivateKey, rsa_cb) = {
     ASN1_SIMPLE(RSA, q, BIGNUM),
     ASN1_SIMPLE(RSA, dmp1, BIGNUM),
     ASN1_SIMPLE(RSA, dmq1, BIGNUM),
-    ASN1_SIMPLE(RSA, iqmp, BIGNUM)
+    ASN1_SIMPLE(RSA, iqmp, BIGNUM),
+    ASN1_SEQUENCE_OF_OPT(RSA, prime_infos, RSA_PRIME_INFO)
 } ASN1_SEQUENCE_END_cb(RSA, RSAPrivateKey)
 
 ASN1_SEQUENCE_cb(RSAPublicKey, rsa_cb) = {
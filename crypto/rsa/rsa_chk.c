@@ -11,17 +11,27 @@
 #include <openssl/err.h>
 #include <openssl/rsa.h>
 
+#include "rsa_locl.h"
+
 int RSA_check_key(const RSA *key)
 {
     BIGNUM *i, *j, *k, *l, *m;
     BN_CTX *ctx;
-    int ret = 1;
+    RSA_PRIME_INFO *pinfo;
+    int idx, ex_primes, ret = 1;
 
     if (!key->p || !key->q || !key->n || !key->e || !key->d) {
         RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_VALUE_MISSING);
         return 0;
     }
 
+    ex_primes = RSA_get_multi_prime_extra_count(key);
+    if (ex_primes > 0 && (key->version != RSA_ASN1_VERSION_MULTI ||
+                          ex_primes + 2 > RSA_MAX_PRIME_NUM)) {
+        RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_KEY_PRIME_NUM_INVALID);
+        return 0;
+    }
+
     i = BN_new();
     j = BN_new();
     k = BN_new();
@@ -57,14 +67,34 @@ int RSA_check_key(const RSA *key)
         RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_Q_NOT_PRIME);
     }
 
-    /* n = p*q? */
+    /* r_i prime? */
+    for (idx = 0; idx < ex_primes; idx++) {
+        pinfo = sk_RSA_PRIME_INFO_value(key->prime_infos, idx);
+        if (BN_is_prime_ex(pinfo->r, BN_prime_checks, NULL, NULL) != 1) {
+            ret = 0;
+            RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_MP_R_NOT_PRIME);
+        }
+    }
+
+    /* n = p*q*r_3...r_i? */
     if (!BN_mul(i, key->p, key->q, ctx)) {
         ret = -1;
         goto err;
     }
+    for (idx = 0; idx < ex_primes; idx++) {
+        pinfo = sk_RSA_PRIME_INFO_value(key->prime_infos, idx);
+        if (!BN_mul(i, i, pinfo->r, ctx)) {
+            ret = -1;
+            goto err;
+        }
+    }
     if (BN_cmp(i, key->n) != 0) {
         ret = 0;
-        RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_N_DOES_NOT_EQUAL_P_Q);
+        if (ex_primes > 0)
+            RSAerr(RSA_F_RSA_CHECK_KEY,
+                   RSA_R_N_DOES_NOT_EQUAL_PRODUCT_OF_PRIMES);
+        else
+            RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_N_DOES_NOT_EQUAL_P_Q);
     }
 
     /* d*e = 1  mod lcm(p-1,q-1)? */
@@ -90,6 +120,17 @@ int RSA_check_key(const RSA *key)
         ret = -1;
         goto err;
     }
+
+    /* and k = lcm(k, r_i-1) for each further prime */
+    for (idx = 0; idx < ex_primes; idx++) {
+        pinfo = sk_RSA_PRIME_INFO_value(key->prime_infos, idx);
+        if (!BN_sub(j, pinfo->r, BN_value_one()) ||
+            !BN_mul(l, k, j, ctx) || !BN_gcd(m, k, j, ctx) ||
+            !BN_div(k, NULL, l, m, ctx)) {
+            ret = -1;
+            goto err;
+        }
+    }
     if (!BN_mod_mul(i, key->d, key->e, k, ctx)) {
         ret = -1;
         goto err;
@@ -140,6 +181,43 @@ int RSA_check_key(const RSA *key)
         }
     }
 
+    /* l holds the product of the primes before each further prime */
+    if (ex_primes > 0 && !BN_mul(l, key->p, key->q, ctx)) {
+        ret = -1;
+        goto err;
+    }
+    for (idx = 0; idx < ex_primes; idx++) {
+        pinfo = sk_RSA_PRIME_INFO_value(key->prime_infos, idx);
+
+        /* d_i = d mod (r_i-1)? */
+        if (!BN_sub(i, pinfo->r, BN_value_one())) {
+            ret = -1;
+            goto err;
+        }
+        if (!BN_mod(j, key->d, i, ctx)) {
+            ret = -1;
+            goto err;
+        }
+        if (BN_cmp(j, pinfo->d) != 0) {
+            ret = 0;
+            RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_MP_EXPONENT_NOT_CONGRUENT_TO_D);
+        }
+
+        /* t_i = (r_1*...*r_(i-1))^-1 mod r_i? */
+        if (!BN_mod_inverse(i, l, pinfo->r, ctx)) {
+            ret = -1;
+            goto err;
+        }
+        if (BN_cmp(i, pinfo->t) != 0) {
+            ret = 0;
+            RSAerr(RSA_F_RSA_CHECK_KEY, RSA_R_MP_COEFFICIENT_NOT_INVERSE_OF_R);
+        }
+        if (!BN_mul(l, l, pinfo->r, ctx)) {
+            ret = -1;
+            goto err;
+        }
+    }
+
  err:
     BN_free(i);
     BN_free(j);
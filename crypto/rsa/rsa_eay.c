@@ -13,6 +13,7 @@
 #include <openssl/rsa.h>
 
 #include "internal/threads.h"
+#include "rsa_locl.h"
 
 static int RSA_eay_public_encrypt(int flen, const uint8_t *from,
                                   uint8_t *to, RSA *rsa, int padding);
@@ -73,7 +74,7 @@ static int RSA_eay_public_encrypt(int flen, const uint8_t *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -221,7 +222,7 @@ static int RSA_eay_private_encrypt(int flen, const uint8_t *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -346,7 +347,7 @@ static int RSA_eay_private_decrypt(int flen, const uint8_t *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -478,7 +479,7 @@ static int RSA_eay_public_decrypt(int flen, const uint8_t *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = BN_CTX_new_cached()) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -552,7 +553,8 @@ static int RSA_eay_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
     BIGNUM *r1, *m1, *vrfy;
     BIGNUM local_dmp1, local_dmq1, local_c, local_r1;
     BIGNUM *dmp1, *dmq1, *c, *pr1;
-    int ret = 0;
+    RSA_PRIME_INFO *pinfo;
+    int i, ex_primes, ret = 0;
 
     BN_CTX_start(ctx);
     r1 = BN_CTX_get(ctx);
@@ -668,6 +670,70 @@ static int RSA_eay_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
     if (!BN_add(r0, r1, m1))
         goto err;
 
+    /* Fold in the further primes of a multi-prime key the same way, r0
+     * becoming the result modulo the product of all the primes so far */
+    ex_primes = sk_RSA_PRIME_INFO_num(rsa->prime_infos);
+    for (i = 0; i < ex_primes; i++) {
+        BIGNUM local_r, local_d, local_r0;
+        BIGNUM *r, *d, *pr0;
+        const BIGNUM *ci;
+
+        pinfo = sk_RSA_PRIME_INFO_value(rsa->prime_infos, i);
+        if (pinfo->pp == NULL)
+            goto err;
+        if (!(rsa->flags & RSA_FLAG_NO_CONSTTIME)) {
+            r = &local_r;
+            BN_with_flags(r, pinfo->r, BN_FLG_CONSTTIME);
+            d = &local_d;
+            BN_with_flags(d, pinfo->d, BN_FLG_CONSTTIME);
+            c = &local_c;
+            BN_with_flags(c, I, BN_FLG_CONSTTIME);
+            ci = c;
+            pr0 = &local_r0;
+            BN_with_flags(pr0, r0, BN_FLG_CONSTTIME);
+        } else {
+            r = pinfo->r;
+            d = pinfo->d;
+            ci = I;
+            pr0 = r0;
+        }
+
+        if (rsa->flags & RSA_FLAG_CACHE_PRIVATE) {
+            if (!BN_MONT_CTX_set_locked(&pinfo->m, rsa->lock, r, ctx))
+                goto err;
+        }
+
+        /* compute (I mod r_i)^d_i mod r_i */
+        if (!BN_mod(r1, ci, pinfo->r, ctx))
+            goto err;
+        if (!rsa->meth->bn_mod_exp(m1, r1, d, pinfo->r, ctx, pinfo->m))
+            goto err;
+
+        /* compute ((m_i - r0) * t_i) mod r_i */
+        if (!BN_mod(r1, pr0, pinfo->r, ctx))
+            goto err;
+        if (!BN_sub(m1, m1, r1))
+            goto err;
+        if (BN_is_negative(m1))
+            if (!BN_add(m1, m1, pinfo->r))
+                goto err;
+        if (!BN_mul(r1, m1, pinfo->t, ctx))
+            goto err;
+        if (!(rsa->flags & RSA_FLAG_NO_CONSTTIME)) {
+            pr1 = &local_r1;
+            BN_with_flags(pr1, r1, BN_FLG_CONSTTIME);
+        } else
+            pr1 = r1;
+        if (!BN_mod(m1, pr1, pinfo->r, ctx))
+            goto err;
+
+        /* and add that many times the product of the earlier primes */
+        if (!BN_mul(r1, m1, pinfo->pp, ctx))
+            goto err;
+        if (!BN_add(r0, r0, r1))
+            goto err;
+    }
+
     if (rsa->e && rsa->n) {
         if (!rsa->meth->bn_mod_exp(vrfy, r0, rsa->e, rsa->n, ctx, rsa->_method_mod_n))
             goto err;
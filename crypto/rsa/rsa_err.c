@@ -38,6 +38,7 @@ static ERR_STRING_DATA RSA_str_functs[] = {
     { ERR_FUNC(RSA_F_RSA_EAY_PUBLIC_ENCRYPT), "RSA_EAY_PUBLIC_ENCRYPT" },
     { ERR_FUNC(RSA_F_RSA_GENERATE_KEY), "RSA_GENERATE_KEY" },
     { ERR_FUNC(RSA_F_RSA_GENERATE_KEY_EX), "RSA_GENERATE_KEY_EX" },
+    { ERR_FUNC(RSA_F_RSA_GENERATE_MULTI_PRIME_KEY), "RSA_GENERATE_MULTI_PRIME_KEY" },
     { ERR_FUNC(RSA_F_RSA_ITEM_VERIFY), "RSA_ITEM_VERIFY" },
     { ERR_FUNC(RSA_F_RSA_MEMORY_LOCK), "RSA_MEMORY_LOCK" },
     { ERR_FUNC(RSA_F_RSA_MGF1_TO_MD), "RSA_MGF1_TO_MD" },
@@ -135,11 +136,16 @@ static ERR_STRING_DATA RSA_str_reasons[] = {
     { ERR_REASON(RSA_R_INVALID_TRAILER), "invalid trailer" },
     { ERR_REASON(RSA_R_INVALID_X931_DIGEST), "invalid x931 digest" },
     { ERR_REASON(RSA_R_IQMP_NOT_INVERSE_OF_Q), "iqmp not inverse of q" },
+    { ERR_REASON(RSA_R_KEY_PRIME_NUM_INVALID), "key prime num invalid" },
     { ERR_REASON(RSA_R_KEY_SIZE_TOO_SMALL), "key size too small" },
     { ERR_REASON(RSA_R_LAST_OCTET_INVALID), "last octet invalid" },
     { ERR_REASON(RSA_R_MODULUS_TOO_LARGE), "modulus too large" },
+    { ERR_REASON(RSA_R_MP_COEFFICIENT_NOT_INVERSE_OF_R), "mp coefficient not inverse of r" },
+    { ERR_REASON(RSA_R_MP_EXPONENT_NOT_CONGRUENT_TO_D), "mp exponent not congruent to d" },
+    { ERR_REASON(RSA_R_MP_R_NOT_PRIME), "mp r not prime" },
     { ERR_REASON(RSA_R_NO_PUBLIC_EXPONENT), "no public exponent" },
     { ERR_REASON(RSA_R_NULL_BEFORE_BLOCK_MISSING), "null before block missing" },
+    { ERR_REASON(RSA_R_N_DOES_NOT_EQUAL_PRODUCT_OF_PRIMES), "n does not equal product of primes" },
     { ERR_REASON(RSA_R_N_DOES_NOT_EQUAL_P_Q), "n does not equal p q" },
     { ERR_REASON(RSA_R_OAEP_DECODING_ERROR), "oaep decoding error" },
     { ERR_REASON(RSA_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE),
@@ -19,7 +19,10 @@
 #include <openssl/err.h>
 #include <openssl/rsa.h>
 
-static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb);
+#include "rsa_locl.h"
+
+static int rsa_builtin_keygen(RSA *rsa, int bits, int primes, BIGNUM *e_value,
+                              BN_GENCB *cb);
 
 /* NB: this wrapper would normally be placed in rsa_lib.c and the static
  * implementation would probably be in rsa_eay.c. Nonetheless, is kept here so
@@ -30,17 +33,52 @@ int RSA_generate_key_ex(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
 {
     if (rsa->meth->rsa_keygen)
         return rsa->meth->rsa_keygen(rsa, bits, e_value, cb);
-    return rsa_builtin_keygen(rsa, bits, e_value, cb);
+    return rsa_builtin_keygen(rsa, bits, 2, e_value, cb);
+}
+
+int RSA_generate_multi_prime_key(RSA *rsa, int bits, int primes,
+                                 BIGNUM *e_value, BN_GENCB *cb)
+{
+    if (primes < 2 || primes > rsa_multip_cap(bits)) {
+        RSAerr(RSA_F_RSA_GENERATE_MULTI_PRIME_KEY, RSA_R_KEY_PRIME_NUM_INVALID);
+        return 0;
+    }
+    /* A method's own key generation only knows about two primes */
+    if (primes == 2)
+        return RSA_generate_key_ex(rsa, bits, e_value, cb);
+    return rsa_builtin_keygen(rsa, bits, primes, e_value, cb);
+}
+
+/* rsa_keygen_prime returns the |i|th prime of |rsa|, counting p and q first. */
+static BIGNUM *rsa_keygen_prime(RSA *rsa, int i)
+{
+    if (i == 0)
+        return rsa->p;
+    if (i == 1)
+        return rsa->q;
+    return sk_RSA_PRIME_INFO_value(rsa->prime_infos, i - 2)->r;
 }
 
-static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
+static int rsa_builtin_keygen(RSA *rsa, int bits, int primes, BIGNUM *e_value,
+                              BN_GENCB *cb)
 {
-    BIGNUM *r0 = NULL, *r1 = NULL, *r2 = NULL, *r3 = NULL, *tmp;
+    BIGNUM *r0 = NULL, *r1 = NULL, *r2 = NULL, *r3 = NULL, *tmp, *prime;
     BIGNUM local_r0, local_d, local_p;
     BIGNUM *pr0, *d, *p;
-    int bitsp, bitsq, ok = -1, n = 0;
+    BIGNUM *prod;
+    STACK_OF(RSA_PRIME_INFO) *prime_infos = NULL;
+    RSA_PRIME_INFO *pinfo;
+    int bitsr[RSA_MAX_PRIME_NUM], bitse;
+    int i, j, retries = 0, ok = -1, n = 0;
+    unsigned int degenerate;
     BN_CTX *ctx = NULL;
 
+    if (primes < 2 || primes > RSA_MAX_PRIME_NUM) {
+        ok = 0;
+        RSAerr(RSA_F_RSA_BUILTIN_KEYGEN, RSA_R_KEY_PRIME_NUM_INVALID);
+        goto err;
+    }
+
     ctx = BN_CTX_new();
     if (ctx == NULL)
         goto err;
@@ -49,11 +87,25 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
     r1 = BN_CTX_get(ctx);
     r2 = BN_CTX_get(ctx);
     r3 = BN_CTX_get(ctx);
-    if (r3 == NULL)
+    prod = BN_CTX_get(ctx);
+    if (prod == NULL)
         goto err;
 
-    bitsp = (bits + 1) / 2;
-    bitsq = bits - bitsp;
+    /* Share the bits out between the primes, the first ones taking any
+     * remainder, so that p is the longer for two primes */
+    for (i = 0; i < primes; i++)
+        bitsr[i] = bits / primes + (i < bits % primes);
+
+    /*
+     * Montgomery multiplication has its fastest code for moduli of a multiple
+     * of 256 bits, so a multi-prime key's primes are rounded to that where
+     * none then falls more than 128 bits short of an even share.
+     */
+    if (primes > 2 && bits % 256 == 0 &&
+        256 * (bits / 256 / primes) >= bits / primes - 128) {
+        for (i = 0; i < primes; i++)
+            bitsr[i] = 256 * (bits / 256 / primes + (i < bits / 256 % primes));
+    }
 
     /* We need the RSA components non-NULL */
     if (!rsa->n && ((rsa->n = BN_new()) == NULL))
@@ -73,48 +125,94 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
     if (!rsa->iqmp && ((rsa->iqmp = BN_new()) == NULL))
         goto err;
 
-    BN_copy(rsa->e, e_value);
-
-    /* generate p and q */
-    for (;;) {
-        if (!BN_generate_prime_ex(rsa->p, bitsp, 0, NULL, NULL, cb))
-            goto err;
-        if (!BN_sub(r2, rsa->p, BN_value_one()))
-            goto err;
-        if (!BN_gcd(r1, r2, rsa->e, ctx))
-            goto err;
-        if (BN_is_one(r1))
-            break;
-        if (!BN_GENCB_call(cb, 2, n++))
+    /* and the further primes of a multi-prime key */
+    if (primes > 2) {
+        if ((prime_infos = sk_RSA_PRIME_INFO_new_null()) == NULL)
             goto err;
+        for (i = 2; i < primes; i++) {
+            if ((pinfo = rsa_multip_info_new()) == NULL)
+                goto err;
+            if (!sk_RSA_PRIME_INFO_push(prime_infos, pinfo)) {
+                rsa_multip_info_free(pinfo);
+                goto err;
+            }
+        }
     }
-    if (!BN_GENCB_call(cb, 3, 0))
-        goto err;
-    for (;;) {
-        /* When generating ridiculously small keys, we can get stuck
-         * continually regenerating the same prime values. Check for
-         * this and bail if it happens 3 times. */
-        unsigned int degenerate = 0;
-        do {
-            if (!BN_generate_prime_ex(rsa->q, bitsq, 0, NULL, NULL, cb))
+    sk_RSA_PRIME_INFO_pop_free(rsa->prime_infos, rsa_multip_info_free);
+    rsa->prime_infos = prime_infos;
+    prime_infos = NULL;
+    rsa->version = primes > 2 ? RSA_ASN1_VERSION_MULTI
+                              : RSA_ASN1_VERSION_DEFAULT;
+
+    BN_copy(rsa->e, e_value);
+
+    /* generate the primes, keeping their product in prod */
+    bitse = 0;
+    for (i = 0; i < primes; i++) {
+        prime = rsa_keygen_prime(rsa, i);
+        bitse += bitsr[i];
+ redo:
+        for (;;) {
+            /* When generating ridiculously small keys, we can get stuck
+             * continually regenerating the same prime values. Check for
+             * this and bail if it happens 3 times. */
+            degenerate = 0;
+            do {
+                if (!BN_generate_prime_ex(prime, bitsr[i], 0, NULL, NULL, cb))
+                    goto err;
+                for (j = 0; j < i; j++) {
+                    if (BN_cmp(prime, rsa_keygen_prime(rsa, j)) == 0)
+                        break;
+                }
+            } while (j < i && ++degenerate < 3);
+            if (degenerate == 3) {
+                ok = 0; /* we set our own err */
+                RSAerr(RSA_F_RSA_BUILTIN_KEYGEN, RSA_R_KEY_SIZE_TOO_SMALL);
+                goto err;
+            }
+            if (!BN_sub(r2, prime, BN_value_one()))
+                goto err;
+            if (!BN_gcd(r1, r2, rsa->e, ctx))
+                goto err;
+            if (BN_is_one(r1))
+                break;
+            if (!BN_GENCB_call(cb, 2, n++))
                 goto err;
-        } while ((BN_cmp(rsa->p, rsa->q) == 0) && (++degenerate < 3));
-        if (degenerate == 3) {
-            ok = 0; /* we set our own err */
-            RSAerr(RSA_F_RSA_BUILTIN_KEYGEN, RSA_R_KEY_SIZE_TOO_SMALL);
-            goto err;
         }
-        if (!BN_sub(r2, rsa->q, BN_value_one()))
-            goto err;
-        if (!BN_gcd(r1, r2, rsa->e, ctx))
-            goto err;
-        if (BN_is_one(r1))
-            break;
-        if (!BN_GENCB_call(cb, 2, n++))
+
+        if (i == 0) {
+            if (!BN_copy(prod, prime))
+                goto err;
+        } else {
+            if (!BN_mul(r1, prod, prime, ctx))
+                goto err;
+            /*
+             * Each prime has its top two bits set, which keeps the product of
+             * two at exactly the bits asked for. With more, a product that
+             * falls under 9/16 of its largest value might not reach them, so
+             * the prime is replaced, and after a few tries all of them are.
+             */
+            if (primes > 2) {
+                if (!BN_rshift(r2, r1, bitse - 4))
+                    goto err;
+                if (BN_get_word(r2) < 9) {
+                    if (!BN_GENCB_call(cb, 2, n++))
+                        goto err;
+                    if (++retries < 4)
+                        goto redo;
+                    retries = 0;
+                    bitse = 0;
+                    i = -1;
+                    continue;
+                }
+            }
+            retries = 0;
+            if (!BN_copy(prod, r1))
+                goto err;
+        }
+        if (!BN_GENCB_call(cb, 3, i))
             goto err;
     }
-    if (!BN_GENCB_call(cb, 3, 1))
-        goto err;
     if (BN_cmp(rsa->p, rsa->q) < 0) {
         tmp = rsa->p;
         rsa->p = rsa->q;
@@ -122,7 +220,7 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
     }
 
     /* calculate n */
-    if (!BN_mul(rsa->n, rsa->p, rsa->q, ctx))
+    if (!BN_copy(rsa->n, prod))
         goto err;
 
     /* calculate d */
@@ -132,6 +230,12 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
         goto err; /* q-1 */
     if (!BN_mul(r0, r1, r2, ctx))
         goto err; /* (p-1)(q-1) */
+    for (i = 2; i < primes; i++) {
+        if (!BN_sub(r3, rsa_keygen_prime(rsa, i), BN_value_one()))
+            goto err;
+        if (!BN_mul(r0, r0, r3, ctx))
+            goto err; /* (p-1)(q-1)...(r_i-1) */
+    }
     if (!(rsa->flags & RSA_FLAG_NO_CONSTTIME)) {
         pr0 = &local_r0;
         BN_with_flags(pr0, r0, BN_FLG_CONSTTIME);
@@ -155,6 +259,15 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
     if (!BN_mod(rsa->dmq1, d, r2, ctx))
         goto err;
 
+    /* calculate d mod (r_i-1) for the further primes */
+    for (i = 2; i < primes; i++) {
+        pinfo = sk_RSA_PRIME_INFO_value(rsa->prime_infos, i - 2);
+        if (!BN_sub(r3, pinfo->r, BN_value_one()))
+            goto err;
+        if (!BN_mod(pinfo->d, d, r3, ctx))
+            goto err;
+    }
+
     /* calculate inverse of q mod p */
     if (!(rsa->flags & RSA_FLAG_NO_CONSTTIME)) {
         p = &local_p;
@@ -164,12 +277,27 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
     if (!BN_mod_inverse(rsa->iqmp, rsa->q, p, ctx))
         goto err;
 
+    /* calculate the inverse of the product of the earlier primes mod r_i */
+    if (primes > 2 && !rsa_multip_calc_product(rsa))
+        goto err;
+    for (i = 2; i < primes; i++) {
+        pinfo = sk_RSA_PRIME_INFO_value(rsa->prime_infos, i - 2);
+        if (!(rsa->flags & RSA_FLAG_NO_CONSTTIME)) {
+            p = &local_p;
+            BN_with_flags(p, pinfo->r, BN_FLG_CONSTTIME);
+        } else
+            p = pinfo->r;
+        if (!BN_mod_inverse(pinfo->t, pinfo->pp, p, ctx))
+            goto err;
+    }
+
     ok = 1;
 err:
     if (ok == -1) {
         RSAerr(RSA_F_RSA_BUILTIN_KEYGEN, ERR_LIB_BN);
         ok = 0;
     }
+    sk_RSA_PRIME_INFO_pop_free(prime_infos, rsa_multip_info_free);
     BN_CTX_end(ctx);
     BN_CTX_free(ctx);
 
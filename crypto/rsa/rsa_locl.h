@@ -1,4 +1,34 @@
+#include <openssl/bn.h>
+#include <openssl/rsa.h>
+
+struct rsa_prime_info_st {
+    /* The prime, its CRT exponent d mod (r - 1) and its CRT coefficient */
+    BIGNUM *r;
+    BIGNUM *d;
+    BIGNUM *t;
+    /* The product of the primes before this one, which t is the inverse of */
+    BIGNUM *pp;
+    /* Cached Montgomery context for r */
+    BN_MONT_CTX *m;
+};
+
 extern int int_rsa_verify(int dtype, const uint8_t *m, unsigned int m_len,
                           uint8_t *rm, size_t *prm_len,
                           const uint8_t *sigbuf, size_t siglen,
                           RSA *rsa);
+
+RSA_PRIME_INFO *rsa_multip_info_new(void);
+void rsa_multip_info_free(RSA_PRIME_INFO *pinfo);
+/* rsa_multip_info_free_ex frees the members of |pinfo| that are not part of
+ * its ASN.1 encoding. */
+void rsa_multip_info_free_ex(RSA_PRIME_INFO *pinfo);
+
+/*
+ * rsa_multip_calc_product sets the pp member of each of |rsa|'s extra primes,
+ * which is needed after decoding a key. It returns one on success and zero on
+ * error.
+ */
+int rsa_multip_calc_product(RSA *rsa);
+
+/* rsa_multip_cap returns the most primes a key of |bits| bits may have. */
+int rsa_multip_cap(int bits);
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdlib.h>
+
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+
+#include "rsa_locl.h"
+
+void rsa_multip_info_free_ex(RSA_PRIME_INFO *pinfo)
+{
+    BN_clear_free(pinfo->pp);
+    pinfo->pp = NULL;
+    BN_MONT_CTX_free(pinfo->m);
+    pinfo->m = NULL;
+}
+
+void rsa_multip_info_free(RSA_PRIME_INFO *pinfo)
+{
+    if (pinfo == NULL)
+        return;
+    BN_clear_free(pinfo->r);
+    BN_clear_free(pinfo->d);
+    BN_clear_free(pinfo->t);
+    rsa_multip_info_free_ex(pinfo);
+    free(pinfo);
+}
+
+RSA_PRIME_INFO *rsa_multip_info_new(void)
+{
+    RSA_PRIME_INFO *pinfo;
+
+    if ((pinfo = calloc(1, sizeof(*pinfo))) == NULL) {
+        RSAerr(RSA_F_RSA_GENERATE_MULTI_PRIME_KEY, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((pinfo->r = BN_new()) == NULL || (pinfo->d = BN_new()) == NULL ||
+        (pinfo->t = BN_new()) == NULL || (pinfo->pp = BN_new()) == NULL) {
+        RSAerr(RSA_F_RSA_GENERATE_MULTI_PRIME_KEY, ERR_R_MALLOC_FAILURE);
+        rsa_multip_info_free(pinfo);
+        return NULL;
+    }
+    return pinfo;
+}
+
+int rsa_multip_calc_product(RSA *rsa)
+{
+    RSA_PRIME_INFO *pinfo;
+    BIGNUM *p1, *p2;
+    BN_CTX *ctx;
+    int i, rv = 0, ex_primes;
+
+    ex_primes = sk_RSA_PRIME_INFO_num(rsa->prime_infos);
+    if (ex_primes <= 0 || ex_primes > RSA_MAX_PRIME_NUM - 2)
+        return 0;
+    if (rsa->p == NULL || rsa->q == NULL)
+        return 0;
+
+    if ((ctx = BN_CTX_new()) == NULL)
+        return 0;
+
+    /* The product of p and q is the first running product */
+    p1 = rsa->p;
+    p2 = rsa->q;
+    for (i = 0; i < ex_primes; i++) {
+        pinfo = sk_RSA_PRIME_INFO_value(rsa->prime_infos, i);
+        if (pinfo->r == NULL)
+            goto err;
+        if (pinfo->pp == NULL && (pinfo->pp = BN_new()) == NULL)
+            goto err;
+        if (!BN_mul(pinfo->pp, p1, p2, ctx))
+            goto err;
+        /* The next product is this one times this prime */
+        p1 = pinfo->pp;
+        p2 = pinfo->r;
+    }
+    rv = 1;
+
+err:
+    BN_CTX_free(ctx);
+    return rv;
+}
+
+int rsa_multip_cap(int bits)
+{
+    int cap = RSA_MAX_PRIME_NUM;
+
+    if (bits < 1024)
+        cap = 2;
+    else if (bits < 4096)
+        cap = 3;
+    else if (bits < 8192)
+        cap = 4;
+
+    if (cap > RSA_MAX_PRIME_NUM)
+        cap = RSA_MAX_PRIME_NUM;
+
+    return cap;
+}
@@ -27,6 +27,7 @@ typedef struct {
     /* Key gen parameters */
     int nbits;
     BIGNUM *pub_exp;
+    int primes;
     /* Keygen callback info */
     int gentmp[2];
     /* RSA padding mode */
@@ -51,6 +52,7 @@ static int pkey_rsa_init(EVP_PKEY_CTX *ctx)
     if (rctx == NULL)
         return 0;
     rctx->nbits = 1024;
+    rctx->primes = 2;
     rctx->pad_mode = RSA_PKCS1_PADDING;
 
     rctx->saltlen = -2;
@@ -72,6 +74,7 @@ static int pkey_rsa_copy(EVP_PKEY_CTX *dst, EVP_PKEY_CTX *src)
     sctx = src->data;
     dctx = dst->data;
     dctx->nbits = sctx->nbits;
+    dctx->primes = sctx->primes;
     if (sctx->pub_exp) {
         dctx->pub_exp = BN_dup(sctx->pub_exp);
         if (!dctx->pub_exp)
@@ -406,6 +409,14 @@ static int pkey_rsa_ctrl(EVP_PKEY_CTX *ctx, int type, int p1, void *p2)
             BN_free(rctx->pub_exp);
             rctx->pub_exp = p2;
             return 1;
+
+        case EVP_PKEY_CTRL_RSA_KEYGEN_PRIMES:
+            if (p1 < 2 || p1 > RSA_MAX_PRIME_NUM) {
+                RSAerr(RSA_F_PKEY_RSA_CTRL, RSA_R_KEY_PRIME_NUM_INVALID);
+                return -2;
+            }
+            rctx->primes = p1;
+            return 1;
             
         case EVP_PKEY_CTRL_RSA_OAEP_MD:
         case EVP_PKEY_CTRL_GET_RSA_OAEP_MD:
@@ -542,6 +553,20 @@ static int pkey_rsa_ctrl_str(EVP_PKEY_CTX *ctx, const char *type, const char *va
         return EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, nbits);
     }
 
+    if (strcmp(type, "rsa_keygen_primes") == 0) {
+        int primes;
+
+        errno = 0;
+        lval = strtol(value, &ep, 10);
+        if (value[0] == '\0' || *ep != '\0')
+            goto invalid_number;
+        if ((errno == ERANGE && (lval == LONG_MAX || lval == LONG_MIN)) ||
+            (lval > INT_MAX || lval < INT_MIN))
+            goto out_of_range;
+        primes = lval;
+        return EVP_PKEY_CTX_set_rsa_keygen_primes(ctx, primes);
+    }
+
     if (strcmp(type, "rsa_keygen_pubexp") == 0) {
         int ret;
         BIGNUM *pubexp = NULL;
@@ -609,7 +634,8 @@ static int pkey_rsa_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
         evp_pkey_set_cb_translate(pcb, ctx);
     } else
         pcb = NULL;
-    ret = RSA_generate_key_ex(rsa, rctx->nbits, rctx->pub_exp, pcb);
+    ret = RSA_generate_multi_prime_key(rsa, rctx->nbits, rctx->primes,
+                                       rctx->pub_exp, pcb);
     if (ret > 0)
         EVP_PKEY_assign_RSA(pkey, rsa);
     else
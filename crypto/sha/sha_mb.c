@@ -0,0 +1,240 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Multi-buffer SHA-1 and SHA-256. Independent messages are hashed side by
+ * side in the lanes of the sha1-mb/sha256-mb kernels, four per call with
+ * SSSE3/AVX and eight with AVX2. A call costs as much as its longest lane,
+ * so messages are sorted by length and hashed in groups of similar size.
+ * The kernels stop at the first group of lanes that has no blocks left, so
+ * the lanes are filled longest first.
+ */
+
+#include <openssl/opensslconf.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include <stdcompat.h>
+
+#if !defined(OPENSSL_NO_ASM) && defined(VIGORTLS_X86_64)
+#define SHA_MB_ASM
+#endif
+
+#ifdef SHA_MB_ASM
+
+extern unsigned int OPENSSL_ia32cap_P[];
+
+#define SHA_MB_LANES 8
+
+/* Largest number of blocks passed to the kernel per lane and call */
+#define SHA_MB_MAX_BLOCKS (1 << 24)
+
+/* Chaining values, word-sliced: h[i][lane] is word i of a lane's state */
+typedef struct {
+    uint32_t h[8][SHA_MB_LANES];
+} SHA_MB_CTX;
+
+typedef struct {
+    const uint8_t *ptr;
+    int blocks;
+} HASH_DESC;
+
+void sha1_multi_block(SHA_MB_CTX *, const HASH_DESC *, int);
+void sha256_multi_block(SHA_MB_CTX *, const HASH_DESC *, int);
+
+typedef struct {
+    size_t md_len;
+    const uint32_t *iv;
+    void (*multi_block)(SHA_MB_CTX *, const HASH_DESC *, int);
+} SHA_MB_METHOD;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t idx;
+} SHA_MB_MSG;
+
+static const uint32_t sha1_iv[5] = {
+    0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL, 0xc3d2e1f0UL,
+};
+
+static const uint32_t sha256_iv[8] = {
+    0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+    0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL,
+};
+
+static const SHA_MB_METHOD sha1_mb_method = {
+    SHA_DIGEST_LENGTH, sha1_iv, sha1_multi_block,
+};
+
+static const SHA_MB_METHOD sha256_mb_method = {
+    SHA256_DIGEST_LENGTH, sha256_iv, sha256_multi_block,
+};
+
+static int sha_mb_capable(void)
+{
+    return (OPENSSL_ia32cap_P[1] & (1 << (41 - 32))) != 0; /* SSSE3 */
+}
+
+static int sha_mb_msg_cmp(const void *a_, const void *b_)
+{
+    const SHA_MB_MSG *a = a_, *b = b_;
+
+    if (a->len != b->len)
+        return a->len > b->len ? -1 : 1;
+    return 0;
+}
+
+/*
+ * sha_mb_hash_lanes hashes the |n| (at most SHA_MB_LANES) messages in
+ * |msgs| in parallel and writes each digest to |out| at the message's
+ * index.
+ */
+static void sha_mb_hash_lanes(const SHA_MB_METHOD *meth, const SHA_MB_MSG *msgs,
+                              size_t n, uint8_t *out)
+{
+    uint8_t storage[sizeof(SHA_MB_CTX) + 32];
+    uint8_t tail[SHA_MB_LANES][2 * SHA256_CBLOCK];
+    HASH_DESC desc[SHA_MB_LANES];
+    size_t blocks[SHA_MB_LANES];
+    size_t i, words = meth->md_len / 4;
+    int n4x = n > 4 ? 2 : 1, more;
+    SHA_MB_CTX *ctx;
+
+    ctx = (SHA_MB_CTX *)(storage + 32 - ((size_t)storage % 32)); /* align */
+
+    for (i = 0; i < SHA_MB_LANES; i++) {
+        size_t w;
+
+        if (i >= n) {
+            desc[i].ptr = tail[0];
+            desc[i].blocks = 0;
+            blocks[i] = 0;
+            continue;
+        }
+        for (w = 0; w < words; w++)
+            ctx->h[w][i] = meth->iv[w];
+        desc[i].ptr = msgs[i].data;
+        blocks[i] = msgs[i].len / SHA256_CBLOCK;
+    }
+
+    /* Whole blocks, in bounded steps since the kernel counts in an int */
+    do {
+        more = 0;
+        for (i = 0; i < n; i++) {
+            desc[i].blocks = (int)(blocks[i] < SHA_MB_MAX_BLOCKS ?
+                                   blocks[i] : SHA_MB_MAX_BLOCKS);
+            more |= desc[i].blocks != 0;
+        }
+        if (!more)
+            break;
+        meth->multi_block(ctx, desc, n4x);
+        for (i = 0; i < n; i++) {
+            desc[i].ptr += (size_t)desc[i].blocks * SHA256_CBLOCK;
+            blocks[i] -= desc[i].blocks;
+        }
+    } while (1);
+
+    /* Padding: one or two final blocks per lane */
+    for (i = 0; i < n; i++) {
+        size_t rem = msgs[i].len % SHA256_CBLOCK, last;
+        uint64_t bits = (uint64_t)msgs[i].len << 3;
+        int j;
+
+        memset(tail[i], 0, sizeof(tail[i]));
+        memcpy(tail[i], desc[i].ptr, rem);
+        tail[i][rem] = 0x80;
+        desc[i].blocks = rem < SHA256_CBLOCK - 8 ? 1 : 2;
+        last = (size_t)desc[i].blocks * SHA256_CBLOCK;
+        for (j = 1; j <= 8; j++, bits >>= 8)
+            tail[i][last - j] = (uint8_t)bits;
+        desc[i].ptr = tail[i];
+    }
+    meth->multi_block(ctx, desc, n4x);
+
+    for (i = 0; i < n; i++) {
+        uint8_t *md = out + msgs[i].idx * meth->md_len;
+        size_t w;
+
+        for (w = 0; w < words; w++) {
+            uint32_t v = ctx->h[w][i];
+
+            md[4 * w + 0] = (uint8_t)(v >> 24);
+            md[4 * w + 1] = (uint8_t)(v >> 16);
+            md[4 * w + 2] = (uint8_t)(v >> 8);
+            md[4 * w + 3] = (uint8_t)v;
+        }
+    }
+
+    vigortls_zeroize(tail, sizeof(tail));
+    vigortls_zeroize(storage, sizeof(storage));
+}
+
+/*
+ * sha_mb hashes the messages in groups of up to SHA_MB_LANES of similar
+ * length and returns one, or returns zero if the multi-buffer code cannot
+ * be used, in which case nothing has been written.
+ */
+static int sha_mb(const SHA_MB_METHOD *meth, size_t num,
+                  const uint8_t *const *data, const size_t *lens, uint8_t *out)
+{
+    SHA_MB_MSG *msgs;
+    size_t i, n;
+
+    if (num < 2 || !sha_mb_capable())
+        return 0;
+
+    if ((msgs = reallocarray(NULL, num, sizeof(*msgs))) == NULL)
+        return 0;
+    for (i = 0; i < num; i++) {
+        msgs[i].data = data[i];
+        msgs[i].len = lens[i];
+        msgs[i].idx = i;
+    }
+    qsort(msgs, num, sizeof(*msgs), sha_mb_msg_cmp);
+
+    for (i = 0; i < num; i += n) {
+        n = num - i < SHA_MB_LANES ? num - i : SHA_MB_LANES;
+        sha_mb_hash_lanes(meth, msgs + i, n, out);
+    }
+
+    free(msgs);
+    return 1;
+}
+
+#endif /* SHA_MB_ASM */
+
+void SHA1_multi(size_t num, const uint8_t *const *data, const size_t *lens,
+                uint8_t *out)
+{
+    size_t i;
+
+#ifdef SHA_MB_ASM
+    if (sha_mb(&sha1_mb_method, num, data, lens, out))
+        return;
+#endif
+    for (i = 0; i < num; i++)
+        SHA1(data[i], lens[i], out + i * SHA_DIGEST_LENGTH);
+}
+
+void SHA256_multi(size_t num, const uint8_t *const *data, const size_t *lens,
+                  uint8_t *out)
+{
+    size_t i;
+
+#ifdef SHA_MB_ASM
+    if (sha_mb(&sha256_mb_method, num, data, lens, out))
+        return;
+#endif
+    for (i = 0; i < num; i++)
+        SHA256(data[i], lens[i], out + i * SHA256_DIGEST_LENGTH);
+}
@@ -18,6 +18,77 @@
 #undef MIN_NODES
 #define MIN_NODES 4
 
+/*
+ * A stack with a hash function keeps an open-addressed index from hashes to
+ * positions, at most half full, so sk_find neither sorts the stack nor
+ * searches it and returns the first match in the current order. Pushes add
+ * to the index and other changes to the positions rebuild it. If the index
+ * cannot be allocated, sk_find falls back to searching.
+ */
+static size_t sk_index_slot(const _STACK *st, const void *data)
+{
+    uint32_t h = (uint32_t)st->hash(data) * 0x9e3779b1U;
+
+    return (h ^ (h >> 15)) & st->index_mask;
+}
+
+static void sk_index_add(_STACK *st, int loc)
+{
+    size_t i;
+
+    if (st->data[loc] == NULL)
+        return;
+    for (i = sk_index_slot(st, st->data[loc]); st->index[i] != 0;
+         i = (i + 1) & st->index_mask)
+        ;
+    st->index[i] = loc + 1;
+}
+
+static void sk_index_build(_STACK *st)
+{
+    size_t size = 16;
+    int i;
+
+    free(st->index);
+    st->index = NULL;
+    st->index_mask = 0;
+    if (st->hash == NULL)
+        return;
+
+    while (size < 2 * (size_t)st->num_alloc)
+        size <<= 1;
+    if ((st->index = calloc(size, sizeof(*st->index))) == NULL)
+        return;
+    st->index_mask = size - 1;
+    for (i = 0; i < st->num; i++)
+        sk_index_add(st, i);
+}
+
+static int sk_index_find(_STACK *st, void *data)
+{
+    size_t i;
+    int loc, ret = -1;
+
+    for (i = sk_index_slot(st, data); st->index[i] != 0;
+         i = (i + 1) & st->index_mask) {
+        loc = st->index[i] - 1;
+        if (ret >= 0 && loc > ret)
+            continue;
+        if (st->comp != NULL ? st->comp(&data, &st->data[loc]) == 0
+                             : st->data[loc] == data)
+            ret = loc;
+    }
+    return ret;
+}
+
+int sk_set_hash_func(_STACK *sk, unsigned long (*hash)(const void *))
+{
+    sk->hash = hash;
+    sk_index_build(sk);
+
+    return hash == NULL || sk->index != NULL;
+}
+
 int (*sk_set_cmp_func(_STACK *sk, int (*c)(const void *, const void *)))(const void *, const void *)
 {
     int (*old)(const void *, const void *) = sk->comp;
@@ -46,6 +117,8 @@ _STACK *sk_dup(_STACK *sk)
     ret->sorted = sk->sorted;
     ret->num_alloc = sk->num_alloc;
     ret->comp = sk->comp;
+    ret->hash = sk->hash;
+    sk_index_build(ret);
     return (ret);
 err:
     if (ret)
@@ -66,6 +139,9 @@ _STACK *sk_deep_copy(_STACK *sk, void *(*copy_func)(void *),
     ret->sorted = sk->sorted;
     ret->num = sk->num;
     ret->num_alloc = sk->num > MIN_NODES ? sk->num : MIN_NODES;
+    ret->hash = NULL;
+    ret->index = NULL;
+    ret->index_mask = 0;
     ret->data = reallocarray(NULL, ret->num_alloc, sizeof(char *));
     if (ret->data == NULL) {
         free(ret);
@@ -85,6 +161,8 @@ _STACK *sk_deep_copy(_STACK *sk, void *(*copy_func)(void *),
             return NULL;
         }
     }
+    ret->hash = sk->hash;
+    sk_index_build(ret);
     return ret;
 }
 
@@ -108,6 +186,9 @@ _STACK *sk_new(int (*c)(const void *, const void *))
     ret->num_alloc = MIN_NODES;
     ret->num = 0;
     ret->sorted = 0;
+    ret->hash = NULL;
+    ret->index = NULL;
+    ret->index_mask = 0;
     return (ret);
 err:
     free(ret);
@@ -117,6 +198,7 @@ err:
 int sk_insert(_STACK *st, void *data, int loc)
 {
     char **s;
+    int append, grown = 0, sorted = 0;
 
     if (st == NULL)
         return 0;
@@ -126,8 +208,13 @@ int sk_insert(_STACK *st, void *data, int loc)
             return (0);
         st->data = s;
         st->num_alloc *= 2;
+        grown = 1;
     }
-    if ((loc >= (int)st->num) || (loc < 0))
+    append = loc >= (int)st->num || loc < 0;
+    /* Appending in order, as when loading sorted data, keeps the stack sorted */
+    if (append && st->sorted && st->comp != NULL)
+        sorted = st->num == 0 || st->comp(&st->data[st->num - 1], &data) <= 0;
+    if (append)
         st->data[st->num] = data;
     else {
         memmove(&(st->data[loc + 1]), &(st->data[loc]),
@@ -135,7 +222,13 @@ int sk_insert(_STACK *st, void *data, int loc)
         st->data[loc] = data;
     }
     st->num++;
-    st->sorted = 0;
+    st->sorted = sorted;
+    if (st->hash != NULL) {
+        if (append && !grown && st->index != NULL)
+            sk_index_add(st, st->num - 1);
+        else
+            sk_index_build(st);
+    }
     return (st->num);
 }
 
@@ -165,6 +258,8 @@ void *sk_delete(_STACK *st, int loc)
                 sizeof(char *)*(st->num - 1 - loc));
     }
     st->num--;
+    if (st->hash != NULL)
+        sk_index_build(st);
     return (ret);
 }
 
@@ -176,6 +271,10 @@ static int internal_find(_STACK *st, void *data, int ret_val_options)
     if (st == NULL)
         return -1;
 
+    if (st->index != NULL && data != NULL &&
+        ret_val_options == OBJ_BSEARCH_FIRST_VALUE_ON_MATCH)
+        return sk_index_find(st, data);
+
     if (st->comp == NULL) {
         for (i = 0; i < st->num; i++)
             if (st->data[i] == data)
@@ -237,6 +336,8 @@ void sk_zero(_STACK *st)
         return;
     memset((char *)st->data, 0, sizeof(*st->data) * st->num);
     st->num = 0;
+    if (st->hash != NULL)
+        sk_index_build(st);
 }
 
 void sk_pop_free(_STACK *st, void (*func)(void *))
@@ -255,6 +356,7 @@ void sk_free(_STACK *st)
 {
     if (st == NULL)
         return;
+    free(st->index);
     free(st->data);
     free(st);
 }
@@ -277,7 +379,11 @@ void *sk_set(_STACK *st, int i, void *value)
 {
     if (!st || (i < 0) || (i >= st->num))
         return NULL;
-    return (st->data[i] = value);
+    st->data[i] = value;
+    st->sorted = 0;
+    if (st->hash != NULL)
+        sk_index_build(st);
+    return value;
 }
 
 void sk_sort(_STACK *st)
@@ -293,6 +399,8 @@ void sk_sort(_STACK *st)
         comp_func = (int (*)(const void *, const void *))(st->comp);
         qsort(st->data, st->num, sizeof(char *), comp_func);
         st->sorted = 1;
+        if (st->hash != NULL)
+            sk_index_build(st);
     }
 }
 
@@ -106,6 +106,17 @@ int CRYPTO_thread_cleanup_local(CRYPTO_THREAD_LOCAL *key)
     return 1;
 }
 
+int CRYPTO_thread_spawn(CRYPTO_THREAD *thread, void *(*start)(void *),
+                        void *arg)
+{
+    return 0;
+}
+
+int CRYPTO_thread_join(CRYPTO_THREAD thread)
+{
+    return 0;
+}
+
 CRYPTO_THREAD_ID CRYPTO_thread_get_current_id(void)
 {
     return 0;
@@ -123,3 +134,31 @@ int CRYPTO_atomic_add(int *val, int amount, int *ret, CRYPTO_MUTEX *lock)
 
     return 1;
 }
+
+int CRYPTO_atomic_add_unless(int *val, int amount, int unless, int *ret,
+                             CRYPTO_MUTEX *lock)
+{
+    if (*val == unless)
+        return 0;
+
+    *val += amount;
+    *ret  = *val;
+
+    return 1;
+}
+
+void *CRYPTO_atomic_get_ptr(void **ptr, CRYPTO_MUTEX *lock)
+{
+    return *ptr;
+}
+
+int CRYPTO_atomic_set_ptr(void **ptr, void *val, CRYPTO_MUTEX *lock)
+{
+    *ptr = val;
+
+    return 1;
+}
+
+void CRYPTO_atomic_fence(void)
+{
+}
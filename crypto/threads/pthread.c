@@ -102,6 +102,23 @@ int CRYPTO_thread_cleanup_local(CRYPTO_THREAD_LOCAL *key)
     return 1;
 }
 
+int CRYPTO_thread_spawn(CRYPTO_THREAD *thread, void *(*start)(void *),
+                        void *arg)
+{
+    if (pthread_create(thread, NULL, start, arg) != 0)
+        return 0;
+
+    return 1;
+}
+
+int CRYPTO_thread_join(CRYPTO_THREAD thread)
+{
+    if (pthread_join(thread, NULL) != 0)
+        return 0;
+
+    return 1;
+}
+
 CRYPTO_THREAD_ID CRYPTO_thread_get_current_id(void)
 {
     return pthread_self();
@@ -117,15 +134,90 @@ int CRYPTO_atomic_add(int *val, int amount, int *ret, CRYPTO_MUTEX *lock)
 #ifdef __ATOMIC_RELAXED
     *ret = __atomic_add_fetch(val, amount, __ATOMIC_RELAXED);
 #else
-    if (!CRYPTO_thread_write_lock(lock))
+    if (lock != NULL && !CRYPTO_thread_write_lock(lock))
         return 0;
 
     *val += amount;
     *ret  = *val;
 
-    if (!CRYPTO_thread_unlock(lock))
+    if (lock != NULL && !CRYPTO_thread_unlock(lock))
         return 0;
 #endif
 
     return 1;
 }
+
+int CRYPTO_atomic_add_unless(int *val, int amount, int unless, int *ret,
+                             CRYPTO_MUTEX *lock)
+{
+#ifdef __ATOMIC_RELAXED
+    int cur = __atomic_load_n(val, __ATOMIC_RELAXED);
+
+    do {
+        if (cur == unless)
+            return 0;
+    } while (!__atomic_compare_exchange_n(val, &cur, cur + amount, 0,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    *ret = cur + amount;
+#else
+    if (lock != NULL && !CRYPTO_thread_write_lock(lock))
+        return 0;
+
+    if (*val == unless) {
+        if (lock != NULL)
+            CRYPTO_thread_unlock(lock);
+        return 0;
+    }
+    *val += amount;
+    *ret  = *val;
+
+    if (lock != NULL && !CRYPTO_thread_unlock(lock))
+        return 0;
+#endif
+
+    return 1;
+}
+
+void *CRYPTO_atomic_get_ptr(void **ptr, CRYPTO_MUTEX *lock)
+{
+    void *ret;
+
+#ifdef __ATOMIC_ACQUIRE
+    ret = __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#else
+    if (lock != NULL && !CRYPTO_thread_read_lock(lock))
+        return NULL;
+
+    ret = *ptr;
+
+    if (lock != NULL)
+        CRYPTO_thread_unlock(lock);
+#endif
+
+    return ret;
+}
+
+int CRYPTO_atomic_set_ptr(void **ptr, void *val, CRYPTO_MUTEX *lock)
+{
+#ifdef __ATOMIC_RELEASE
+    __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+#else
+    if (lock != NULL && !CRYPTO_thread_write_lock(lock))
+        return 0;
+
+    *ptr = val;
+
+    if (lock != NULL && !CRYPTO_thread_unlock(lock))
+        return 0;
+#endif
+
+    return 1;
+}
+
+void CRYPTO_atomic_fence(void)
+{
+#ifdef __ATOMIC_SEQ_CST
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+    /* Otherwise every atomic operation takes a lock, which orders them. */
+}
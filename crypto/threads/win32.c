@@ -111,6 +111,49 @@ int CRYPTO_thread_cleanup_local(CRYPTO_THREAD_LOCAL *key)
     return 1;
 }
 
+struct thread_start {
+    void *(*start)(void *);
+    void *arg;
+};
+
+static DWORD WINAPI thread_start_routine(LPVOID parameter)
+{
+    struct thread_start ts = *(struct thread_start *)parameter;
+
+    free(parameter);
+    ts.start(ts.arg);
+
+    return 0;
+}
+
+int CRYPTO_thread_spawn(CRYPTO_THREAD *thread, void *(*start)(void *),
+                        void *arg)
+{
+    struct thread_start *ts = malloc(sizeof(*ts));
+    if (ts == NULL)
+        return 0;
+
+    ts->start = start;
+    ts->arg = arg;
+    *thread = CreateThread(NULL, 0, thread_start_routine, ts, 0, NULL);
+    if (*thread == NULL) {
+        free(ts);
+        return 0;
+    }
+
+    return 1;
+}
+
+int CRYPTO_thread_join(CRYPTO_THREAD thread)
+{
+    if (WaitForSingleObject(thread, INFINITE) != WAIT_OBJECT_0)
+        return 0;
+
+    CloseHandle(thread);
+
+    return 1;
+}
+
 CRYPTO_THREAD_ID CRYPTO_thread_get_current_id(void)
 {
     return GetCurrentThreadId();
@@ -127,3 +170,36 @@ int CRYPTO_atomic_add(int *val, int amount, int *ret, CRYPTO_MUTEX *lock)
 
     return 1;
 }
+
+int CRYPTO_atomic_add_unless(int *val, int amount, int unless, int *ret,
+                             CRYPTO_MUTEX *lock)
+{
+    LONG cur, prev;
+
+    for (cur = *(volatile LONG *)val; cur != unless; cur = prev) {
+        prev = InterlockedCompareExchange((volatile LONG *)val, cur + amount,
+                                          cur);
+        if (prev == cur) {
+            *ret = cur + amount;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void *CRYPTO_atomic_get_ptr(void **ptr, CRYPTO_MUTEX *lock)
+{
+    return InterlockedCompareExchangePointer(ptr, NULL, NULL);
+}
+
+int CRYPTO_atomic_set_ptr(void **ptr, void *val, CRYPTO_MUTEX *lock)
+{
+    InterlockedExchangePointer(ptr, val);
+
+    return 1;
+}
+
+void CRYPTO_atomic_fence(void)
+{
+    MemoryBarrier();
+}
@@ -9,6 +9,13 @@
 
 #include <time.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include <openssl/err.h>
 #include <openssl/lhash.h>
@@ -16,6 +23,8 @@
 #include <openssl/x509.h>
 #include <openssl/pem.h>
 
+#include "x509_lcl.h"
+
 static int by_file_ctrl(X509_LOOKUP *ctx, int cmd, const char *argc,
                         long argl, char **ret);
 X509_LOOKUP_METHOD x509_file_lookup = {
@@ -174,21 +183,106 @@ err:
     return (ret);
 }
 
+/*
+ * Open a certificate bundle for reading. A regular file is read whole into
+ * a buffer and read through a read-only memory BIO, which PEM_read_bio scans
+ * in place rather than line by line through stdio; anything else is opened
+ * as a file BIO. The file is read rather than mapped, since a mapping of a
+ * bundle that is truncated while it is being parsed faults. The buffer, if
+ * any, is returned in |*buf| and must outlive the BIO.
+ */
+static BIO *bundle_bio_open(const char *file, uint8_t **buf)
+{
+#if !defined(_WIN32)
+    struct stat st;
+    uint8_t *p = NULL, *np;
+    size_t len = 0, size;
+    ssize_t n;
+    BIO *in;
+    int fd;
+
+    *buf = NULL;
+    if ((fd = open(file, O_RDONLY)) == -1)
+        goto fallback;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size >= INT_MAX) {
+        close(fd);
+        goto fallback;
+    }
+    /* One spare byte, so that reaching the end of the file is seen at once */
+    size = st.st_size + 1;
+    if ((p = malloc(size)) == NULL) {
+        close(fd);
+        return NULL;
+    }
+    for (;;) {
+        if (len == size) {
+            /* The file grew since fstat */
+            if (size >= INT_MAX / 2 ||
+                (np = realloc(p, size * 2)) == NULL)
+                goto err;
+            p = np;
+            size *= 2;
+        }
+        if ((n = read(fd, p + len, size - len)) == -1) {
+            if (errno == EINTR)
+                continue;
+            goto err;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+    close(fd);
+    if ((in = BIO_new_mem_buf(p, (int)len)) == NULL) {
+        free(p);
+        return NULL;
+    }
+    *buf = p;
+    return in;
+
+err:
+    close(fd);
+    free(p);
+    return NULL;
+
+fallback:
+#else
+    *buf = NULL;
+#endif
+    return BIO_new_file(file, "r");
+}
+
+static void bundle_bio_close(BIO *in, uint8_t *buf)
+{
+    BIO_free(in);
+    free(buf);
+}
+
 int X509_load_cert_crl_file(X509_LOOKUP *ctx, const char *file, int type)
 {
     STACK_OF(X509_INFO) *inf;
     X509_INFO *itmp;
+    X509_LOOKUP *snap;
     BIO *in;
+    uint8_t *buf;
     int i, count = 0;
     if (type != X509_FILETYPE_PEM)
         return X509_load_cert_file(ctx, file, type);
-    in = BIO_new_file(file, "r");
+    /* A snapshot stands in for the bundle it was made from. */
+    if (file != NULL && ctx->store_ctx != NULL && x509_snapshot_file(file)) {
+        snap = X509_STORE_add_lookup(ctx->store_ctx, X509_LOOKUP_snapshot());
+        if (snap == NULL)
+            return 0;
+        return X509_LOOKUP_load_snapshot(snap, file);
+    }
+    in = bundle_bio_open(file, &buf);
     if (!in) {
         X509err(X509_F_X509_LOAD_CERT_CRL_FILE, ERR_R_SYS_LIB);
         return 0;
     }
     inf = PEM_X509_INFO_read_bio(in, NULL, NULL, NULL);
-    BIO_free(in);
+    bundle_bio_close(in, buf);
     if (!inf) {
         X509err(X509_F_X509_LOAD_CERT_CRL_FILE, ERR_R_PEM_LIB);
         return 0;
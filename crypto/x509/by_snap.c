@@ -0,0 +1,554 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * A trust store snapshot holds a set of trusted certificates in DER form
+ * together with an index of their subject name hashes, so that a store can
+ * use it without parsing every certificate up front. The file is mapped
+ * read-only and shared between every process that loads it; a certificate is
+ * only decoded, and added to the store's cache, the first time a chain needs
+ * an issuer with its subject name. A snapshot must be replaced by renaming a
+ * new file over it, as "openssl snapshot" does: the mapping would see a file
+ * rewritten in place change, and fault on one truncated in place.
+ *
+ * All numbers are 32-bit big-endian. The file starts with a header:
+ *
+ *   magic "VTLSSNAP", version (1), entry count, file length
+ *
+ * followed by one index entry per certificate:
+ *
+ *   subject hash, then offset and length of each of the canonical subject
+ *   encoding, the subject key identifier (empty if none) and the
+ *   certificate
+ *
+ * sorted by subject hash and then canonical subject, and then the data the
+ * offsets, which are from the start of the file, point to.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <openssl/err.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <stdcompat.h>
+
+#include "bytestring.h"
+#include "internal/threads.h"
+#include "internal/x509_int.h"
+#include "x509_lcl.h"
+
+#define SNAPSHOT_MAGIC "VTLSSNAP"
+#define SNAPSHOT_MAGIC_LEN 8
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_LEN (SNAPSHOT_MAGIC_LEN + 3 * 4)
+#define SNAPSHOT_ENTRY_LEN (7 * 4)
+
+typedef struct snapshot_file_st {
+    const uint8_t *data;
+    size_t len;
+    int mapped;       /* unmap rather than free |data| */
+    size_t count;
+    const uint8_t *index;
+    uint8_t *loaded;  /* entry has been added to the store */
+} SNAPSHOT_FILE;
+
+typedef struct lookup_snapshot_st {
+    SNAPSHOT_FILE **files;
+    size_t num_files;
+    CRYPTO_MUTEX *lock;
+} BY_SNAPSHOT;
+
+static int snapshot_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp,
+                         long argl, char **ret);
+static int new_snapshot(X509_LOOKUP *lu);
+static void free_snapshot(X509_LOOKUP *lu);
+static int get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
+                               X509_OBJECT *ret);
+X509_LOOKUP_METHOD x509_snapshot_lookup = {
+    .name = "Load certs from a trust store snapshot",
+    .new_item = new_snapshot,
+    .free = free_snapshot,
+    .init = NULL,
+    .shutdown = NULL,
+    .ctrl = snapshot_ctrl,
+    .get_by_subject = get_cert_by_subject,
+    .get_by_issuer_serial = NULL,
+    .get_by_fingerprint = NULL,
+    .get_by_alias = NULL,
+};
+
+X509_LOOKUP_METHOD *X509_LOOKUP_snapshot(void)
+{
+    return (&x509_snapshot_lookup);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void snapshot_file_free(SNAPSHOT_FILE *sf)
+{
+    if (sf == NULL)
+        return;
+#if !defined(_WIN32)
+    if (sf->mapped)
+        munmap((void *)sf->data, sf->len);
+    else
+#endif
+        free((void *)sf->data);
+    free(sf->loaded);
+    free(sf);
+}
+
+/*
+ * snapshot_map returns the contents of |file| in |sf|, mapped if it is a
+ * regular file and read into memory otherwise.
+ */
+static int snapshot_map(SNAPSHOT_FILE *sf, const char *file)
+{
+    BIO *in;
+    BUF_MEM *buf;
+    size_t len = 0;
+    int n;
+
+#if !defined(_WIN32)
+    struct stat st;
+    void *p;
+    int fd;
+
+    if ((fd = open(file, O_RDONLY)) != -1) {
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            (uintmax_t)st.st_size <= SIZE_MAX) {
+            p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                close(fd);
+                sf->data = p;
+                sf->len = st.st_size;
+                sf->mapped = 1;
+                return 1;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if ((in = BIO_new_file(file, "rb")) == NULL)
+        return 0;
+    if ((buf = BUF_MEM_new()) == NULL) {
+        BIO_free(in);
+        return 0;
+    }
+    for (;;) {
+        /* BUF_MEM_grow sets the length, so track the bytes read apart. */
+        if (!BUF_MEM_grow(buf, len + 4096))
+            goto err;
+        if ((n = BIO_read(in, buf->data + len, 4096)) <= 0)
+            break;
+        len += n;
+    }
+    BIO_free(in);
+    sf->data = (uint8_t *)buf->data;
+    sf->len = len;
+    free(buf);
+    return 1;
+
+err:
+    BIO_free(in);
+    BUF_MEM_free(buf);
+    return 0;
+}
+
+/*
+ * snapshot_check validates the header and every index entry of |sf|, so
+ * that lookups can trust the offsets without checking them again.
+ */
+static int snapshot_check(SNAPSHOT_FILE *sf)
+{
+    CBS cbs, index, magic;
+    uint32_t version, count, len, prev = 0, v[7];
+    size_t i;
+    int j;
+
+    CBS_init(&cbs, sf->data, sf->len);
+    if (!CBS_get_bytes(&cbs, &magic, SNAPSHOT_MAGIC_LEN) ||
+        !CBS_mem_equal(&magic, (const uint8_t *)SNAPSHOT_MAGIC,
+                       SNAPSHOT_MAGIC_LEN) ||
+        !CBS_get_u32(&cbs, &version) || version != SNAPSHOT_VERSION ||
+        !CBS_get_u32(&cbs, &count) || !CBS_get_u32(&cbs, &len) ||
+        len != sf->len || count > CBS_len(&cbs) / SNAPSHOT_ENTRY_LEN ||
+        !CBS_get_bytes(&cbs, &index, count * SNAPSHOT_ENTRY_LEN))
+        return 0;
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < 7; j++) {
+            if (!CBS_get_u32(&index, &v[j]))
+                return 0;
+        }
+        /* Each (offset, length) pair must lie within the file. */
+        for (j = 1; j < 7; j += 2) {
+            if (v[j] > sf->len || v[j + 1] > sf->len - v[j])
+                return 0;
+        }
+        if (v[6] == 0 || v[6] > LONG_MAX)
+            return 0;
+        /* Entries must be sorted by subject hash for the binary search. */
+        if (v[0] < prev)
+            return 0;
+        prev = v[0];
+    }
+    sf->index = sf->data + SNAPSHOT_HEADER_LEN;
+    sf->count = count;
+    return 1;
+}
+
+int x509_snapshot_file(const char *file)
+{
+    char magic[SNAPSHOT_MAGIC_LEN];
+    FILE *fp;
+    int ret;
+
+    if ((fp = fopen(file, "rb")) == NULL)
+        return 0;
+    ret = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+          memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return ret;
+}
+
+/* load_snapshot returns the number of certificates in |file|, or zero. */
+static int load_snapshot(BY_SNAPSHOT *ctx, const char *file)
+{
+    SNAPSHOT_FILE *sf, **files;
+
+    if (file == NULL) {
+        X509err(X509_F_LOAD_SNAPSHOT, X509_R_INVALID_SNAPSHOT);
+        return 0;
+    }
+    if ((sf = calloc(1, sizeof(*sf))) == NULL) {
+        X509err(X509_F_LOAD_SNAPSHOT, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (!snapshot_map(sf, file)) {
+        X509err(X509_F_LOAD_SNAPSHOT, ERR_R_SYS_LIB);
+        goto err;
+    }
+    if (!snapshot_check(sf)) {
+        X509err(X509_F_LOAD_SNAPSHOT, X509_R_INVALID_SNAPSHOT);
+        goto err;
+    }
+    if (sf->count > 0 && (sf->loaded = calloc(sf->count, 1)) == NULL) {
+        X509err(X509_F_LOAD_SNAPSHOT, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    CRYPTO_thread_write_lock(ctx->lock);
+    files = reallocarray(ctx->files, ctx->num_files + 1, sizeof(*files));
+    if (files != NULL) {
+        files[ctx->num_files++] = sf;
+        ctx->files = files;
+    }
+    CRYPTO_thread_unlock(ctx->lock);
+    if (files == NULL) {
+        X509err(X509_F_LOAD_SNAPSHOT, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    return (int)sf->count;
+
+err:
+    snapshot_file_free(sf);
+    return 0;
+}
+
+static int snapshot_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp,
+                         long argl, char **retp)
+{
+    int ret = 0;
+
+    switch (cmd) {
+        case X509_L_LOAD_SNAPSHOT:
+            ret = load_snapshot((BY_SNAPSHOT *)ctx->method_data, argp);
+            break;
+    }
+    return (ret);
+}
+
+static int new_snapshot(X509_LOOKUP *lu)
+{
+    BY_SNAPSHOT *a;
+
+    if ((a = malloc(sizeof(BY_SNAPSHOT))) == NULL)
+        return 0;
+    a->files = NULL;
+    a->num_files = 0;
+    if ((a->lock = CRYPTO_thread_new()) == NULL) {
+        free(a);
+        return 0;
+    }
+    lu->method_data = (char *)a;
+    return 1;
+}
+
+static void free_snapshot(X509_LOOKUP *lu)
+{
+    BY_SNAPSHOT *a;
+    size_t i;
+
+    a = (BY_SNAPSHOT *)lu->method_data;
+    for (i = 0; i < a->num_files; i++)
+        snapshot_file_free(a->files[i]);
+    free(a->files);
+    CRYPTO_thread_cleanup(a->lock);
+    free(a);
+}
+
+/*
+ * snapshot_span sets |*out| and |*out_len| to the data of the (offset,
+ * length) pair at |field| in |sf|, and returns whether it lies within the
+ * file. snapshot_check has checked every pair already, but a file rewritten
+ * in place could have changed them since; checking again keeps lookups
+ * within the mapping.
+ */
+static int snapshot_span(const SNAPSHOT_FILE *sf, const uint8_t *field,
+                         const uint8_t **out, size_t *out_len)
+{
+    uint32_t off = get_u32(field), len = get_u32(field + 4);
+
+    if (off > sf->len || len > sf->len - off)
+        return 0;
+    *out = sf->data + off;
+    *out_len = len;
+    return 1;
+}
+
+/*
+ * snapshot_add adds every certificate in |sf| with the subject |name|, whose
+ * hash is |h|, to |store|, decoding the ones not added before. Several
+ * certificates may share a subject, for instance a root and its renewal; the
+ * store's issuer check picks between them by key identifier.
+ */
+static int snapshot_add(SNAPSHOT_FILE *sf, X509_STORE *store, X509_NAME *name,
+                        uint32_t h)
+{
+    const uint8_t *e, *subject, *der;
+    size_t lo = 0, hi = sf->count, mid, subject_len, der_len;
+    X509 *x;
+    int found = 0;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (get_u32(sf->index + mid * SNAPSHOT_ENTRY_LEN) < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; lo < sf->count; lo++) {
+        e = sf->index + lo * SNAPSHOT_ENTRY_LEN;
+        if (get_u32(e) != h)
+            break;
+        if (!snapshot_span(sf, e + 4, &subject, &subject_len) ||
+            subject_len != (size_t)name->canon_enclen ||
+            (subject_len > 0 &&
+             memcmp(subject, name->canon_enc, subject_len) != 0))
+            continue;
+        found = 1;
+        if (sf->loaded[lo])
+            continue;
+        sf->loaded[lo] = 1;
+        if (!snapshot_span(sf, e + 20, &der, &der_len) || der_len > LONG_MAX ||
+            (x = d2i_X509_AUX(NULL, &der, (long)der_len)) == NULL) {
+            X509err(X509_F_GET_CERT_BY_SUBJECT, X509_R_INVALID_SNAPSHOT);
+            continue;
+        }
+        if (!X509_STORE_add_cert(store, x))
+            ERR_clear_error();
+        X509_free(x);
+    }
+    return found;
+}
+
+static int get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
+                               X509_OBJECT *ret)
+{
+    BY_SNAPSHOT *ctx = (BY_SNAPSHOT *)xl->method_data;
+    X509_OBJECT *tmp = NULL;
+    uint32_t h;
+    size_t i;
+    int found = 0;
+
+    if (name == NULL || type != X509_LU_X509)
+        return 0;
+
+    /* X509_NAME_hash also brings the canonical encoding up to date. */
+    h = X509_NAME_hash(name);
+
+    CRYPTO_thread_write_lock(ctx->lock);
+    for (i = 0; i < ctx->num_files; i++) {
+        if (snapshot_add(ctx->files[i], xl->store_ctx, name, h))
+            found = 1;
+    }
+    CRYPTO_thread_unlock(ctx->lock);
+    if (!found)
+        return 0;
+
+    /* we have added it to the cache so now pull it out again */
+    CRYPTO_thread_write_lock(xl->store_ctx->lock);
+    tmp = X509_OBJECT_retrieve_by_subject(xl->store_ctx->objs, type, name);
+    CRYPTO_thread_unlock(xl->store_ctx->lock);
+    if (tmp == NULL)
+        return 0;
+
+    ret->type = tmp->type;
+    memcpy(&ret->data, &tmp->data, sizeof(ret->data));
+    return 1;
+}
+
+typedef struct {
+    uint32_t hash;
+    const uint8_t *subject;
+    int subject_len;
+    const uint8_t *skid;
+    int skid_len;
+    uint8_t *der;
+    int der_len;
+} SNAPSHOT_ENTRY;
+
+static int snapshot_entry_cmp(const void *a, const void *b)
+{
+    const SNAPSHOT_ENTRY *ea = a, *eb = b;
+    int ret;
+
+    if (ea->hash != eb->hash)
+        return ea->hash < eb->hash ? -1 : 1;
+    if (ea->subject_len != eb->subject_len)
+        return ea->subject_len - eb->subject_len;
+    if (ea->subject_len > 0 &&
+        (ret = memcmp(ea->subject, eb->subject, ea->subject_len)) != 0)
+        return ret;
+    if (ea->der_len != eb->der_len)
+        return ea->der_len - eb->der_len;
+    return memcmp(ea->der, eb->der, ea->der_len);
+}
+
+int X509_snapshot_write_bio(BIO *bp, STACK_OF(X509) *certs)
+{
+    SNAPSHOT_ENTRY *ents = NULL;
+    X509_NAME *subject;
+    X509 *x;
+    CBB cbb;
+    uint8_t *p, *out = NULL;
+    size_t i, n = 0, off, total, outlen;
+    int ret = 0, num;
+
+    if (!CBB_init(&cbb, 0)) {
+        X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    num = sk_X509_num(certs);
+    if (num > 0 && (ents = calloc(num, sizeof(*ents))) == NULL) {
+        X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i < (size_t)num; i++) {
+        x = sk_X509_value(certs, i);
+        subject = X509_get_subject_name(x);
+        ents[n].hash = X509_NAME_hash(subject);
+        ents[n].subject = subject->canon_enc;
+        ents[n].subject_len = subject->canon_enclen;
+        /* Caches the extensions, including the key identifier. */
+        X509_check_purpose(x, -1, -1);
+        if (x->skid != NULL) {
+            ents[n].skid = x->skid->data;
+            ents[n].skid_len = x->skid->length;
+        }
+        if ((ents[n].der_len = i2d_X509_AUX(x, NULL)) <= 0 ||
+            (ents[n].der = malloc(ents[n].der_len)) == NULL) {
+            X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, ERR_R_ASN1_LIB);
+            goto err;
+        }
+        p = ents[n].der;
+        i2d_X509_AUX(x, &p);
+        n++;
+    }
+    qsort(ents, n, sizeof(*ents), snapshot_entry_cmp);
+
+    /* Duplicates would only be rejected by the store when loaded. */
+    for (i = 1, num = n > 0; i < n; i++) {
+        if (snapshot_entry_cmp(&ents[i], &ents[num - 1]) == 0) {
+            free(ents[i].der);
+            continue;
+        }
+        ents[num++] = ents[i];
+    }
+    n = num;
+
+    total = SNAPSHOT_HEADER_LEN + n * SNAPSHOT_ENTRY_LEN;
+    for (i = 0; i < n; i++)
+        total += ents[i].subject_len + ents[i].skid_len + ents[i].der_len;
+    if (total > UINT32_MAX) {
+        X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, X509_R_INVALID_SNAPSHOT);
+        goto err;
+    }
+
+    if (!CBB_add_bytes(&cbb, (const uint8_t *)SNAPSHOT_MAGIC,
+                       SNAPSHOT_MAGIC_LEN) ||
+        !CBB_add_u32(&cbb, SNAPSHOT_VERSION) || !CBB_add_u32(&cbb, n) ||
+        !CBB_add_u32(&cbb, total))
+        goto cbb_err;
+    off = SNAPSHOT_HEADER_LEN + n * SNAPSHOT_ENTRY_LEN;
+    for (i = 0; i < n; i++) {
+        if (!CBB_add_u32(&cbb, ents[i].hash) || !CBB_add_u32(&cbb, off) ||
+            !CBB_add_u32(&cbb, ents[i].subject_len))
+            goto cbb_err;
+        off += ents[i].subject_len;
+        if (!CBB_add_u32(&cbb, off) || !CBB_add_u32(&cbb, ents[i].skid_len))
+            goto cbb_err;
+        off += ents[i].skid_len;
+        if (!CBB_add_u32(&cbb, off) || !CBB_add_u32(&cbb, ents[i].der_len))
+            goto cbb_err;
+        off += ents[i].der_len;
+    }
+    for (i = 0; i < n; i++) {
+        if (!CBB_add_bytes(&cbb, ents[i].subject, ents[i].subject_len) ||
+            (ents[i].skid_len > 0 &&
+             !CBB_add_bytes(&cbb, ents[i].skid, ents[i].skid_len)) ||
+            !CBB_add_bytes(&cbb, ents[i].der, ents[i].der_len))
+            goto cbb_err;
+    }
+    if (!CBB_finish(&cbb, &out, &outlen))
+        goto cbb_err;
+
+    if (BIO_write(bp, out, outlen) != (int)outlen) {
+        X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, ERR_R_SYS_LIB);
+        goto err;
+    }
+    ret = 1;
+    goto err;
+
+cbb_err:
+    X509err(X509_F_X509_SNAPSHOT_WRITE_BIO, ERR_R_MALLOC_FAILURE);
+err:
+    CBB_cleanup(&cbb);
+    free(out);
+    for (i = 0; i < n; i++)
+        free(ents[i].der);
+    free(ents);
+    return ret;
+}
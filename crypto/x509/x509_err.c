@@ -23,6 +23,7 @@ static ERR_STRING_DATA X509_str_functs[] = {
     { ERR_FUNC(X509_F_CHECK_POLICY), "CHECK_POLICY" },
     { ERR_FUNC(X509_F_DIR_CTRL), "DIR_CTRL" },
     { ERR_FUNC(X509_F_GET_CERT_BY_SUBJECT), "GET_CERT_BY_SUBJECT" },
+    { ERR_FUNC(X509_F_LOAD_SNAPSHOT), "LOAD_SNAPSHOT" },
     { ERR_FUNC(X509_F_NETSCAPE_SPKI_B64_DECODE), "NETSCAPE_SPKI_B64_DECODE" },
     { ERR_FUNC(X509_F_NETSCAPE_SPKI_B64_ENCODE), "NETSCAPE_SPKI_B64_ENCODE" },
     { ERR_FUNC(X509_F_X509AT_ADD1_ATTR), "X509AT_ADD1_ATTR" },
@@ -64,6 +65,7 @@ static ERR_STRING_DATA X509_str_functs[] = {
     { ERR_FUNC(X509_F_X509_REQ_PRINT_EX), "X509_REQ_PRINT_EX" },
     { ERR_FUNC(X509_F_X509_REQ_PRINT_FP), "X509_REQ_PRINT_FP" },
     { ERR_FUNC(X509_F_X509_REQ_TO_X509), "X509_REQ_TO_X509" },
+    { ERR_FUNC(X509_F_X509_SNAPSHOT_WRITE_BIO), "X509_SNAPSHOT_WRITE_BIO" },
     { ERR_FUNC(X509_F_X509_STORE_ADD_CERT), "X509_STORE_ADD_CERT" },
     { ERR_FUNC(X509_F_X509_STORE_ADD_CRL), "X509_STORE_ADD_CRL" },
     { ERR_FUNC(X509_F_X509_STORE_CTX_GET1_ISSUER),
@@ -92,6 +94,7 @@ static ERR_STRING_DATA X509_str_reasons[] = {
     { ERR_REASON(X509_R_IDP_MISMATCH), "idp mismatch" },
     { ERR_REASON(X509_R_INVALID_DIRECTORY), "invalid directory" },
     { ERR_REASON(X509_R_INVALID_FIELD_NAME), "invalid field name" },
+    { ERR_REASON(X509_R_INVALID_SNAPSHOT), "invalid snapshot" },
     { ERR_REASON(X509_R_INVALID_TRUST), "invalid trust" },
     { ERR_REASON(X509_R_ISSUER_MISMATCH), "issuer mismatch" },
     { ERR_REASON(X509_R_KEY_TYPE_MISMATCH), "key type mismatch" },
@@ -116,6 +119,7 @@ static ERR_STRING_DATA X509_str_reasons[] = {
     { ERR_REASON(X509_R_UNKNOWN_PURPOSE_ID), "unknown purpose id" },
     { ERR_REASON(X509_R_UNKNOWN_TRUST_ID), "unknown trust id" },
     { ERR_REASON(X509_R_UNSUPPORTED_ALGORITHM), "unsupported algorithm" },
+    { ERR_REASON(X509_R_VALUE_IN_ARENA), "value in arena" },
     { ERR_REASON(X509_R_WRONG_LOOKUP_TYPE), "wrong lookup type" },
     { ERR_REASON(X509_R_WRONG_TYPE), "wrong type" },
     { 0, NULL }
@@ -6,3 +6,6 @@ struct x509_attributes_st {
 };
 
 int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int quiet);
+
+/* x509_snapshot_file returns one if |file| is a trust store snapshot. */
+int x509_snapshot_file(const char *file);
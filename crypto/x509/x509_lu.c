@@ -290,6 +290,10 @@ int X509_STORE_add_cert(X509_STORE *ctx, X509 *x)
 
     if (x == NULL)
         return 0;
+    if (x->ex_flags & EXFLAG_ARENA) {
+        X509err(X509_F_X509_STORE_ADD_CERT, X509_R_VALUE_IN_ARENA);
+        return 0;
+    }
     obj = malloc(sizeof(X509_OBJECT));
     if (obj == NULL) {
         X509err(X509_F_X509_STORE_ADD_CERT, ERR_R_MALLOC_FAILURE);
@@ -322,6 +326,10 @@ int X509_STORE_add_crl(X509_STORE *ctx, X509_CRL *x)
 
     if (x == NULL)
         return 0;
+    if (x->flags & EXFLAG_ARENA) {
+        X509err(X509_F_X509_STORE_ADD_CRL, X509_R_VALUE_IN_ARENA);
+        return 0;
+    }
     obj = malloc(sizeof(X509_OBJECT));
     if (obj == NULL) {
         X509err(X509_F_X509_STORE_ADD_CRL, ERR_R_MALLOC_FAILURE);
@@ -11,12 +11,13 @@
 #include <openssl/objects.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 
 #include "internal/threads.h"
 
 int X509_set_version(X509 *x, long version)
 {
-    if (x == NULL)
+    if (x == NULL || (x->ex_flags & EXFLAG_ARENA))
         return 0;
     if (version == 0) {
         ASN1_INTEGER_free(x->cert_info->version);
@@ -34,7 +35,7 @@ int X509_set_serialNumber(X509 *x, ASN1_INTEGER *serial)
 {
     ASN1_INTEGER *in;
 
-    if (x == NULL)
+    if (x == NULL || (x->ex_flags & EXFLAG_ARENA))
         return (0);
     in = x->cert_info->serialNumber;
     if (in != serial) {
@@ -49,14 +50,14 @@ int X509_set_serialNumber(X509 *x, ASN1_INTEGER *serial)
 
 int X509_set_issuer_name(X509 *x, X509_NAME *name)
 {
-    if ((x == NULL) || (x->cert_info == NULL))
+    if ((x == NULL) || (x->cert_info == NULL) || (x->ex_flags & EXFLAG_ARENA))
         return (0);
     return (X509_NAME_set(&x->cert_info->issuer, name));
 }
 
 int X509_set_subject_name(X509 *x, X509_NAME *name)
 {
-    if ((x == NULL) || (x->cert_info == NULL))
+    if ((x == NULL) || (x->cert_info == NULL) || (x->ex_flags & EXFLAG_ARENA))
         return (0);
     return (X509_NAME_set(&x->cert_info->subject, name));
 }
@@ -65,7 +66,8 @@ int X509_set_notBefore(X509 *x, const ASN1_TIME *tm)
 {
     ASN1_TIME *in;
 
-    if ((x == NULL) || (x->cert_info->validity == NULL))
+    if ((x == NULL) || (x->cert_info->validity == NULL) ||
+        (x->ex_flags & EXFLAG_ARENA))
         return (0);
     in = x->cert_info->validity->notBefore;
     if (in != tm) {
@@ -82,7 +84,8 @@ int X509_set_notAfter(X509 *x, const ASN1_TIME *tm)
 {
     ASN1_TIME *in;
 
-    if ((x == NULL) || (x->cert_info->validity == NULL))
+    if ((x == NULL) || (x->cert_info->validity == NULL) ||
+        (x->ex_flags & EXFLAG_ARENA))
         return (0);
     in = x->cert_info->validity->notAfter;
     if (in != tm) {
@@ -97,7 +100,7 @@ int X509_set_notAfter(X509 *x, const ASN1_TIME *tm)
 
 int X509_set_pubkey(X509 *x, EVP_PKEY *pkey)
 {
-    if ((x == NULL) || (x->cert_info == NULL))
+    if ((x == NULL) || (x->cert_info == NULL) || (x->ex_flags & EXFLAG_ARENA))
         return (0);
     return (X509_PUBKEY_set(&(x->cert_info->key), pkey));
 }
@@ -7,10 +7,12 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
 
+#include <stdcompat.h>
 #include <win32compat.h>
 
 #include <openssl/crypto.h>
@@ -1628,15 +1630,120 @@ int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int quiet)
     return 1;
 }
 
+/* Value in the check_chain_signatures result array for certificates whose
+ * signature was not checked in the batch. */
+#define SIG_NOT_BATCHED (-2)
+
+/*
+ * check_chain_signatures verifies, in one EVP_PKEY_verify_batch call, the
+ * signatures that internal_verify would otherwise check one at a time. It
+ * returns an array holding the result for each chain position or
+ * SIG_NOT_BATCHED where internal_verify has to call X509_verify itself
+ * (including every signature scheme with parameters, such as RSA-PSS), or
+ * NULL if there is nothing to gain from batching.
+ */
+static int *check_chain_signatures(X509_STORE_CTX *ctx)
+{
+    EVP_PKEY_VERIFY_ITEM *items = NULL;
+    uint8_t (*digests)[EVP_MAX_MD_SIZE] = NULL;
+    size_t *pos = NULL, nitems = 0, i;
+    int *sig_ok = NULL;
+    int num, k, mdnid, pknid;
+    unsigned int len;
+    const EVP_MD *md;
+    EVP_PKEY *pkey;
+    X509 *xs, *xi;
+
+    num = sk_X509_num(ctx->chain);
+    if (num < 3)
+        return NULL;
+
+    if ((sig_ok = reallocarray(NULL, num, sizeof(int))) == NULL ||
+        (items = calloc(num, sizeof(EVP_PKEY_VERIFY_ITEM))) == NULL ||
+        (digests = reallocarray(NULL, num, EVP_MAX_MD_SIZE)) == NULL ||
+        (pos = reallocarray(NULL, num, sizeof(size_t))) == NULL)
+        goto err;
+
+    for (k = 0; k < num; k++) {
+        sig_ok[k] = SIG_NOT_BATCHED;
+        xs = sk_X509_value(ctx->chain, k);
+        if (k + 1 < num) {
+            xi = sk_X509_value(ctx->chain, k + 1);
+        } else {
+            /* The top of the chain is only checked if self-issued and the
+             * caller asked for self-signed signatures to be checked. This
+             * is a plain check so the issuer callback and ctx->error are
+             * left to internal_verify. */
+            xi = xs;
+            if (!(ctx->param->flags & X509_V_FLAG_CHECK_SS_SIGNATURE) ||
+                X509_check_issued(xi, xi) != X509_V_OK)
+                continue;
+        }
+        if (xs->valid)
+            continue;
+
+        if (X509_ALGOR_cmp(xs->sig_alg, xs->cert_info->signature) != 0 ||
+            (xs->signature->type == V_ASN1_BIT_STRING &&
+             (xs->signature->flags & 0x7)))
+            continue;
+        if (!OBJ_find_sigid_algs(OBJ_obj2nid(xs->sig_alg->algorithm), &mdnid,
+                                 &pknid) ||
+            mdnid == NID_undef || (md = EVP_get_digestbynid(mdnid)) == NULL)
+            continue;
+        if ((pkey = X509_get_pubkey(xi)) == NULL)
+            continue;
+        if (EVP_PKEY_type(pknid) != EVP_PKEY_base_id(pkey) ||
+            !ASN1_item_digest(ASN1_ITEM_rptr(X509_CINF), md, xs->cert_info,
+                              digests[nitems], &len)) {
+            EVP_PKEY_free(pkey);
+            continue;
+        }
+
+        items[nitems].pkey = pkey;
+        items[nitems].md = md;
+        items[nitems].tbs = digests[nitems];
+        items[nitems].tbslen = len;
+        items[nitems].sig = xs->signature->data;
+        items[nitems].siglen = xs->signature->length;
+        pos[nitems++] = k;
+    }
+
+    if (nitems < 2) {
+        /* Leave a lone signature to X509_verify. */
+        free(sig_ok);
+        sig_ok = NULL;
+        goto err;
+    }
+
+    EVP_PKEY_verify_batch(items, nitems);
+    for (i = 0; i < nitems; i++)
+        sig_ok[pos[i]] = items[i].result;
+    /* Failed signatures are reported through the verify callback. */
+    ERR_clear_error();
+
+err:
+    if (items != NULL) {
+        for (i = 0; i < nitems; i++)
+            EVP_PKEY_free(items[i].pkey);
+    }
+    free(items);
+    free(digests);
+    free(pos);
+    return sig_ok;
+}
+
 static int internal_verify(X509_STORE_CTX *ctx)
 {
     int ok = 0, n;
     X509 *xs, *xi;
     EVP_PKEY *pkey = NULL;
+    int *sig_ok;
     int (*cb)(int xok, X509_STORE_CTX *xctx);
 
     cb = ctx->verify_cb;
 
+    sig_ok = check_chain_signatures(ctx);
+
     n = sk_X509_num(ctx->chain);
     ctx->error_depth = n - 1;
     n--;
@@ -1676,7 +1783,8 @@ static int internal_verify(X509_STORE_CTX *ctx)
                 ok = (*cb)(0, ctx);
                 if (!ok)
                     goto end;
-            } else if (X509_verify(xs, pkey) <= 0) {
+            } else if ((sig_ok != NULL && sig_ok[n] != SIG_NOT_BATCHED ?
+                            sig_ok[n] : X509_verify(xs, pkey)) <= 0) {
                 ctx->error = X509_V_ERR_CERT_SIGNATURE_FAILURE;
                 ctx->current_cert = xs;
                 ok = (*cb)(0, ctx);
@@ -1711,6 +1819,7 @@ static int internal_verify(X509_STORE_CTX *ctx)
     }
     ok = 1;
 end:
+    free(sig_ok);
     return ok;
 }
 
@@ -11,12 +11,13 @@
 #include <openssl/objects.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 
 #include "internal/threads.h"
 
 int X509_CRL_set_version(X509_CRL *x, long version)
 {
-    if (x == NULL)
+    if (x == NULL || (x->flags & EXFLAG_ARENA))
         return (0);
     if (x->crl->version == NULL) {
         if ((x->crl->version = ASN1_INTEGER_new()) == NULL)
@@ -27,7 +28,7 @@ int X509_CRL_set_version(X509_CRL *x, long version)
 
 int X509_CRL_set_issuer_name(X509_CRL *x, X509_NAME *name)
 {
-    if ((x == NULL) || (x->crl == NULL))
+    if ((x == NULL) || (x->crl == NULL) || (x->flags & EXFLAG_ARENA))
         return (0);
     return (X509_NAME_set(&x->crl->issuer, name));
 }
@@ -36,7 +37,7 @@ int X509_CRL_set_lastUpdate(X509_CRL *x, const ASN1_TIME *tm)
 {
     ASN1_TIME *in;
 
-    if (x == NULL)
+    if (x == NULL || (x->flags & EXFLAG_ARENA))
         return (0);
     in = x->crl->lastUpdate;
     if (in != tm) {
@@ -53,7 +54,7 @@ int X509_CRL_set_nextUpdate(X509_CRL *x, const ASN1_TIME *tm)
 {
     ASN1_TIME *in;
 
-    if (x == NULL)
+    if (x == NULL || (x->flags & EXFLAG_ARENA))
         return (0);
     in = x->crl->nextUpdate;
     if (in != tm) {
@@ -70,6 +71,9 @@ int X509_CRL_sort(X509_CRL *c)
 {
     int i;
     X509_REVOKED *r;
+
+    if (c->flags & EXFLAG_ARENA)
+        return 0;
     /* sort the data so it will be written in serial
      * number order */
     sk_X509_REVOKED_sort(c->crl->revoked);
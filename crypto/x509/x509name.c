@@ -104,6 +104,9 @@ X509_NAME_ENTRY *X509_NAME_delete_entry(X509_NAME *name, int loc)
         || loc < 0)
         return (NULL);
     sk = name->entries;
+    /* An entry decoded into an arena cannot be handed to the caller */
+    if (sk_X509_NAME_ENTRY_value(sk, loc)->value->flags & ASN1_STRING_FLAG_ARENA)
+        return (NULL);
     ret = sk_X509_NAME_ENTRY_delete(sk, loc);
     n = sk_X509_NAME_ENTRY_num(sk);
     name->modified = 1;
@@ -12,6 +12,7 @@
 #include <openssl/asn1.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 #include <openssl/ocsp.h>
 #include <openssl/rsa.h>
 #ifndef OPENSSL_NO_DSA
@@ -40,6 +41,8 @@ int NETSCAPE_SPKI_verify(NETSCAPE_SPKI *a, EVP_PKEY *r)
 
 int X509_sign(X509 *x, EVP_PKEY *pkey, const EVP_MD *md)
 {
+    if (x->ex_flags & EXFLAG_ARENA)
+        return 0;
     x->cert_info->enc.modified = 1;
     return (ASN1_item_sign(ASN1_ITEM_rptr(X509_CINF), x->cert_info->signature,
                            x->sig_alg, x->signature, x->cert_info, pkey, md));
@@ -47,6 +50,8 @@ int X509_sign(X509 *x, EVP_PKEY *pkey, const EVP_MD *md)
 
 int X509_sign_ctx(X509 *x, EVP_MD_CTX *ctx)
 {
+    if (x->ex_flags & EXFLAG_ARENA)
+        return 0;
     x->cert_info->enc.modified = 1;
     return ASN1_item_sign_ctx(ASN1_ITEM_rptr(X509_CINF),
                               x->cert_info->signature,
@@ -73,6 +78,8 @@ int X509_REQ_sign_ctx(X509_REQ *x, EVP_MD_CTX *ctx)
 
 int X509_CRL_sign(X509_CRL *x, EVP_PKEY *pkey, const EVP_MD *md)
 {
+    if (x->flags & EXFLAG_ARENA)
+        return 0;
     x->crl->enc.modified = 1;
     return (ASN1_item_sign(ASN1_ITEM_rptr(X509_CRL_INFO), x->crl->sig_alg,
                            x->sig_alg, x->signature, x->crl, pkey, md));
@@ -80,6 +87,8 @@ int X509_CRL_sign(X509_CRL *x, EVP_PKEY *pkey, const EVP_MD *md)
 
 int X509_CRL_sign_ctx(X509_CRL *x, EVP_MD_CTX *ctx)
 {
+    if (x->flags & EXFLAG_ARENA)
+        return 0;
     x->crl->enc.modified = 1;
     return ASN1_item_sign_ctx(ASN1_ITEM_rptr(X509_CRL_INFO),
                               x->crl->sig_alg, x->sig_alg, x->signature, x->crl, ctx);
@@ -133,7 +133,7 @@ X509_NAME *X509_NAME_dup(X509_NAME *x)
 static int x509_name_ex_new(ASN1_VALUE **val, const ASN1_ITEM *it)
 {
     X509_NAME *ret = NULL;
-    ret = malloc(sizeof(X509_NAME));
+    ret = asn1_malloc(sizeof(X509_NAME));
     if (!ret)
         goto memerr;
     if ((ret->entries = sk_X509_NAME_ENTRY_new_null()) == NULL)
@@ -151,7 +151,7 @@ memerr:
     if (ret) {
         if (ret->entries)
             sk_X509_NAME_ENTRY_free(ret->entries);
-        free(ret);
+        asn1_free(ret);
     }
     return 0;
 }
@@ -166,7 +166,7 @@ static void x509_name_ex_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
     BUF_MEM_free(a->bytes);
     sk_X509_NAME_ENTRY_pop_free(a->entries, X509_NAME_ENTRY_free);
     free(a->canon_enc);
-    free(a);
+    asn1_free(a);
     *pval = NULL;
 }
 
@@ -380,6 +380,7 @@ static int x509_name_canon(X509_NAME *a)
     len = i2d_name_canon(intname, NULL);
     if (len < 0)
         goto err;
+    /* Always on the heap, since a name in an arena may be re-canonicalized */
     p = malloc(len);
     if (p == NULL)
         goto err;
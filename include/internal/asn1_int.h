@@ -62,6 +62,7 @@ struct evp_pkey_asn1_method_st {
 # define ASN1_OBJECT_FLAG_CRITICAL        0x02/* critical x509v3 object id */
 # define ASN1_OBJECT_FLAG_DYNAMIC_STRINGS 0x04/* internal use */
 # define ASN1_OBJECT_FLAG_DYNAMIC_DATA    0x08/* internal use */
+# define ASN1_OBJECT_FLAG_ARENA           0x10/* owned by an ASN1_ARENA */
 struct asn1_object_st {
     const char *sn, *ln;
     int nid;
@@ -79,3 +80,17 @@ struct asn1_pctx_st {
     unsigned long oid_flags;
     unsigned long str_flags;
 } /* ASN1_PCTX */ ;
+
+/*
+ * Allocation functions for decoded ASN1 values. They use the heap unless an
+ * ASN1_ARENA is being decoded into or freed on the calling thread, in which
+ * case asn1_free skips the arena's own memory.
+ */
+void *asn1_malloc(size_t len);
+void *asn1_calloc(size_t num, size_t size);
+void asn1_free(void *ptr);
+
+/* asn1_arena_current returns the arena in use on this thread, if any. */
+ASN1_ARENA *asn1_arena_current(void);
+void *asn1_arena_alloc(ASN1_ARENA *arena, size_t len);
+void *asn1_arena_realloc(ASN1_ARENA *arena, void *ptr, size_t len);
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/* Internal EC functions for other submodules: not for application use */
+
+#ifndef HEADER_EC_INT_H
+#define HEADER_EC_INT_H
+
+#include <openssl/ec.h>
+
+int ec_group_do_order_mul(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                          const BIGNUM *b, BN_CTX *ctx);
+int ec_group_do_inverse_ord(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+                            BN_CTX *ctx);
+int ec_group_do_public_inverse_ord(const EC_GROUP *group, BIGNUM *r,
+                                   const BIGNUM *a, BN_CTX *ctx);
+int ec_key_do_verify_mul(EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+                         const BIGNUM *p_scalar, BN_CTX *ctx);
+
+#endif
@@ -22,6 +22,7 @@
 #if !defined(OPENSSL_THREADS)
 
 typedef unsigned int CRYPTO_ONCE;
+typedef unsigned int CRYPTO_THREAD;
 
 #define CRYPTO_ONCE_STATIC_INIT 0
 
@@ -31,6 +32,7 @@ typedef unsigned int CRYPTO_ONCE;
 #include <windows.h>
 
 typedef INIT_ONCE CRYPTO_ONCE;
+typedef HANDLE CRYPTO_THREAD;
 
 #define CRYPTO_ONCE_STATIC_INIT INIT_ONCE_STATIC_INIT
 
@@ -39,6 +41,7 @@ typedef INIT_ONCE CRYPTO_ONCE;
 #include <pthread.h>
 
 typedef pthread_once_t CRYPTO_ONCE;
+typedef pthread_t CRYPTO_THREAD;
 
 #define CRYPTO_ONCE_STATIC_INIT PTHREAD_ONCE_INIT
 
@@ -61,11 +64,50 @@ VIGORTLS_EXPORT int CRYPTO_thread_set_local(CRYPTO_THREAD_LOCAL *key,
                                             void *val);
 VIGORTLS_EXPORT int CRYPTO_thread_cleanup_local(CRYPTO_THREAD_LOCAL *key);
 
+/*
+ * CRYPTO_thread_spawn starts a thread running |start| with |arg|, which must
+ * later be passed to CRYPTO_thread_join. It returns one on success and zero
+ * on error, which is always the case when built without thread support.
+ */
+VIGORTLS_EXPORT int CRYPTO_thread_spawn(CRYPTO_THREAD *thread,
+                                        void *(*start)(void *), void *arg);
+VIGORTLS_EXPORT int CRYPTO_thread_join(CRYPTO_THREAD thread);
+
 VIGORTLS_EXPORT CRYPTO_THREAD_ID CRYPTO_thread_get_current_id(void);
 VIGORTLS_EXPORT int CRYPTO_thread_compare_id(CRYPTO_THREAD_ID a,
                                              CRYPTO_THREAD_ID b);
 
+/*
+ * The atomic functions below only use |lock| where the compiler has no
+ * atomics. It must not be held by the caller, except that a NULL |lock| says
+ * the caller already holds the lock that every other update takes.
+ */
 VIGORTLS_EXPORT int CRYPTO_atomic_add(int *val, int amount, int *ret,
                                       CRYPTO_MUTEX *lock);
 
+/*
+ * CRYPTO_atomic_add_unless adds |amount| to |*val| unless it equals |unless|.
+ * This lets a reference count be raised only while another reference is held,
+ * or dropped only while it is not the last. It returns one and sets |*ret| to
+ * the new value if it added, and zero otherwise.
+ */
+VIGORTLS_EXPORT int CRYPTO_atomic_add_unless(int *val, int amount, int unless,
+                                             int *ret, CRYPTO_MUTEX *lock);
+
+/*
+ * CRYPTO_atomic_get_ptr and CRYPTO_atomic_set_ptr read and publish a pointer
+ * with acquire and release ordering, so a reader that sees the new pointer
+ * also sees everything written before it was set.
+ */
+VIGORTLS_EXPORT void *CRYPTO_atomic_get_ptr(void **ptr, CRYPTO_MUTEX *lock);
+VIGORTLS_EXPORT int CRYPTO_atomic_set_ptr(void **ptr, void *val,
+                                          CRYPTO_MUTEX *lock);
+
+/*
+ * CRYPTO_atomic_fence orders every atomic operation before it against every
+ * one after it. Two threads that each update one variable and then read the
+ * other's need it on both sides for at least one to see the other's update.
+ */
+VIGORTLS_EXPORT void CRYPTO_atomic_fence(void);
+
 #endif
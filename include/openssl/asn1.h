@@ -126,6 +126,8 @@ DECLARE_STACK_OF(X509_ALGOR)
  * type.
  */
 #define ASN1_STRING_FLAG_MSTRING   0x040
+/* This flag is set on strings owned by an ASN1_ARENA, which are read-only */
+#define ASN1_STRING_FLAG_ARENA     0x080
 /* This is the base type that holds just about everything :-) */
 struct asn1_string_st {
     int length;
@@ -187,6 +189,7 @@ typedef struct ASN1_TEMPLATE_st ASN1_TEMPLATE;
 typedef struct ASN1_TLC_st ASN1_TLC;
 /* This is just an opaque pointer */
 typedef struct ASN1_VALUE_st ASN1_VALUE;
+typedef struct asn1_arena_st ASN1_ARENA;
 
 /* Declare ASN1 functions: the implement macro in in asn1t.h */
 
@@ -810,6 +813,25 @@ VIGORTLS_EXPORT ASN1_VALUE *ASN1_item_new(const ASN1_ITEM *it);
 VIGORTLS_EXPORT void ASN1_item_free(ASN1_VALUE *val, const ASN1_ITEM *it);
 VIGORTLS_EXPORT ASN1_VALUE *ASN1_item_d2i(ASN1_VALUE **val, const uint8_t **in,
                                           long len, const ASN1_ITEM *it);
+
+/*
+ * An ASN1_ARENA owns values decoded with ASN1_item_d2i_arena. Their
+ * structures, strings and objects are allocated in a few large chunks rather
+ * than one by one, and everything is released at once by ASN1_ARENA_free.
+ * Values decoded into an arena must be treated as read-only, must not be
+ * freed individually and must not be used after the arena is freed. Strings
+ * in an arena carry ASN1_STRING_FLAG_ARENA and ASN1_STRING_set fails on them
+ * with ASN1_R_VALUE_IN_ARENA. An arena must only be used by one thread at a
+ * time.
+ */
+VIGORTLS_EXPORT ASN1_ARENA *ASN1_ARENA_new(void);
+VIGORTLS_EXPORT void ASN1_ARENA_free(ASN1_ARENA *arena);
+/* ASN1_ARENA_allocated returns the number of bytes handed out by |arena|. */
+VIGORTLS_EXPORT size_t ASN1_ARENA_allocated(const ASN1_ARENA *arena);
+VIGORTLS_EXPORT ASN1_VALUE *ASN1_item_d2i_arena(ASN1_ARENA *arena,
+                                                const uint8_t **in, long len,
+                                                const ASN1_ITEM *it);
+
 VIGORTLS_EXPORT int ASN1_item_i2d(ASN1_VALUE *val, uint8_t **out,
                                   const ASN1_ITEM *it);
 VIGORTLS_EXPORT int ASN1_item_ndef_i2d(ASN1_VALUE *val, uint8_t **out,
@@ -891,6 +913,7 @@ VIGORTLS_EXPORT void ERR_load_ASN1_strings(void);
 # define ASN1_F_A2I_ASN1_INTEGER                          102
 # define ASN1_F_A2I_ASN1_STRING                           103
 # define ASN1_F_APPEND_EXP                                176
+# define ASN1_F_ASN1_ARENA_NEW                            230
 # define ASN1_F_ASN1_BIT_STRING_SET_BIT                   183
 # define ASN1_F_ASN1_CB                                   177
 # define ASN1_F_ASN1_CHECK_TLEN                           104
@@ -917,6 +940,7 @@ VIGORTLS_EXPORT void ERR_load_ASN1_strings(void);
 # define ASN1_F_ASN1_I2D_FP                               117
 # define ASN1_F_ASN1_INTEGER_SET                          118
 # define ASN1_F_ASN1_INTEGER_TO_BN                        119
+# define ASN1_F_ASN1_ITEM_D2I_ARENA                       231
 # define ASN1_F_ASN1_ITEM_D2I_FP                          206
 # define ASN1_F_ASN1_ITEM_DUP                             191
 # define ASN1_F_ASN1_ITEM_EX_D2I                          120
@@ -1136,12 +1160,14 @@ VIGORTLS_EXPORT void ERR_load_ASN1_strings(void);
 # define ASN1_R_UNSUPPORTED_ENCRYPTION_ALGORITHM          166
 # define ASN1_R_UNSUPPORTED_PUBLIC_KEY_TYPE               167
 # define ASN1_R_UNSUPPORTED_TYPE                          196
+# define ASN1_R_VALUE_IN_ARENA                            226
 # define ASN1_R_WRONG_INTEGER_TYPE                        225
 # define ASN1_R_WRONG_PUBLIC_KEY_TYPE                     200
 # define ASN1_R_WRONG_TAG                                 168
 # define ASN1_R_WRONG_TYPE                                169
 
-int ASN1_time_parse(const char *bytes, size_t len, struct tm *tm, int mode);
+VIGORTLS_EXPORT int ASN1_time_parse(const char *bytes, size_t len,
+                                    struct tm *tm, int mode);
 int ASN1_time_tm_cmp(struct tm *tm1, struct tm *tm2);
 
 #ifdef  __cplusplus
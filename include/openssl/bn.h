@@ -138,6 +138,8 @@ struct bn_gencb_st {
         /* if(ver==2) - new callback style */
         int (*cb_2)(int, int, BN_GENCB *);
     } cb;
+    /* Threads to search for primes with, or zero for just the caller */
+    int threads;
 };
 /* Wrapper function to make using BN_GENCB easier,  */
 int BN_GENCB_call(BN_GENCB *cb, int a, int b);
@@ -148,6 +150,7 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b);
         tmp_gencb->ver      = 1;                  \
         tmp_gencb->arg      = (cb_arg);           \
         tmp_gencb->cb.cb_1  = (callback);         \
+        tmp_gencb->threads  = 0;                  \
     }
 /* Macro to populate a BN_GENCB structure with a "new"-style callback */
 #define BN_GENCB_set(gencb, callback, cb_arg) \
@@ -156,7 +159,15 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b);
         tmp_gencb->ver      = 2;              \
         tmp_gencb->arg      = (cb_arg);       \
         tmp_gencb->cb.cb_2  = (callback);     \
+        tmp_gencb->threads  = 0;              \
     }
+/*
+ * Macro to have prime generation with a BN_GENCB search in |n| threads. The
+ * callback is only ever called from the thread that started the search, and
+ * returning zero from it stops every thread.
+ */
+#define BN_GENCB_MAX_THREADS 64
+#define BN_GENCB_set_threads(gencb, n) ((gencb)->threads = (n))
 
 #define BN_prime_checks                       \
     0 /* default: select number of iterations \
@@ -212,6 +223,13 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b);
 VIGORTLS_EXPORT const BIGNUM *BN_value_one(void);
 VIGORTLS_EXPORT char *BN_options(void);
 VIGORTLS_EXPORT BN_CTX *BN_CTX_new(void);
+/*
+ * BN_CTX_new_cached returns a context kept by the calling thread, whose
+ * temporaries are already allocated from earlier operations. It is released
+ * with BN_CTX_free, which clears it and gives it back to the thread, and must
+ * not be passed to another thread.
+ */
+VIGORTLS_EXPORT BN_CTX *BN_CTX_new_cached(void);
 #ifndef OPENSSL_NO_DEPRECATED
 VIGORTLS_EXPORT void BN_CTX_init(BN_CTX *c);
 #endif
@@ -835,6 +835,34 @@ VIGORTLS_EXPORT void EC_KEY_set_asn1_flag(EC_KEY *eckey, int asn1_flag);
  */
 VIGORTLS_EXPORT int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx);
 
+/** Creates a table of pre-computed multiples of the public key of |key| to
+ *  accelerate signature verification with it, where the group supports it
+ *  (currently the x86_64 P-256 implementation). The table belongs to the
+ *  key; see EC_KEY_get_precompute_size for its cost. Does nothing for
+ *  other groups.
+ *  \param  key  EC_KEY object
+ *  \param  ctx  BN_CTX object (optional)
+ *  \return 1 on success and 0 if an error occurred.
+ */
+VIGORTLS_EXPORT int EC_KEY_precompute_public_mult(EC_KEY *key, BN_CTX *ctx);
+
+/** Makes signature verification build the public key table of
+ *  EC_KEY_precompute_public_mult on its own once the key has been used for
+ *  |uses| verifications. Meant for long-lived keys that verify many
+ *  signatures; disabled (0) by default.
+ *  \param  key   EC_KEY object
+ *  \param  uses  number of verifications, or 0 to disable
+ */
+VIGORTLS_EXPORT void EC_KEY_set_precompute_threshold(EC_KEY *key, int uses);
+
+/** Returns the number of bytes held by the public key table of |key|.
+ *  For P-256 the table is 37 rows of 64 affine points (about 148 KiB),
+ *  built with about 2400 point additions and 37 field inversions.
+ *  \param  key  EC_KEY object
+ *  \return the size of the table, or 0 if none has been built.
+ */
+VIGORTLS_EXPORT size_t EC_KEY_get_precompute_size(const EC_KEY *key);
+
 /** Creates a new ec private (and optional a new public) key.
  *  \param  key  EC_KEY object
  *  \return 1 on success and 0 if an error occurred.
@@ -89,6 +89,25 @@ VIGORTLS_EXPORT ECDSA_SIG *ECDSA_do_sign_ex(const uint8_t *dgst, int dgstlen,
 VIGORTLS_EXPORT int ECDSA_do_verify(const uint8_t *dgst, int dgst_len,
                                     const ECDSA_SIG *sig, EC_KEY *eckey);
 
+/** Verifies a batch of ECDSA signatures. Entry i checks sigs[i] over the
+ *  dgst_lens[i] byte hash value dgsts[i] with eckeys[i]. Per-call setup is
+ *  shared by the whole batch and the s values of entries on the same curve
+ *  are inverted together, so this is cheaper than num ECDSA_do_verify calls.
+ *  \param  num       number of signatures
+ *  \param  dgsts     pointers to the hash values
+ *  \param  dgst_lens lengths of the hash values
+ *  \param  sigs      ECDSA_SIG structures
+ *  \param  eckeys    EC_KEY objects containing public EC keys
+ *  \param  results   receives the ECDSA_do_verify result for each entry
+ *  \return 1 if all signatures are valid, -1 if an error occurred for any
+ *          of them and 0 otherwise
+ */
+VIGORTLS_EXPORT int ECDSA_do_verify_batch(size_t num,
+                                          const uint8_t *const *dgsts,
+                                          const int *dgst_lens,
+                                          const ECDSA_SIG *const *sigs,
+                                          EC_KEY *const *eckeys, int *results);
+
 VIGORTLS_EXPORT const ECDSA_METHOD *ECDSA_OpenSSL(void);
 
 /** Sets the default ECDSA method
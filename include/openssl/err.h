@@ -43,6 +43,9 @@ typedef struct err_state_st {
     const char *err_file[ERR_NUM_ERRORS];
     int err_line[ERR_NUM_ERRORS];
     int top, bottom;
+    /* Reused by ERR_add_error_data and ERR_asprintf_error_data */
+    char *err_data_buf[ERR_NUM_ERRORS];
+    size_t err_data_buf_len[ERR_NUM_ERRORS];
 } ERR_STATE;
 
 /* library */
@@ -1143,6 +1143,25 @@ VIGORTLS_EXPORT int EVP_PKEY_verify_init(EVP_PKEY_CTX *ctx);
 VIGORTLS_EXPORT int EVP_PKEY_verify(EVP_PKEY_CTX *ctx, const uint8_t *sig,
                                     size_t siglen, const uint8_t *tbs,
                                     size_t tbslen);
+
+/* EVP_PKEY_VERIFY_ITEM is one signature for EVP_PKEY_verify_batch. */
+typedef struct evp_pkey_verify_item_st {
+    EVP_PKEY *pkey;      /* public key */
+    const EVP_MD *md;    /* digest the signature was made with */
+    const uint8_t *tbs;  /* digest of the signed data */
+    size_t tbslen;
+    const uint8_t *sig;  /* encoded signature */
+    size_t siglen;
+    int result;          /* set to the EVP_PKEY_verify return value */
+} EVP_PKEY_VERIFY_ITEM;
+
+/* EVP_PKEY_verify_batch verifies |num| signatures over precomputed digests
+ * using the default signature scheme of each key (PKCS#1 v1.5 for RSA).
+ * Per-call setup is shared across the batch and ECDSA signatures are checked
+ * with ECDSA_do_verify_batch. It returns 1 if every signature is valid, 0 if
+ * any is invalid and a negative value if any could not be checked. */
+VIGORTLS_EXPORT int EVP_PKEY_verify_batch(EVP_PKEY_VERIFY_ITEM *items,
+                                          size_t num);
 VIGORTLS_EXPORT int EVP_PKEY_verify_recover_init(EVP_PKEY_CTX *ctx);
 VIGORTLS_EXPORT int EVP_PKEY_verify_recover(EVP_PKEY_CTX *ctx, uint8_t *rout,
                                             size_t *routlen, const uint8_t *sig,
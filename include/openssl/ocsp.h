@@ -578,6 +578,52 @@ VIGORTLS_EXPORT int OCSP_basic_verify(OCSP_BASICRESP *bs,
                                       STACK_OF(X509) *certs, X509_STORE *st,
                                       unsigned long flags);
 
+/*
+ * OCSP_RESPONDER answers requests from responses signed in advance, one
+ * per serial number of a single issuer, as in the RFC 5019 lightweight
+ * profile.
+ *
+ * OCSP_RESPONDER_new creates a responder for certificates issued by
+ * |issuer|, whose responses are signed by |signer| with |key| and |md|.
+ *
+ * OCSP_RESPONDER_load_index reads the certificates and their status from
+ * an index in the format written by the ca command. Valid and revoked
+ * certificates are answered for; expired ones are not. The new index is
+ * used from the next signing onwards.
+ *
+ * OCSP_RESPONDER_update signs responses for every certificate in the index,
+ * valid from now for |validity| seconds, if there are none yet or the
+ * current ones expire within |margin| seconds. The new responses are all
+ * signed before any is served. It returns one on success, or if the
+ * current responses are still fresh, and zero on error.
+ *
+ * OCSP_RESPONDER_get_next_update returns the nextUpdate time of the
+ * current responses, or zero if there are none.
+ *
+ * OCSP_RESPONDER_respond answers the DER OCSPRequest in |req| by copying
+ * the DER OCSPResponse into |out|. Requests must be for a single
+ * certificate with a SHA-1 CertID, and nonces are ignored. Certificates not
+ * in the index get an unauthorized response, and all requests get a
+ * tryLater response while there are no valid responses. It returns the
+ * response status sent, or -1 on allocation failure.
+ *
+ * OCSP_RESPONDER_respond may be called from several threads at once, also
+ * during OCSP_RESPONDER_update. Loading and updating must not overlap.
+ */
+typedef struct ocsp_responder_st OCSP_RESPONDER;
+
+VIGORTLS_EXPORT OCSP_RESPONDER *OCSP_RESPONDER_new(X509 *issuer, X509 *signer,
+                                                   EVP_PKEY *key,
+                                                   const EVP_MD *md);
+VIGORTLS_EXPORT void OCSP_RESPONDER_free(OCSP_RESPONDER *r);
+VIGORTLS_EXPORT int OCSP_RESPONDER_load_index(OCSP_RESPONDER *r, BIO *in);
+VIGORTLS_EXPORT int OCSP_RESPONDER_update(OCSP_RESPONDER *r, long validity,
+                                          long margin);
+VIGORTLS_EXPORT time_t OCSP_RESPONDER_get_next_update(OCSP_RESPONDER *r);
+VIGORTLS_EXPORT int OCSP_RESPONDER_respond(OCSP_RESPONDER *r,
+                                           const uint8_t *req, size_t req_len,
+                                           BUF_MEM *out);
+
 /* BEGIN ERROR CODES */
 /*
  * The following lines are auto generated by the script mkerr.pl. Any changes
@@ -602,6 +648,9 @@ VIGORTLS_EXPORT void ERR_load_OCSP_strings(void);
 # define OCSP_F_OCSP_PARSE_URL                            114
 # define OCSP_F_OCSP_REQUEST_SIGN                         110
 # define OCSP_F_OCSP_REQUEST_VERIFY                       116
+# define OCSP_F_OCSP_RESPONDER_LOAD_INDEX                 119
+# define OCSP_F_OCSP_RESPONDER_NEW                        120
+# define OCSP_F_OCSP_RESPONDER_UPDATE                     121
 # define OCSP_F_OCSP_RESPONSE_GET1_BASIC                  111
 # define OCSP_F_OCSP_SENDREQ_BIO                          112
 # define OCSP_F_OCSP_SENDREQ_NBIO                         117
@@ -610,6 +659,7 @@ VIGORTLS_EXPORT void ERR_load_OCSP_strings(void);
 
 /* Reason codes. */
 # define OCSP_R_BAD_DATA                                  100
+# define OCSP_R_BAD_INDEX_ENTRY                           130
 # define OCSP_R_CERTIFICATE_VERIFY_ERROR                  101
 # define OCSP_R_DIGEST_ERR                                102
 # define OCSP_R_ERROR_IN_NEXTUPDATE_FIELD                 122
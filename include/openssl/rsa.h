@@ -24,6 +24,13 @@
 extern "C" {
 #endif
 
+/*
+ * An RSA_PRIME_INFO holds one of the primes beyond p and q of a multi-prime
+ * key (RFC 8017, section 3.2), with its CRT exponent and coefficient.
+ */
+typedef struct rsa_prime_info_st RSA_PRIME_INFO;
+DECLARE_STACK_OF(RSA_PRIME_INFO)
+
 struct rsa_meth_st {
     const char *name;
     int (*rsa_pub_enc)(int flen, const uint8_t *from, uint8_t *to, RSA *rsa,
@@ -96,6 +103,9 @@ struct rsa_st {
     BN_BLINDING *blinding;
     BN_BLINDING *mt_blinding;
     CRYPTO_MUTEX *lock;
+
+    /* The third and later primes of a multi-prime key, or NULL */
+    STACK_OF(RSA_PRIME_INFO) *prime_infos;
 };
 
 #ifndef OPENSSL_RSA_MAX_MODULUS_BITS
@@ -110,6 +120,11 @@ struct rsa_st {
                                         * modulus only */
 #endif
 
+/* The most primes a key may have, and the version of multi-prime keys */
+#define RSA_MAX_PRIME_NUM 5
+#define RSA_ASN1_VERSION_DEFAULT 0
+#define RSA_ASN1_VERSION_MULTI 1
+
 #define RSA_3 0x3L
 #define RSA_F4 0x10001L
 
@@ -172,6 +187,10 @@ struct rsa_st {
     EVP_PKEY_CTX_ctrl(ctx, EVP_PKEY_RSA, EVP_PKEY_OP_KEYGEN, \
                       EVP_PKEY_CTRL_RSA_KEYGEN_PUBEXP, 0, pubexp)
 
+#define EVP_PKEY_CTX_set_rsa_keygen_primes(ctx, primes)      \
+    EVP_PKEY_CTX_ctrl(ctx, EVP_PKEY_RSA, EVP_PKEY_OP_KEYGEN, \
+                      EVP_PKEY_CTRL_RSA_KEYGEN_PRIMES, primes, NULL)
+
 #define EVP_PKEY_CTX_set_rsa_mgf1_md(ctx, md)                   \
     EVP_PKEY_CTX_ctrl(ctx, EVP_PKEY_RSA, EVP_PKEY_OP_TYPE_SIG | \
                       EVP_PKEY_OP_TYPE_CRYPT,                   \
@@ -215,6 +234,8 @@ struct rsa_st {
 #define EVP_PKEY_CTRL_GET_RSA_OAEP_MD (EVP_PKEY_ALG_CTRL + 11)
 #define EVP_PKEY_CTRL_GET_RSA_OAEP_LABEL (EVP_PKEY_ALG_CTRL + 12)
 
+#define EVP_PKEY_CTRL_RSA_KEYGEN_PRIMES (EVP_PKEY_ALG_CTRL + 13)
+
 #define RSA_PKCS1_PADDING       1
 #define RSA_SSLV23_PADDING      2
 #define RSA_NO_PADDING          3
@@ -243,6 +264,20 @@ VIGORTLS_EXPORT RSA *RSA_generate_key(int bits, unsigned long e,
 VIGORTLS_EXPORT int RSA_generate_key_ex(RSA *rsa, int bits, BIGNUM *e,
                                         BN_GENCB *cb);
 
+/*
+ * RSA_generate_multi_prime_key generates a key whose modulus is the product of
+ * |primes| primes. Private key operations on it take one exponentiation per
+ * prime, each modulo a smaller prime, so they are faster than with two primes.
+ * At most 3 primes are allowed below 4096 bits, 4 below 8192 bits and
+ * RSA_MAX_PRIME_NUM above that.
+ */
+VIGORTLS_EXPORT int RSA_generate_multi_prime_key(RSA *rsa, int bits, int primes,
+                                                 BIGNUM *e, BN_GENCB *cb);
+
+/* RSA_get_multi_prime_extra_count returns the number of primes of |r| beyond
+ * p and q. */
+VIGORTLS_EXPORT int RSA_get_multi_prime_extra_count(const RSA *r);
+
 VIGORTLS_EXPORT int RSA_check_key(const RSA *);
 /* next 4 return -1 on error */
 VIGORTLS_EXPORT int RSA_public_encrypt(int flen, const uint8_t *from,
@@ -442,6 +477,7 @@ VIGORTLS_EXPORT void ERR_load_RSA_strings(void);
 # define RSA_F_RSA_EAY_PUBLIC_ENCRYPT                     104
 # define RSA_F_RSA_GENERATE_KEY                           105
 # define RSA_F_RSA_GENERATE_KEY_EX                        155
+# define RSA_F_RSA_GENERATE_MULTI_PRIME_KEY               163
 # define RSA_F_RSA_ITEM_VERIFY                            156
 # define RSA_F_RSA_MEMORY_LOCK                            130
 # define RSA_F_RSA_MGF1_TO_MD                             159
@@ -523,11 +559,16 @@ VIGORTLS_EXPORT void ERR_load_RSA_strings(void);
 # define RSA_R_INVALID_TRAILER                            139
 # define RSA_R_INVALID_X931_DIGEST                        142
 # define RSA_R_IQMP_NOT_INVERSE_OF_Q                      126
+# define RSA_R_KEY_PRIME_NUM_INVALID                      166
 # define RSA_R_KEY_SIZE_TOO_SMALL                         120
 # define RSA_R_LAST_OCTET_INVALID                         134
 # define RSA_R_MODULUS_TOO_LARGE                          105
+# define RSA_R_MP_COEFFICIENT_NOT_INVERSE_OF_R            167
+# define RSA_R_MP_EXPONENT_NOT_CONGRUENT_TO_D             168
+# define RSA_R_MP_R_NOT_PRIME                             169
 # define RSA_R_NO_PUBLIC_EXPONENT                         140
 # define RSA_R_NULL_BEFORE_BLOCK_MISSING                  113
+# define RSA_R_N_DOES_NOT_EQUAL_PRODUCT_OF_PRIMES         170
 # define RSA_R_N_DOES_NOT_EQUAL_P_Q                       127
 # define RSA_R_OAEP_DECODING_ERROR                        121
 # define RSA_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE   148
@@ -38,6 +38,10 @@ extern "C" {
     ((int (*)(const void *, const void *))( \
         (1 ? p : (int (*)(const type *const *, const type *const *))0)))
 
+#define CHECKED_SK_HASH_FUNC(type, p)    \
+    ((unsigned long (*)(const void *))( \
+        (1 ? p : (unsigned long (*)(const type *))0)))
+
 #define STACK_OF(type) struct stack_st_##type
 #define PREDECLARE_STACK_OF(type) STACK_OF(type);
 
@@ -114,6 +118,9 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define SKM_sk_set_cmp_func(type, st, cmp)                               \
     ((int (*)(const type *const *, const type *const *))sk_set_cmp_func( \
         CHECKED_STACK_OF(type, st), CHECKED_SK_CMP_FUNC(type, cmp)))
+#define SKM_sk_set_hash_func(type, st, hash) \
+    sk_set_hash_func(CHECKED_STACK_OF(type, st), \
+                     CHECKED_SK_HASH_FUNC(type, hash))
 #define SKM_sk_dup(type, st) \
     (STACK_OF(type) *) sk_dup(CHECKED_STACK_OF(type, st))
 #define SKM_sk_pop_free(type, st, free_func) \
@@ -176,6 +183,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ACCESS_DESCRIPTION, (st), (val), (i))
 #define sk_ACCESS_DESCRIPTION_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ACCESS_DESCRIPTION, (st), (cmp))
+#define sk_ACCESS_DESCRIPTION_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ACCESS_DESCRIPTION, (st), (hash))
 #define sk_ACCESS_DESCRIPTION_dup(st) SKM_sk_dup(ACCESS_DESCRIPTION, st)
 #define sk_ACCESS_DESCRIPTION_pop_free(st, free_func) \
     SKM_sk_pop_free(ACCESS_DESCRIPTION, (st), (free_func))
@@ -212,6 +221,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_GENERALSTRING, (st), (val), (i))
 #define sk_ASN1_GENERALSTRING_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_GENERALSTRING, (st), (cmp))
+#define sk_ASN1_GENERALSTRING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_GENERALSTRING, (st), (hash))
 #define sk_ASN1_GENERALSTRING_dup(st) SKM_sk_dup(ASN1_GENERALSTRING, st)
 #define sk_ASN1_GENERALSTRING_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_GENERALSTRING, (st), (free_func))
@@ -244,6 +255,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_INTEGER, (st), (val), (i))
 #define sk_ASN1_INTEGER_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_INTEGER, (st), (cmp))
+#define sk_ASN1_INTEGER_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_INTEGER, (st), (hash))
 #define sk_ASN1_INTEGER_dup(st) SKM_sk_dup(ASN1_INTEGER, st)
 #define sk_ASN1_INTEGER_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_INTEGER, (st), (free_func))
@@ -272,6 +285,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_OBJECT, (st), (val), (i))
 #define sk_ASN1_OBJECT_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_OBJECT, (st), (cmp))
+#define sk_ASN1_OBJECT_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_OBJECT, (st), (hash))
 #define sk_ASN1_OBJECT_dup(st) SKM_sk_dup(ASN1_OBJECT, st)
 #define sk_ASN1_OBJECT_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_OBJECT, (st), (free_func))
@@ -307,6 +322,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_STRING_TABLE, (st), (val), (i))
 #define sk_ASN1_STRING_TABLE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_STRING_TABLE, (st), (cmp))
+#define sk_ASN1_STRING_TABLE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_STRING_TABLE, (st), (hash))
 #define sk_ASN1_STRING_TABLE_dup(st) SKM_sk_dup(ASN1_STRING_TABLE, st)
 #define sk_ASN1_STRING_TABLE_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_STRING_TABLE, (st), (free_func))
@@ -336,6 +353,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_TYPE, (st), (val), (i))
 #define sk_ASN1_TYPE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_TYPE, (st), (cmp))
+#define sk_ASN1_TYPE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_TYPE, (st), (hash))
 #define sk_ASN1_TYPE_dup(st) SKM_sk_dup(ASN1_TYPE, st)
 #define sk_ASN1_TYPE_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_TYPE, (st), (free_func))
@@ -370,6 +389,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_UTF8STRING, (st), (val), (i))
 #define sk_ASN1_UTF8STRING_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_UTF8STRING, (st), (cmp))
+#define sk_ASN1_UTF8STRING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_UTF8STRING, (st), (hash))
 #define sk_ASN1_UTF8STRING_dup(st) SKM_sk_dup(ASN1_UTF8STRING, st)
 #define sk_ASN1_UTF8STRING_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_UTF8STRING, (st), (free_func))
@@ -398,6 +419,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ASN1_VALUE, (st), (val), (i))
 #define sk_ASN1_VALUE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ASN1_VALUE, (st), (cmp))
+#define sk_ASN1_VALUE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ASN1_VALUE, (st), (hash))
 #define sk_ASN1_VALUE_dup(st) SKM_sk_dup(ASN1_VALUE, st)
 #define sk_ASN1_VALUE_pop_free(st, free_func) \
     SKM_sk_pop_free(ASN1_VALUE, (st), (free_func))
@@ -423,6 +446,7 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_BIO_delete_ptr(st, ptr) SKM_sk_delete_ptr(BIO, (st), (ptr))
 #define sk_BIO_insert(st, val, i) SKM_sk_insert(BIO, (st), (val), (i))
 #define sk_BIO_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(BIO, (st), (cmp))
+#define sk_BIO_set_hash_func(st, hash) SKM_sk_set_hash_func(BIO, (st), (hash))
 #define sk_BIO_dup(st) SKM_sk_dup(BIO, st)
 #define sk_BIO_pop_free(st, free_func) SKM_sk_pop_free(BIO, (st), (free_func))
 #define sk_BIO_deep_copy(st, copy_func, free_func) \
@@ -453,6 +477,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(BY_DIR_ENTRY, (st), (val), (i))
 #define sk_BY_DIR_ENTRY_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(BY_DIR_ENTRY, (st), (cmp))
+#define sk_BY_DIR_ENTRY_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(BY_DIR_ENTRY, (st), (hash))
 #define sk_BY_DIR_ENTRY_dup(st) SKM_sk_dup(BY_DIR_ENTRY, st)
 #define sk_BY_DIR_ENTRY_pop_free(st, free_func) \
     SKM_sk_pop_free(BY_DIR_ENTRY, (st), (free_func))
@@ -481,6 +507,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(BY_DIR_HASH, (st), (val), (i))
 #define sk_BY_DIR_HASH_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(BY_DIR_HASH, (st), (cmp))
+#define sk_BY_DIR_HASH_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(BY_DIR_HASH, (st), (hash))
 #define sk_BY_DIR_HASH_dup(st) SKM_sk_dup(BY_DIR_HASH, st)
 #define sk_BY_DIR_HASH_pop_free(st, free_func) \
     SKM_sk_pop_free(BY_DIR_HASH, (st), (free_func))
@@ -521,6 +549,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CMS_CertificateChoices, (st), (val), (i))
 #define sk_CMS_CertificateChoices_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CMS_CertificateChoices, (st), (cmp))
+#define sk_CMS_CertificateChoices_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CMS_CertificateChoices, (st), (hash))
 #define sk_CMS_CertificateChoices_dup(st) SKM_sk_dup(CMS_CertificateChoices, st)
 #define sk_CMS_CertificateChoices_pop_free(st, free_func) \
     SKM_sk_pop_free(CMS_CertificateChoices, (st), (free_func))
@@ -565,6 +595,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CMS_RecipientEncryptedKey, (st), (val), (i))
 #define sk_CMS_RecipientEncryptedKey_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CMS_RecipientEncryptedKey, (st), (cmp))
+#define sk_CMS_RecipientEncryptedKey_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CMS_RecipientEncryptedKey, (st), (hash))
 #define sk_CMS_RecipientEncryptedKey_dup(st) \
     SKM_sk_dup(CMS_RecipientEncryptedKey, st)
 #define sk_CMS_RecipientEncryptedKey_pop_free(st, free_func) \
@@ -605,6 +637,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CMS_RecipientInfo, (st), (val), (i))
 #define sk_CMS_RecipientInfo_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CMS_RecipientInfo, (st), (cmp))
+#define sk_CMS_RecipientInfo_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CMS_RecipientInfo, (st), (hash))
 #define sk_CMS_RecipientInfo_dup(st) SKM_sk_dup(CMS_RecipientInfo, st)
 #define sk_CMS_RecipientInfo_pop_free(st, free_func) \
     SKM_sk_pop_free(CMS_RecipientInfo, (st), (free_func))
@@ -646,6 +680,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CMS_RevocationInfoChoice, (st), (val), (i))
 #define sk_CMS_RevocationInfoChoice_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CMS_RevocationInfoChoice, (st), (cmp))
+#define sk_CMS_RevocationInfoChoice_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CMS_RevocationInfoChoice, (st), (hash))
 #define sk_CMS_RevocationInfoChoice_dup(st) \
     SKM_sk_dup(CMS_RevocationInfoChoice, st)
 #define sk_CMS_RevocationInfoChoice_pop_free(st, free_func) \
@@ -682,6 +718,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CMS_SignerInfo, (st), (val), (i))
 #define sk_CMS_SignerInfo_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CMS_SignerInfo, (st), (cmp))
+#define sk_CMS_SignerInfo_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CMS_SignerInfo, (st), (hash))
 #define sk_CMS_SignerInfo_dup(st) SKM_sk_dup(CMS_SignerInfo, st)
 #define sk_CMS_SignerInfo_pop_free(st, free_func) \
     SKM_sk_pop_free(CMS_SignerInfo, (st), (free_func))
@@ -713,6 +751,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CONF_IMODULE, (st), (val), (i))
 #define sk_CONF_IMODULE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CONF_IMODULE, (st), (cmp))
+#define sk_CONF_IMODULE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CONF_IMODULE, (st), (hash))
 #define sk_CONF_IMODULE_dup(st) SKM_sk_dup(CONF_IMODULE, st)
 #define sk_CONF_IMODULE_pop_free(st, free_func) \
     SKM_sk_pop_free(CONF_IMODULE, (st), (free_func))
@@ -741,6 +781,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CONF_MODULE, (st), (val), (i))
 #define sk_CONF_MODULE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CONF_MODULE, (st), (cmp))
+#define sk_CONF_MODULE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CONF_MODULE, (st), (hash))
 #define sk_CONF_MODULE_dup(st) SKM_sk_dup(CONF_MODULE, st)
 #define sk_CONF_MODULE_pop_free(st, free_func) \
     SKM_sk_pop_free(CONF_MODULE, (st), (free_func))
@@ -769,6 +811,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CONF_VALUE, (st), (val), (i))
 #define sk_CONF_VALUE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CONF_VALUE, (st), (cmp))
+#define sk_CONF_VALUE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CONF_VALUE, (st), (hash))
 #define sk_CONF_VALUE_dup(st) SKM_sk_dup(CONF_VALUE, st)
 #define sk_CONF_VALUE_pop_free(st, free_func) \
     SKM_sk_pop_free(CONF_VALUE, (st), (free_func))
@@ -804,6 +848,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(CRYPTO_EX_DATA_FUNCS, (st), (val), (i))
 #define sk_CRYPTO_EX_DATA_FUNCS_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(CRYPTO_EX_DATA_FUNCS, (st), (cmp))
+#define sk_CRYPTO_EX_DATA_FUNCS_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(CRYPTO_EX_DATA_FUNCS, (st), (hash))
 #define sk_CRYPTO_EX_DATA_FUNCS_dup(st) SKM_sk_dup(CRYPTO_EX_DATA_FUNCS, st)
 #define sk_CRYPTO_EX_DATA_FUNCS_pop_free(st, free_func) \
     SKM_sk_pop_free(CRYPTO_EX_DATA_FUNCS, (st), (free_func))
@@ -834,6 +880,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(DIST_POINT, (st), (val), (i))
 #define sk_DIST_POINT_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(DIST_POINT, (st), (cmp))
+#define sk_DIST_POINT_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(DIST_POINT, (st), (hash))
 #define sk_DIST_POINT_dup(st) SKM_sk_dup(DIST_POINT, st)
 #define sk_DIST_POINT_pop_free(st, free_func) \
     SKM_sk_pop_free(DIST_POINT, (st), (free_func))
@@ -859,6 +907,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_ENGINE_delete_ptr(st, ptr) SKM_sk_delete_ptr(ENGINE, (st), (ptr))
 #define sk_ENGINE_insert(st, val, i) SKM_sk_insert(ENGINE, (st), (val), (i))
 #define sk_ENGINE_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(ENGINE, (st), (cmp))
+#define sk_ENGINE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ENGINE, (st), (hash))
 #define sk_ENGINE_dup(st) SKM_sk_dup(ENGINE, st)
 #define sk_ENGINE_pop_free(st, free_func) \
     SKM_sk_pop_free(ENGINE, (st), (free_func))
@@ -894,6 +944,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ENGINE_CLEANUP_ITEM, (st), (val), (i))
 #define sk_ENGINE_CLEANUP_ITEM_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ENGINE_CLEANUP_ITEM, (st), (cmp))
+#define sk_ENGINE_CLEANUP_ITEM_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ENGINE_CLEANUP_ITEM, (st), (hash))
 #define sk_ENGINE_CLEANUP_ITEM_dup(st) SKM_sk_dup(ENGINE_CLEANUP_ITEM, st)
 #define sk_ENGINE_CLEANUP_ITEM_pop_free(st, free_func) \
     SKM_sk_pop_free(ENGINE_CLEANUP_ITEM, (st), (free_func))
@@ -923,6 +975,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(ESS_CERT_ID, (st), (val), (i))
 #define sk_ESS_CERT_ID_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(ESS_CERT_ID, (st), (cmp))
+#define sk_ESS_CERT_ID_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(ESS_CERT_ID, (st), (hash))
 #define sk_ESS_CERT_ID_dup(st) SKM_sk_dup(ESS_CERT_ID, st)
 #define sk_ESS_CERT_ID_pop_free(st, free_func) \
     SKM_sk_pop_free(ESS_CERT_ID, (st), (free_func))
@@ -948,6 +1002,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_EVP_MD_delete_ptr(st, ptr) SKM_sk_delete_ptr(EVP_MD, (st), (ptr))
 #define sk_EVP_MD_insert(st, val, i) SKM_sk_insert(EVP_MD, (st), (val), (i))
 #define sk_EVP_MD_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(EVP_MD, (st), (cmp))
+#define sk_EVP_MD_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(EVP_MD, (st), (hash))
 #define sk_EVP_MD_dup(st) SKM_sk_dup(EVP_MD, st)
 #define sk_EVP_MD_pop_free(st, free_func) \
     SKM_sk_pop_free(EVP_MD, (st), (free_func))
@@ -976,6 +1032,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(EVP_PBE_CTL, (st), (val), (i))
 #define sk_EVP_PBE_CTL_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(EVP_PBE_CTL, (st), (cmp))
+#define sk_EVP_PBE_CTL_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(EVP_PBE_CTL, (st), (hash))
 #define sk_EVP_PBE_CTL_dup(st) SKM_sk_dup(EVP_PBE_CTL, st)
 #define sk_EVP_PBE_CTL_pop_free(st, free_func) \
     SKM_sk_pop_free(EVP_PBE_CTL, (st), (free_func))
@@ -1011,6 +1069,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(EVP_PKEY_ASN1_METHOD, (st), (val), (i))
 #define sk_EVP_PKEY_ASN1_METHOD_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(EVP_PKEY_ASN1_METHOD, (st), (cmp))
+#define sk_EVP_PKEY_ASN1_METHOD_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(EVP_PKEY_ASN1_METHOD, (st), (hash))
 #define sk_EVP_PKEY_ASN1_METHOD_dup(st) SKM_sk_dup(EVP_PKEY_ASN1_METHOD, st)
 #define sk_EVP_PKEY_ASN1_METHOD_pop_free(st, free_func) \
     SKM_sk_pop_free(EVP_PKEY_ASN1_METHOD, (st), (free_func))
@@ -1047,6 +1107,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(EVP_PKEY_METHOD, (st), (val), (i))
 #define sk_EVP_PKEY_METHOD_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(EVP_PKEY_METHOD, (st), (cmp))
+#define sk_EVP_PKEY_METHOD_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(EVP_PKEY_METHOD, (st), (hash))
 #define sk_EVP_PKEY_METHOD_dup(st) SKM_sk_dup(EVP_PKEY_METHOD, st)
 #define sk_EVP_PKEY_METHOD_pop_free(st, free_func) \
     SKM_sk_pop_free(EVP_PKEY_METHOD, (st), (free_func))
@@ -1078,6 +1140,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(GENERAL_NAME, (st), (val), (i))
 #define sk_GENERAL_NAME_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(GENERAL_NAME, (st), (cmp))
+#define sk_GENERAL_NAME_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(GENERAL_NAME, (st), (hash))
 #define sk_GENERAL_NAME_dup(st) SKM_sk_dup(GENERAL_NAME, st)
 #define sk_GENERAL_NAME_pop_free(st, free_func) \
     SKM_sk_pop_free(GENERAL_NAME, (st), (free_func))
@@ -1109,6 +1173,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(GENERAL_NAMES, (st), (val), (i))
 #define sk_GENERAL_NAMES_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(GENERAL_NAMES, (st), (cmp))
+#define sk_GENERAL_NAMES_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(GENERAL_NAMES, (st), (hash))
 #define sk_GENERAL_NAMES_dup(st) SKM_sk_dup(GENERAL_NAMES, st)
 #define sk_GENERAL_NAMES_pop_free(st, free_func) \
     SKM_sk_pop_free(GENERAL_NAMES, (st), (free_func))
@@ -1143,6 +1209,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(GENERAL_SUBTREE, (st), (val), (i))
 #define sk_GENERAL_SUBTREE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(GENERAL_SUBTREE, (st), (cmp))
+#define sk_GENERAL_SUBTREE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(GENERAL_SUBTREE, (st), (hash))
 #define sk_GENERAL_SUBTREE_dup(st) SKM_sk_dup(GENERAL_SUBTREE, st)
 #define sk_GENERAL_SUBTREE_pop_free(st, free_func) \
     SKM_sk_pop_free(GENERAL_SUBTREE, (st), (free_func))
@@ -1171,6 +1239,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(MIME_HEADER, (st), (val), (i))
 #define sk_MIME_HEADER_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(MIME_HEADER, (st), (cmp))
+#define sk_MIME_HEADER_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(MIME_HEADER, (st), (hash))
 #define sk_MIME_HEADER_dup(st) SKM_sk_dup(MIME_HEADER, st)
 #define sk_MIME_HEADER_pop_free(st, free_func) \
     SKM_sk_pop_free(MIME_HEADER, (st), (free_func))
@@ -1199,6 +1269,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(MIME_PARAM, (st), (val), (i))
 #define sk_MIME_PARAM_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(MIME_PARAM, (st), (cmp))
+#define sk_MIME_PARAM_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(MIME_PARAM, (st), (hash))
 #define sk_MIME_PARAM_dup(st) SKM_sk_dup(MIME_PARAM, st)
 #define sk_MIME_PARAM_pop_free(st, free_func) \
     SKM_sk_pop_free(MIME_PARAM, (st), (free_func))
@@ -1227,6 +1299,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(NAME_FUNCS, (st), (val), (i))
 #define sk_NAME_FUNCS_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(NAME_FUNCS, (st), (cmp))
+#define sk_NAME_FUNCS_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(NAME_FUNCS, (st), (hash))
 #define sk_NAME_FUNCS_dup(st) SKM_sk_dup(NAME_FUNCS, st)
 #define sk_NAME_FUNCS_pop_free(st, free_func) \
     SKM_sk_pop_free(NAME_FUNCS, (st), (free_func))
@@ -1255,6 +1329,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(OCSP_CERTID, (st), (val), (i))
 #define sk_OCSP_CERTID_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(OCSP_CERTID, (st), (cmp))
+#define sk_OCSP_CERTID_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OCSP_CERTID, (st), (hash))
 #define sk_OCSP_CERTID_dup(st) SKM_sk_dup(OCSP_CERTID, st)
 #define sk_OCSP_CERTID_pop_free(st, free_func) \
     SKM_sk_pop_free(OCSP_CERTID, (st), (free_func))
@@ -1283,6 +1359,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(OCSP_ONEREQ, (st), (val), (i))
 #define sk_OCSP_ONEREQ_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(OCSP_ONEREQ, (st), (cmp))
+#define sk_OCSP_ONEREQ_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OCSP_ONEREQ, (st), (hash))
 #define sk_OCSP_ONEREQ_dup(st) SKM_sk_dup(OCSP_ONEREQ, st)
 #define sk_OCSP_ONEREQ_pop_free(st, free_func) \
     SKM_sk_pop_free(OCSP_ONEREQ, (st), (free_func))
@@ -1311,6 +1389,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(OCSP_RESPID, (st), (val), (i))
 #define sk_OCSP_RESPID_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(OCSP_RESPID, (st), (cmp))
+#define sk_OCSP_RESPID_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OCSP_RESPID, (st), (hash))
 #define sk_OCSP_RESPID_dup(st) SKM_sk_dup(OCSP_RESPID, st)
 #define sk_OCSP_RESPID_pop_free(st, free_func) \
     SKM_sk_pop_free(OCSP_RESPID, (st), (free_func))
@@ -1345,6 +1425,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(OCSP_SINGLERESP, (st), (val), (i))
 #define sk_OCSP_SINGLERESP_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(OCSP_SINGLERESP, (st), (cmp))
+#define sk_OCSP_SINGLERESP_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OCSP_SINGLERESP, (st), (hash))
 #define sk_OCSP_SINGLERESP_dup(st) SKM_sk_dup(OCSP_SINGLERESP, st)
 #define sk_OCSP_SINGLERESP_pop_free(st, free_func) \
     SKM_sk_pop_free(OCSP_SINGLERESP, (st), (free_func))
@@ -1376,6 +1458,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(PKCS12_SAFEBAG, (st), (val), (i))
 #define sk_PKCS12_SAFEBAG_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(PKCS12_SAFEBAG, (st), (cmp))
+#define sk_PKCS12_SAFEBAG_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(PKCS12_SAFEBAG, (st), (hash))
 #define sk_PKCS12_SAFEBAG_dup(st) SKM_sk_dup(PKCS12_SAFEBAG, st)
 #define sk_PKCS12_SAFEBAG_pop_free(st, free_func) \
     SKM_sk_pop_free(PKCS12_SAFEBAG, (st), (free_func))
@@ -1401,6 +1485,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_PKCS7_delete_ptr(st, ptr) SKM_sk_delete_ptr(PKCS7, (st), (ptr))
 #define sk_PKCS7_insert(st, val, i) SKM_sk_insert(PKCS7, (st), (val), (i))
 #define sk_PKCS7_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(PKCS7, (st), (cmp))
+#define sk_PKCS7_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(PKCS7, (st), (hash))
 #define sk_PKCS7_dup(st) SKM_sk_dup(PKCS7, st)
 #define sk_PKCS7_pop_free(st, free_func) \
     SKM_sk_pop_free(PKCS7, (st), (free_func))
@@ -1436,6 +1522,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(PKCS7_RECIP_INFO, (st), (val), (i))
 #define sk_PKCS7_RECIP_INFO_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(PKCS7_RECIP_INFO, (st), (cmp))
+#define sk_PKCS7_RECIP_INFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(PKCS7_RECIP_INFO, (st), (hash))
 #define sk_PKCS7_RECIP_INFO_dup(st) SKM_sk_dup(PKCS7_RECIP_INFO, st)
 #define sk_PKCS7_RECIP_INFO_pop_free(st, free_func) \
     SKM_sk_pop_free(PKCS7_RECIP_INFO, (st), (free_func))
@@ -1472,6 +1560,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(PKCS7_SIGNER_INFO, (st), (val), (i))
 #define sk_PKCS7_SIGNER_INFO_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(PKCS7_SIGNER_INFO, (st), (cmp))
+#define sk_PKCS7_SIGNER_INFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(PKCS7_SIGNER_INFO, (st), (hash))
 #define sk_PKCS7_SIGNER_INFO_dup(st) SKM_sk_dup(PKCS7_SIGNER_INFO, st)
 #define sk_PKCS7_SIGNER_INFO_pop_free(st, free_func) \
     SKM_sk_pop_free(PKCS7_SIGNER_INFO, (st), (free_func))
@@ -1501,6 +1591,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(POLICYINFO, (st), (val), (i))
 #define sk_POLICYINFO_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(POLICYINFO, (st), (cmp))
+#define sk_POLICYINFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(POLICYINFO, (st), (hash))
 #define sk_POLICYINFO_dup(st) SKM_sk_dup(POLICYINFO, st)
 #define sk_POLICYINFO_pop_free(st, free_func) \
     SKM_sk_pop_free(POLICYINFO, (st), (free_func))
@@ -1532,6 +1624,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(POLICYQUALINFO, (st), (val), (i))
 #define sk_POLICYQUALINFO_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(POLICYQUALINFO, (st), (cmp))
+#define sk_POLICYQUALINFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(POLICYQUALINFO, (st), (hash))
 #define sk_POLICYQUALINFO_dup(st) SKM_sk_dup(POLICYQUALINFO, st)
 #define sk_POLICYQUALINFO_pop_free(st, free_func) \
     SKM_sk_pop_free(POLICYQUALINFO, (st), (free_func))
@@ -1563,6 +1657,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(POLICY_MAPPING, (st), (val), (i))
 #define sk_POLICY_MAPPING_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(POLICY_MAPPING, (st), (cmp))
+#define sk_POLICY_MAPPING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(POLICY_MAPPING, (st), (hash))
 #define sk_POLICY_MAPPING_dup(st) SKM_sk_dup(POLICY_MAPPING, st)
 #define sk_POLICY_MAPPING_pop_free(st, free_func) \
     SKM_sk_pop_free(POLICY_MAPPING, (st), (free_func))
@@ -1573,6 +1669,39 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_POLICY_MAPPING_sort(st) SKM_sk_sort(POLICY_MAPPING, (st))
 #define sk_POLICY_MAPPING_is_sorted(st) SKM_sk_is_sorted(POLICY_MAPPING, (st))
 
+#define sk_RSA_PRIME_INFO_new(cmp) SKM_sk_new(RSA_PRIME_INFO, (cmp))
+#define sk_RSA_PRIME_INFO_new_null() SKM_sk_new_null(RSA_PRIME_INFO)
+#define sk_RSA_PRIME_INFO_free(st) SKM_sk_free(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_num(st) SKM_sk_num(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_value(st, i) SKM_sk_value(RSA_PRIME_INFO, (st), (i))
+#define sk_RSA_PRIME_INFO_set(st, i, val) \
+    SKM_sk_set(RSA_PRIME_INFO, (st), (i), (val))
+#define sk_RSA_PRIME_INFO_zero(st) SKM_sk_zero(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_push(st, val) SKM_sk_push(RSA_PRIME_INFO, (st), (val))
+#define sk_RSA_PRIME_INFO_unshift(st, val) \
+    SKM_sk_unshift(RSA_PRIME_INFO, (st), (val))
+#define sk_RSA_PRIME_INFO_find(st, val) SKM_sk_find(RSA_PRIME_INFO, (st), (val))
+#define sk_RSA_PRIME_INFO_find_ex(st, val) \
+    SKM_sk_find_ex(RSA_PRIME_INFO, (st), (val))
+#define sk_RSA_PRIME_INFO_delete(st, i) SKM_sk_delete(RSA_PRIME_INFO, (st), (i))
+#define sk_RSA_PRIME_INFO_delete_ptr(st, ptr) \
+    SKM_sk_delete_ptr(RSA_PRIME_INFO, (st), (ptr))
+#define sk_RSA_PRIME_INFO_insert(st, val, i) \
+    SKM_sk_insert(RSA_PRIME_INFO, (st), (val), (i))
+#define sk_RSA_PRIME_INFO_set_cmp_func(st, cmp) \
+    SKM_sk_set_cmp_func(RSA_PRIME_INFO, (st), (cmp))
+#define sk_RSA_PRIME_INFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(RSA_PRIME_INFO, (st), (hash))
+#define sk_RSA_PRIME_INFO_dup(st) SKM_sk_dup(RSA_PRIME_INFO, st)
+#define sk_RSA_PRIME_INFO_pop_free(st, free_func) \
+    SKM_sk_pop_free(RSA_PRIME_INFO, (st), (free_func))
+#define sk_RSA_PRIME_INFO_deep_copy(st, copy_func, free_func) \
+    SKM_sk_deep_copy(RSA_PRIME_INFO, (st), (copy_func), (free_func))
+#define sk_RSA_PRIME_INFO_shift(st) SKM_sk_shift(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_pop(st) SKM_sk_pop(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_sort(st) SKM_sk_sort(RSA_PRIME_INFO, (st))
+#define sk_RSA_PRIME_INFO_is_sorted(st) SKM_sk_is_sorted(RSA_PRIME_INFO, (st))
+
 #define sk_SCT_new(cmp) SKM_sk_new(SCT, (cmp))
 #define sk_SCT_new_null() SKM_sk_new_null(SCT)
 #define sk_SCT_free(st) SKM_sk_free(SCT, (st))
@@ -1588,6 +1717,7 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_SCT_delete_ptr(st, ptr) SKM_sk_delete_ptr(SCT, (st), (ptr))
 #define sk_SCT_insert(st, val, i) SKM_sk_insert(SCT, (st), (val), (i))
 #define sk_SCT_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(SCT, (st), (cmp))
+#define sk_SCT_set_hash_func(st, hash) SKM_sk_set_hash_func(SCT, (st), (hash))
 #define sk_SCT_dup(st) SKM_sk_dup(SCT, st)
 #define sk_SCT_pop_free(st, free_func) SKM_sk_pop_free(SCT, (st), (free_func))
 #define sk_SCT_deep_copy(st, copy_func, free_func) \
@@ -1627,6 +1757,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(SRTP_PROTECTION_PROFILE, (st), (val), (i))
 #define sk_SRTP_PROTECTION_PROFILE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(SRTP_PROTECTION_PROFILE, (st), (cmp))
+#define sk_SRTP_PROTECTION_PROFILE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(SRTP_PROTECTION_PROFILE, (st), (hash))
 #define sk_SRTP_PROTECTION_PROFILE_dup(st) \
     SKM_sk_dup(SRTP_PROTECTION_PROFILE, st)
 #define sk_SRTP_PROTECTION_PROFILE_pop_free(st, free_func) \
@@ -1660,6 +1792,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(SSL_CIPHER, (st), (val), (i))
 #define sk_SSL_CIPHER_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(SSL_CIPHER, (st), (cmp))
+#define sk_SSL_CIPHER_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(SSL_CIPHER, (st), (hash))
 #define sk_SSL_CIPHER_dup(st) SKM_sk_dup(SSL_CIPHER, st)
 #define sk_SSL_CIPHER_pop_free(st, free_func) \
     SKM_sk_pop_free(SSL_CIPHER, (st), (free_func))
@@ -1686,6 +1820,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_SSL_COMP_insert(st, val, i) SKM_sk_insert(SSL_COMP, (st), (val), (i))
 #define sk_SSL_COMP_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(SSL_COMP, (st), (cmp))
+#define sk_SSL_COMP_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(SSL_COMP, (st), (hash))
 #define sk_SSL_COMP_dup(st) SKM_sk_dup(SSL_COMP, st)
 #define sk_SSL_COMP_pop_free(st, free_func) \
     SKM_sk_pop_free(SSL_COMP, (st), (free_func))
@@ -1726,6 +1862,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(STACK_OF_X509_NAME_ENTRY, (st), (val), (i))
 #define sk_STACK_OF_X509_NAME_ENTRY_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(STACK_OF_X509_NAME_ENTRY, (st), (cmp))
+#define sk_STACK_OF_X509_NAME_ENTRY_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(STACK_OF_X509_NAME_ENTRY, (st), (hash))
 #define sk_STACK_OF_X509_NAME_ENTRY_dup(st) \
     SKM_sk_dup(STACK_OF_X509_NAME_ENTRY, st)
 #define sk_STACK_OF_X509_NAME_ENTRY_pop_free(st, free_func) \
@@ -1757,6 +1895,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_SXNETID_insert(st, val, i) SKM_sk_insert(SXNETID, (st), (val), (i))
 #define sk_SXNETID_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(SXNETID, (st), (cmp))
+#define sk_SXNETID_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(SXNETID, (st), (hash))
 #define sk_SXNETID_dup(st) SKM_sk_dup(SXNETID, st)
 #define sk_SXNETID_pop_free(st, free_func) \
     SKM_sk_pop_free(SXNETID, (st), (free_func))
@@ -1785,6 +1925,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(UI_STRING, (st), (val), (i))
 #define sk_UI_STRING_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(UI_STRING, (st), (cmp))
+#define sk_UI_STRING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(UI_STRING, (st), (hash))
 #define sk_UI_STRING_dup(st) SKM_sk_dup(UI_STRING, st)
 #define sk_UI_STRING_pop_free(st, free_func) \
     SKM_sk_pop_free(UI_STRING, (st), (free_func))
@@ -1810,6 +1952,7 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_X509_delete_ptr(st, ptr) SKM_sk_delete_ptr(X509, (st), (ptr))
 #define sk_X509_insert(st, val, i) SKM_sk_insert(X509, (st), (val), (i))
 #define sk_X509_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(X509, (st), (cmp))
+#define sk_X509_set_hash_func(st, hash) SKM_sk_set_hash_func(X509, (st), (hash))
 #define sk_X509_dup(st) SKM_sk_dup(X509, st)
 #define sk_X509_pop_free(st, free_func) SKM_sk_pop_free(X509, (st), (free_func))
 #define sk_X509_deep_copy(st, copy_func, free_func) \
@@ -1844,6 +1987,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509V3_EXT_METHOD, (st), (val), (i))
 #define sk_X509V3_EXT_METHOD_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509V3_EXT_METHOD, (st), (cmp))
+#define sk_X509V3_EXT_METHOD_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509V3_EXT_METHOD, (st), (hash))
 #define sk_X509V3_EXT_METHOD_dup(st) SKM_sk_dup(X509V3_EXT_METHOD, st)
 #define sk_X509V3_EXT_METHOD_pop_free(st, free_func) \
     SKM_sk_pop_free(X509V3_EXT_METHOD, (st), (free_func))
@@ -1873,6 +2018,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_ALGOR, (st), (val), (i))
 #define sk_X509_ALGOR_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_ALGOR, (st), (cmp))
+#define sk_X509_ALGOR_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_ALGOR, (st), (hash))
 #define sk_X509_ALGOR_dup(st) SKM_sk_dup(X509_ALGOR, st)
 #define sk_X509_ALGOR_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_ALGOR, (st), (free_func))
@@ -1904,6 +2051,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_ATTRIBUTE, (st), (val), (i))
 #define sk_X509_ATTRIBUTE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_ATTRIBUTE, (st), (cmp))
+#define sk_X509_ATTRIBUTE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_ATTRIBUTE, (st), (hash))
 #define sk_X509_ATTRIBUTE_dup(st) SKM_sk_dup(X509_ATTRIBUTE, st)
 #define sk_X509_ATTRIBUTE_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_ATTRIBUTE, (st), (free_func))
@@ -1930,6 +2079,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_X509_CRL_insert(st, val, i) SKM_sk_insert(X509_CRL, (st), (val), (i))
 #define sk_X509_CRL_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_CRL, (st), (cmp))
+#define sk_X509_CRL_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_CRL, (st), (hash))
 #define sk_X509_CRL_dup(st) SKM_sk_dup(X509_CRL, st)
 #define sk_X509_CRL_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_CRL, (st), (free_func))
@@ -1961,6 +2112,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_EXTENSION, (st), (val), (i))
 #define sk_X509_EXTENSION_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_EXTENSION, (st), (cmp))
+#define sk_X509_EXTENSION_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_EXTENSION, (st), (hash))
 #define sk_X509_EXTENSION_dup(st) SKM_sk_dup(X509_EXTENSION, st)
 #define sk_X509_EXTENSION_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_EXTENSION, (st), (free_func))
@@ -1989,6 +2142,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_INFO, (st), (val), (i))
 #define sk_X509_INFO_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_INFO, (st), (cmp))
+#define sk_X509_INFO_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_INFO, (st), (hash))
 #define sk_X509_INFO_dup(st) SKM_sk_dup(X509_INFO, st)
 #define sk_X509_INFO_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_INFO, (st), (free_func))
@@ -2017,6 +2172,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_LOOKUP, (st), (val), (i))
 #define sk_X509_LOOKUP_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_LOOKUP, (st), (cmp))
+#define sk_X509_LOOKUP_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_LOOKUP, (st), (hash))
 #define sk_X509_LOOKUP_dup(st) SKM_sk_dup(X509_LOOKUP, st)
 #define sk_X509_LOOKUP_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_LOOKUP, (st), (free_func))
@@ -2045,6 +2202,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_NAME, (st), (val), (i))
 #define sk_X509_NAME_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_NAME, (st), (cmp))
+#define sk_X509_NAME_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_NAME, (st), (hash))
 #define sk_X509_NAME_dup(st) SKM_sk_dup(X509_NAME, st)
 #define sk_X509_NAME_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_NAME, (st), (free_func))
@@ -2079,6 +2238,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_NAME_ENTRY, (st), (val), (i))
 #define sk_X509_NAME_ENTRY_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_NAME_ENTRY, (st), (cmp))
+#define sk_X509_NAME_ENTRY_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_NAME_ENTRY, (st), (hash))
 #define sk_X509_NAME_ENTRY_dup(st) SKM_sk_dup(X509_NAME_ENTRY, st)
 #define sk_X509_NAME_ENTRY_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_NAME_ENTRY, (st), (free_func))
@@ -2107,6 +2268,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_OBJECT, (st), (val), (i))
 #define sk_X509_OBJECT_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_OBJECT, (st), (cmp))
+#define sk_X509_OBJECT_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_OBJECT, (st), (hash))
 #define sk_X509_OBJECT_dup(st) SKM_sk_dup(X509_OBJECT, st)
 #define sk_X509_OBJECT_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_OBJECT, (st), (free_func))
@@ -2142,6 +2305,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_POLICY_DATA, (st), (val), (i))
 #define sk_X509_POLICY_DATA_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_POLICY_DATA, (st), (cmp))
+#define sk_X509_POLICY_DATA_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_POLICY_DATA, (st), (hash))
 #define sk_X509_POLICY_DATA_dup(st) SKM_sk_dup(X509_POLICY_DATA, st)
 #define sk_X509_POLICY_DATA_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_POLICY_DATA, (st), (free_func))
@@ -2178,6 +2343,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_POLICY_NODE, (st), (val), (i))
 #define sk_X509_POLICY_NODE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_POLICY_NODE, (st), (cmp))
+#define sk_X509_POLICY_NODE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_POLICY_NODE, (st), (hash))
 #define sk_X509_POLICY_NODE_dup(st) SKM_sk_dup(X509_POLICY_NODE, st)
 #define sk_X509_POLICY_NODE_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_POLICY_NODE, (st), (free_func))
@@ -2210,6 +2377,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_PURPOSE, (st), (val), (i))
 #define sk_X509_PURPOSE_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_PURPOSE, (st), (cmp))
+#define sk_X509_PURPOSE_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_PURPOSE, (st), (hash))
 #define sk_X509_PURPOSE_dup(st) SKM_sk_dup(X509_PURPOSE, st)
 #define sk_X509_PURPOSE_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_PURPOSE, (st), (free_func))
@@ -2241,6 +2410,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_REVOKED, (st), (val), (i))
 #define sk_X509_REVOKED_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_REVOKED, (st), (cmp))
+#define sk_X509_REVOKED_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_REVOKED, (st), (hash))
 #define sk_X509_REVOKED_dup(st) SKM_sk_dup(X509_REVOKED, st)
 #define sk_X509_REVOKED_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_REVOKED, (st), (free_func))
@@ -2269,6 +2440,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_TRUST, (st), (val), (i))
 #define sk_X509_TRUST_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_TRUST, (st), (cmp))
+#define sk_X509_TRUST_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_TRUST, (st), (hash))
 #define sk_X509_TRUST_dup(st) SKM_sk_dup(X509_TRUST, st)
 #define sk_X509_TRUST_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_TRUST, (st), (free_func))
@@ -2304,6 +2477,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(X509_VERIFY_PARAM, (st), (val), (i))
 #define sk_X509_VERIFY_PARAM_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(X509_VERIFY_PARAM, (st), (cmp))
+#define sk_X509_VERIFY_PARAM_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(X509_VERIFY_PARAM, (st), (hash))
 #define sk_X509_VERIFY_PARAM_dup(st) SKM_sk_dup(X509_VERIFY_PARAM, st)
 #define sk_X509_VERIFY_PARAM_pop_free(st, free_func) \
     SKM_sk_pop_free(X509_VERIFY_PARAM, (st), (free_func))
@@ -2333,6 +2508,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     SKM_sk_insert(nid_triple, (st), (val), (i))
 #define sk_nid_triple_set_cmp_func(st, cmp) \
     SKM_sk_set_cmp_func(nid_triple, (st), (cmp))
+#define sk_nid_triple_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(nid_triple, (st), (hash))
 #define sk_nid_triple_dup(st) SKM_sk_dup(nid_triple, st)
 #define sk_nid_triple_pop_free(st, free_func) \
     SKM_sk_pop_free(nid_triple, (st), (free_func))
@@ -2358,6 +2535,7 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_void_delete_ptr(st, ptr) SKM_sk_delete_ptr(void, (st), (ptr))
 #define sk_void_insert(st, val, i) SKM_sk_insert(void, (st), (val), (i))
 #define sk_void_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(void, (st), (cmp))
+#define sk_void_set_hash_func(st, hash) SKM_sk_set_hash_func(void, (st), (hash))
 #define sk_void_dup(st) SKM_sk_dup(void, st)
 #define sk_void_pop_free(st, free_func) SKM_sk_pop_free(void, (st), (free_func))
 #define sk_void_deep_copy(st, copy_func, free_func) \
@@ -2404,6 +2582,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_OPENSSL_STRING_set_cmp_func(st, cmp)                          \
     ((int (*)(const char *const *, const char *const *))sk_set_cmp_func( \
         CHECKED_STACK_OF(OPENSSL_STRING, st), CHECKED_SK_CMP_FUNC(char, cmp)))
+#define sk_OPENSSL_STRING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OPENSSL_STRING, (st), (hash))
 #define sk_OPENSSL_STRING_dup(st) SKM_sk_dup(OPENSSL_STRING, st)
 #define sk_OPENSSL_STRING_shift(st) SKM_sk_shift(OPENSSL_STRING, (st))
 #define sk_OPENSSL_STRING_pop(st) \
@@ -2447,6 +2627,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_OPENSSL_BLOCK_set_cmp_func(st, cmp)                           \
     ((int (*)(const void *const *, const void *const *))sk_set_cmp_func( \
         CHECKED_STACK_OF(OPENSSL_BLOCK, st), CHECKED_SK_CMP_FUNC(void, cmp)))
+#define sk_OPENSSL_BLOCK_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OPENSSL_BLOCK, (st), (hash))
 #define sk_OPENSSL_BLOCK_dup(st) SKM_sk_dup(OPENSSL_BLOCK, st)
 #define sk_OPENSSL_BLOCK_shift(st) SKM_sk_shift(OPENSSL_BLOCK, (st))
 #define sk_OPENSSL_BLOCK_pop(st) \
@@ -2499,6 +2681,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
     ((int (*)(const OPENSSL_STRING *const *, const OPENSSL_STRING *const *)) \
          sk_set_cmp_func(CHECKED_STACK_OF(OPENSSL_PSTRING, st),              \
                          CHECKED_SK_CMP_FUNC(OPENSSL_STRING, cmp)))
+#define sk_OPENSSL_PSTRING_set_hash_func(st, hash) \
+    SKM_sk_set_hash_func(OPENSSL_PSTRING, (st), (hash))
 #define sk_OPENSSL_PSTRING_dup(st) SKM_sk_dup(OPENSSL_PSTRING, st)
 #define sk_OPENSSL_PSTRING_shift(st) SKM_sk_shift(OPENSSL_PSTRING, (st))
 #define sk_OPENSSL_PSTRING_pop(st) \
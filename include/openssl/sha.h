@@ -62,6 +62,18 @@ VIGORTLS_EXPORT int SHA256_Final(uint8_t *md, SHA256_CTX *c);
 VIGORTLS_EXPORT uint8_t *SHA256(const uint8_t *d, size_t n, uint8_t *md);
 VIGORTLS_EXPORT void SHA256_Transform(SHA256_CTX *c, const uint8_t *data);
 
+/*
+ * SHA1_multi and SHA256_multi hash |num| independent messages, |data[i]|
+ * of |lens[i]| bytes, and write the digest of message i to |out| + i *
+ * SHA_DIGEST_LENGTH (resp. SHA256_DIGEST_LENGTH). On x86_64 up to eight
+ * messages of similar length are hashed in parallel, which pays off for
+ * many short messages such as certificates or OCSP CertIDs.
+ */
+VIGORTLS_EXPORT void SHA1_multi(size_t num, const uint8_t *const *data,
+                                const size_t *lens, uint8_t *out);
+VIGORTLS_EXPORT void SHA256_multi(size_t num, const uint8_t *const *data,
+                                  const size_t *lens, uint8_t *out);
+
 #define SHA384_DIGEST_LENGTH 48
 #define SHA512_DIGEST_LENGTH 64
 
@@ -503,6 +503,22 @@ struct ssl_session_st {
  */
 #define SSL_MODE_SEND_CLIENTHELLO_TIME          0x00000020L
 #define SSL_MODE_SEND_SERVERHELLO_TIME          0x00000040L
+/*
+ * Encrypt large application data writes on TLS 1.1+ AES-CBC-HMAC-SHA1/SHA256
+ * connections four or eight records at a time with the interleaved
+ * multi-block cipher kernels, where available. While such a write is in
+ * progress the write buffer holds up to eight records (about 128 KiB with the
+ * default fragment size); it is freed when the write completes. Whether this
+ * is faster than the single-record path depends on the CPU.
+ */
+#define SSL_MODE_MULTIBLOCK_WRITE               0x00000100L
+/*
+ * Keep the public keys of certificates received from peers in a small cache
+ * on the SSL_CTX, and reuse the decoded key when a peer sends the same
+ * certificate again rather than decoding it for every handshake. Each
+ * connection still gets its own X509 objects; only the keys are shared.
+ */
+#define SSL_MODE_CACHE_PEER_CERTS               0x00000200L
 
 /* Cert related flags */
 /*
@@ -652,6 +668,10 @@ typedef struct ssl_aead_ctx_st SSL_AEAD_CTX;
 typedef int (*GEN_SESSION_CB)(const SSL *ssl, uint8_t *id,
                               unsigned int *id_len);
 
+/* Fetches an OCSP response for |x|, see SSL_CTX_set_ocsp_fetch_cb */
+typedef OCSP_RESPONSE *(*SSL_OCSP_FETCH_CB)(SSL_CTX *ctx, X509 *x,
+                                            X509 *issuer, void *arg);
+
 typedef struct ssl_comp_st SSL_COMP;
 
 #ifndef OPENSSL_NO_SSL_INTERN
@@ -670,6 +690,8 @@ struct ssl_ctx_st {
     STACK_OF(SSL_CIPHER) *cipher_list;
     /* same as above but sorted for lookup */
     STACK_OF(SSL_CIPHER) *cipher_list_by_id;
+    /* position in cipher_list, from one, by ssl3_cipher_index */
+    uint16_t *cipher_rank;
 
     struct x509_store_st /* X509_STORE */ *cert_store;
     LHASH_OF(SSL_SESSION) *sessions;
@@ -818,6 +840,9 @@ struct ssl_ctx_st {
     /* Callback for status request */
     int (*tlsext_status_cb)(SSL *ssl, void *arg);
     void *tlsext_status_arg;
+    /* Fetcher for SSL_CTX_refresh_ocsp_staples */
+    SSL_OCSP_FETCH_CB ocsp_fetch_cb;
+    void *ocsp_fetch_arg;
 
     /* Next protocol negotiation information */
     /* (for experimental NPN extension). */
@@ -870,6 +895,9 @@ struct ssl_ctx_st {
     size_t tlsext_ellipticcurvelist_length;
     uint16_t *tlsext_ellipticcurvelist;
 
+    /* Decoded peer public keys, for SSL_MODE_CACHE_PEER_CERTS */
+    struct ssl_peer_key_cache_st *peer_key_cache;
+
     CRYPTO_MUTEX *lock;
 };
 
@@ -1102,6 +1130,7 @@ struct ssl_st {
 
     STACK_OF(SSL_CIPHER) *cipher_list;
     STACK_OF(SSL_CIPHER) *cipher_list_by_id;
+    uint16_t *cipher_rank;
 
     /*
      * These are the ones being used, the ones in SSL_SESSION are the ones to
@@ -1783,6 +1812,34 @@ VIGORTLS_EXPORT int SSL_CTX_use_serverinfo(SSL_CTX *ctx,
                                            size_t serverinfo_length);
 VIGORTLS_EXPORT int SSL_CTX_use_serverinfo_file(SSL_CTX *ctx, const char *file);
 
+/*
+ * SSL_CTX_set_ocsp_fetch_cb sets |cb| as the source of OCSP responses for
+ * the certificates of |ctx|. It is called with a certificate and its
+ * issuer, taken from the certificate's chain or the extra chain
+ * certificates, and returns a new OCSP_RESPONSE or NULL on failure.
+ *
+ * While a fetcher is set, and no status callback is, the server answers
+ * status requests by stapling the response last fetched for the
+ * certificate it sends, provided it has not passed its nextUpdate time.
+ */
+VIGORTLS_EXPORT void SSL_CTX_set_ocsp_fetch_cb(SSL_CTX *ctx,
+                                               SSL_OCSP_FETCH_CB cb,
+                                               void *arg);
+
+/*
+ * SSL_CTX_refresh_ocsp_staples calls the fetcher for every certificate of
+ * |ctx| that has no staple, or whose staple reaches its nextUpdate time
+ * within |margin| seconds, and installs the responses. Responses must be
+ * successful, cover the certificate and carry a nextUpdate time that has
+ * not passed. The
+ * library starts no threads: applications call this before serving and
+ * then periodically, typically from a thread of their own, with a margin
+ * longer than the period. Connections are never blocked by a refresh.
+ * It returns one if every fetch succeeded and zero otherwise, in which
+ * case a certificate keeps its previous staple until it expires.
+ */
+VIGORTLS_EXPORT int SSL_CTX_refresh_ocsp_staples(SSL_CTX *ctx, long margin);
+
 VIGORTLS_EXPORT int SSL_use_RSAPrivateKey_file(SSL *ssl, const char *file,
                                                int type);
 VIGORTLS_EXPORT int SSL_use_PrivateKey_file(SSL *ssl, const char *file,
@@ -2282,10 +2339,12 @@ VIGORTLS_EXPORT void ERR_load_SSL_strings(void);
 # define SSL_F_SSL_BAD_METHOD                             160
 # define SSL_F_SSL_BUILD_CERT_CHAIN                       332
 # define SSL_F_SSL_BYTES_TO_CIPHER_LIST                   161
+# define SSL_F_SSL_CERT_ADD0_CHAIN_CERT                   427
 # define SSL_F_SSL_CERT_DUP                               221
 # define SSL_F_SSL_CERT_INST                              222
 # define SSL_F_SSL_CERT_INSTANTIATE                       214
 # define SSL_F_SSL_CERT_NEW                               162
+# define SSL_F_SSL_CERT_SET0_CHAIN                        428
 # define SSL_F_SSL_CHECK_PRIVATE_KEY                      163
 # define SSL_F_SSL_CHECK_SERVERHELLO_TLSEXT               280
 # define SSL_F_SSL_CHECK_SRVR_ECC_CERT_AND_ALG            279
@@ -2299,6 +2358,7 @@ VIGORTLS_EXPORT void ERR_load_SSL_strings(void);
 # define SSL_F_SSL_CTX_CHECK_PRIVATE_KEY                  168
 # define SSL_F_SSL_CTX_MAKE_PROFILES                      309
 # define SSL_F_SSL_CTX_NEW                                169
+# define SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES                425
 # define SSL_F_SSL_CTX_SET_CIPHER_LIST                    269
 # define SSL_F_SSL_CTX_SET_CLIENT_CERT_ENGINE             290
 # define SSL_F_SSL_CTX_SET_PURPOSE                        226
@@ -2384,6 +2444,7 @@ VIGORTLS_EXPORT void ERR_load_SSL_strings(void);
 # define SSL_F_TLS1_CHECK_SERVERHELLO_TLSEXT              274
 # define SSL_F_TLS1_ENC                                   210
 # define SSL_F_TLS1_EXPORT_KEYING_MATERIAL                314
+# define SSL_F_TLS1_HANDSHAKE_DIGEST_INIT                 426
 # define SSL_F_TLS1_HEARTBEAT                             315
 # define SSL_F_TLS1_PREPARE_CLIENTHELLO_TLSEXT            275
 # define SSL_F_TLS1_PREPARE_SERVERHELLO_TLSEXT            276
@@ -2443,6 +2504,7 @@ VIGORTLS_EXPORT void ERR_load_SSL_strings(void);
 # define SSL_R_CA_DN_LENGTH_MISMATCH                      131
 # define SSL_R_CA_DN_TOO_LONG                             132
 # define SSL_R_CCS_RECEIVED_EARLY                         133
+# define SSL_R_CERTIFICATE_IN_ARENA                       410
 # define SSL_R_CERTIFICATE_VERIFY_FAILED                  134
 # define SSL_R_CERT_CB_ERROR                              377
 # define SSL_R_CERT_LENGTH_MISMATCH                       135
@@ -2563,6 +2625,8 @@ VIGORTLS_EXPORT void ERR_load_SSL_strings(void);
 # define SSL_R_NULL_SSL_METHOD_PASSED                     196
 # define SSL_R_OLD_SESSION_CIPHER_NOT_RETURNED            197
 # define SSL_R_OLD_SESSION_COMPRESSION_ALGORITHM_NOT_RETURNED 344
+# define SSL_R_OCSP_FETCH_FAILED                          408
+# define SSL_R_OCSP_NO_ISSUER                             409
 # define SSL_R_ONLY_DTLS_1_2_ALLOWED_IN_SUITEB_MODE       390
 # define SSL_R_ONLY_TLS_1_2_ALLOWED_IN_SUITEB_MODE        382
 # define SSL_R_ONLY_TLS_ALLOWED_IN_FIPS_MODE              297
@@ -332,10 +332,12 @@ typedef struct ssl3_state_st {
     BIO *handshake_buffer;
     /*
      * When set of handshake digests is determined, buffer is hashed
-     * and freed and MD_CTX-es for all required digests are stored in
-     * this array
+     * and freed and the required digests are run in this array, which
+     * is indexed like the handshake digest masks. It is allocated on
+     * first use and kept until the SSL is freed. Unused slots have no
+     * digest set.
      */
-    EVP_MD_CTX **handshake_dgst;
+    EVP_MD_CTX *handshake_dgst;
     /*
      * Set whenever an expected ChangeCipherSpec message is processed.
      * Unset when the peer's Finished message is received.
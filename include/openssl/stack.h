@@ -23,6 +23,10 @@ typedef struct stack_st {
 
     int num_alloc;
     int (*comp)(const void *, const void *);
+
+    unsigned long (*hash)(const void *);
+    int *index;
+    size_t index_mask;
 } _STACK; /* Use STACK_OF(...) instead */
 
 #define M_sk_num(sk) ((sk) ? (sk)->num : -1)
@@ -53,6 +57,16 @@ VIGORTLS_EXPORT int (*sk_set_cmp_func(_STACK *sk,
                                       int (*c)(const void *,
                                                const void *)))(const void *,
                                                                const void *);
+/*
+ * sk_set_hash_func gives |sk| a hash of its elements, which must agree with
+ * the comparison function, or with pointer equality if there is none. The
+ * stack then keeps an index that sk_find uses in place of sorting it, so
+ * finds do not reorder the stack, and a stack that is not being modified
+ * may be searched from several threads. Passing NULL drops the index. It
+ * returns zero if the index could not be allocated.
+ */
+VIGORTLS_EXPORT int sk_set_hash_func(_STACK *sk,
+                                     unsigned long (*hash)(const void *));
 VIGORTLS_EXPORT _STACK *sk_dup(_STACK *st);
 VIGORTLS_EXPORT void sk_sort(_STACK *st);
 VIGORTLS_EXPORT int sk_is_sorted(const _STACK *st);
@@ -355,6 +355,11 @@ struct X509_crl_st {
     const X509_CRL_METHOD *meth;
     void *meth_data;
     CRYPTO_MUTEX *lock;
+    /*
+     * Serial number index of the revoked entries, built when decoded so that
+     * lookups take no lock. It is kept in addition to the revoked stack.
+     */
+    struct x509_crl_index_st *revoked_index;
 } /* X509_CRL */;
 
 DECLARE_STACK_OF(X509_CRL)
@@ -482,6 +487,11 @@ extern "C" {
 #define X509_CRL_get_lastUpdate(x) ((x)->crl->lastUpdate)
 #define X509_CRL_get_nextUpdate(x) ((x)->crl->nextUpdate)
 #define X509_CRL_get_issuer(x) ((x)->crl->issuer)
+/*
+ * X509_CRL_get_REVOKED returns the revoked entries of |x|. Lookups on a
+ * decoded CRL use an index of these entries, which is bypassed once the
+ * stack is changed; add entries with X509_CRL_add0_revoked where possible.
+ */
 #define X509_CRL_get_REVOKED(x) ((x)->crl->revoked)
 
 VIGORTLS_EXPORT void X509_CRL_set_default_method(const X509_CRL_METHOD *meth);
@@ -702,6 +712,17 @@ VIGORTLS_EXPORT void *X509_get_ex_data(X509 *r, int idx);
 VIGORTLS_EXPORT int i2d_X509_AUX(X509 *a, uint8_t **pp);
 VIGORTLS_EXPORT X509 *d2i_X509_AUX(X509 **a, const uint8_t **pp, long length);
 
+/*
+ * d2i_X509_arena and d2i_X509_CRL_arena decode into |arena|; see
+ * ASN1_item_d2i_arena for the rules on using the result. The result is
+ * flagged EXFLAG_ARENA, and the functions that would modify it or keep a
+ * reference to it, such as the X509_set_* family, X509_sign and
+ * X509_STORE_add_cert, fail instead. X509_free and X509_CRL_free do nothing
+ * on such a value, which is freed by ASN1_ARENA_free.
+ */
+VIGORTLS_EXPORT X509 *d2i_X509_arena(ASN1_ARENA *arena, const uint8_t **in,
+                                     long len);
+
 VIGORTLS_EXPORT int i2d_re_X509_tbs(X509 *x, uint8_t **pp);
 
 VIGORTLS_EXPORT void X509_get0_signature(ASN1_BIT_STRING **psig,
@@ -724,6 +745,8 @@ VIGORTLS_EXPORT void X509_reject_clear(X509 *x);
 DECLARE_ASN1_FUNCTIONS(X509_REVOKED)
 DECLARE_ASN1_FUNCTIONS(X509_CRL_INFO)
 DECLARE_ASN1_FUNCTIONS(X509_CRL)
+VIGORTLS_EXPORT X509_CRL *d2i_X509_CRL_arena(ASN1_ARENA *arena,
+                                             const uint8_t **in, long len);
 
 VIGORTLS_EXPORT int X509_CRL_add0_revoked(X509_CRL *crl, X509_REVOKED *rev);
 VIGORTLS_EXPORT int X509_CRL_get0_by_serial(X509_CRL *crl, X509_REVOKED **ret,
@@ -1144,6 +1167,7 @@ VIGORTLS_EXPORT void ERR_load_X509_strings(void);
 # define X509_F_CHECK_POLICY                              145
 # define X509_F_DIR_CTRL                                  102
 # define X509_F_GET_CERT_BY_SUBJECT                       103
+# define X509_F_LOAD_SNAPSHOT                             148
 # define X509_F_NETSCAPE_SPKI_B64_DECODE                  129
 # define X509_F_NETSCAPE_SPKI_B64_ENCODE                  130
 # define X509_F_X509AT_ADD1_ATTR                          135
@@ -1175,6 +1199,7 @@ VIGORTLS_EXPORT void ERR_load_X509_strings(void);
 # define X509_F_X509_REQ_PRINT_EX                         121
 # define X509_F_X509_REQ_PRINT_FP                         122
 # define X509_F_X509_REQ_TO_X509                          123
+# define X509_F_X509_SNAPSHOT_WRITE_BIO                   149
 # define X509_F_X509_STORE_ADD_CERT                       124
 # define X509_F_X509_STORE_ADD_CRL                        125
 # define X509_F_X509_STORE_CTX_GET1_ISSUER                146
@@ -1198,6 +1223,7 @@ VIGORTLS_EXPORT void ERR_load_X509_strings(void);
 # define X509_R_IDP_MISMATCH                              128
 # define X509_R_INVALID_DIRECTORY                         113
 # define X509_R_INVALID_FIELD_NAME                        119
+# define X509_R_INVALID_SNAPSHOT                          135
 # define X509_R_INVALID_TRUST                             123
 # define X509_R_ISSUER_MISMATCH                           129
 # define X509_R_KEY_TYPE_MISMATCH                         115
@@ -1219,6 +1245,7 @@ VIGORTLS_EXPORT void ERR_load_X509_strings(void);
 # define X509_R_UNKNOWN_PURPOSE_ID                        121
 # define X509_R_UNKNOWN_TRUST_ID                          120
 # define X509_R_UNSUPPORTED_ALGORITHM                     111
+# define X509_R_VALUE_IN_ARENA                            136
 # define X509_R_WRONG_LOOKUP_TYPE                         112
 # define X509_R_WRONG_TYPE                                122
 
@@ -235,6 +235,7 @@ VIGORTLS_EXPORT void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 
 #define X509_L_FILE_LOAD    1
 #define X509_L_ADD_DIR      2
+#define X509_L_LOAD_SNAPSHOT 3
 
 #define X509_LOOKUP_load_file(x, name, type) \
     X509_LOOKUP_ctrl((x), X509_L_FILE_LOAD, (name), (long)(type), NULL)
@@ -242,6 +243,9 @@ VIGORTLS_EXPORT void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 #define X509_LOOKUP_add_dir(x, name, type) \
     X509_LOOKUP_ctrl((x), X509_L_ADD_DIR, (name), (long)(type), NULL)
 
+#define X509_LOOKUP_load_snapshot(x, name) \
+    X509_LOOKUP_ctrl((x), X509_L_LOAD_SNAPSHOT, (name), 0, NULL)
+
 #define X509_V_OK                                           0
 #define X509_V_ERR_UNSPECIFIED                              1
 
@@ -429,6 +433,7 @@ VIGORTLS_EXPORT X509_LOOKUP *X509_STORE_add_lookup(X509_STORE *v,
 
 VIGORTLS_EXPORT X509_LOOKUP_METHOD *X509_LOOKUP_hash_dir(void);
 VIGORTLS_EXPORT X509_LOOKUP_METHOD *X509_LOOKUP_file(void);
+VIGORTLS_EXPORT X509_LOOKUP_METHOD *X509_LOOKUP_snapshot(void);
 
 VIGORTLS_EXPORT int X509_STORE_add_cert(X509_STORE *ctx, X509 *x);
 VIGORTLS_EXPORT int X509_STORE_add_crl(X509_STORE *ctx, X509_CRL *x);
@@ -447,6 +452,14 @@ VIGORTLS_EXPORT int X509_load_crl_file(X509_LOOKUP *ctx, const char *file,
 VIGORTLS_EXPORT int X509_load_cert_crl_file(X509_LOOKUP *ctx, const char *file,
                                             int type);
 
+/*
+ * X509_snapshot_write_bio writes |certs| to |bp| as a trust store snapshot.
+ * X509_LOOKUP_snapshot loads one without parsing each certificate up front,
+ * as does X509_LOOKUP_file when given one as a PEM file. It returns one on
+ * success and zero on error.
+ */
+VIGORTLS_EXPORT int X509_snapshot_write_bio(BIO *bp, STACK_OF(X509) *certs);
+
 VIGORTLS_EXPORT X509_LOOKUP *X509_LOOKUP_new(X509_LOOKUP_METHOD *method);
 VIGORTLS_EXPORT void X509_LOOKUP_free(X509_LOOKUP *ctx);
 VIGORTLS_EXPORT int X509_LOOKUP_init(X509_LOOKUP *ctx);
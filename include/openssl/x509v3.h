@@ -375,6 +375,8 @@ struct ISSUING_DIST_POINT_st {
 #define EXFLAG_FRESHEST         0x1000
 /* Self signed */
 #define EXFLAG_SS               0x2000
+/* Decoded into an ASN1_ARENA: read-only and not to be kept */
+#define EXFLAG_ARENA            0x4000
 
 #define KU_DIGITAL_SIGNATURE    0x0080
 #define KU_NON_REPUDIATION      0x0040
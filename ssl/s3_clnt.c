@@ -935,7 +935,7 @@ int ssl3_get_server_certificate(SSL *s)
         }
 
         q = CBS_data(&cert);
-        x = d2i_X509(NULL, &q, CBS_len(&cert));
+        x = ssl_get_peer_x509(s, &q, CBS_len(&cert));
         if (x == NULL) {
             al = SSL_AD_BAD_CERTIFICATE;
             SSLerr(SSL_F_SSL3_GET_SERVER_CERTIFICATE,
@@ -1201,7 +1201,7 @@ static int ssl3_get_server_kex_ecdhe(SSL *s, EVP_PKEY **pkey, uint8_t **pp,
 
     /* Next, get the encoded ECPoint */
     srvr_ecpoint = EC_POINT_new(group);
-    bn_ctx = BN_CTX_new();
+    bn_ctx = BN_CTX_new_cached();
     if (srvr_ecpoint == NULL || bn_ctx == NULL) {
         SSLerr(SSL_F_SSL3_GET_KEY_EXCHANGE, ERR_R_MALLOC_FAILURE);
         goto err;
@@ -2034,7 +2034,7 @@ static int ssl3_send_client_kex_ecdhe(SSL *s, SESS_CERT *sess_cert, uint8_t *p,
         EC_POINT_point2oct(srvr_group, EC_KEY_get0_public_key(clnt_ecdh),
                            POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
 
-    bn_ctx = BN_CTX_new();
+    bn_ctx = BN_CTX_new_cached();
     encodedPoint = malloc(encoded_pt_len);
     if (encodedPoint == NULL || bn_ctx == NULL) {
         SSLerr(SSL_F_SSL3_SEND_CLIENT_KEY_EXCHANGE, ERR_R_MALLOC_FAILURE);
@@ -2261,26 +2261,31 @@ int ssl3_send_client_verify(SSL *s)
          * using agreed digest and cached handshake records.
          */
         if (SSL_USE_SIGALGS(s)) {
-            long hdatalen = 0;
-            void *hdata;
             const EVP_MD *md = s->cert->key->digest;
-            hdatalen = BIO_get_mem_data(s->s3->handshake_buffer,
-                                        &hdata);
-            if (hdatalen <= 0 || !tls12_get_sigandhash(p, pkey, md)) {
+            if (s->s3->handshake_buffer == NULL ||
+                !tls12_get_sigandhash(p, pkey, md)) {
                 SSLerr(SSL_F_SSL3_SEND_CLIENT_VERIFY,
                        ERR_R_INTERNAL_ERROR);
                 goto err;
             }
             p += 2;
-            if (!EVP_SignInit_ex(&mctx, md, NULL) || !EVP_SignUpdate(&mctx, hdata, hdatalen) || !EVP_SignFinal(&mctx, p + 2, &u, pkey)) {
+            /*
+             * Start the transcript digests first, keeping the cached
+             * records in case the signature uses another hash.
+             */
+            s->s3->flags |= TLS1_FLAGS_KEEP_HANDSHAKE;
+            if (!tls1_digest_cached_records(s))
+                goto err;
+            if (!tls1_handshake_digest_init(s, &mctx, md) || !EVP_SignFinal(&mctx, p + 2, &u, pkey)) {
                 SSLerr(SSL_F_SSL3_SEND_CLIENT_VERIFY,
                        ERR_R_EVP_LIB);
                 goto err;
             }
             s2n(u, p);
             n = u + 4;
-            if (!tls1_digest_cached_records(s))
-                goto err;
+            BIO_free(s->s3->handshake_buffer);
+            s->s3->handshake_buffer = NULL;
+            s->s3->flags &= ~TLS1_FLAGS_KEEP_HANDSHAKE;
         } else if (pkey->type == EVP_PKEY_RSA) {
             s->method->ssl3_enc->cert_verify_mac(
             s, NID_md5, &(data[0]));
@@ -2345,6 +2350,7 @@ int ssl3_send_client_verify(SSL *s)
     EVP_PKEY_CTX_free(pctx);
     return ssl_do_write(s);
 err:
+    s->s3->flags &= ~TLS1_FLAGS_KEEP_HANDSHAKE;
     EVP_MD_CTX_cleanup(&mctx);
     EVP_PKEY_CTX_free(pctx);
     s->state = SSL_ST_ERR;
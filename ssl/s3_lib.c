@@ -25,6 +25,7 @@
 #include <openssl/dh.h>
 #include <openssl/md5.h>
 #include <openssl/objects.h>
+#include <openssl/x509v3.h>
 
 #include "bytestring.h"
 #include "ssl_locl.h"
@@ -1481,6 +1482,21 @@ const SSL_CIPHER *ssl3_get_cipher_by_value(uint16_t value)
     return ssl3_get_cipher_by_id(SSL3_CK_ID | value);
 }
 
+/*
+ * ssl3_cipher_index returns the position of |c| in the table of ciphers,
+ * which is less than ssl3_num_ciphers, or -1 if it is not in the table.
+ */
+int ssl3_cipher_index(const SSL_CIPHER *c)
+{
+    const SSL_CIPHER *cp;
+
+    if (c >= ssl3_ciphers && c < ssl3_ciphers + SSL3_NUM_CIPHERS)
+        return (int)(c - ssl3_ciphers);
+    if ((cp = ssl3_get_cipher_by_id(c->id)) == NULL)
+        return -1;
+    return (int)(cp - ssl3_ciphers);
+}
+
 uint16_t ssl3_cipher_get_value(const SSL_CIPHER *cipher)
 {
     return (cipher->id & SSL3_CK_VALUE_MASK);
@@ -1540,6 +1556,7 @@ void ssl3_free(SSL *s)
     sk_X509_NAME_pop_free(s->s3->tmp.ca_names, X509_NAME_free);
     BIO_free(s->s3->handshake_buffer);
     tls1_free_digest_list(s);
+    free(s->s3->handshake_dgst);
     free(s->s3->alpn_selected);
 
     vigortls_zeroize(s->s3, sizeof *s->s3);
@@ -1551,6 +1568,7 @@ void ssl3_clear(SSL *s)
 {
     uint8_t *rp, *wp;
     size_t rlen, wlen;
+    EVP_MD_CTX *hdgst;
     int init_extra;
 
     ssl3_cleanup_key_block(s);
@@ -1570,11 +1588,13 @@ void ssl3_clear(SSL *s)
     s->s3->handshake_buffer = NULL;
 
     tls1_free_digest_list(s);
+    hdgst = s->s3->handshake_dgst;
 
     free(s->s3->alpn_selected);
     s->s3->alpn_selected = NULL;
 
     memset(s->s3, 0, sizeof *s->s3);
+    s->s3->handshake_dgst = hdgst;
     s->s3->rbuf.buf = rp;
     s->s3->wbuf.buf = wp;
     s->s3->rbuf.len = rlen;
@@ -2105,6 +2125,10 @@ long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
 
         /* A Thawte special :-) */
         case SSL_CTRL_EXTRA_CHAIN_CERT:
+            if (((X509 *)parg)->ex_flags & EXFLAG_ARENA) {
+                SSLerr(SSL_F_SSL3_CTX_CTRL, SSL_R_CERTIFICATE_IN_ARENA);
+                return (0);
+            }
             if (ctx->extra_certs == NULL) {
                 if ((ctx->extra_certs = sk_X509_new_null()) == NULL)
                     return (0);
@@ -2215,13 +2239,50 @@ int ssl3_put_cipher_by_char(const SSL_CIPHER *c, unsigned char *p)
     return 2;
 }
 
+/*
+ * ssl3_cipher_usable returns whether |c| can be negotiated on |s| with the
+ * certificates in |cert|.
+ */
+static int ssl3_cipher_usable(SSL *s, CERT *cert, const SSL_CIPHER *c,
+                              int use_chacha)
+{
+    unsigned long alg_k, alg_a, mask_k, mask_a;
+    int ok;
+
+    /* Skip TLS v1.2 only ciphersuites if not supported. */
+    if ((c->algorithm_ssl & SSL_TLSV1_2) && !SSL_USE_TLS1_2_CIPHERS(s))
+        return 0;
+
+    if ((c->algorithm_enc == SSL_CHACHA20POLY1305) && !use_chacha)
+        return 0;
+
+    ssl_set_cert_masks(cert, c);
+    mask_k = cert->mask_k;
+    mask_a = cert->mask_a;
+
+    alg_k = c->algorithm_mkey;
+    alg_a = c->algorithm_auth;
+
+    ok = (alg_k & mask_k) && (alg_a & mask_a);
+
+    /*
+     * If we are considering an ECC cipher suite that uses
+     * an ephemeral EC key check it.
+     */
+    if (alg_k & SSL_kECDHE)
+        ok = ok && tls1_check_ec_tmp_key(s, c->id);
+
+    return ok;
+}
+
 SSL_CIPHER *ssl3_choose_cipher(SSL *s, STACK_OF(SSL_CIPHER) *clnt,
                                STACK_OF(SSL_CIPHER) *srvr)
 {
-    unsigned long alg_k, alg_a, mask_k, mask_a;
     STACK_OF(SSL_CIPHER) *prio, *allow;
+    const uint16_t *rank = NULL;
+    uint8_t shared[SSL3_NUM_CIPHERS];
     SSL_CIPHER *c, *ret = NULL;
-    int i, ii, ok, use_chacha = 0;
+    int i, ii, idx, server_pref, use_chacha = 0;
     CERT *cert;
 
     /* Let's see which ciphers we can support */
@@ -2230,11 +2291,15 @@ SSL_CIPHER *ssl3_choose_cipher(SSL *s, STACK_OF(SSL_CIPHER) *clnt,
     /*
      * Do not set the compare functions, because this may lead to a
      * reordering by "id". We want to keep the original ordering.
-     * We may pay a price in performance during sk_SSL_CIPHER_find(),
-     * but would have to pay with the price of sk_SSL_CIPHER_dup().
+     * Lists made by ssl_create_cipher_list rank each cipher, so neither
+     * list is searched when the server's list is its own. Otherwise they
+     * are indexed, so finds in the server's list do not search it; finds
+     * in the client's list do.
      */
 
-    if (s->options & SSL_OP_CIPHER_SERVER_PREFERENCE || tls1_suiteb(s)) {
+    server_pref = (s->options & SSL_OP_CIPHER_SERVER_PREFERENCE) ||
+                  tls1_suiteb(s);
+    if (server_pref) {
         prio = srvr;
         allow = clnt;
         /* Use ChaCha20+Poly1305 if it's the client's most preferred cipher suite */
@@ -2252,33 +2317,46 @@ SSL_CIPHER *ssl3_choose_cipher(SSL *s, STACK_OF(SSL_CIPHER) *clnt,
 
     tls1_set_cert_validity(s);
 
-    for (i = 0; i < sk_SSL_CIPHER_num(prio); i++) {
-        c = sk_SSL_CIPHER_value(prio, i);
-
-        /* Skip TLS v1.2 only ciphersuites if not supported. */
-        if ((c->algorithm_ssl & SSL_TLSV1_2) && !SSL_USE_TLS1_2_CIPHERS(s))
-            continue;
-
-        if ((c->algorithm_enc == SSL_CHACHA20POLY1305) && !use_chacha)
-            continue;
-
-        ssl_set_cert_masks(cert, c);
-        mask_k = cert->mask_k;
-        mask_a = cert->mask_a;
-
-        alg_k = c->algorithm_mkey;
-        alg_a = c->algorithm_auth;
-
-        ok = (alg_k & mask_k) && (alg_a & mask_a);
-
+    if (srvr == SSL_get_ciphers(s))
+        rank = ssl_get_cipher_rank(s);
+
+    if (rank != NULL && !server_pref) {
+        /* The server's list is ranked, so it need not be searched. */
+        for (i = 0; i < sk_SSL_CIPHER_num(clnt); i++) {
+            c = sk_SSL_CIPHER_value(clnt, i);
+            if ((idx = ssl3_cipher_index(c)) < 0 || rank[idx] == 0)
+                continue;
+            if (ssl3_cipher_usable(s, cert, c, use_chacha))
+                return (sk_SSL_CIPHER_value(srvr, rank[idx] - 1));
+        }
+        return (NULL);
+    }
+    if (rank != NULL) {
         /*
-         * If we are considering an ECC cipher suite that uses
-         * an ephemeral EC key check it.
+         * One pass over the client's list marks the ciphers both sides
+         * have by their rank on the server, and the marks are then
+         * checked in the server's order.
          */
-        if (alg_k & SSL_kECDHE)
-            ok = ok && tls1_check_ec_tmp_key(s, c->id);
+        memset(shared, 0, sizeof(shared));
+        for (i = 0; i < sk_SSL_CIPHER_num(clnt); i++) {
+            idx = ssl3_cipher_index(sk_SSL_CIPHER_value(clnt, i));
+            if (idx >= 0 && rank[idx] != 0)
+                shared[rank[idx] - 1] = 1;
+        }
+        for (i = 0; i < sk_SSL_CIPHER_num(srvr); i++) {
+            if (!shared[i])
+                continue;
+            c = sk_SSL_CIPHER_value(srvr, i);
+            if (ssl3_cipher_usable(s, cert, c, use_chacha))
+                return (c);
+        }
+        return (NULL);
+    }
+
+    for (i = 0; i < sk_SSL_CIPHER_num(prio); i++) {
+        c = sk_SSL_CIPHER_value(prio, i);
 
-        if (!ok)
+        if (!ssl3_cipher_usable(s, cert, c, use_chacha))
             continue;
         ii = sk_SSL_CIPHER_find(allow, c);
         if (ii >= 0) {
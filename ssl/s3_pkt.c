@@ -18,8 +18,7 @@
 #define EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK 0
 #endif
 
-#if defined(OPENSSL_NO_ASM) || defined(OPENSSL_SMALL_FOOTPRINT) || \
-    !defined(OPENSSL_NO_ASM)
+#if defined(OPENSSL_NO_ASM) || defined(OPENSSL_SMALL_FOOTPRINT)
 #undef EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
 #define EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK 0
 #endif
@@ -484,12 +483,16 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, int len)
     /*
      * Depending on the platform multi-block can deliver several *times* better
      * performance. The downside is that it has to allocate jumbo buffer to
-     * accomodate up to 8 records, but the compromise is considered worthy.
+     * accomodate up to 8 records, so it is only used when the application
+     * asks for it with SSL_MODE_MULTIBLOCK_WRITE.
      */
     if (type == SSL3_RT_APPLICATION_DATA &&
+        (s->mode & SSL_MODE_MULTIBLOCK_WRITE) &&
         len >= 4 * (int)(max_send_fragment = s->max_send_fragment) &&
         s->msg_callback == NULL &&
+        !SSL_IS_DTLS(s) &&
         SSL_USE_EXPLICIT_IV(s) &&
+        s->enc_write_ctx != NULL &&
         EVP_CIPHER_flags(s->enc_write_ctx->cipher) &
         EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK)
     {
@@ -383,14 +383,15 @@ int ssl3_accept(SSL *s)
                             return -1;
                         }
                     }
-                    for (dgst_num = 0; dgst_num < SSL_MAX_DIGEST; dgst_num++)
-                        if (s->s3->handshake_dgst[dgst_num]) {
+                    for (dgst_num = 0; s->s3->handshake_dgst != NULL &&
+                                       dgst_num < SSL_MAX_DIGEST; dgst_num++)
+                        if (EVP_MD_CTX_md(&s->s3->handshake_dgst[dgst_num])) {
                             int dgst_size;
 
                             s->method->ssl3_enc->cert_verify_mac(
-                                s, EVP_MD_CTX_type(s->s3->handshake_dgst[dgst_num]),
+                                s, EVP_MD_CTX_type(&s->s3->handshake_dgst[dgst_num]),
                                 &(s->s3->tmp.cert_verify_md[offset]));
-                            dgst_size = EVP_MD_CTX_size(s->s3->handshake_dgst[dgst_num]);
+                            dgst_size = EVP_MD_CTX_size(&s->s3->handshake_dgst[dgst_num]);
                             if (dgst_size < 0) {
                                 s->state = SSL_ST_ERR;
                                 ret = -1;
@@ -912,6 +913,9 @@ int ssl3_get_client_hello(SSL *s)
 
             s->cipher_list = sk_SSL_CIPHER_dup(s->session->ciphers);
             s->cipher_list_by_id = sk_SSL_CIPHER_dup(s->session->ciphers);
+            /* The client's list has no ranks to choose by. */
+            free(s->cipher_rank);
+            s->cipher_rank = NULL;
         }
     }
 
@@ -1263,7 +1267,7 @@ int ssl3_send_server_kex_ecdhe(SSL *s, CBB *cbb)
                            POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
 
     encodedPoint = malloc(encodedlen);
-    bn_ctx = BN_CTX_new();
+    bn_ctx = BN_CTX_new_cached();
     if ((encodedPoint == NULL) || (bn_ctx == NULL)) {
         SSLerr(SSL_F_SSL3_SEND_SERVER_KEY_EXCHANGE, ERR_R_MALLOC_FAILURE);
         goto err;
@@ -1799,7 +1803,7 @@ static int ssl3_get_client_kex_ecdhe(SSL *s, uint8_t *p, long n)
          * Get client's public key from encoded point
          * in the ClientKeyExchange message.
          */
-        if ((bn_ctx = BN_CTX_new()) == NULL) {
+        if ((bn_ctx = BN_CTX_new_cached()) == NULL) {
             SSLerr(SSL_F_SSL3_GET_CLIENT_KEY_EXCHANGE, ERR_R_MALLOC_FAILURE);
             goto err;
         }
@@ -2234,7 +2238,7 @@ int ssl3_get_client_certificate(SSL *s)
         }
 
         q = CBS_data(&cert);
-        x = d2i_X509(NULL, &q, CBS_len(&cert));
+        x = ssl_get_peer_x509(s, &q, CBS_len(&cert));
         if (x == NULL) {
             SSLerr(SSL_F_SSL3_GET_CLIENT_CERTIFICATE, ERR_R_ASN1_LIB);
             goto err;
@@ -2497,16 +2501,24 @@ err:
 int ssl3_send_cert_status(SSL *s)
 {
     if (s->state == SSL3_ST_SW_CERT_STATUS_A) {
+        SSL_OCSP_STAPLE *staple = NULL;
         uint8_t *p;
         size_t msglen;
 
+        /* A response from the status callback takes precedence */
+        if (s->tlsext_ocsp_resp == NULL)
+            staple = s->cert->key->ocsp_staple;
+
         /*
          * Grow buffer if need be: the length calculation is as
          * follows handshake_header_length +
          * 1 (ocsp response type) + 3 (ocsp response length)
          * + (ocsp response)
          */
-        msglen = 4 + s->tlsext_ocsp_resplen;
+        if (staple != NULL)
+            msglen = staple->msg_len;
+        else
+            msglen = 4 + s->tlsext_ocsp_resplen;
         if (!BUF_MEM_grow(s->init_buf, SSL_HM_HEADER_LENGTH(s) + msglen)) {
             s->state = SSL_ST_ERR;
             return -1;
@@ -2514,12 +2526,17 @@ int ssl3_send_cert_status(SSL *s)
 
         p = ssl_handshake_start(s);
 
-        /* status type */
-        *(p++) = s->tlsext_status_type;
-        /* length of OCSP response */
-        l2n3(s->tlsext_ocsp_resplen, p);
-        /* actual response */
-        memcpy(p, s->tlsext_ocsp_resp, s->tlsext_ocsp_resplen);
+        if (staple != NULL) {
+            /* The staple holds the whole message body */
+            memcpy(p, staple->msg, msglen);
+        } else {
+            /* status type */
+            *(p++) = s->tlsext_status_type;
+            /* length of OCSP response */
+            l2n3(s->tlsext_ocsp_resplen, p);
+            /* actual response */
+            memcpy(p, s->tlsext_ocsp_resp, s->tlsext_ocsp_resplen);
+        }
 
         ssl_set_handshake_header(s, SSL3_MT_CERTIFICATE_STATUS, msglen);
     }
@@ -175,6 +175,12 @@ CERT *ssl_cert_dup(CERT *cert)
                 memcpy(ret->pkeys[i].serverinfo, cert->pkeys[i].serverinfo,
                        cert->pkeys[i].serverinfo_length);
         }
+
+        /* Staples are replaced under the lock by a concurrent refresh */
+        CRYPTO_thread_read_lock(cert->lock);
+        if ((rpk->ocsp_staple = cpk->ocsp_staple) != NULL)
+            ssl_ocsp_staple_up_ref(rpk->ocsp_staple);
+        CRYPTO_thread_unlock(cert->lock);
     }
 
     /*
@@ -267,6 +273,8 @@ void ssl_cert_clear_certs(CERT *c)
         cpk->chain = NULL;
         free(cpk->serverinfo);
         cpk->serverinfo = NULL;
+        ssl_ocsp_staple_free(cpk->ocsp_staple);
+        cpk->ocsp_staple = NULL;
 
         /* Clear all flags apart from explicit sign */
         cpk->valid_flags &= CERT_PKEY_EXPLICIT_SIGN;
@@ -332,8 +340,16 @@ int ssl_cert_inst(CERT **o)
 int ssl_cert_set0_chain(CERT *c, STACK_OF(X509) *chain)
 {
     CERT_PKEY *cpk = c->key;
+    int i;
+
     if (cpk == NULL)
         return 0;
+    for (i = 0; i < sk_X509_num(chain); i++) {
+        if (sk_X509_value(chain, i)->ex_flags & EXFLAG_ARENA) {
+            SSLerr(SSL_F_SSL_CERT_SET0_CHAIN, SSL_R_CERTIFICATE_IN_ARENA);
+            return 0;
+        }
+    }
     sk_X509_pop_free(cpk->chain, X509_free);
     cpk->chain = chain;
     return 1;
@@ -359,6 +375,10 @@ int ssl_cert_add0_chain_cert(CERT *c, X509 *x)
     CERT_PKEY *cpk = c->key;
     if (cpk == NULL)
         return 0;
+    if (x->ex_flags & EXFLAG_ARENA) {
+        SSLerr(SSL_F_SSL_CERT_ADD0_CHAIN_CERT, SSL_R_CERTIFICATE_IN_ARENA);
+        return 0;
+    }
     if (!cpk->chain)
         cpk->chain = sk_X509_new_null();
     if (!cpk->chain || !sk_X509_push(cpk->chain, x))
@@ -466,6 +486,7 @@ void ssl_sess_cert_free(SESS_CERT *sc)
     DH_free(sc->peer_dh_tmp);
     EC_KEY_free(sc->peer_ecdh_tmp);
 
+    CRYPTO_thread_cleanup(sc->lock);
     free(sc);
 }
 
@@ -617,6 +638,11 @@ static int xname_cmp(const X509_NAME *const *a, const X509_NAME *const *b)
     return (X509_NAME_cmp(*a, *b));
 }
 
+static unsigned long xname_hash(const X509_NAME *a)
+{
+    return X509_NAME_hash((X509_NAME *)a);
+}
+
 /*!
  * Load CA certs from a file into a ::STACK. Note that it is somewhat misnamed;
  * it doesn't really have anything to do with clients (except that a common use
@@ -636,7 +662,8 @@ STACK_OF(X509_NAME) *SSL_load_client_CA_file(const char *file)
 
     in = BIO_new(BIO_s_file_internal());
 
-    if ((sk == NULL) || (in == NULL)) {
+    if ((sk == NULL) || !sk_X509_NAME_set_hash_func(sk, xname_hash) ||
+        (in == NULL)) {
         SSLerr(SSL_F_SSL_LOAD_CLIENT_CA_FILE, ERR_R_MALLOC_FAILURE);
         goto err;
     }
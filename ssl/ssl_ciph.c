@@ -1193,37 +1193,27 @@ static int check_suiteb_cipher_list(const SSL_METHOD *meth, CERT *c,
     return 1;
 }
 
-STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
-                                              STACK_OF(SSL_CIPHER) **cipher_list,
-                                              STACK_OF(SSL_CIPHER) **cipher_list_by_id,
-                                              const char *rule_str, CERT *c)
+/*
+ * ssl_cipher_compile applies |rule_str| to the ciphers of |ssl_method| that
+ * are not disabled, and sets |*out| to a new array of the selected ciphers in
+ * order of preference and |*out_num| to their number. It returns one on
+ * success and zero on error.
+ */
+static int ssl_cipher_compile(const SSL_METHOD *ssl_method,
+                              const char *rule_str,
+                              const unsigned long disabled[5],
+                              const SSL_CIPHER ***out, int *out_num)
 {
-    int ok, num_of_ciphers, num_of_alias_max, num_of_group_aliases;
-    unsigned long disabled_mkey, disabled_auth, disabled_enc, disabled_mac,
-        disabled_ssl;
-    STACK_OF(SSL_CIPHER) *cipherstack, *tmp_cipher_list;
+    int ok, num_of_ciphers, num_of_alias_max, num_of_group_aliases, num;
+    unsigned long disabled_mkey = disabled[0], disabled_auth = disabled[1],
+                  disabled_enc = disabled[2], disabled_mac = disabled[3],
+                  disabled_ssl = disabled[4];
     const char *rule_p;
     CIPHER_ORDER *co_list = NULL, *head = NULL, *tail = NULL, *curr;
-    const SSL_CIPHER **ca_list = NULL;
-
-    /*
-     * Return with error if nothing to do.
-     */
-    if (rule_str == NULL || cipher_list == NULL || cipher_list_by_id == NULL)
-        return NULL;
-
-    if (!check_suiteb_cipher_list(ssl_method, c, &rule_str))
-        return NULL;
+    const SSL_CIPHER **ca_list = NULL, **ciphers;
 
     /*
-     * To reduce the work to do we only want to process the compiled
-     * in algorithms, so we first get the mask of disabled ciphers.
-     */
-    ssl_cipher_get_disabled(&disabled_mkey, &disabled_auth, &disabled_enc,
-                            &disabled_mac, &disabled_ssl);
-
-    /*
-     * Now we have to collect the available ciphers from the compiled
+     * We have to collect the available ciphers from the compiled
      * in ciphers. We cannot get more than the number compiled in, so
      * it is used for allocation.
      */
@@ -1231,7 +1221,7 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
     co_list = reallocarray(NULL, num_of_ciphers, sizeof(CIPHER_ORDER));
     if (co_list == NULL) {
         SSLerr(SSL_F_SSL_CREATE_CIPHER_LIST, ERR_R_MALLOC_FAILURE);
-        return (NULL); /* Failure */
+        return 0; /* Failure */
     }
 
     ssl_cipher_collect_ciphers(ssl_method, num_of_ciphers, disabled_mkey,
@@ -1278,7 +1268,7 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
       * in force within each class */
     if (!ssl_cipher_strength_sort(&head, &tail)) {
         free(co_list);
-        return NULL;
+        return 0;
     }
 
     /* Now disable everything (maintaining the ordering!) */
@@ -1298,7 +1288,7 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
     if (ca_list == NULL) {
         free(co_list);
         SSLerr(SSL_F_SSL_CREATE_CIPHER_LIST, ERR_R_MALLOC_FAILURE);
-        return (NULL); /* Failure */
+        return 0; /* Failure */
     }
     ssl_cipher_collect_aliases(ca_list, num_of_group_aliases, disabled_mkey,
                                disabled_auth, disabled_enc, disabled_mac,
@@ -1326,32 +1316,231 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
     if (!ok) {
         /* Rule processing failure */
         free(co_list);
-        return (NULL);
+        return 0;
     }
 
+    /*
+     * The cipher selection for the list is done. The active ciphers are
+     * collected in order of preference.
+     */
+    ciphers = reallocarray(NULL, num_of_ciphers, sizeof(SSL_CIPHER *));
+    if (ciphers == NULL) {
+        free(co_list);
+        SSLerr(SSL_F_SSL_CREATE_CIPHER_LIST, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    num = 0;
+    for (curr = head; curr != NULL; curr = curr->next) {
+        if (curr->active)
+            ciphers[num++] = curr->cipher;
+    }
+    free(co_list); /* Not needed any longer */
+
+    *out = ciphers;
+    *out_num = num;
+    return 1;
+}
+
+/*
+ * Compiling a rule string walks the list of every available cipher once for
+ * each rule, which is most of the cost of setting a cipher list. Programs
+ * tend to set the same few strings on many contexts, so the results for the
+ * most recently compiled ones are kept.
+ */
+#define SSL_CIPHER_CACHE_SIZE 8
+
+typedef struct ssl_cipher_cache_st {
+    const SSL_CIPHER *(*get_cipher)(unsigned ncipher);
+    unsigned long disabled[5];
+    char *rule_str;
+    const SSL_CIPHER **ciphers;
+    int num;
+} SSL_CIPHER_CACHE;
+
+static SSL_CIPHER_CACHE ssl_cipher_cache[SSL_CIPHER_CACHE_SIZE];
+static int ssl_cipher_cache_next;
+static CRYPTO_MUTEX *ssl_cipher_cache_lock;
+static CRYPTO_ONCE ssl_cipher_cache_once = CRYPTO_ONCE_STATIC_INIT;
+
+static void ssl_cipher_cache_init(void)
+{
+    ssl_cipher_cache_lock = CRYPTO_thread_new();
+}
+
+static int ssl_cipher_cache_match(const SSL_CIPHER_CACHE *entry,
+                                  const SSL_METHOD *ssl_method,
+                                  const char *rule_str,
+                                  const unsigned long disabled[5])
+{
+    return entry->rule_str != NULL &&
+           entry->get_cipher == ssl_method->get_cipher &&
+           memcmp(entry->disabled, disabled, sizeof(entry->disabled)) == 0 &&
+           strcmp(entry->rule_str, rule_str) == 0;
+}
+
+/*
+ * ssl_cipher_cache_get pushes the ciphers cached for |rule_str| onto |sk|. It
+ * returns one if they were found, zero if they were not and -1 on error.
+ */
+static int ssl_cipher_cache_get(const SSL_METHOD *ssl_method,
+                                const char *rule_str,
+                                const unsigned long disabled[5],
+                                STACK_OF(SSL_CIPHER) *sk)
+{
+    const SSL_CIPHER_CACHE *entry;
+    int i, j, ret = 0;
+
+    CRYPTO_thread_run_once(&ssl_cipher_cache_once, ssl_cipher_cache_init);
+    if (ssl_cipher_cache_lock == NULL)
+        return 0;
+
+    CRYPTO_thread_read_lock(ssl_cipher_cache_lock);
+    for (i = 0; i < SSL_CIPHER_CACHE_SIZE; i++) {
+        entry = &ssl_cipher_cache[i];
+        if (!ssl_cipher_cache_match(entry, ssl_method, rule_str, disabled))
+            continue;
+        ret = 1;
+        for (j = 0; j < entry->num; j++) {
+            if (!sk_SSL_CIPHER_push(sk, (SSL_CIPHER *)entry->ciphers[j])) {
+                ret = -1;
+                break;
+            }
+        }
+        break;
+    }
+    CRYPTO_thread_unlock(ssl_cipher_cache_lock);
+
+    return ret;
+}
+
+/*
+ * ssl_cipher_cache_put keeps |ciphers|, as compiled from |rule_str|, in
+ * place of the oldest entry. It takes ownership of |ciphers|.
+ */
+static void ssl_cipher_cache_put(const SSL_METHOD *ssl_method,
+                                 const char *rule_str,
+                                 const unsigned long disabled[5],
+                                 const SSL_CIPHER **ciphers, int num)
+{
+    SSL_CIPHER_CACHE *entry;
+    char *str;
+    int i;
+
+    if (ssl_cipher_cache_lock == NULL || (str = strdup(rule_str)) == NULL) {
+        free(ciphers);
+        return;
+    }
+
+    CRYPTO_thread_write_lock(ssl_cipher_cache_lock);
+    /* Another thread may have compiled the same string meanwhile. */
+    for (i = 0; i < SSL_CIPHER_CACHE_SIZE; i++) {
+        if (ssl_cipher_cache_match(&ssl_cipher_cache[i], ssl_method, rule_str,
+                                   disabled))
+            break;
+    }
+    if (i == SSL_CIPHER_CACHE_SIZE) {
+        entry = &ssl_cipher_cache[ssl_cipher_cache_next];
+        ssl_cipher_cache_next = (ssl_cipher_cache_next + 1) %
+                                SSL_CIPHER_CACHE_SIZE;
+        free(entry->rule_str);
+        free(entry->ciphers);
+        entry->get_cipher = ssl_method->get_cipher;
+        memcpy(entry->disabled, disabled, sizeof(entry->disabled));
+        entry->rule_str = str;
+        entry->ciphers = ciphers;
+        entry->num = num;
+        str = NULL;
+        ciphers = NULL;
+    }
+    CRYPTO_thread_unlock(ssl_cipher_cache_lock);
+
+    free(str);
+    free(ciphers);
+}
+
+STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
+                                              STACK_OF(SSL_CIPHER) **cipher_list,
+                                              STACK_OF(SSL_CIPHER) **cipher_list_by_id,
+                                              uint16_t **cipher_rank,
+                                              const char *rule_str, CERT *c)
+{
+    unsigned long disabled[5];
+    STACK_OF(SSL_CIPHER) *cipherstack, *tmp_cipher_list;
+    const SSL_CIPHER **ciphers;
+    uint16_t *rank;
+    int i, idx, num, found;
+
+    /*
+     * Return with error if nothing to do.
+     */
+    if (rule_str == NULL || cipher_list == NULL || cipher_list_by_id == NULL ||
+        cipher_rank == NULL)
+        return NULL;
+
+    if (!check_suiteb_cipher_list(ssl_method, c, &rule_str))
+        return NULL;
+
+    /*
+     * To reduce the work to do we only want to process the compiled
+     * in algorithms, so we first get the mask of disabled ciphers.
+     */
+    ssl_cipher_get_disabled(&disabled[0], &disabled[1], &disabled[2],
+                            &disabled[3], &disabled[4]);
+
     /*
      * Allocate new "cipherstack" for the result, return with error
      * if we cannot get one.
      */
-    if ((cipherstack = sk_SSL_CIPHER_new_null()) == NULL) {
-        free(co_list);
+    if ((cipherstack = sk_SSL_CIPHER_new_null()) == NULL)
+        return (NULL);
+
+    found = ssl_cipher_cache_get(ssl_method, rule_str, disabled, cipherstack);
+    if (found == 0) {
+        if (!ssl_cipher_compile(ssl_method, rule_str, disabled, &ciphers,
+                                &num)) {
+            sk_SSL_CIPHER_free(cipherstack);
+            return (NULL);
+        }
+        for (i = 0; i < num; i++) {
+            if (!sk_SSL_CIPHER_push(cipherstack, (SSL_CIPHER *)ciphers[i]))
+                break;
+        }
+        if (i < num) {
+            free(ciphers);
+            found = -1;
+        } else {
+            ssl_cipher_cache_put(ssl_method, rule_str, disabled, ciphers, num);
+        }
+    }
+    if (found < 0) {
+        SSLerr(SSL_F_SSL_CREATE_CIPHER_LIST, ERR_R_MALLOC_FAILURE);
+        sk_SSL_CIPHER_free(cipherstack);
         return (NULL);
     }
 
     /*
-     * The cipher selection for the list is done. The ciphers are added
-     * to the resulting precedence to the STACK_OF(SSL_CIPHER).
+     * Rank each cipher by its position, from one, so that a cipher can be
+     * chosen from a client's list without searching this one.
      */
-    for (curr = head; curr != NULL; curr = curr->next) {
-        if (curr->active) {
-            sk_SSL_CIPHER_push(cipherstack, curr->cipher);
-        }
+    rank = calloc(ssl3_num_ciphers(), sizeof(uint16_t));
+    if (rank == NULL) {
+        SSLerr(SSL_F_SSL_CREATE_CIPHER_LIST, ERR_R_MALLOC_FAILURE);
+        sk_SSL_CIPHER_free(cipherstack);
+        return (NULL);
     }
-    free(co_list); /* Not needed any longer */
+    for (i = 0; i < sk_SSL_CIPHER_num(cipherstack); i++) {
+        idx = ssl3_cipher_index(sk_SSL_CIPHER_value(cipherstack, i));
+        if (idx >= 0)
+            rank[idx] = i + 1;
+    }
+
+    /* Index the list for the lookups made when choosing a cipher */
+    (void)sk_SSL_CIPHER_set_hash_func(cipherstack, ssl_cipher_hash);
 
     tmp_cipher_list = sk_SSL_CIPHER_dup(cipherstack);
     if (tmp_cipher_list == NULL) {
         sk_SSL_CIPHER_free(cipherstack);
+        free(rank);
         return NULL;
     }
     sk_SSL_CIPHER_free(*cipher_list);
@@ -1359,6 +1548,8 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
     sk_SSL_CIPHER_free(*cipher_list_by_id);
     *cipher_list_by_id = tmp_cipher_list;
     (void)sk_SSL_CIPHER_set_cmp_func(*cipher_list_by_id, ssl_cipher_ptr_id_cmp);
+    free(*cipher_rank);
+    *cipher_rank = rank;
 
     sk_SSL_CIPHER_sort(*cipher_list_by_id);
     return (cipherstack);
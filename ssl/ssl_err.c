@@ -168,10 +168,12 @@ static ERR_STRING_DATA SSL_str_functs[] = {
     { ERR_FUNC(SSL_F_SSL_BAD_METHOD), "SSL_BAD_METHOD" },
     { ERR_FUNC(SSL_F_SSL_BUILD_CERT_CHAIN), "ssl_build_cert_chain" },
     { ERR_FUNC(SSL_F_SSL_BYTES_TO_CIPHER_LIST), "SSL_BYTES_TO_CIPHER_LIST" },
+    { ERR_FUNC(SSL_F_SSL_CERT_ADD0_CHAIN_CERT), "SSL_CERT_ADD0_CHAIN_CERT" },
     { ERR_FUNC(SSL_F_SSL_CERT_DUP), "SSL_CERT_DUP" },
     { ERR_FUNC(SSL_F_SSL_CERT_INST), "SSL_CERT_INST" },
     { ERR_FUNC(SSL_F_SSL_CERT_INSTANTIATE), "SSL_CERT_INSTANTIATE" },
     { ERR_FUNC(SSL_F_SSL_CERT_NEW), "SSL_CERT_NEW" },
+    { ERR_FUNC(SSL_F_SSL_CERT_SET0_CHAIN), "SSL_CERT_SET0_CHAIN" },
     { ERR_FUNC(SSL_F_SSL_CHECK_PRIVATE_KEY), "SSL_CHECK_PRIVATE_KEY" },
     { ERR_FUNC(SSL_F_SSL_CHECK_SERVERHELLO_TLSEXT),
      "SSL_CHECK_SERVERHELLO_TLSEXT" },
@@ -188,6 +190,8 @@ static ERR_STRING_DATA SSL_str_functs[] = {
     { ERR_FUNC(SSL_F_SSL_CTX_CHECK_PRIVATE_KEY), "SSL_CTX_CHECK_PRIVATE_KEY" },
     { ERR_FUNC(SSL_F_SSL_CTX_MAKE_PROFILES), "SSL_CTX_MAKE_PROFILES" },
     { ERR_FUNC(SSL_F_SSL_CTX_NEW), "SSL_CTX_NEW" },
+    { ERR_FUNC(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES),
+     "SSL_CTX_REFRESH_OCSP_STAPLES" },
     { ERR_FUNC(SSL_F_SSL_CTX_SET_CIPHER_LIST), "SSL_CTX_SET_CIPHER_LIST" },
     { ERR_FUNC(SSL_F_SSL_CTX_SET_CLIENT_CERT_ENGINE),
      "SSL_CTX_SET_CLIENT_CERT_ENGINE" },
@@ -301,6 +305,8 @@ static ERR_STRING_DATA SSL_str_functs[] = {
     { ERR_FUNC(SSL_F_TLS1_ENC), "TLS1_ENC" },
     { ERR_FUNC(SSL_F_TLS1_EXPORT_KEYING_MATERIAL),
      "TLS1_EXPORT_KEYING_MATERIAL" },
+    { ERR_FUNC(SSL_F_TLS1_HANDSHAKE_DIGEST_INIT),
+     "TLS1_HANDSHAKE_DIGEST_INIT" },
     { ERR_FUNC(SSL_F_TLS1_HEARTBEAT), "TLS1_HEARTBEAT" },
     { ERR_FUNC(SSL_F_TLS1_PREPARE_CLIENTHELLO_TLSEXT),
      "TLS1_PREPARE_CLIENTHELLO_TLSEXT" },
@@ -369,6 +375,7 @@ static ERR_STRING_DATA SSL_str_reasons[] = {
     { ERR_REASON(SSL_R_CA_DN_LENGTH_MISMATCH), "ca dn length mismatch" },
     { ERR_REASON(SSL_R_CA_DN_TOO_LONG), "ca dn too long" },
     { ERR_REASON(SSL_R_CCS_RECEIVED_EARLY), "ccs received early" },
+    { ERR_REASON(SSL_R_CERTIFICATE_IN_ARENA), "certificate in arena" },
     { ERR_REASON(SSL_R_CERTIFICATE_VERIFY_FAILED), "certificate verify failed" },
     { ERR_REASON(SSL_R_CERT_CB_ERROR), "cert cb error" },
     { ERR_REASON(SSL_R_CERT_LENGTH_MISMATCH), "cert length mismatch" },
@@ -515,6 +522,8 @@ static ERR_STRING_DATA SSL_str_reasons[] = {
      "old session cipher not returned" },
     { ERR_REASON(SSL_R_OLD_SESSION_COMPRESSION_ALGORITHM_NOT_RETURNED),
      "old session compression algorithm not returned" },
+    { ERR_REASON(SSL_R_OCSP_FETCH_FAILED), "ocsp fetch failed" },
+    { ERR_REASON(SSL_R_OCSP_NO_ISSUER), "ocsp no issuer" },
     { ERR_REASON(SSL_R_ONLY_DTLS_1_2_ALLOWED_IN_SUITEB_MODE),
      "only DTLS 1.2 allowed in Suite B mode" },
     { ERR_REASON(SSL_R_ONLY_TLS_1_2_ALLOWED_IN_SUITEB_MODE),
@@ -127,7 +127,7 @@ int SSL_CTX_set_ssl_version(SSL_CTX *ctx, const SSL_METHOD *meth)
     ctx->method = meth;
 
     sk = ssl_create_cipher_list(ctx->method, &(ctx->cipher_list),
-                                &(ctx->cipher_list_by_id),
+                                &(ctx->cipher_list_by_id), &ctx->cipher_rank,
                                 SSL_DEFAULT_CIPHER_LIST, ctx->cert);
     if ((sk == NULL) || (sk_SSL_CIPHER_num(sk) <= 0)) {
         SSLerr(SSL_F_SSL_CTX_SET_SSL_VERSION, SSL_R_SSL_LIBRARY_HAS_NO_CIPHERS);
@@ -423,6 +423,7 @@ void SSL_free(SSL *s)
         sk_SSL_CIPHER_free(s->cipher_list);
     if (s->cipher_list_by_id != NULL)
         sk_SSL_CIPHER_free(s->cipher_list_by_id);
+    free(s->cipher_rank);
 
     /* Make the next call work :-) */
     if (s->session != NULL) {
@@ -1104,6 +1105,11 @@ int ssl_cipher_ptr_id_cmp(const SSL_CIPHER *const *ap,
         return ((l > 0) ? 1 : -1);
 }
 
+unsigned long ssl_cipher_hash(const SSL_CIPHER *c)
+{
+    return c->id;
+}
+
 /*
  * Return a STACK of the ciphers available for the SSL and in order of
  * preference.
@@ -1136,6 +1142,19 @@ STACK_OF(SSL_CIPHER) *ssl_get_ciphers_by_id(SSL *s)
     return (NULL);
 }
 
+/*
+ * Return the rank of each cipher in the list SSL_get_ciphers returns, or NULL
+ * if it has none.
+ */
+const uint16_t *ssl_get_cipher_rank(const SSL *s)
+{
+    if (s->cipher_list != NULL)
+        return (s->cipher_rank);
+    else if (s->ctx != NULL)
+        return (s->ctx->cipher_rank);
+    return (NULL);
+}
+
 /* The old interface to get the same thing as SSL_get_ciphers(). */
 const char *SSL_get_cipher_list(const SSL *s, int n)
 {
@@ -1159,7 +1178,8 @@ int SSL_CTX_set_cipher_list(SSL_CTX *ctx, const char *str)
     STACK_OF(SSL_CIPHER) *sk;
 
     sk = ssl_create_cipher_list(ctx->method, &ctx->cipher_list,
-                                &ctx->cipher_list_by_id, str, ctx->cert);
+                                &ctx->cipher_list_by_id, &ctx->cipher_rank,
+                                str, ctx->cert);
     /*
    * ssl_create_cipher_list may return an empty stack if it
    * was unable to find a cipher matching the given rule string
@@ -1184,7 +1204,8 @@ int SSL_set_cipher_list(SSL *s, const char *str)
     STACK_OF(SSL_CIPHER) *sk;
 
     sk = ssl_create_cipher_list(s->ctx->method, &s->cipher_list,
-                                &s->cipher_list_by_id, str, s->cert);
+                                &s->cipher_list_by_id, &s->cipher_rank, str,
+                                s->cert);
     /* see comment in SSL_CTX_set_cipher_list */
     if (sk == NULL)
         return (0);
@@ -1668,8 +1689,8 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
         goto err;
 
     ssl_create_cipher_list(ret->method, &ret->cipher_list,
-                           &ret->cipher_list_by_id, SSL_DEFAULT_CIPHER_LIST,
-                           ret->cert);
+                           &ret->cipher_list_by_id, &ret->cipher_rank,
+                           SSL_DEFAULT_CIPHER_LIST, ret->cert);
     if (ret->cipher_list == NULL || sk_SSL_CIPHER_num(ret->cipher_list) <= 0) {
         SSLerr(SSL_F_SSL_CTX_NEW, SSL_R_LIBRARY_HAS_NO_CIPHERS);
         goto err2;
@@ -1775,9 +1796,11 @@ void SSL_CTX_free(SSL_CTX *a)
     X509_STORE_free(a->cert_store);
     sk_SSL_CIPHER_free(a->cipher_list);
     sk_SSL_CIPHER_free(a->cipher_list_by_id);
+    free(a->cipher_rank);
     ssl_cert_free(a->cert);
     sk_X509_NAME_pop_free(a->client_CA, X509_NAME_free);
     sk_X509_pop_free(a->extra_certs, X509_free);
+    ssl_peer_key_cache_free(a->peer_key_cache);
 #ifndef OPENSSL_NO_ENGINE
     if (a->client_cert_engine)
         ENGINE_finish(a->client_cert_engine);
@@ -2399,6 +2422,14 @@ SSL *SSL_dup(SSL *s)
         if ((ret->cipher_list_by_id = sk_SSL_CIPHER_dup(s->cipher_list_by_id)) == NULL)
             goto err;
     }
+    if (s->cipher_rank != NULL) {
+        ret->cipher_rank = reallocarray(NULL, ssl3_num_ciphers(),
+                                        sizeof(uint16_t));
+        if (ret->cipher_rank == NULL)
+            goto err;
+        memcpy(ret->cipher_rank, s->cipher_rank,
+               ssl3_num_ciphers() * sizeof(uint16_t));
+    }
 
     /* Dup the client_CA list */
     if (s->client_CA != NULL) {
@@ -2809,8 +2840,12 @@ int ssl_handshake_hash(SSL *s, uint8_t *out, int outlen)
     for (idx = 0; ssl_get_handshake_digest(idx, &mask, &md); idx++) {
         if (mask & ssl_get_algorithm2(s)) {
             int hashsize = EVP_MD_size(md);
-            EVP_MD_CTX *hdgst = s->s3->handshake_dgst[idx];
-            if (!hdgst || hashsize < 0 || hashsize > outlen)
+            EVP_MD_CTX *hdgst;
+            if (s->s3->handshake_dgst == NULL)
+                goto err;
+            hdgst = &s->s3->handshake_dgst[idx];
+            if (EVP_MD_CTX_md(hdgst) == NULL || hashsize < 0 ||
+                hashsize > outlen)
                 goto err;
             if (!EVP_MD_CTX_copy_ex(&ctx, hdgst))
                 goto err;
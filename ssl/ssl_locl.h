@@ -33,6 +33,8 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 
+#include "bytestring.h"
+
 #define c2l(c, l)                                                              \
     (l = ((unsigned long)(*((c)++))), l |= (((unsigned long)(*((c)++))) << 8), \
      l |= (((unsigned long)(*((c)++))) << 16),                                 \
@@ -348,6 +350,9 @@ typedef struct cert_pkey_st {
      uint8_t *serverinfo;
      size_t serverinfo_length;
 
+    /* OCSP response stapled for this certificate, shared with copies */
+    struct ssl_ocsp_staple_st *ocsp_staple;
+
     /*
      * Set if CERT_PKEY can be used with current SSL session: e.g.
      * appropriate curve, signature algorithms etc. If zero it can't be
@@ -355,6 +360,23 @@ typedef struct cert_pkey_st {
      */
     int valid_flags;
 } CERT_PKEY;
+
+/*
+ * An OCSP response for a server certificate, as fetched by
+ * SSL_CTX_refresh_ocsp_staples. The CertificateStatus message body is built
+ * once, so stapling it is a copy. A staple never changes after creation;
+ * refreshing replaces the CERT_PKEY's reference, and connections keep the
+ * one they started with.
+ */
+typedef struct ssl_ocsp_staple_st {
+    int references;
+    CRYPTO_MUTEX *lock;
+    /* Not stapled at or after this time */
+    time_t next_update;
+    /* CertificateStatus body: status type, length and the DER response */
+    uint8_t *msg;
+    size_t msg_len;
+} SSL_OCSP_STAPLE;
 /* Retrieve Suite B flags */
 #define tls1_suiteb(s) (s->cert->cert_flags & SSL_CERT_FLAG_SUITEB_128_LOS)
 /* Uses to check strict mode: suite B modes are always strict */
@@ -522,6 +544,25 @@ typedef struct sess_cert_st {
     CRYPTO_MUTEX *lock;
 } SESS_CERT;
 
+/*
+ * Up to SSL_PEER_KEY_CACHE_SIZE decoded peer public keys are kept per
+ * SSL_CTX for connections in SSL_MODE_CACHE_PEER_CERTS, each with the DER
+ * certificate it came from.
+ */
+#define SSL_PEER_KEY_CACHE_SIZE 64
+
+typedef struct ssl_peer_key_entry_st {
+    uint32_t hash;
+    uint8_t *der;
+    size_t der_len;
+    EVP_PKEY *pkey;
+} SSL_PEER_KEY_ENTRY;
+
+typedef struct ssl_peer_key_cache_st {
+    SSL_PEER_KEY_ENTRY entries[SSL_PEER_KEY_CACHE_SIZE];
+    CRYPTO_MUTEX *lock;
+} SSL_PEER_KEY_CACHE;
+
 /* Structure containing decoded values of signature algorithms extension */
 struct tls_sigalgs_st {
     /* NID of hash algorithm */
@@ -649,6 +690,8 @@ int ssl_cipher_id_cmp(const SSL_CIPHER *a, const SSL_CIPHER *b);
 DECLARE_OBJ_BSEARCH_GLOBAL_CMP_FN(SSL_CIPHER, SSL_CIPHER, ssl_cipher_id);
 int ssl_cipher_ptr_id_cmp(const SSL_CIPHER *const *ap,
                           const SSL_CIPHER *const *bp);
+unsigned long ssl_cipher_hash(const SSL_CIPHER *c);
+const uint16_t *ssl_get_cipher_rank(const SSL *s);
 STACK_OF(SSL_CIPHER) *ssl_bytes_to_cipher_list(SSL *s, const uint8_t *p,
                                                int num);
 int ssl_cipher_list_to_bytes(SSL *s, STACK_OF(SSL_CIPHER) *sk, uint8_t *p,
@@ -656,6 +699,7 @@ int ssl_cipher_list_to_bytes(SSL *s, STACK_OF(SSL_CIPHER) *sk, uint8_t *p,
 STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *meth,
                                              STACK_OF(SSL_CIPHER) **pref,
                                              STACK_OF(SSL_CIPHER) **sorted,
+                                             uint16_t **rank,
                                              const char *rule_str, CERT *c);
 void ssl_update_cache(SSL *s, int mode);
 int ssl_cipher_get_evp(const SSL_SESSION *s, const EVP_CIPHER **enc,
@@ -675,6 +719,12 @@ X509 *ssl_cert_get0_next_certificate(CERT *c, int first);
 void ssl_cert_set_cert_cb(CERT *c, int (*cb)(SSL *ssl, void *arg), void *arg);
 
 int ssl_verify_cert_chain(SSL *s, STACK_OF(X509) *sk);
+X509 *ssl_get_peer_x509(SSL *s, const uint8_t **in, size_t len);
+SSL_PEER_KEY_CACHE *ssl_peer_key_cache_new(void);
+void ssl_peer_key_cache_free(SSL_PEER_KEY_CACHE *cache);
+void ssl_ocsp_staple_up_ref(SSL_OCSP_STAPLE *staple);
+void ssl_ocsp_staple_free(SSL_OCSP_STAPLE *staple);
+int ssl_ocsp_staple_usable(const SSL_OCSP_STAPLE *staple);
 int ssl_add_cert_chain(SSL *s, CERT_PKEY *cpk, unsigned long *l);
 int ssl_build_cert_chain(CERT *c, X509_STORE *chain_store, int flags);
 int ssl_cert_set_cert_store(CERT *c, X509_STORE *store, int chain, int ref);
@@ -709,6 +759,7 @@ long ssl3_get_message(SSL *s, int st1, int stn, int mt, long max, int *ok);
 int ssl3_send_finished(SSL *s, int a, int b, const char *sender, int slen);
 int ssl3_num_ciphers(void);
 const SSL_CIPHER *ssl3_get_cipher(unsigned int u);
+int ssl3_cipher_index(const SSL_CIPHER *c);
 const SSL_CIPHER *ssl3_get_cipher_by_id(unsigned int id);
 const SSL_CIPHER *ssl3_get_cipher_by_value(uint16_t value);
 uint16_t ssl3_cipher_get_value(const SSL_CIPHER *cipher);
@@ -721,6 +772,8 @@ int ssl3_read_bytes(SSL *s, int type, uint8_t *buf, int len, int peek);
 int ssl3_write_bytes(SSL *s, int type, const void *buf, int len);
 int tls1_finish_mac(SSL *s, const uint8_t *buf, int len);
 void tls1_free_digest_list(SSL *s);
+EVP_MD_CTX *tls1_handshake_digest(SSL *s, int md_nid);
+int tls1_handshake_digest_init(SSL *s, EVP_MD_CTX *ctx, const EVP_MD *md);
 unsigned long ssl3_output_cert_chain(SSL *s, CERT_PKEY *cpk);
 SSL_CIPHER *ssl3_choose_cipher(SSL *ssl, STACK_OF(SSL_CIPHER) *clnt,
                                STACK_OF(SSL_CIPHER) *srvr);
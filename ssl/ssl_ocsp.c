@@ -0,0 +1,213 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Built-in OCSP stapling. SSL_CTX_refresh_ocsp_staples fetches a response
+ * for each server certificate and turns it into an SSL_OCSP_STAPLE, which
+ * holds the CertificateStatus message ready to send. Connections take a
+ * reference to the staples when they copy the SSL_CTX's CERT, so a
+ * handshake reads its own staple without any locking and sending it is a
+ * single copy into the handshake buffer.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include <openssl/ocsp.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <win32compat.h>
+
+#include "internal/threads.h"
+#include "ssl_locl.h"
+
+static SSL_OCSP_STAPLE *ssl_ocsp_staple_new(const uint8_t *der,
+                                            size_t der_len,
+                                            time_t next_update)
+{
+    SSL_OCSP_STAPLE *staple;
+    uint8_t *p;
+
+    if (der_len > 0xffffff)
+        return NULL;
+    if ((staple = calloc(1, sizeof(*staple))) == NULL)
+        return NULL;
+    staple->references = 1;
+    staple->next_update = next_update;
+    staple->msg_len = 4 + der_len;
+    if ((staple->lock = CRYPTO_thread_new()) == NULL ||
+        (staple->msg = malloc(staple->msg_len)) == NULL) {
+        ssl_ocsp_staple_free(staple);
+        return NULL;
+    }
+
+    p = staple->msg;
+    *(p++) = TLSEXT_STATUSTYPE_ocsp;
+    l2n3(der_len, p);
+    memcpy(p, der, der_len);
+
+    return staple;
+}
+
+void ssl_ocsp_staple_up_ref(SSL_OCSP_STAPLE *staple)
+{
+    int refs;
+
+    CRYPTO_atomic_add(&staple->references, 1, &refs, staple->lock);
+}
+
+void ssl_ocsp_staple_free(SSL_OCSP_STAPLE *staple)
+{
+    int refs;
+
+    if (staple == NULL)
+        return;
+    CRYPTO_atomic_add(&staple->references, -1, &refs, staple->lock);
+    if (refs > 0)
+        return;
+
+    free(staple->msg);
+    CRYPTO_thread_cleanup(staple->lock);
+    free(staple);
+}
+
+/* ssl_ocsp_staple_usable returns one if |staple| may be sent now. */
+int ssl_ocsp_staple_usable(const SSL_OCSP_STAPLE *staple)
+{
+    return staple != NULL && time(NULL) < staple->next_update;
+}
+
+void SSL_CTX_set_ocsp_fetch_cb(SSL_CTX *ctx, SSL_OCSP_FETCH_CB cb, void *arg)
+{
+    ctx->ocsp_fetch_cb = cb;
+    ctx->ocsp_fetch_arg = arg;
+}
+
+static X509 *ssl_ocsp_find_issuer(SSL_CTX *ctx, CERT_PKEY *cpk)
+{
+    STACK_OF(X509) *chain;
+    X509 *x;
+    int i;
+
+    chain = cpk->chain != NULL ? cpk->chain : ctx->extra_certs;
+    for (i = 0; i < sk_X509_num(chain); i++) {
+        x = sk_X509_value(chain, i);
+        if (X509_check_issued(x, cpk->x509) == X509_V_OK)
+            return x;
+    }
+    return NULL;
+}
+
+/*
+ * ssl_ocsp_next_update checks that |resp| is a successful response with a
+ * status for the certificate |x| issued by |issuer|, and sets |*out| to its
+ * nextUpdate time.
+ */
+static int ssl_ocsp_next_update(OCSP_RESPONSE *resp, X509 *x, X509 *issuer,
+                                time_t *out)
+{
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_CERTID *id = NULL;
+    ASN1_GENERALIZEDTIME *thisupd, *nextupd = NULL;
+    struct tm tm;
+    int status, reason, ret = 0;
+
+    if (OCSP_response_status(resp) != OCSP_RESPONSE_STATUS_SUCCESSFUL ||
+        (bs = OCSP_response_get1_basic(resp)) == NULL ||
+        (id = OCSP_cert_to_id(NULL, x, issuer)) == NULL ||
+        !OCSP_resp_find_status(bs, id, &status, &reason, NULL, &thisupd,
+                               &nextupd) ||
+        nextupd == NULL)
+        goto err;
+
+    memset(&tm, 0, sizeof(tm));
+    if (ASN1_time_parse((const char *)nextupd->data, nextupd->length, &tm,
+                        V_ASN1_GENERALIZEDTIME) == -1 ||
+        (*out = timegm(&tm)) == -1)
+        goto err;
+    ret = 1;
+
+err:
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(bs);
+    return ret;
+}
+
+static int ssl_ocsp_refresh(SSL_CTX *ctx, CERT_PKEY *cpk)
+{
+    CERT *c = ctx->cert;
+    SSL_OCSP_STAPLE *staple, *old;
+    OCSP_RESPONSE *resp;
+    X509 *issuer;
+    uint8_t *der = NULL;
+    time_t next_update;
+    int der_len;
+
+    if ((issuer = ssl_ocsp_find_issuer(ctx, cpk)) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES, SSL_R_OCSP_NO_ISSUER);
+        return 0;
+    }
+    resp = ctx->ocsp_fetch_cb(ctx, cpk->x509, issuer, ctx->ocsp_fetch_arg);
+    if (resp == NULL) {
+        SSLerr(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES, SSL_R_OCSP_FETCH_FAILED);
+        return 0;
+    }
+    if (!ssl_ocsp_next_update(resp, cpk->x509, issuer, &next_update) ||
+        next_update <= time(NULL) ||
+        (der_len = i2d_OCSP_RESPONSE(resp, &der)) <= 0) {
+        OCSP_RESPONSE_free(resp);
+        SSLerr(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES,
+               SSL_R_INVALID_STATUS_RESPONSE);
+        return 0;
+    }
+    OCSP_RESPONSE_free(resp);
+
+    staple = ssl_ocsp_staple_new(der, der_len, next_update);
+    free(der);
+    if (staple == NULL) {
+        SSLerr(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    CRYPTO_thread_write_lock(c->lock);
+    old = cpk->ocsp_staple;
+    cpk->ocsp_staple = staple;
+    CRYPTO_thread_unlock(c->lock);
+
+    ssl_ocsp_staple_free(old);
+    return 1;
+}
+
+int SSL_CTX_refresh_ocsp_staples(SSL_CTX *ctx, long margin)
+{
+    CERT *c = ctx->cert;
+    CERT_PKEY *cpk;
+    time_t now = time(NULL);
+    int i, fresh, ret = 1;
+
+    if (ctx->ocsp_fetch_cb == NULL) {
+        SSLerr(SSL_F_SSL_CTX_REFRESH_OCSP_STAPLES, SSL_R_OCSP_FETCH_FAILED);
+        return 0;
+    }
+
+    for (i = 0; i < SSL_PKEY_NUM; i++) {
+        cpk = &c->pkeys[i];
+        if (cpk->x509 == NULL)
+            continue;
+
+        CRYPTO_thread_read_lock(c->lock);
+        fresh = cpk->ocsp_staple != NULL &&
+                cpk->ocsp_staple->next_update - now > margin;
+        CRYPTO_thread_unlock(c->lock);
+
+        if (!fresh && !ssl_ocsp_refresh(ctx, cpk))
+            ret = 0;
+    }
+    return ret;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * The peer public key cache. Peer certificates are decoded into X509 objects
+ * by ssl_get_peer_x509, and every connection gets its own X509, since
+ * verification records its results in the object. In
+ * SSL_MODE_CACHE_PEER_CERTS the decoded public key, which verification only
+ * reads, is shared instead: it is looked up in a cache on the SSL_CTX and
+ * attached to the new X509, so a peer that sends the same certificate again
+ * does not have its key decoded again. The cache is allocated the first time
+ * a connection in that mode receives a certificate.
+ */
+
+#include <string.h>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include "internal/threads.h"
+#include "ssl_locl.h"
+
+/*
+ * The cache is indexed by a hash of the signature, which d2i_X509 has
+ * already decoded and which differs between certificates. Hits are confirmed
+ * against the whole encoding, so a crafted collision can only cause a miss.
+ */
+static uint32_t ssl_peer_key_hash(const X509 *x)
+{
+    const uint8_t *p = x->signature->data;
+    uint32_t h = 2166136261U;
+    int i;
+
+    for (i = 0; i < x->signature->length; i++)
+        h = (h ^ p[i]) * 16777619U;
+    return h;
+}
+
+SSL_PEER_KEY_CACHE *ssl_peer_key_cache_new(void)
+{
+    SSL_PEER_KEY_CACHE *cache;
+
+    if ((cache = calloc(1, sizeof(*cache))) == NULL)
+        return NULL;
+    if ((cache->lock = CRYPTO_thread_new()) == NULL) {
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void ssl_peer_key_cache_free(SSL_PEER_KEY_CACHE *cache)
+{
+    size_t i;
+
+    if (cache == NULL)
+        return;
+    for (i = 0; i < SSL_PEER_KEY_CACHE_SIZE; i++) {
+        free(cache->entries[i].der);
+        EVP_PKEY_free(cache->entries[i].pkey);
+    }
+    CRYPTO_thread_cleanup(cache->lock);
+    free(cache);
+}
+
+/*
+ * ssl_peer_key_cache_get_ctx returns the cache of |ctx|, allocating it on
+ * first use, or NULL if it cannot be allocated.
+ */
+static SSL_PEER_KEY_CACHE *ssl_peer_key_cache_get_ctx(SSL_CTX *ctx)
+{
+    SSL_PEER_KEY_CACHE *cache;
+
+    cache = CRYPTO_atomic_get_ptr((void **)&ctx->peer_key_cache, ctx->lock);
+    if (cache != NULL)
+        return cache;
+
+    CRYPTO_thread_write_lock(ctx->lock);
+    if ((cache = ctx->peer_key_cache) == NULL &&
+        (cache = ssl_peer_key_cache_new()) != NULL)
+        CRYPTO_atomic_set_ptr((void **)&ctx->peer_key_cache, cache, NULL);
+    CRYPTO_thread_unlock(ctx->lock);
+    return cache;
+}
+
+static EVP_PKEY *ssl_peer_key_cache_get(SSL_PEER_KEY_CACHE *cache,
+                                        uint32_t hash, const CBS *der)
+{
+    SSL_PEER_KEY_ENTRY *entry;
+    EVP_PKEY *pkey = NULL;
+
+    entry = &cache->entries[hash % SSL_PEER_KEY_CACHE_SIZE];
+
+    CRYPTO_thread_read_lock(cache->lock);
+    if (entry->pkey != NULL && entry->hash == hash &&
+        CBS_mem_equal(der, entry->der, entry->der_len)) {
+        pkey = entry->pkey;
+        EVP_PKEY_up_ref(pkey);
+    }
+    CRYPTO_thread_unlock(cache->lock);
+
+    return pkey;
+}
+
+static void ssl_peer_key_cache_put(SSL_PEER_KEY_CACHE *cache, uint32_t hash,
+                                   const CBS *der, EVP_PKEY *pkey)
+{
+    SSL_PEER_KEY_ENTRY *entry, old;
+    uint8_t *copy = NULL;
+    size_t copy_len;
+
+    if (!CBS_stow(der, &copy, &copy_len))
+        return;
+    EVP_PKEY_up_ref(pkey);
+
+    entry = &cache->entries[hash % SSL_PEER_KEY_CACHE_SIZE];
+
+    CRYPTO_thread_write_lock(cache->lock);
+    old = *entry;
+    entry->hash = hash;
+    entry->der = copy;
+    entry->der_len = copy_len;
+    entry->pkey = pkey;
+    CRYPTO_thread_unlock(cache->lock);
+
+    free(old.der);
+    EVP_PKEY_free(old.pkey);
+}
+
+/*
+ * ssl_get_peer_x509 decodes the DER certificate at |*in|, which is |len|
+ * bytes long, into a new X509 and advances |*in| past it, like d2i_X509. It
+ * returns NULL if the certificate does not decode.
+ */
+X509 *ssl_get_peer_x509(SSL *s, const uint8_t **in, size_t len)
+{
+    SSL_PEER_KEY_CACHE *cache;
+    const uint8_t *start = *in;
+    EVP_PKEY *pkey;
+    uint32_t hash;
+    CBS der;
+    X509 *x;
+
+    if ((x = d2i_X509(NULL, in, len)) == NULL)
+        return NULL;
+    if (!(s->mode & SSL_MODE_CACHE_PEER_CERTS) ||
+        (cache = ssl_peer_key_cache_get_ctx(s->ctx)) == NULL)
+        return x;
+
+    CBS_init(&der, start, *in - start);
+    hash = ssl_peer_key_hash(x);
+    if ((pkey = ssl_peer_key_cache_get(cache, hash, &der)) != NULL) {
+        /* Nothing else can see |x| yet, so no lock is needed */
+        x->cert_info->key->pkey = pkey;
+        return x;
+    }
+
+    /*
+     * Keys that take their parameters from the issuer are completed during
+     * verification, so they are not shared.
+     */
+    ERR_set_mark();
+    if ((pkey = X509_get_pubkey(x)) != NULL &&
+        !EVP_PKEY_missing_parameters(pkey))
+        ssl_peer_key_cache_put(cache, hash, &der, pkey);
+    EVP_PKEY_free(pkey);
+    ERR_pop_to_mark();
+    return x;
+}
@@ -12,6 +12,7 @@
 #include <openssl/objects.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 #include <openssl/pem.h>
 
 #include "ssl_locl.h"
@@ -299,6 +300,10 @@ static int ssl_set_cert(CERT *c, X509 *x)
     EVP_PKEY *pkey;
     int i;
 
+    if (x->ex_flags & EXFLAG_ARENA) {
+        SSLerr(SSL_F_SSL_SET_CERT, SSL_R_CERTIFICATE_IN_ARENA);
+        return (0);
+    }
     pkey = X509_get_pubkey(x);
     if (pkey == NULL) {
         SSLerr(SSL_F_SSL_SET_CERT, SSL_R_X509_LIB);
@@ -341,6 +346,9 @@ static int ssl_set_cert(CERT *c, X509 *x)
     X509_free(c->pkeys[i].x509);
     X509_up_ref(x);
     c->pkeys[i].x509 = x;
+    /* A staple for the previous certificate does not cover this one */
+    ssl_ocsp_staple_free(c->pkeys[i].ocsp_staple);
+    c->pkeys[i].ocsp_staple = NULL;
     c->key = &(c->pkeys[i]);
 
     c->valid = 0;
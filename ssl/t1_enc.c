@@ -11,8 +11,81 @@
 #include "ssl_locl.h"
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
+#ifndef OPENSSL_NO_ENGINE
+#include <openssl/engine.h>
+#endif
 #include <openssl/md5.h>
 #include <openssl/rand.h>
+#include <openssl/sha.h>
+
+/*
+ * The PRF digests are run directly on the hash primitives. The keyed HMAC
+ * inner and outer states are computed once per P_hash and then copied on
+ * the stack, where EVP_DigestSign would allocate a key and several
+ * contexts on every call.
+ */
+typedef union {
+    MD5_CTX md5;
+    SHA_CTX sha1;
+    SHA256_CTX sha256;
+    SHA512_CTX sha512;
+} TLS1_PRF_MD_CTX;
+
+typedef struct {
+    int type;
+    const EVP_MD *(*evp)(void);
+    size_t md_size;
+    size_t block_size;
+    void (*init)(TLS1_PRF_MD_CTX *ctx);
+    void (*update)(TLS1_PRF_MD_CTX *ctx, const void *data, size_t len);
+    void (*final)(uint8_t *md, TLS1_PRF_MD_CTX *ctx);
+} TLS1_PRF_MD;
+
+#define TLS1_PRF_MD_FUNCS(name, field, prefix)                           \
+    static void tls1_prf_##name##_init(TLS1_PRF_MD_CTX *ctx)             \
+    {                                                                    \
+        prefix##_Init(&ctx->field);                                      \
+    }                                                                    \
+    static void tls1_prf_##name##_update(TLS1_PRF_MD_CTX *ctx,           \
+                                         const void *data, size_t len)   \
+    {                                                                    \
+        prefix##_Update(&ctx->field, data, len);                         \
+    }                                                                    \
+    static void tls1_prf_##name##_final(uint8_t *md, TLS1_PRF_MD_CTX *ctx) \
+    {                                                                    \
+        prefix##_Final(md, &ctx->field);                                 \
+    }
+
+TLS1_PRF_MD_FUNCS(md5, md5, MD5)
+TLS1_PRF_MD_FUNCS(sha1, sha1, SHA1)
+TLS1_PRF_MD_FUNCS(sha256, sha256, SHA256)
+TLS1_PRF_MD_FUNCS(sha384, sha512, SHA384)
+
+static const TLS1_PRF_MD tls1_prf_mds[] = {
+    {
+        NID_md5, EVP_md5, MD5_DIGEST_LENGTH, MD5_CBLOCK,
+        tls1_prf_md5_init, tls1_prf_md5_update, tls1_prf_md5_final,
+    },
+    {
+        NID_sha1, EVP_sha1, SHA_DIGEST_LENGTH, SHA_CBLOCK,
+        tls1_prf_sha1_init, tls1_prf_sha1_update, tls1_prf_sha1_final,
+    },
+    {
+        NID_sha256, EVP_sha256, SHA256_DIGEST_LENGTH, SHA256_CBLOCK,
+        tls1_prf_sha256_init, tls1_prf_sha256_update, tls1_prf_sha256_final,
+    },
+    {
+        NID_sha384, EVP_sha384, SHA384_DIGEST_LENGTH, SHA512_CBLOCK,
+        tls1_prf_sha384_init, tls1_prf_sha384_update, tls1_prf_sha384_final,
+    },
+};
+
+/* HMAC key schedule: the states after absorbing key^ipad and key^opad. */
+typedef struct {
+    const TLS1_PRF_MD *md;
+    TLS1_PRF_MD_CTX inner;
+    TLS1_PRF_MD_CTX outer;
+} TLS1_PRF_HMAC;
 
 void ssl3_cleanup_key_block(SSL *s)
 {
@@ -31,18 +104,18 @@ void tls1_init_finished_mac(SSL *s)
     (void)BIO_set_close(s->s3->handshake_buffer, BIO_CLOSE);
 }
 
+/*
+ * tls1_free_digest_list resets every handshake digest. The array itself is
+ * kept for the next handshake and freed in ssl3_free.
+ */
 void tls1_free_digest_list(SSL *s)
 {
     int i;
 
     if (s->s3->handshake_dgst == NULL)
         return;
-    for (i = 0; i < SSL_MAX_DIGEST; i++) {
-        if (s->s3->handshake_dgst[i])
-            EVP_MD_CTX_destroy(s->s3->handshake_dgst[i]);
-    }
-    free(s->s3->handshake_dgst);
-    s->s3->handshake_dgst = NULL;
+    for (i = 0; i < SSL_MAX_DIGEST; i++)
+        EVP_MD_CTX_cleanup(&s->s3->handshake_dgst[i]);
 }
 
 int tls1_finish_mac(SSL *s, const uint8_t *buf, int len)
@@ -54,10 +127,12 @@ int tls1_finish_mac(SSL *s, const uint8_t *buf, int len)
         return 1;
     }
 
+    if (s->s3->handshake_dgst == NULL)
+        return 1;
     for (i = 0; i < SSL_MAX_DIGEST; i++) {
-        if (s->s3->handshake_dgst[i] == NULL)
+        if (EVP_MD_CTX_md(&s->s3->handshake_dgst[i]) == NULL)
             continue;
-        if (!EVP_DigestUpdate(s->s3->handshake_dgst[i], buf, len)) {
+        if (!EVP_DigestUpdate(&s->s3->handshake_dgst[i], buf, len)) {
             SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_EVP_LIB);
             return 0;
         }
@@ -75,10 +150,12 @@ int tls1_digest_cached_records(SSL *s)
 
     tls1_free_digest_list(s);
 
-    s->s3->handshake_dgst = calloc(SSL_MAX_DIGEST, sizeof(EVP_MD_CTX *));
     if (s->s3->handshake_dgst == NULL) {
-        SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_MALLOC_FAILURE);
-        goto err;
+        s->s3->handshake_dgst = calloc(SSL_MAX_DIGEST, sizeof(EVP_MD_CTX));
+        if (s->s3->handshake_dgst == NULL) {
+            SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
     }
     hdatalen = BIO_get_mem_data(s->s3->handshake_buffer, &hdata);
     if (hdatalen <= 0) {
@@ -91,16 +168,11 @@ int tls1_digest_cached_records(SSL *s)
         if ((mask & ssl_get_algorithm2(s)) == 0 || md == NULL)
             continue;
 
-        s->s3->handshake_dgst[i] = EVP_MD_CTX_create();
-        if (s->s3->handshake_dgst[i] == NULL) {
-            SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-        if (!EVP_DigestInit_ex(s->s3->handshake_dgst[i], md, NULL)) {
+        if (!EVP_DigestInit_ex(&s->s3->handshake_dgst[i], md, NULL)) {
             SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_EVP_LIB);
             goto err;
         }
-        if (!EVP_DigestUpdate(s->s3->handshake_dgst[i], hdata, hdatalen)) {
+        if (!EVP_DigestUpdate(&s->s3->handshake_dgst[i], hdata, hdatalen)) {
             SSLerr(SSL_F_SSL3_DIGEST_CACHED_RECORDS, ERR_R_EVP_LIB);
             goto err;
         }
@@ -118,6 +190,50 @@ err:
     return 0;
 }
 
+/*
+ * tls1_handshake_digest returns the running handshake digest that uses the
+ * digest |md_nid|, or NULL if there is none.
+ */
+EVP_MD_CTX *tls1_handshake_digest(SSL *s, int md_nid)
+{
+    EVP_MD_CTX *d;
+    int i;
+
+    if (s->s3->handshake_dgst == NULL)
+        return NULL;
+    for (i = 0; i < SSL_MAX_DIGEST; i++) {
+        d = &s->s3->handshake_dgst[i];
+        if (EVP_MD_CTX_md(d) != NULL && EVP_MD_CTX_type(d) == md_nid)
+            return d;
+    }
+    return NULL;
+}
+
+/*
+ * tls1_handshake_digest_init sets up |ctx| as a hash of the handshake so far
+ * with |md|, for a signature over the handshake. A running handshake digest
+ * for |md| is copied if there is one; otherwise the cached records are
+ * hashed. Both must cover the same messages, which is not the case on a
+ * server that has frozen the records and digested more messages since.
+ */
+int tls1_handshake_digest_init(SSL *s, EVP_MD_CTX *ctx, const EVP_MD *md)
+{
+    EVP_MD_CTX *d;
+    long hdatalen;
+    void *hdata;
+
+    if ((d = tls1_handshake_digest(s, EVP_MD_type(md))) != NULL)
+        return EVP_MD_CTX_copy_ex(ctx, d);
+
+    if (s->s3->handshake_buffer == NULL ||
+        (hdatalen = BIO_get_mem_data(s->s3->handshake_buffer, &hdata)) <= 0) {
+        SSLerr(SSL_F_TLS1_HANDSHAKE_DIGEST_INIT, SSL_R_BAD_HANDSHAKE_LENGTH);
+        return 0;
+    }
+    return EVP_DigestInit_ex(ctx, md, NULL) &&
+           EVP_DigestUpdate(ctx, hdata, hdatalen);
+}
+
 void tls1_record_sequence_increment(uint8_t *seq)
 {
     int i;
@@ -128,6 +244,138 @@ void tls1_record_sequence_increment(uint8_t *seq)
     }
 }
 
+/*
+ * tls1_prf_md returns the direct implementation of |md|, or NULL if the PRF
+ * must go through EVP. That is the case unless |md| is the built-in digest
+ * and no ENGINE is registered for it or for HMAC, since EVP would then run
+ * the ENGINE's implementation instead.
+ */
+static const TLS1_PRF_MD *tls1_prf_md(const EVP_MD *md)
+{
+    const TLS1_PRF_MD *prf_md = NULL;
+#ifndef OPENSSL_NO_ENGINE
+    ENGINE *e;
+#endif
+    size_t i;
+
+    for (i = 0; i < sizeof(tls1_prf_mds) / sizeof(tls1_prf_mds[0]); i++) {
+        if (tls1_prf_mds[i].type == EVP_MD_type(md)) {
+            prf_md = &tls1_prf_mds[i];
+            break;
+        }
+    }
+    if (prf_md == NULL || md != prf_md->evp())
+        return NULL;
+#ifndef OPENSSL_NO_ENGINE
+    if ((e = ENGINE_get_digest_engine(prf_md->type)) != NULL ||
+        (e = ENGINE_get_pkey_meth_engine(EVP_PKEY_HMAC)) != NULL) {
+        ENGINE_finish(e);
+        return NULL;
+    }
+#endif
+    return prf_md;
+}
+
+static void tls1_prf_hmac_init(TLS1_PRF_HMAC *hmac, const TLS1_PRF_MD *md,
+                               const uint8_t *key, size_t key_len)
+{
+    uint8_t pad[SHA512_CBLOCK];
+    size_t i;
+
+    memset(pad, 0, sizeof(pad));
+    if (key_len > md->block_size) {
+        md->init(&hmac->inner);
+        md->update(&hmac->inner, key, key_len);
+        md->final(pad, &hmac->inner);
+    } else {
+        memcpy(pad, key, key_len);
+    }
+
+    for (i = 0; i < md->block_size; i++)
+        pad[i] ^= 0x36;
+    md->init(&hmac->inner);
+    md->update(&hmac->inner, pad, md->block_size);
+
+    for (i = 0; i < md->block_size; i++)
+        pad[i] ^= 0x36 ^ 0x5c;
+    md->init(&hmac->outer);
+    md->update(&hmac->outer, pad, md->block_size);
+
+    hmac->md = md;
+    vigortls_zeroize(pad, sizeof(pad));
+}
+
+/*
+ * tls1_prf_hmac_final finishes the HMAC whose inner hash is |ctx| and
+ * writes the md_size byte result to |out|.
+ */
+static void tls1_prf_hmac_final(const TLS1_PRF_HMAC *hmac,
+                                TLS1_PRF_MD_CTX *ctx, uint8_t *out)
+{
+    const TLS1_PRF_MD *md = hmac->md;
+    uint8_t inner[EVP_MAX_MD_SIZE];
+
+    md->final(inner, ctx);
+    *ctx = hmac->outer;
+    md->update(ctx, inner, md->md_size);
+    md->final(out, ctx);
+    vigortls_zeroize(inner, sizeof(inner));
+}
+
+static void tls1_prf_update_seeds(const TLS1_PRF_MD *md, TLS1_PRF_MD_CTX *ctx,
+                                  const void *const seed[5],
+                                  const int seed_len[5])
+{
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        if (seed[i] != NULL)
+            md->update(ctx, seed[i], seed_len[i]);
+    }
+}
+
+static void tls1_P_hash_direct(const TLS1_PRF_MD *md, const uint8_t *sec,
+                               int sec_len, const void *const seed[5],
+                               const int seed_len[5], uint8_t *out, int olen)
+{
+    TLS1_PRF_HMAC hmac;
+    TLS1_PRF_MD_CTX ctx, ctx_tmp;
+    uint8_t A1[EVP_MAX_MD_SIZE];
+    int chunk = md->md_size;
+
+    tls1_prf_hmac_init(&hmac, md, sec, sec_len);
+
+    ctx = hmac.inner;
+    tls1_prf_update_seeds(md, &ctx, seed, seed_len);
+    tls1_prf_hmac_final(&hmac, &ctx, A1);
+
+    for (;;) {
+        ctx = hmac.inner;
+        md->update(&ctx, A1, chunk);
+        if (olen > chunk)
+            ctx_tmp = ctx;
+        tls1_prf_update_seeds(md, &ctx, seed, seed_len);
+
+        if (olen > chunk) {
+            tls1_prf_hmac_final(&hmac, &ctx, out);
+            out += chunk;
+            olen -= chunk;
+            /* calc the next A1 value */
+            tls1_prf_hmac_final(&hmac, &ctx_tmp, A1);
+        } else {
+            /* last one */
+            tls1_prf_hmac_final(&hmac, &ctx, A1);
+            memcpy(out, A1, olen);
+            break;
+        }
+    }
+
+    vigortls_zeroize(&hmac, sizeof(hmac));
+    vigortls_zeroize(&ctx, sizeof(ctx));
+    vigortls_zeroize(&ctx_tmp, sizeof(ctx_tmp));
+    vigortls_zeroize(A1, sizeof(A1));
+}
+
 /* seed1 through seed5 are virtually concatenated */
 static int tls1_P_hash(const EVP_MD *md, const uint8_t *sec, int sec_len,
                        const void *seed1, int seed1_len, const void *seed2,
@@ -141,8 +389,19 @@ static int tls1_P_hash(const EVP_MD *md, const uint8_t *sec, int sec_len,
     EVP_PKEY *mac_key;
     uint8_t A1[EVP_MAX_MD_SIZE];
     size_t A1_len;
+    const TLS1_PRF_MD *prf_md;
     int ret = 0;
 
+    if ((prf_md = tls1_prf_md(md)) != NULL) {
+        const void *const seed[5] = { seed1, seed2, seed3, seed4, seed5 };
+        const int seed_len[5] = {
+            seed1_len, seed2_len, seed3_len, seed4_len, seed5_len,
+        };
+
+        tls1_P_hash_direct(prf_md, sec, sec_len, seed, seed_len, out, olen);
+        return 1;
+    }
+
     chunk = EVP_MD_size(md);
     OPENSSL_assert(chunk >= 0);
 
@@ -934,21 +1193,14 @@ int tls1_enc(SSL *s, int send)
 
 int tls1_cert_verify_mac(SSL *s, int md_nid, uint8_t *out)
 {
-    EVP_MD_CTX ctx, *d = NULL;
+    EVP_MD_CTX ctx, *d;
     unsigned int ret;
-    int i;
 
     if (s->s3->handshake_buffer)
         if (!tls1_digest_cached_records(s))
             return 0;
 
-    for (i = 0; i < SSL_MAX_DIGEST; i++) {
-        if (s->s3->handshake_dgst[i] && EVP_MD_CTX_type(s->s3->handshake_dgst[i]) == md_nid) {
-            d = s->s3->handshake_dgst[i];
-            break;
-        }
-    }
-    if (d == NULL) {
+    if ((d = tls1_handshake_digest(s, md_nid)) == NULL) {
         SSLerr(SSL_F_TLS1_CERT_VERIFY_MAC, SSL_R_NO_REQUIRED_DIGEST);
         return 0;
     }
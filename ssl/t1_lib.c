@@ -1693,8 +1693,8 @@ static int ssl_scan_clienthello_tlsext(SSL *s, uint8_t **p, uint8_t *limit,
                 goto err;
             if (!tls1_save_sigalgs(s, data, dsize))
                 goto err;
-        } else if (type == TLSEXT_TYPE_status_request
-                   && s->ctx->tlsext_status_cb)
+        } else if (type == TLSEXT_TYPE_status_request &&
+                   (s->ctx->tlsext_status_cb || s->ctx->ocsp_fetch_cb))
         {
 
             if (size < 5)
@@ -2255,6 +2255,17 @@ int ssl_check_clienthello_tlsext_late(SSL *s)
                 al = SSL_AD_INTERNAL_ERROR;
                 goto err;
         }
+    } else if (s->tlsext_status_type == TLSEXT_STATUSTYPE_ocsp && s->ctx &&
+               s->ctx->ocsp_fetch_cb) {
+        /* Staple the cached response for the certificate, if any */
+        CERT_PKEY *certpkey;
+        certpkey = ssl_get_server_send_pkey(s);
+        s->tlsext_status_expected = 0;
+        if (certpkey != NULL &&
+            ssl_ocsp_staple_usable(certpkey->ocsp_staple)) {
+            s->cert->key = certpkey;
+            s->tlsext_status_expected = 1;
+        }
     } else
         s->tlsext_status_expected = 0;
 
@@ -32,7 +32,7 @@
  *   TAG: 1d45758621762e061368e68868e2f929
  */
 
-#define BUF_MAX 1024
+#define BUF_MAX 4096
 
 /* These are the different types of line that are found in the input file. */
 enum {
@@ -174,7 +174,7 @@ int main(int argc, char **argv)
         lengths[j] = 0;
 
     for (;;) {
-        char line[4096];
+        char line[16384];
         unsigned int i, type_len = 0;
 
         uint8_t *buf = NULL;
@@ -285,6 +285,16 @@ int main(int argc, char **argv)
         }
     }
 
+    /* The last test need not be followed by a blank line. */
+    for (j = 0; j < NUM_TYPES; j++) {
+        if (lengths[j] != 0) {
+            if (!run_test_case(aead, bufs, lengths, line_no))
+                return 4;
+            num_tests++;
+            break;
+        }
+    }
+
     printf("Completed %u test cases\n", num_tests);
     printf("\x1b[32mPASS\x1b[0m\n");
     fclose(fp);
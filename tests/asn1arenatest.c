@@ -0,0 +1,511 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Decodes the certificates under tests/data, and a CRL, both normally and
+ * into an ASN1_ARENA and checks that the results agree, and that arena values
+ * can be neither modified nor kept past the arena. With a "bench" argument,
+ * it then times both ways of parsing the certificates and, where malloc can
+ * be interposed, counts the allocations each makes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/asn1.h>
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include "testutil.h"
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCS
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static unsigned long num_allocs;
+
+void *malloc(size_t len)
+{
+    num_allocs++;
+    return __libc_malloc(len);
+}
+
+void *calloc(size_t num, size_t size)
+{
+    num_allocs++;
+    return __libc_calloc(num, size);
+}
+
+void *realloc(void *ptr, size_t len)
+{
+    num_allocs++;
+    return __libc_realloc(ptr, len);
+}
+#endif
+
+#define MAX_CERTS 64
+#define BENCH_ROUNDS 2000
+
+static const char *cert_files[] = {
+    "ca.pem",
+    "server.pem",
+    "certs/bad.pem",
+    "certs/interCA.pem",
+    "certs/leaf.pem",
+    "certs/pss1.pem",
+    "certs/rootCA.pem",
+    "certs/roots.pem",
+    "certs/subinterCA.pem",
+    "certs/subinterCA-ss.pem",
+    "certs/untrusted.pem",
+};
+
+static uint8_t *ders[MAX_CERTS];
+static long der_lens[MAX_CERTS];
+static int num_ders;
+
+static int load_certs(void)
+{
+    char *name = NULL, *header = NULL;
+    uint8_t *data = NULL;
+    long len;
+    size_t i;
+    BIO *bio;
+
+    for (i = 0; i < sizeof(cert_files) / sizeof(cert_files[0]); i++) {
+        if ((bio = BIO_new_file(cert_files[i], "r")) == NULL) {
+            printf("Unable to open %s\n", cert_files[i]);
+            return 0;
+        }
+        while (PEM_read_bio(bio, &name, &header, &data, &len)) {
+            if (strcmp(name, PEM_STRING_X509) == 0 && num_ders < MAX_CERTS) {
+                ders[num_ders] = data;
+                der_lens[num_ders] = len;
+                num_ders++;
+                data = NULL;
+            }
+            free(name);
+            free(header);
+            free(data);
+            name = header = NULL;
+            data = NULL;
+        }
+        ERR_clear_error();
+        BIO_free(bio);
+    }
+    if (num_ders == 0) {
+        printf("No certificates found\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int same_encoding(const uint8_t *a, int a_len, const uint8_t *b,
+                         int b_len)
+{
+    return a_len > 0 && a_len == b_len && memcmp(a, b, a_len) == 0;
+}
+
+static int check_cert(ASN1_ARENA *arena, int idx)
+{
+    const uint8_t *p, *q;
+    uint8_t *enc = NULL, *arena_enc = NULL;
+    X509 *x = NULL, *ax;
+    EVP_PKEY *key = NULL, *arena_key = NULL;
+    int len, arena_len, ret = 0;
+
+    p = ders[idx];
+    q = ders[idx];
+    x = d2i_X509(NULL, &p, der_lens[idx]);
+    ax = d2i_X509_arena(arena, &q, der_lens[idx]);
+    if (x == NULL || ax == NULL || p != q) {
+        printf("Certificate %d: decoding failed\n", idx);
+        goto err;
+    }
+
+    len = i2d_X509(x, &enc);
+    arena_len = i2d_X509(ax, &arena_enc);
+    if (!same_encoding(enc, len, arena_enc, arena_len) ||
+        !same_encoding(ders[idx], der_lens[idx], arena_enc, arena_len)) {
+        printf("Certificate %d: encodings differ\n", idx);
+        goto err;
+    }
+
+    if (X509_NAME_cmp(X509_get_subject_name(x),
+                      X509_get_subject_name(ax)) != 0 ||
+        X509_NAME_cmp(X509_get_issuer_name(x),
+                      X509_get_issuer_name(ax)) != 0 ||
+        ASN1_INTEGER_cmp(X509_get_serialNumber(x),
+                         X509_get_serialNumber(ax)) != 0) {
+        printf("Certificate %d: names or serial numbers differ\n", idx);
+        goto err;
+    }
+
+    if (X509_check_purpose(x, -1, 0) != X509_check_purpose(ax, -1, 0) ||
+        x->ex_flags != (ax->ex_flags & ~EXFLAG_ARENA) ||
+        x->ex_kusage != ax->ex_kusage ||
+        X509_check_ca(x) != X509_check_ca(ax)) {
+        printf("Certificate %d: extensions differ\n", idx);
+        goto err;
+    }
+
+    key = X509_get_pubkey(x);
+    arena_key = X509_get_pubkey(ax);
+    if ((key == NULL) != (arena_key == NULL) ||
+        (key != NULL && EVP_PKEY_cmp(key, arena_key) != 1)) {
+        printf("Certificate %d: public keys differ\n", idx);
+        goto err;
+    }
+
+    /* A truncated certificate must fail cleanly, leaving nothing behind */
+    q = ders[idx];
+    if (d2i_X509_arena(arena, &q, der_lens[idx] - 1) != NULL) {
+        printf("Certificate %d: truncated encoding was accepted\n", idx);
+        goto err;
+    }
+    ERR_clear_error();
+
+    ret = 1;
+
+ err:
+    free(enc);
+    free(arena_enc);
+    EVP_PKEY_free(key);
+    EVP_PKEY_free(arena_key);
+    X509_free(x);
+    return ret;
+}
+
+static int test_certs(void)
+{
+    ASN1_ARENA *arena;
+    int i, ret = 1;
+
+    if ((arena = ASN1_ARENA_new()) == NULL)
+        return 0;
+    for (i = 0; i < num_ders; i++) {
+        if (!check_cert(arena, i))
+            ret = 0;
+    }
+    ASN1_ARENA_free(arena);
+    return ret;
+}
+
+static ASN1_INTEGER *make_serial(long i)
+{
+    ASN1_INTEGER *serial;
+
+    if ((serial = ASN1_INTEGER_new()) == NULL)
+        return NULL;
+    if (!ASN1_INTEGER_set(serial, 1000 + i)) {
+        ASN1_INTEGER_free(serial);
+        return NULL;
+    }
+    return serial;
+}
+
+/* make_crl returns the DER encoding of a CRL revoking serials 1000-1099 */
+static int make_crl(uint8_t **der)
+{
+    X509_CRL *crl;
+    X509_REVOKED *rev = NULL;
+    X509_NAME *name;
+    ASN1_INTEGER *serial = NULL;
+    ASN1_TIME *tm;
+    long i;
+    int len = 0;
+
+    crl = X509_CRL_new();
+    name = X509_NAME_new();
+    tm = ASN1_TIME_set(NULL, 1000000000);
+    if (crl == NULL || name == NULL || tm == NULL ||
+        !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (const uint8_t *)"Test CA", -1, -1, 0) ||
+        !X509_CRL_set_version(crl, 1) ||
+        !X509_CRL_set_issuer_name(crl, name) ||
+        !X509_CRL_set_lastUpdate(crl, tm))
+        goto err;
+
+    for (i = 0; i < 100; i++) {
+        if ((rev = X509_REVOKED_new()) == NULL ||
+            (serial = make_serial(i)) == NULL ||
+            !X509_REVOKED_set_serialNumber(rev, serial) ||
+            !X509_REVOKED_set_revocationDate(rev, tm) ||
+            !X509_CRL_add0_revoked(crl, rev))
+            goto err;
+        rev = NULL;
+        ASN1_INTEGER_free(serial);
+        serial = NULL;
+    }
+
+    /* Nothing here checks the signature, so a placeholder will do */
+    if (!X509_ALGOR_set0(crl->crl->sig_alg,
+                         OBJ_nid2obj(NID_ecdsa_with_SHA256), V_ASN1_UNDEF,
+                         NULL) ||
+        !X509_ALGOR_set0(crl->sig_alg, OBJ_nid2obj(NID_ecdsa_with_SHA256),
+                         V_ASN1_UNDEF, NULL) ||
+        !ASN1_BIT_STRING_set(crl->signature, (uint8_t *)"sig", 3))
+        goto err;
+
+    len = i2d_X509_CRL(crl, der);
+
+ err:
+    X509_REVOKED_free(rev);
+    ASN1_INTEGER_free(serial);
+    ASN1_TIME_free(tm);
+    X509_NAME_free(name);
+    X509_CRL_free(crl);
+    return len;
+}
+
+static int test_crl(void)
+{
+    ASN1_ARENA *arena = NULL;
+    X509_CRL *crl;
+    X509_REVOKED *rev;
+    ASN1_INTEGER *serial = NULL;
+    uint8_t *der = NULL, *enc = NULL;
+    const uint8_t *p;
+    int der_len, len, ret = 0;
+    long i;
+
+    if ((der_len = make_crl(&der)) <= 0) {
+        printf("Creating the CRL failed\n");
+        goto err;
+    }
+    if ((arena = ASN1_ARENA_new()) == NULL)
+        goto err;
+    p = der;
+    if ((crl = d2i_X509_CRL_arena(arena, &p, der_len)) == NULL) {
+        printf("Decoding the CRL failed\n");
+        goto err;
+    }
+
+    len = i2d_X509_CRL(crl, &enc);
+    if (!same_encoding(der, der_len, enc, len)) {
+        printf("CRL encodings differ\n");
+        goto err;
+    }
+
+    for (i = 0; i < 110; i++) {
+        if ((serial = make_serial(i)) == NULL)
+            goto err;
+        if (X509_CRL_get0_by_serial(crl, &rev, serial) != (i < 100)) {
+            printf("Lookup of serial %ld failed\n", 1000 + i);
+            goto err;
+        }
+        ASN1_INTEGER_free(serial);
+        serial = NULL;
+    }
+
+    ret = 1;
+
+ err:
+    ASN1_INTEGER_free(serial);
+    ASN1_ARENA_free(arena);
+    free(enc);
+    free(der);
+    return ret;
+}
+
+/*
+ * test_escape checks that an arena certificate and CRL refuse to be modified
+ * or added to a store, and are left unchanged by the attempts, and that
+ * freeing them on their own leaves them to the arena.
+ */
+static int test_escape(void)
+{
+    ASN1_ARENA *arena = NULL;
+    X509_STORE *store = NULL;
+    X509_NAME *name = NULL;
+    ASN1_INTEGER *serial = NULL;
+    X509 *x;
+    X509_CRL *crl;
+    uint8_t *der = NULL, *enc = NULL, *name_enc = NULL;
+    const uint8_t *p;
+    int der_len, len, ret = 0;
+
+    if ((arena = ASN1_ARENA_new()) == NULL ||
+        (store = X509_STORE_new()) == NULL ||
+        (name = X509_NAME_new()) == NULL ||
+        (serial = make_serial(0)) == NULL)
+        goto err;
+
+    p = ders[0];
+    if ((x = d2i_X509_arena(arena, &p, der_lens[0])) == NULL)
+        goto err;
+    if (X509_STORE_add_cert(store, x) ||
+        ERR_GET_REASON(ERR_get_error()) != X509_R_VALUE_IN_ARENA) {
+        printf("Arena certificate was added to a store\n");
+        goto err;
+    }
+    if (X509_set_version(x, 0) || X509_set_serialNumber(x, serial) ||
+        X509_set_subject_name(x, name) || X509_add_ext(x, NULL, -1) ||
+        X509_delete_ext(x, 0) != NULL ||
+        ASN1_INTEGER_set(X509_get_serialNumber(x), 1) ||
+        ASN1_STRING_set(X509_get_serialNumber(x), "x", 1) ||
+        X509_NAME_delete_entry(X509_get_subject_name(x), 0) != NULL) {
+        printf("Arena certificate was modified\n");
+        goto err;
+    }
+    ERR_clear_error();
+    len = i2d_X509(x, &enc);
+    if (!same_encoding(ders[0], der_lens[0], enc, len)) {
+        printf("Arena certificate changed\n");
+        goto err;
+    }
+
+    /* Entries added to an arena name live on the heap and are freed with it */
+    if (!X509_NAME_add_entry_by_txt(X509_get_subject_name(x), "CN",
+                                    MBSTRING_ASC, (const uint8_t *)"extra",
+                                    -1, -1, 0) ||
+        i2d_X509_NAME(X509_get_subject_name(x), &name_enc) <= 0) {
+        printf("Adding to an arena name failed\n");
+        goto err;
+    }
+
+    if ((der_len = make_crl(&der)) <= 0)
+        goto err;
+    p = der;
+    if ((crl = d2i_X509_CRL_arena(arena, &p, der_len)) == NULL)
+        goto err;
+    if (X509_STORE_add_crl(store, crl) || X509_CRL_sort(crl) ||
+        X509_CRL_set_version(crl, 0) || X509_CRL_add0_revoked(crl, NULL)) {
+        printf("Arena CRL was modified or added to a store\n");
+        goto err;
+    }
+    ERR_clear_error();
+
+    /* The arena still owns both, so they must be intact afterwards. */
+    X509_free(x);
+    X509_CRL_free(crl);
+    free(enc);
+    enc = NULL;
+    len = i2d_X509(x, &enc);
+    if (!same_encoding(ders[0], der_lens[0], enc, len) ||
+        X509_CRL_get0_by_serial(crl, NULL, serial) != 1) {
+        printf("Freeing an arena value released it\n");
+        goto err;
+    }
+
+    ret = 1;
+
+ err:
+    ASN1_ARENA_free(arena);
+    X509_STORE_free(store);
+    X509_NAME_free(name);
+    ASN1_INTEGER_free(serial);
+    free(der);
+    free(enc);
+    free(name_enc);
+    return ret;
+}
+
+static void report(const char *mode, double secs, unsigned long allocs)
+{
+    double parses = (double)BENCH_ROUNDS * num_ders;
+
+    test_report(mode, parses, secs, "parses");
+#ifdef COUNT_ALLOCS
+    printf("%-30s %12.1f allocations per certificate\n", mode,
+           allocs / parses);
+#endif
+}
+
+static int bench(void)
+{
+    X509 *certs[MAX_CERTS];
+    ASN1_ARENA *arena;
+    const uint8_t *p;
+    unsigned long allocs = 0;
+    double start;
+    int i, round;
+
+#ifdef COUNT_ALLOCS
+    allocs = num_allocs;
+#endif
+    start = test_now();
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (i = 0; i < num_ders; i++) {
+            p = ders[i];
+            if ((certs[i] = d2i_X509(NULL, &p, der_lens[i])) == NULL)
+                return 0;
+        }
+        for (i = 0; i < num_ders; i++)
+            X509_free(certs[i]);
+    }
+#ifdef COUNT_ALLOCS
+    allocs = num_allocs - allocs;
+#endif
+    report("heap", test_now() - start, allocs);
+
+#ifdef COUNT_ALLOCS
+    allocs = num_allocs;
+#endif
+    start = test_now();
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        if ((arena = ASN1_ARENA_new()) == NULL)
+            return 0;
+        for (i = 0; i < num_ders; i++) {
+            p = ders[i];
+            if (d2i_X509_arena(arena, &p, der_lens[i]) == NULL) {
+                ASN1_ARENA_free(arena);
+                return 0;
+            }
+        }
+        ASN1_ARENA_free(arena);
+    }
+#ifdef COUNT_ALLOCS
+    allocs = num_allocs - allocs;
+#endif
+    report("arena", test_now() - start, allocs);
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, ret = 1;
+
+    ERR_load_crypto_strings();
+    OpenSSL_add_all_algorithms();
+
+    if (!load_certs())
+        goto err;
+    if (!test_certs() || !test_crl() || !test_escape())
+        goto err;
+    if (test_bench_requested(argc, argv) && !bench()) {
+        printf("Benchmark decoding failed\n");
+        goto err;
+    }
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    for (i = 0; i < num_ders; i++)
+        free(ders[i]);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
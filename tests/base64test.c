@@ -0,0 +1,276 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that base64 decoding gives the same results however the input is
+ * split, in place or not, and that a bad character anywhere in a full line
+ * is rejected, since full lines take a faster path than the rest. Then reads
+ * PEM blocks back from memory and buffered BIOs, checking that each read
+ * consumes exactly one block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+
+#define MAX_LEN 600
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                               "abcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* encode returns |in| encoded in lines of 64 characters, optionally CRLF. */
+static char *encode(const uint8_t *in, int inl, int crlf, int *outl)
+{
+    EVP_ENCODE_CTX ctx;
+    char *b64, *out;
+    int i, n, total, len = 0;
+
+    b64 = malloc(inl * 2 + 80);
+    out = malloc(inl * 3 + 80);
+    if (b64 == NULL || out == NULL) {
+        free(b64);
+        free(out);
+        return NULL;
+    }
+    EVP_EncodeInit(&ctx);
+    EVP_EncodeUpdate(&ctx, (uint8_t *)b64, &n, in, inl);
+    total = n;
+    EVP_EncodeFinal(&ctx, (uint8_t *)b64 + total, &n);
+    total += n;
+    for (i = 0; i < total; i++) {
+        if (crlf && b64[i] == '\n')
+            out[len++] = '\r';
+        out[len++] = b64[i];
+    }
+    free(b64);
+    *outl = len;
+    return out;
+}
+
+/*
+ * decode decodes |inl| bytes of |in| into |out|, |chunk| bytes at a time, or
+ * in place in |in| if |out| is NULL. It returns the decoded length or -1.
+ */
+static int decode(uint8_t *out, uint8_t *in, int inl, int chunk)
+{
+    EVP_ENCODE_CTX ctx;
+    int off, n, total = 0;
+
+    if (out == NULL)
+        out = in;
+    EVP_DecodeInit(&ctx);
+    for (off = 0; off < inl; off += chunk) {
+        n = inl - off < chunk ? inl - off : chunk;
+        if (EVP_DecodeUpdate(&ctx, out + total, &n, in + off, n) < 0)
+            return -1;
+        total += n;
+    }
+    if (EVP_DecodeFinal(&ctx, out + total, &n) < 0)
+        return -1;
+    return total + n;
+}
+
+static int test_round_trip(void)
+{
+    static const int chunks[] = { 1, 3, 7, 63, 64, 65, 66, 200, MAX_LEN * 2 };
+    uint8_t data[MAX_LEN], out[MAX_LEN + 64];
+    char *b64;
+    int len, b64len, crlf, i, n;
+
+    for (len = 0; len <= MAX_LEN; len++) {
+        RAND_bytes(data, len);
+        for (crlf = 0; crlf < 2; crlf++) {
+            if ((b64 = encode(data, len, crlf, &b64len)) == NULL)
+                return 0;
+            for (i = 0; i < (int)(sizeof(chunks) / sizeof(chunks[0])); i++) {
+                n = decode(out, (uint8_t *)b64, b64len, chunks[i]);
+                if (n != len || memcmp(out, data, len) != 0) {
+                    printf("Decoding %d bytes in chunks of %d failed\n", len,
+                           chunks[i]);
+                    free(b64);
+                    return 0;
+                }
+            }
+            n = decode(NULL, (uint8_t *)b64, b64len, b64len);
+            if (n != len || memcmp(b64, data, len) != 0) {
+                printf("Decoding %d bytes in place failed\n", len);
+                free(b64);
+                return 0;
+            }
+            free(b64);
+        }
+    }
+    return 1;
+}
+
+/* ref_decode_block is EVP_DecodeBlock for unpadded alphabet characters. */
+static void ref_decode_block(uint8_t *out, const char *in, int n)
+{
+    unsigned long l;
+    int i, j;
+
+    for (i = 0; i < n; i += 4) {
+        l = 0;
+        for (j = 0; j < 4; j++)
+            l = (l << 6) | (strchr(alphabet, in[i + j]) - alphabet);
+        *(out++) = l >> 16;
+        *(out++) = l >> 8;
+        *(out++) = l;
+    }
+}
+
+static int test_decode_block(void)
+{
+    char in[256 + 1];
+    uint8_t out[192], ref[192];
+    int n, i, iter;
+
+    for (iter = 0; iter < 2000; iter++) {
+        n = 4 * (1 + rand() % 64);
+        for (i = 0; i < n; i++)
+            in[i] = alphabet[rand() % 64];
+        in[n] = '\0';
+        ref_decode_block(ref, in, n);
+        if (EVP_DecodeBlock(out, (uint8_t *)in, n) != n / 4 * 3 ||
+            memcmp(out, ref, n / 4 * 3) != 0) {
+            printf("EVP_DecodeBlock of %d characters failed\n", n);
+            return 0;
+        }
+        /* A bad character anywhere but the trimmed ends is an error. */
+        i = 1 + rand() % (n - 2);
+        in[i] = "*-.\x80 \n"[rand() % 6];
+        if (EVP_DecodeBlock(out, (uint8_t *)in, n) != -1) {
+            printf("EVP_DecodeBlock accepted 0x%02x at %d of %d\n",
+                   (uint8_t)in[i], i, n);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int test_bad_lines(void)
+{
+    static const char bad[] = { '*', '.', ':', '@', '[', '`', '{', '\x7f',
+                                '\x80', '\xff', '\0', '=' };
+    char line[64 * 3 + 2];
+    uint8_t out[sizeof(line)];
+    int i, j, n;
+
+    for (i = 0; i < 64 * 3; i++)
+        line[i] = alphabet[i % 64];
+    line[64 * 3] = '\n';
+    for (i = 0; i < 64; i++) {
+        for (j = 0; j < (int)sizeof(bad); j++) {
+            line[64 + i] = bad[j];
+            n = decode(out, (uint8_t *)line, 64 * 3 + 1, sizeof(line));
+            if (n != -1) {
+                printf("Decoding accepted 0x%02x at %d\n", (uint8_t)bad[j], i);
+                return 0;
+            }
+            line[64 + i] = alphabet[i];
+        }
+    }
+    return 1;
+}
+
+static int read_blocks(BIO *bio, uint8_t blocks[][MAX_LEN], int *lens,
+                       int count, const char *trailer, const char *what)
+{
+    char *name, *header, rest[64];
+    uint8_t *data;
+    long len;
+    int i, n;
+
+    for (i = 0; i < count; i++) {
+        if (!PEM_read_bio(bio, &name, &header, &data, &len)) {
+            printf("%s: reading block %d failed\n", what, i);
+            return 0;
+        }
+        if (strcmp(name, "TEST BLOCK") != 0 || len != lens[i] ||
+            memcmp(data, blocks[i], len) != 0 ||
+            (i == 1 && strcmp(header, "Comment: one\n") != 0)) {
+            printf("%s: block %d differs\n", what, i);
+            return 0;
+        }
+        free(name);
+        free(header);
+        free(data);
+    }
+    n = BIO_read(bio, rest, sizeof(rest) - 1);
+    rest[n < 0 ? 0 : n] = '\0';
+    if (strcmp(rest, trailer) != 0) {
+        printf("%s: left \"%s\" unread\n", what, rest);
+        return 0;
+    }
+    return 1;
+}
+
+static int test_pem(void)
+{
+    static const char trailer[] = "trailing text\n";
+    uint8_t blocks[3][MAX_LEN];
+    int lens[3] = { 1, 48, MAX_LEN };
+    BIO *mem, *ro = NULL, *buf = NULL;
+    char *pem;
+    long pemlen;
+    int i, ret = 0;
+
+    if ((mem = BIO_new(BIO_s_mem())) == NULL)
+        return 0;
+    BIO_puts(mem, "leading text\n");
+    for (i = 0; i < 3; i++) {
+        RAND_bytes(blocks[i], lens[i]);
+        if (!PEM_write_bio(mem, "TEST BLOCK", i == 1 ? "Comment: one\n" : "",
+                           blocks[i], lens[i]))
+            goto err;
+    }
+    BIO_puts(mem, trailer);
+    pemlen = BIO_get_mem_data(mem, &pem);
+
+    if ((ro = BIO_new_mem_buf(pem, pemlen)) == NULL ||
+        !read_blocks(ro, blocks, lens, 3, trailer, "read-only"))
+        goto err;
+    BIO_free(ro);
+    if ((ro = BIO_new_mem_buf(pem, pemlen)) == NULL ||
+        (buf = BIO_new(BIO_f_buffer())) == NULL)
+        goto err;
+    BIO_push(buf, ro);
+    ro = NULL;
+    if (!read_blocks(buf, blocks, lens, 3, trailer, "buffered"))
+        goto err;
+    if (!read_blocks(mem, blocks, lens, 3, trailer, "writable"))
+        goto err;
+    ret = 1;
+
+err:
+    BIO_free(mem);
+    BIO_free(ro);
+    BIO_free_all(buf);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 1;
+
+    if (!test_round_trip() || !test_decode_block() || !test_bad_lines() ||
+        !test_pem())
+        goto err;
+
+    printf("PASS\n");
+    ret = 0;
+
+err:
+    return ret;
+}
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that the contexts kept by each thread for BN_CTX_new_cached are
+ * reused, cleared between uses and not shared by nested callers. Where
+ * malloc can be counted, checks that modular exponentiation and DH stop
+ * allocating once the thread's contexts are warm, and prints how many
+ * allocations other public key operations still make.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/dh.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/err.h>
+#include <openssl/obj_mac.h>
+#include <openssl/rsa.h>
+
+#if defined(OPENSSL_THREADS) && !defined(_WIN32)
+#include <pthread.h>
+#define TEST_THREADS
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define BUILT_WITH_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define BUILT_WITH_ASAN
+#endif
+#endif
+
+/* Allocations are counted by wrapping the C library's allocator */
+#if defined(__GLIBC__) && !defined(BUILT_WITH_ASAN)
+#define COUNT_ALLOCS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static int counting;
+static long num_allocs;
+
+void *malloc(size_t size)
+{
+    if (counting)
+        num_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    if (counting)
+        num_allocs++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (counting)
+        num_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+void *reallocarray(void *ptr, size_t nmemb, size_t size)
+{
+    if (size != 0 && nmemb > (size_t)-1 / size)
+        return NULL;
+    return realloc(ptr, nmemb * size);
+}
+#endif
+
+static int test_reuse(void)
+{
+    BN_CTX *ctx, *nested[6];
+    BIGNUM *bn;
+    BN_ULONG *d;
+    int i, j, top;
+
+    if ((ctx = BN_CTX_new_cached()) == NULL)
+        return 0;
+    BN_CTX_start(ctx);
+    if ((bn = BN_CTX_get(ctx)) == NULL || !BN_set_word(bn, 0x5a5a) ||
+        !BN_lshift(bn, bn, 1000)) {
+        BN_CTX_end(ctx);
+        BN_CTX_free(ctx);
+        return 0;
+    }
+    d = bn->d;
+    top = bn->top;
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+
+    /* The same context comes back, with its values cleared */
+    for (i = 0; i < top; i++) {
+        if (d[i] != 0) {
+            printf("Cached context not cleared\n");
+            return 0;
+        }
+    }
+    if (BN_CTX_new_cached() != ctx) {
+        printf("Cached context not reused\n");
+        return 0;
+    }
+    BN_CTX_start(ctx);
+    bn = BN_CTX_get(ctx);
+    if (bn == NULL || bn->d != d || !BN_is_zero(bn)) {
+        printf("Cached context not warm\n");
+        BN_CTX_end(ctx);
+        BN_CTX_free(ctx);
+        return 0;
+    }
+
+    /* Callers nested inside it get contexts of their own */
+    for (i = 0; i < 6; i++) {
+        if ((nested[i] = BN_CTX_new_cached()) == NULL)
+            return 0;
+        for (j = 0; j < i; j++) {
+            if (nested[i] == nested[j] || nested[i] == ctx) {
+                printf("Cached context handed out twice\n");
+                return 0;
+            }
+        }
+    }
+    for (i = 5; i >= 0; i--)
+        BN_CTX_free(nested[i]);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return 1;
+}
+
+/* test_mod_exp does a modular exponentiation the way the library does. */
+static int test_mod_exp(const BIGNUM *a, const BIGNUM *p, const BIGNUM *m,
+                        BN_MONT_CTX *mont)
+{
+    BN_CTX *ctx;
+    BIGNUM *r;
+    int ret;
+
+    if ((ctx = BN_CTX_new_cached()) == NULL)
+        return 0;
+    BN_CTX_start(ctx);
+    ret = (r = BN_CTX_get(ctx)) != NULL &&
+          BN_mod_exp_mont_consttime(r, a, p, m, ctx, mont);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
+typedef struct {
+    RSA *rsa;
+    EC_KEY *ec;
+    DH *dh;
+    BIGNUM *a, *p, *m;
+    BN_MONT_CTX *mont;
+} TEST_KEYS;
+
+static int keys_new(TEST_KEYS *keys)
+{
+    BIGNUM *e;
+    int ret;
+
+    memset(keys, 0, sizeof(*keys));
+    if ((e = BN_new()) == NULL || !BN_set_word(e, RSA_F4)) {
+        BN_free(e);
+        return 0;
+    }
+    ret = (keys->rsa = RSA_new()) != NULL &&
+          RSA_generate_key_ex(keys->rsa, 1024, e, NULL) &&
+          (keys->ec = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) != NULL &&
+          EC_KEY_generate_key(keys->ec) &&
+          (keys->dh = DH_get_2048_256()) != NULL &&
+          DH_generate_key(keys->dh) &&
+          (keys->a = BN_new()) != NULL && (keys->p = BN_new()) != NULL &&
+          (keys->m = BN_new()) != NULL &&
+          BN_rand(keys->m, 1024, 0, 1) && BN_rand(keys->a, 1000, 0, 0) &&
+          BN_rand(keys->p, 1024, 0, 0) &&
+          (keys->mont = BN_MONT_CTX_new()) != NULL;
+    BN_free(e);
+    if (ret) {
+        BN_CTX *ctx = BN_CTX_new();
+
+        ret = ctx != NULL && BN_MONT_CTX_set(keys->mont, keys->m, ctx);
+        BN_CTX_free(ctx);
+    }
+    return ret;
+}
+
+static void keys_free(TEST_KEYS *keys)
+{
+    RSA_free(keys->rsa);
+    EC_KEY_free(keys->ec);
+    DH_free(keys->dh);
+    BN_free(keys->a);
+    BN_free(keys->p);
+    BN_free(keys->m);
+    BN_MONT_CTX_free(keys->mont);
+}
+
+enum { OP_MOD_EXP, OP_RSA, OP_ECDSA_SIGN, OP_ECDSA_VERIFY, OP_DH, OP_NUM };
+
+static const char *op_names[OP_NUM] = {
+    "mod exp", "RSA private", "ECDSA sign", "ECDSA verify", "DH derive",
+};
+
+static int do_op(TEST_KEYS *keys, int op)
+{
+    static uint8_t in[128], out[256];
+    ECDSA_SIG *sig;
+    int ret;
+
+    switch (op) {
+    case OP_MOD_EXP:
+        return test_mod_exp(keys->a, keys->p, keys->m, keys->mont);
+    case OP_RSA:
+        in[0] = 0;
+        in[1] = 1;
+        return RSA_private_encrypt(sizeof(in), in, out, keys->rsa,
+                                   RSA_NO_PADDING) > 0;
+    case OP_ECDSA_SIGN:
+        sig = ECDSA_do_sign(in, 32, keys->ec);
+        ECDSA_SIG_free(sig);
+        return sig != NULL;
+    case OP_ECDSA_VERIFY:
+        if ((sig = ECDSA_do_sign(in, 32, keys->ec)) == NULL)
+            return 0;
+        ret = ECDSA_do_verify(in, 32, sig, keys->ec) == 1;
+        ECDSA_SIG_free(sig);
+        return ret;
+    case OP_DH:
+        return DH_compute_key(out, keys->dh->pub_key, keys->dh) > 0;
+    }
+    return 0;
+}
+
+#define WARM_OPS 4
+#define COUNTED_OPS 16
+
+static int test_steady_state(TEST_KEYS *keys)
+{
+    int i, op;
+
+    for (op = 0; op < OP_NUM; op++) {
+        for (i = 0; i < WARM_OPS; i++) {
+            if (!do_op(keys, op)) {
+                printf("%s failed\n", op_names[op]);
+                return 0;
+            }
+        }
+#ifdef COUNT_ALLOCS
+        {
+            long allocs, verify_sign_allocs = 0;
+
+            if (op == OP_ECDSA_VERIFY) {
+                /* Verifying needs a signature, which is counted apart */
+                counting = 1;
+                num_allocs = 0;
+                do_op(keys, OP_ECDSA_SIGN);
+                counting = 0;
+                verify_sign_allocs = num_allocs;
+            }
+            counting = 1;
+            num_allocs = 0;
+            for (i = 0; i < COUNTED_OPS; i++)
+                do_op(keys, op);
+            counting = 0;
+            allocs = num_allocs / COUNTED_OPS - verify_sign_allocs;
+            printf("%-12s %3ld allocations\n", op_names[op], allocs);
+            /* The others still allocate their results and EC points */
+            if ((op == OP_MOD_EXP || op == OP_DH) && num_allocs != 0) {
+                printf("Warm context still allocates\n");
+                return 0;
+            }
+        }
+#endif
+    }
+    return 1;
+}
+
+#ifdef TEST_THREADS
+
+static volatile int thread_failed;
+
+static void *thread_main(void *arg)
+{
+    TEST_KEYS *keys = arg;
+    int i;
+
+    for (i = 0; i < 50; i++) {
+        if (!do_op(keys, i % OP_NUM))
+            thread_failed = 1;
+    }
+    if (!test_reuse())
+        thread_failed = 1;
+    ERR_remove_thread_state(NULL);
+    return NULL;
+}
+
+/* test_threads checks that threads do not share contexts. */
+static int test_threads(TEST_KEYS *keys)
+{
+    pthread_t threads[4];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        if (pthread_create(&threads[i], NULL, thread_main, keys) != 0)
+            return 0;
+    }
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    if (thread_failed) {
+        printf("Operation failed in a thread\n");
+        return 0;
+    }
+    return 1;
+}
+
+#endif
+
+int main(int argc, char *argv[])
+{
+    TEST_KEYS keys;
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+
+    if (!keys_new(&keys)) {
+        printf("Key generation failed\n");
+        goto err;
+    }
+    if (!test_reuse() || !test_steady_state(&keys))
+        goto err;
+#ifdef TEST_THREADS
+    if (!test_threads(&keys))
+        goto err;
+#endif
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    keys_free(&keys);
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
@@ -69,6 +69,7 @@ int test_gf2m_mod_sqrt(BIO *bp, BN_CTX *ctx);
 int test_gf2m_mod_solve_quad(BIO *bp, BN_CTX *ctx);
 int test_kron(BIO *bp, BN_CTX *ctx);
 int test_sqrt(BIO *bp, BN_CTX *ctx);
+int test_genprime(BIO *bp, BN_CTX *ctx);
 int rand_neg(void);
 static int results = 0;
 
@@ -225,6 +226,11 @@ int main(int argc, char *argv[])
     if (!test_sqrt(out, ctx))
         goto err;
     (void)BIO_flush(out);
+
+    message(out, "BN_generate_prime_ex");
+    if (!test_genprime(out, ctx))
+        goto err;
+    (void)BIO_flush(out);
 #ifndef OPENSSL_NO_EC2M
     message(out, "BN_GF2m_add");
     if (!test_gf2m_add(out))
@@ -1125,6 +1131,18 @@ int test_mod_exp_mont5(BIO *bp, BN_CTX *ctx)
         fprintf(stderr, "Modular exponentiation test failed!\n");
         goto err;
     }
+    /* A short exponent, as DH uses, with a long modulus */
+    BN_bntest_rand(m, 4096, 0, 1);
+    BN_bntest_rand(e, 4096, 0, 0);
+    BN_bntest_rand(p, 400, 0, 0);
+    if (!BN_mod_exp_mont_consttime(d, e, p, m, ctx, NULL))
+        goto err;
+    if (!BN_mod_exp_mont(a, e, p, m, ctx, NULL))
+        goto err;
+    if (BN_cmp(a, d) != 0) {
+        fprintf(stderr, "Modular exponentiation test failed!\n");
+        goto err;
+    }
 
     ret = 1;
 
@@ -1696,6 +1714,99 @@ err:
     return ret;
 }
 
+static int check_prime(const BIGNUM *p, int bits, int safe, BN_CTX *ctx)
+{
+    BIGNUM *q;
+    int ret = 0;
+
+    if (BN_num_bits(p) != bits || BN_is_prime_ex(p, 64, ctx, NULL) != 1) {
+        fprintf(stderr, "%d bit prime is wrong: ", bits);
+        BN_print_fp(stderr, p);
+        fprintf(stderr, "\n");
+        return 0;
+    }
+    if (!safe)
+        return 1;
+
+    if ((q = BN_new()) == NULL)
+        return 0;
+    if (BN_rshift1(q, p) && BN_is_prime_ex(q, 64, ctx, NULL) == 1)
+        ret = 1;
+    else
+        fprintf(stderr, "%d bit safe prime is wrong\n", bits);
+    BN_free(q);
+    return ret;
+}
+
+static int stop_calls;
+
+static int genprime_stop_cb(int p, int n, BN_GENCB *arg)
+{
+    return --stop_calls > 0;
+}
+
+int test_genprime(BIO *bp, BN_CTX *ctx)
+{
+    static const int sizes[] = { 3, 4, 5, 17, 32, 256, 512 };
+    BN_GENCB cb;
+    BIGNUM *p, *add, *rem;
+    size_t i;
+    int ret = 0;
+
+    p = BN_new();
+    add = BN_new();
+    rem = BN_new();
+    if (p == NULL || add == NULL || rem == NULL)
+        goto err;
+
+    BN_GENCB_set(&cb, genprime_cb, NULL);
+
+    /* Down to sizes where a candidate may be one of the sieve primes */
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (!BN_generate_prime_ex(p, sizes[i], 0, NULL, NULL, &cb) ||
+            !check_prime(p, sizes[i], 0, ctx))
+            goto err;
+        if (sizes[i] < 256 &&
+            (!BN_generate_prime_ex(p, sizes[i], 1, NULL, NULL, &cb) ||
+             !check_prime(p, sizes[i], 1, ctx)))
+            goto err;
+    }
+
+    /* Safe primes the way DH parameters are made */
+    if (!BN_set_word(add, 24) || !BN_set_word(rem, 23))
+        goto err;
+    if (!BN_generate_prime_ex(p, 256, 1, add, rem, &cb) ||
+        !check_prime(p, 256, 1, ctx) || BN_mod_word(p, 24) != 23)
+        goto err;
+
+    /* Searching in several threads */
+    BN_GENCB_set_threads(&cb, 4);
+    if (!BN_generate_prime_ex(p, 512, 0, NULL, NULL, &cb) ||
+        !check_prime(p, 512, 0, ctx))
+        goto err;
+    if (!BN_generate_prime_ex(p, 256, 1, add, rem, &cb) ||
+        !check_prime(p, 256, 1, ctx) || BN_mod_word(p, 24) != 23)
+        goto err;
+    putc('\n', stderr);
+
+    /* A callback that gives up stops every thread */
+    BN_GENCB_set(&cb, genprime_stop_cb, NULL);
+    BN_GENCB_set_threads(&cb, 4);
+    stop_calls = 10;
+    if (BN_generate_prime_ex(p, 2048, 1, add, rem, &cb)) {
+        fprintf(stderr, "Prime generation was not stopped\n");
+        goto err;
+    }
+    ERR_clear_error();
+    ret = 1;
+
+err:
+    BN_free(p);
+    BN_free(add);
+    BN_free(rem);
+    return ret;
+}
+
 int test_sqrt(BIO *bp, BN_CTX *ctx)
 {
     BN_GENCB cb;
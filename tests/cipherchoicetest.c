@@ -0,0 +1,236 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that ssl3_choose_cipher picks the same cipher from random client
+ * lists whether it uses the rank array of the server's list or searches a
+ * copy of it, with client and server preference, and that a cipher list set
+ * from the cache of compiled rule strings is the same as the compiled one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "ssl/ssl_locl.h"
+
+#define NUM_TRIALS 20000
+
+static const char *const rules[] = {
+    "ALL",
+    "ALL:COMPLEMENTOFALL",
+    "DEFAULT",
+    "HIGH:!aNULL:!MD5:!RC4",
+    "EECDH:!AES128",
+    "AESGCM:+AES256:CHACHA20",
+    "kRSA:EDH:-SHA1",
+    "3DES:AES128:CAMELLIA:@STRENGTH",
+};
+
+#define NUM_RULES (sizeof(rules) / sizeof(rules[0]))
+
+static uint32_t rand_state = 0x2545f491;
+
+/* next_rand returns a xorshift number, the same from one run to the next. */
+static uint32_t next_rand(void)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static SSL_CTX *new_ctx(const SSL_METHOD *method)
+{
+    SSL_CTX *ctx;
+
+    if ((ctx = SSL_CTX_new(method)) == NULL)
+        return NULL;
+    if (!SSL_CTX_use_certificate_file(ctx, "server.pem", SSL_FILETYPE_PEM) ||
+        !SSL_CTX_use_PrivateKey_file(ctx, "server.pem", SSL_FILETYPE_PEM)) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/*
+ * random_list returns a shuffled random subset of |all|, which starts with a
+ * ChaCha20 cipher one time in four so that both ChaCha20 cases are covered.
+ */
+static STACK_OF(SSL_CIPHER) *random_list(STACK_OF(SSL_CIPHER) *all)
+{
+    STACK_OF(SSL_CIPHER) *sk;
+    SSL_CIPHER *c, *tmp;
+    int i, j, num = sk_SSL_CIPHER_num(all);
+
+    if ((sk = sk_SSL_CIPHER_new_null()) == NULL)
+        return NULL;
+    for (i = 0; i < num; i++) {
+        if (next_rand() % 3 == 0)
+            continue;
+        if (!sk_SSL_CIPHER_push(sk, sk_SSL_CIPHER_value(all, i)))
+            goto err;
+    }
+    num = sk_SSL_CIPHER_num(sk);
+    for (i = num - 1; i > 0; i--) {
+        j = next_rand() % (i + 1);
+        tmp = sk_SSL_CIPHER_value(sk, i);
+        sk_SSL_CIPHER_set(sk, i, sk_SSL_CIPHER_value(sk, j));
+        sk_SSL_CIPHER_set(sk, j, tmp);
+    }
+    if (next_rand() % 4 == 0) {
+        for (i = 0; i < num; i++) {
+            c = sk_SSL_CIPHER_value(sk, i);
+            if (c->algorithm_enc != SSL_CHACHA20POLY1305 &&
+                c->algorithm_enc != SSL_CHACHA20POLY1305_OLD)
+                continue;
+            sk_SSL_CIPHER_set(sk, i, sk_SSL_CIPHER_value(sk, 0));
+            sk_SSL_CIPHER_set(sk, 0, c);
+            break;
+        }
+    }
+    return sk;
+
+err:
+    sk_SSL_CIPHER_free(sk);
+    return NULL;
+}
+
+/*
+ * same_list returns whether |ssl|'s own cipher list and rank array are the
+ * same as those of its context.
+ */
+static int same_list(SSL *ssl)
+{
+    STACK_OF(SSL_CIPHER) *a = ssl->cipher_list, *b = ssl->ctx->cipher_list;
+    int i;
+
+    if (a == NULL || b == NULL || ssl->cipher_rank == NULL ||
+        ssl->ctx->cipher_rank == NULL ||
+        sk_SSL_CIPHER_num(a) != sk_SSL_CIPHER_num(b))
+        return 0;
+    for (i = 0; i < sk_SSL_CIPHER_num(a); i++) {
+        if (sk_SSL_CIPHER_value(a, i) != sk_SSL_CIPHER_value(b, i))
+            return 0;
+    }
+    return memcmp(ssl->cipher_rank, ssl->ctx->cipher_rank,
+                  ssl3_num_ciphers() * sizeof(uint16_t)) == 0;
+}
+
+static const char *cipher_name(const SSL_CIPHER *c)
+{
+    return c != NULL ? c->name : "(none)";
+}
+
+/*
+ * trial chooses a cipher from a random client list on a new server
+ * connection for |ctx|, once with the ranked server list and once with a
+ * copy that has to be searched, and returns whether both chose the same.
+ */
+static int trial(SSL_CTX *ctx, STACK_OF(SSL_CIPHER) *all, int n)
+{
+    STACK_OF(SSL_CIPHER) *clnt = NULL, *srvr = NULL;
+    const SSL_CIPHER *ranked, *searched;
+    const char *rule = rules[next_rand() % NUM_RULES];
+    SSL *ssl = NULL;
+    int own_list, ret = 0;
+
+    /*
+     * Either the connection uses its context's list, or the same string is
+     * set on it as well, which takes its list from the cache.
+     */
+    own_list = next_rand() % 2;
+    if (!SSL_CTX_set_cipher_list(ctx, rule) || (ssl = SSL_new(ctx)) == NULL ||
+        (own_list && !SSL_set_cipher_list(ssl, rule))) {
+        printf("Setting cipher list \"%s\" failed\n", rule);
+        goto err;
+    }
+    if (own_list && !same_list(ssl)) {
+        printf("Cached list for \"%s\" differs from the compiled one\n", rule);
+        goto err;
+    }
+    if (ssl_get_cipher_rank(ssl) == NULL) {
+        printf("Cipher list \"%s\" is not ranked\n", rule);
+        goto err;
+    }
+
+    SSL_set_accept_state(ssl);
+    if (!ssl_get_new_session(ssl, 1))
+        goto err;
+    if (next_rand() % 2)
+        SSL_set_options(ssl, SSL_OP_CIPHER_SERVER_PREFERENCE);
+    /* Without an ECDH key, ECDHE ciphers are not usable. */
+    SSL_set_ecdh_auto(ssl, next_rand() % 2);
+
+    if ((clnt = random_list(all)) == NULL ||
+        (srvr = sk_SSL_CIPHER_dup(SSL_get_ciphers(ssl))) == NULL)
+        goto err;
+    ranked = ssl3_choose_cipher(ssl, clnt, SSL_get_ciphers(ssl));
+    searched = ssl3_choose_cipher(ssl, clnt, srvr);
+    if (ranked != searched) {
+        printf("Trial %d, \"%s\", %s preference: ranked chose %s, "
+               "searched chose %s\n", n, rule,
+               (SSL_get_options(ssl) & SSL_OP_CIPHER_SERVER_PREFERENCE) ?
+               "server" : "client", cipher_name(ranked),
+               cipher_name(searched));
+        goto err;
+    }
+    ret = 1;
+
+err:
+    sk_SSL_CIPHER_free(clnt);
+    sk_SSL_CIPHER_free(srvr);
+    SSL_free(ssl);
+    return ret;
+}
+
+int main(void)
+{
+    SSL_CTX *ctxs[2] = { NULL, NULL }, *all_ctx = NULL;
+    STACK_OF(SSL_CIPHER) *all;
+    int i, ret = 1;
+
+    SSL_library_init();
+    SSL_load_error_strings();
+
+    /* TLS 1.0 leaves out the ciphers only TLS 1.2 can use. */
+    if ((ctxs[0] = new_ctx(TLSv1_2_server_method())) == NULL ||
+        (ctxs[1] = new_ctx(TLSv1_server_method())) == NULL ||
+        (all_ctx = SSL_CTX_new(TLSv1_2_server_method())) == NULL ||
+        !SSL_CTX_set_cipher_list(all_ctx, "ALL:COMPLEMENTOFALL")) {
+        printf("Setting up contexts failed\n");
+        goto err;
+    }
+    all = all_ctx->cipher_list;
+
+    for (i = 0; i < NUM_TRIALS; i++) {
+        if (!trial(ctxs[next_rand() % 2], all, i))
+            goto err;
+    }
+
+    printf("PASS\n");
+    ret = 0;
+
+err:
+    if (ret != 0)
+        ERR_print_errors_fp(stderr);
+    SSL_CTX_free(ctxs[0]);
+    SSL_CTX_free(ctxs[1]);
+    SSL_CTX_free(all_ctx);
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+    return ret;
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Builds a CRL with many revoked entries, round trips it through DER and
+ * checks serial number lookups on the decoded copy, both through its
+ * serial number index and after it has been modified, including entries
+ * deleted directly from its revoked stack.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/objects.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#define NUM_REVOKED 5000
+
+/* Every serial is unique; the lengths vary and most share leading bytes */
+static ASN1_INTEGER *make_serial(int i, int neg)
+{
+    uint8_t buf[12];
+    ASN1_INTEGER *serial;
+    BIGNUM *bn;
+    size_t len;
+
+    len = 2 + i % 11;
+    memset(buf, 0xa5, sizeof(buf));
+    buf[len - 2] = (uint8_t)((i / 11 + 1) >> 8);
+    buf[len - 1] = (uint8_t)(i / 11 + 1);
+
+    if ((bn = BN_bin2bn(buf, len, NULL)) == NULL)
+        return NULL;
+    BN_set_negative(bn, neg);
+    serial = BN_to_ASN1_INTEGER(bn, NULL);
+    BN_free(bn);
+    return serial;
+}
+
+static int add_revoked(X509_CRL *crl, ASN1_INTEGER *serial, int reason)
+{
+    X509_REVOKED *rev;
+    ASN1_TIME *tm;
+    ASN1_ENUMERATED *reason_enum = NULL;
+    int ret = 0;
+
+    rev = X509_REVOKED_new();
+    tm = ASN1_TIME_set(NULL, 1000000000);
+    if (rev == NULL || tm == NULL ||
+        !X509_REVOKED_set_serialNumber(rev, serial) ||
+        !X509_REVOKED_set_revocationDate(rev, tm))
+        goto err;
+    if (reason != CRL_REASON_NONE) {
+        if ((reason_enum = ASN1_ENUMERATED_new()) == NULL ||
+            !ASN1_ENUMERATED_set(reason_enum, reason) ||
+            !X509_REVOKED_add1_ext_i2d(rev, NID_crl_reason, reason_enum, 0, 0))
+            goto err;
+    }
+    if (!X509_CRL_add0_revoked(crl, rev))
+        goto err;
+    rev = NULL;
+    ret = 1;
+
+ err:
+    X509_REVOKED_free(rev);
+    ASN1_TIME_free(tm);
+    ASN1_ENUMERATED_free(reason_enum);
+    return ret;
+}
+
+static X509_CRL *make_crl(void)
+{
+    X509_CRL *crl, *ret = NULL;
+    X509_NAME *name;
+    ASN1_INTEGER *serial;
+    ASN1_TIME *tm;
+    uint8_t *der = NULL;
+    const uint8_t *p;
+    int i, der_len;
+
+    crl = X509_CRL_new();
+    name = X509_NAME_new();
+    tm = ASN1_TIME_set(NULL, 1000000000);
+    if (crl == NULL || name == NULL || tm == NULL ||
+        !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (const uint8_t *)"Test CA", -1, -1, 0) ||
+        !X509_CRL_set_version(crl, 1) ||
+        !X509_CRL_set_issuer_name(crl, name) ||
+        !X509_CRL_set_lastUpdate(crl, tm))
+        goto err;
+
+    /* Insert in an order unrelated to the serial numbers */
+    for (i = 0; i < NUM_REVOKED; i++) {
+        int j = (i * 761) % NUM_REVOKED;
+
+        if ((serial = make_serial(j, 0)) == NULL)
+            goto err;
+        if (!add_revoked(crl, serial,
+                         j == 7 ? CRL_REASON_REMOVE_FROM_CRL
+                                : CRL_REASON_NONE)) {
+            ASN1_INTEGER_free(serial);
+            goto err;
+        }
+        ASN1_INTEGER_free(serial);
+    }
+
+    /* Lookups do not check the signature, so a placeholder will do */
+    if (!X509_ALGOR_set0(crl->crl->sig_alg,
+                         OBJ_nid2obj(NID_ecdsa_with_SHA256), V_ASN1_UNDEF,
+                         NULL) ||
+        !X509_ALGOR_set0(crl->sig_alg, OBJ_nid2obj(NID_ecdsa_with_SHA256),
+                         V_ASN1_UNDEF, NULL) ||
+        !ASN1_BIT_STRING_set(crl->signature, (uint8_t *)"sig", 3))
+        goto err;
+
+    if ((der_len = i2d_X509_CRL(crl, &der)) <= 0)
+        goto err;
+    p = der;
+    ret = d2i_X509_CRL(NULL, &p, der_len);
+
+ err:
+    free(der);
+    X509_CRL_free(crl);
+    X509_NAME_free(name);
+    ASN1_TIME_free(tm);
+    return ret;
+}
+
+/*
+ * check_lookup looks up serial |i| (negated if |neg|) in |crl| and checks the
+ * result against |expected|.
+ */
+static int check_lookup(X509_CRL *crl, int i, int neg, int expected)
+{
+    ASN1_INTEGER *serial;
+    X509_REVOKED *rev = NULL;
+    int ret;
+
+    if ((serial = make_serial(i, neg)) == NULL)
+        return 0;
+    ret = X509_CRL_get0_by_serial(crl, &rev, serial);
+    if (ret != expected) {
+        printf("Lookup of serial %d%s returned %d, expected %d\n", i,
+               neg ? " (negative)" : "", ret, expected);
+        ASN1_INTEGER_free(serial);
+        return 0;
+    }
+    if (ret != 0 && ASN1_INTEGER_cmp(rev->serialNumber, serial) != 0) {
+        printf("Lookup of serial %d returned the wrong entry\n", i);
+        ASN1_INTEGER_free(serial);
+        return 0;
+    }
+    ASN1_INTEGER_free(serial);
+    return 1;
+}
+
+static int test_lookups(X509_CRL *crl, int extra)
+{
+    int i;
+
+    for (i = 0; i < NUM_REVOKED; i++) {
+        if (!check_lookup(crl, i, 0, i == 7 ? 2 : 1) ||
+            !check_lookup(crl, i, 1, 0))
+            return 0;
+    }
+    for (i = NUM_REVOKED; i < NUM_REVOKED + 100; i++) {
+        if (!check_lookup(crl, i, 0, i < extra ? 1 : 0))
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * test_deleted deletes and frees entries of a decoded CRL through
+ * X509_CRL_get_REVOKED and checks that lookups no longer return them.
+ */
+static int test_deleted(void)
+{
+    X509_CRL *crl;
+    X509_REVOKED *rev;
+    ASN1_INTEGER *serial = NULL;
+    int i, ret = 0;
+
+    if ((crl = make_crl()) == NULL)
+        return 0;
+    for (i = 0; i < 100; i++) {
+        rev = sk_X509_REVOKED_delete(X509_CRL_get_REVOKED(crl), i * 7);
+        ASN1_INTEGER_free(serial);
+        serial = ASN1_INTEGER_dup(rev->serialNumber);
+        X509_REVOKED_free(rev);
+        if (serial == NULL)
+            goto err;
+        if (X509_CRL_get0_by_serial(crl, NULL, serial) != 0) {
+            printf("Lookup returned a deleted entry\n");
+            goto err;
+        }
+    }
+    for (i = 0; i < sk_X509_REVOKED_num(X509_CRL_get_REVOKED(crl)); i++) {
+        rev = sk_X509_REVOKED_value(X509_CRL_get_REVOKED(crl), i);
+        if (X509_CRL_get0_by_serial(crl, NULL, rev->serialNumber) == 0) {
+            printf("Lookup missed an entry after deletions\n");
+            goto err;
+        }
+    }
+    ret = 1;
+
+ err:
+    ASN1_INTEGER_free(serial);
+    X509_CRL_free(crl);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    X509_CRL *crl = NULL;
+    ASN1_INTEGER *serial = NULL;
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+
+    if ((crl = make_crl()) == NULL) {
+        printf("Creating the CRL failed\n");
+        goto err;
+    }
+    if (sk_X509_REVOKED_num(X509_CRL_get_REVOKED(crl)) != NUM_REVOKED) {
+        printf("Decoded CRL has the wrong number of entries\n");
+        goto err;
+    }
+
+    if (!test_lookups(crl, 0))
+        goto err;
+
+    /* Entries added after decoding must be found too */
+    if ((serial = make_serial(NUM_REVOKED, 0)) == NULL ||
+        !add_revoked(crl, serial, CRL_REASON_NONE)) {
+        printf("Adding an entry failed\n");
+        goto err;
+    }
+    if (!test_lookups(crl, NUM_REVOKED + 1))
+        goto err;
+
+    if (!test_deleted())
+        goto err;
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    ASN1_INTEGER_free(serial);
+    X509_CRL_free(crl);
+    CRYPTO_cleanup_all_ex_data();
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
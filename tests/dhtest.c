@@ -28,6 +28,7 @@
 static int cb(int p, int n, BN_GENCB *arg);
 
 static int run_rfc5114_tests(void);
+static int run_well_known_tests(void);
 
 int main(int argc, char *argv[])
 {
@@ -123,6 +124,8 @@ int main(int argc, char *argv[])
 
     if (!run_rfc5114_tests())
         ret = 1;
+    if (!run_well_known_tests())
+        ret = 1;
 err:
     ERR_print_errors_fp(stderr);
 
@@ -537,3 +540,121 @@ err:
     fprintf(stderr, "Test failed RFC5114 set %d\n", i + 1);
     return 0;
 }
+
+/*
+ * Keys for the well-known groups are generated from a shared table of powers
+ * of g, with short exponents for the groups without a subgroup order. Check
+ * them against a plain exponentiation, including for exponents too long for
+ * the table and ones with leading zero bits.
+ */
+static const struct {
+    BIGNUM *(*get_prime)(BIGNUM *);
+    int exponent_bits;
+} well_known_primes[] = {
+    { get_rfc2409_prime_1024, 160 },
+    { get_rfc3526_prime_1536, 180 },
+    { get_rfc3526_prime_2048, 225 },
+    { get_rfc3526_prime_3072, 275 },
+    { get_rfc3526_prime_4096, 325 },
+    { get_rfc3526_prime_6144, 375 },
+    { get_rfc3526_prime_8192, 400 },
+};
+
+static DH *(*const well_known_subgroups[])(void) = {
+    DH_get_1024_160,
+    DH_get_2048_224,
+    DH_get_2048_256,
+};
+
+/* check_pub_key checks that |dh|'s public key is g^x. */
+static int check_pub_key(const DH *dh, BN_CTX *ctx)
+{
+    BIGNUM *y;
+    int ret;
+
+    if ((y = BN_new()) == NULL ||
+        !BN_mod_exp(y, dh->g, dh->priv_key, dh->p, ctx)) {
+        BN_free(y);
+        return 0;
+    }
+    ret = BN_cmp(y, dh->pub_key) == 0;
+    BN_free(y);
+    return ret;
+}
+
+/* check_group generates keys for |params| in several ways and checks them. */
+static int check_group(DH *params, int exponent_bits, BN_CTX *ctx)
+{
+    DH *dh = NULL;
+    int i, ret = 0;
+
+    for (i = 0; i < 4; i++) {
+        if ((dh = DHparams_dup(params)) == NULL)
+            goto err;
+        if (i == 1 || i == 2) {
+            /* A full length exponent, then a short one with many zero bits */
+            if ((dh->priv_key = BN_new()) == NULL ||
+                !BN_rand(dh->priv_key, i == 1 ? BN_num_bits(dh->p) - 1 : 9,
+                         0, 0))
+                goto err;
+        } else if (i == 3) {
+            dh->flags |= DH_FLAG_NO_EXP_CONSTTIME;
+        }
+        if (!DH_generate_key(dh) || !check_pub_key(dh, ctx))
+            goto err;
+        if (i != 1 && BN_num_bits(dh->priv_key) > exponent_bits)
+            goto err;
+        DH_free(dh);
+        dh = NULL;
+    }
+    ret = 1;
+
+err:
+    DH_free(dh);
+    return ret;
+}
+
+static int run_well_known_tests(void)
+{
+    BN_CTX *ctx;
+    DH *dh = NULL;
+    size_t i;
+    int ret = 0;
+
+    if ((ctx = BN_CTX_new()) == NULL)
+        return 0;
+    for (i = 0; i < sizeof(well_known_primes) / sizeof(well_known_primes[0]);
+         i++) {
+        if ((dh = DH_new()) == NULL ||
+            (dh->p = well_known_primes[i].get_prime(NULL)) == NULL ||
+            (dh->g = BN_new()) == NULL || !BN_set_word(dh->g, 2))
+            goto err;
+        if (!check_group(dh, well_known_primes[i].exponent_bits, ctx)) {
+            fprintf(stderr, "Keys wrong for %d bit well-known group\n",
+                    BN_num_bits(dh->p));
+            goto err;
+        }
+        DH_free(dh);
+        dh = NULL;
+    }
+    for (i = 0;
+         i < sizeof(well_known_subgroups) / sizeof(well_known_subgroups[0]);
+         i++) {
+        if ((dh = well_known_subgroups[i]()) == NULL)
+            goto err;
+        if (!check_group(dh, BN_num_bits(dh->q), ctx)) {
+            fprintf(stderr, "Keys wrong for RFC5114 set %d\n", (int)i + 1);
+            goto err;
+        }
+        DH_free(dh);
+        dh = NULL;
+    }
+    printf("Well-known group tests OK\n");
+    ret = 1;
+
+err:
+    ERR_print_errors_fp(stderr);
+    DH_free(dh);
+    BN_CTX_free(ctx);
+    return ret;
+}
@@ -39,6 +39,8 @@
 /* declaration of the test functions */
 int x9_62_test_internal(BIO *out, int nid, const char *r, const char *s);
 int test_builtin(BIO *);
+int test_p256_order_arith(BIO *);
+int test_verify_batch(BIO *);
 
 /* some tests from the X9.62 draft */
 int x9_62_test_internal(BIO *out, int nid, const char *r_in, const char *s_in)
@@ -319,6 +321,318 @@ builtin_err:
     return ret;
 }
 
+/*
+ * Signs and verifies with P-256 using both the named curve (which may use
+ * fixed-width scalar arithmetic modulo the order) and an explicit copy of
+ * its parameters (which uses the generic BN code), and checks that each
+ * accepts the other's signatures. Digests that exceed the order are used to
+ * exercise the reduction of out of range inputs.
+ */
+int test_p256_order_arith(BIO *out)
+{
+    EC_KEY *named = NULL, *explicit = NULL;
+    EC_GROUP *group = NULL;
+    BN_CTX *ctx = NULL;
+    BIGNUM *p = NULL, *a = NULL, *b = NULL, *order = NULL, *cofactor = NULL;
+    BIGNUM *x = NULL, *y = NULL;
+    EC_POINT *generator = NULL;
+    ECDSA_SIG *sig = NULL;
+    uint8_t digest[32];
+    int i, ret = 0;
+
+    BIO_printf(out, "testing P-256 order arithmetic: ");
+
+    if ((ctx = BN_CTX_new()) == NULL || (p = BN_new()) == NULL ||
+        (a = BN_new()) == NULL || (b = BN_new()) == NULL ||
+        (order = BN_new()) == NULL || (cofactor = BN_new()) == NULL ||
+        (x = BN_new()) == NULL || (y = BN_new()) == NULL)
+        goto err;
+
+    if ((named = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL ||
+        !EC_KEY_generate_key(named))
+        goto err;
+
+    if (!EC_GROUP_get_curve_GFp(EC_KEY_get0_group(named), p, a, b, ctx) ||
+        !EC_GROUP_get_order(EC_KEY_get0_group(named), order, ctx) ||
+        !EC_GROUP_get_cofactor(EC_KEY_get0_group(named), cofactor, ctx))
+        goto err;
+    if ((group = EC_GROUP_new(EC_GFp_mont_method())) == NULL ||
+        !EC_GROUP_set_curve_GFp(group, p, a, b, ctx) ||
+        (generator = EC_POINT_new(group)) == NULL)
+        goto err;
+    if (!EC_POINT_get_affine_coordinates_GFp(EC_KEY_get0_group(named),
+                                             EC_GROUP_get0_generator(EC_KEY_get0_group(named)),
+                                             x, y, ctx) ||
+        !EC_POINT_set_affine_coordinates_GFp(group, generator, x, y, ctx) ||
+        !EC_GROUP_set_generator(group, generator, order, cofactor))
+        goto err;
+
+    if ((explicit = EC_KEY_new()) == NULL ||
+        !EC_KEY_set_group(explicit, group) ||
+        !EC_KEY_set_private_key(explicit, EC_KEY_get0_private_key(named)))
+        goto err;
+    if (!EC_POINT_get_affine_coordinates_GFp(EC_KEY_get0_group(named),
+                                             EC_KEY_get0_public_key(named),
+                                             x, y, ctx) ||
+        !EC_KEY_set_public_key_affine_coordinates(explicit, x, y))
+        goto err;
+
+    for (i = 0; i < 3; i++) {
+        if (i == 0)
+            memset(digest, 0xff, sizeof(digest));
+        else if (i == 1)
+            BN_bn2bin(order, digest);
+        else if (RAND_bytes(digest, sizeof(digest)) <= 0)
+            goto err;
+
+        if ((sig = ECDSA_do_sign(digest, sizeof(digest), named)) == NULL)
+            goto err;
+        if (ECDSA_do_verify(digest, sizeof(digest), sig, explicit) != 1 ||
+            ECDSA_do_verify(digest, sizeof(digest), sig, named) != 1)
+            goto err;
+        ECDSA_SIG_free(sig);
+
+        if ((sig = ECDSA_do_sign(digest, sizeof(digest), explicit)) == NULL)
+            goto err;
+        if (ECDSA_do_verify(digest, sizeof(digest), sig, named) != 1)
+            goto err;
+        ECDSA_SIG_free(sig);
+        sig = NULL;
+
+        BIO_printf(out, ".");
+        (void)BIO_flush(out);
+    }
+
+    BIO_printf(out, " ok\n");
+    ret = 1;
+err:
+    if (!ret)
+        BIO_printf(out, " failed\n");
+    ECDSA_SIG_free(sig);
+    EC_KEY_free(named);
+    EC_KEY_free(explicit);
+    EC_GROUP_free(group);
+    EC_POINT_free(generator);
+    BN_free(p);
+    BN_free(a);
+    BN_free(b);
+    BN_free(order);
+    BN_free(cofactor);
+    BN_free(x);
+    BN_free(y);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
+/*
+ * Verifies a batch of signatures over several curves with
+ * ECDSA_do_verify_batch, one of them tampered with, and checks the results
+ * against ECDSA_do_verify.
+ */
+int test_verify_batch(BIO *out)
+{
+    static const int nids[] = {
+        NID_X9_62_prime256v1, NID_secp384r1, NID_X9_62_prime256v1,
+        NID_secp521r1, NID_X9_62_prime256v1, NID_secp384r1,
+    };
+    enum { NUM = sizeof(nids) / sizeof(nids[0]) };
+    EC_KEY *keys[NUM] = { NULL };
+    ECDSA_SIG *sigs[NUM] = { NULL };
+    const uint8_t *dgsts[NUM];
+    int dgst_lens[NUM], results[NUM];
+    uint8_t digest[NUM][32];
+    size_t i;
+    int ret = 0;
+
+    BIO_printf(out, "testing ECDSA_do_verify_batch: ");
+
+    for (i = 0; i < NUM; i++) {
+        if (RAND_bytes(digest[i], sizeof(digest[i])) <= 0)
+            goto err;
+        dgsts[i] = digest[i];
+        dgst_lens[i] = sizeof(digest[i]);
+        if ((keys[i] = EC_KEY_new_by_curve_name(nids[i])) == NULL ||
+            !EC_KEY_generate_key(keys[i]))
+            goto err;
+        if ((sigs[i] = ECDSA_do_sign(digest[i], sizeof(digest[i]), keys[i])) == NULL)
+            goto err;
+    }
+
+    if (ECDSA_do_verify_batch(NUM, dgsts, dgst_lens,
+                              (const ECDSA_SIG *const *)sigs, keys, results) != 1)
+        goto err;
+    for (i = 0; i < NUM; i++) {
+        if (results[i] != 1)
+            goto err;
+    }
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    /* Tamper with one digest: only its entry may fail. */
+    digest[2][0] ^= 1;
+    if (ECDSA_do_verify_batch(NUM, dgsts, dgst_lens,
+                              (const ECDSA_SIG *const *)sigs, keys, results) != 0)
+        goto err;
+    for (i = 0; i < NUM; i++) {
+        if (results[i] != ECDSA_do_verify(dgsts[i], dgst_lens[i], sigs[i], keys[i]))
+            goto err;
+        if (results[i] != (i != 2))
+            goto err;
+    }
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    /* A missing key or signature is an error for that entry alone. */
+    {
+        EC_KEY *key1 = keys[1];
+        ECDSA_SIG *sig4 = sigs[4];
+        int r;
+
+        keys[1] = NULL;
+        sigs[4] = NULL;
+        r = ECDSA_do_verify_batch(NUM, dgsts, dgst_lens,
+                                  (const ECDSA_SIG *const *)sigs, keys,
+                                  results);
+        keys[1] = key1;
+        sigs[4] = sig4;
+        if (r != -1 || results[1] != -1 || results[4] != -1 ||
+            results[0] != 1 || results[2] != 0 || results[3] != 1)
+            goto err;
+    }
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    BIO_printf(out, " ok\n");
+    ret = 1;
+err:
+    if (!ret)
+        BIO_printf(out, " failed\n");
+    ERR_clear_error();
+    for (i = 0; i < NUM; i++) {
+        EC_KEY_free(keys[i]);
+        ECDSA_SIG_free(sigs[i]);
+    }
+    return ret;
+}
+
+/*
+ * Verifies P-256 signatures with a key that builds its public key table
+ * lazily, then after switching the key to another public point, and checks
+ * multiplication with a precomputed table for a non-standard generator.
+ */
+int test_precompute(BIO *out)
+{
+    enum { NUM = 8 };
+    EC_KEY *key = NULL, *other = NULL;
+    ECDSA_SIG *sigs[NUM] = { NULL }, *other_sig = NULL;
+    EC_GROUP *group = NULL;
+    EC_POINT *gen2 = NULL, *p1 = NULL, *p2 = NULL;
+    BIGNUM *order = NULL, *k = NULL, *k2 = NULL;
+    BN_CTX *ctx = NULL;
+    uint8_t digest[NUM][32];
+    size_t i;
+    int ret = 0;
+
+    BIO_printf(out, "testing EC_KEY public key precomputation: ");
+
+    if ((key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL ||
+        (other = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL ||
+        !EC_KEY_generate_key(key) || !EC_KEY_generate_key(other))
+        goto err;
+    for (i = 0; i < NUM; i++) {
+        if (RAND_bytes(digest[i], sizeof(digest[i])) <= 0)
+            goto err;
+        if ((sigs[i] = ECDSA_do_sign(digest[i], sizeof(digest[i]), key)) == NULL)
+            goto err;
+    }
+    if ((other_sig = ECDSA_do_sign(digest[0], sizeof(digest[0]), other)) == NULL)
+        goto err;
+
+    /* The table, if supported, is built by the second verification. */
+    EC_KEY_set_precompute_threshold(key, 2);
+    for (i = 0; i < NUM; i++) {
+        if (ECDSA_do_verify(digest[i], sizeof(digest[i]), sigs[i], key) != 1)
+            goto err;
+        if (i == 0 && EC_KEY_get_precompute_size(key) != 0)
+            goto err;
+        digest[i][0] ^= 1;
+        if (ECDSA_do_verify(digest[i], sizeof(digest[i]), sigs[i], key) != 0)
+            goto err;
+        digest[i][0] ^= 1;
+    }
+    /* Building the table leaves neither an error nor an error mark. */
+    if (ERR_peek_error() != 0 || ERR_pop_to_mark())
+        goto err;
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    /* EC_KEY_precompute_mult leaves the public key alone. */
+    if (!EC_KEY_precompute_mult(other, NULL) ||
+        EC_KEY_get_precompute_size(other) != 0)
+        goto err;
+
+    /* A table built for a previous public key must not be used. */
+    if (!EC_KEY_set_public_key(key, EC_KEY_get0_public_key(other)))
+        goto err;
+    if (ECDSA_do_verify(digest[0], sizeof(digest[0]), other_sig, key) != 1 ||
+        ECDSA_do_verify(digest[0], sizeof(digest[0]), sigs[0], key) != 0)
+        goto err;
+    if (!EC_KEY_precompute_public_mult(key, NULL))
+        goto err;
+    if (ECDSA_do_verify(digest[0], sizeof(digest[0]), other_sig, key) != 1 ||
+        ECDSA_do_verify(digest[0], sizeof(digest[0]), sigs[0], key) != 0)
+        goto err;
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    /* k * (2G) using a table precomputed for 2G must equal 2k * G. */
+    if ((ctx = BN_CTX_new()) == NULL ||
+        (group = EC_GROUP_dup(EC_KEY_get0_group(key))) == NULL ||
+        (gen2 = EC_POINT_new(group)) == NULL ||
+        (p1 = EC_POINT_new(group)) == NULL ||
+        (p2 = EC_POINT_new(group)) == NULL ||
+        (order = BN_new()) == NULL || (k = BN_new()) == NULL ||
+        (k2 = BN_new()) == NULL)
+        goto err;
+    if (!EC_GROUP_get_order(group, order, ctx) ||
+        !EC_POINT_dbl(group, gen2, EC_GROUP_get0_generator(group), ctx) ||
+        !EC_POINT_make_affine(group, gen2, ctx) ||
+        !EC_GROUP_set_generator(group, gen2, order, BN_value_one()) ||
+        !EC_GROUP_precompute_mult(group, ctx))
+        goto err;
+    for (i = 0; i < 4; i++) {
+        if (!BN_rand_range(k, order) || !BN_lshift1(k2, k) ||
+            !EC_POINT_mul(group, p1, k, NULL, NULL, ctx) ||
+            !EC_POINT_mul(EC_KEY_get0_group(key), p2, k2, NULL, NULL, ctx))
+            goto err;
+        if (EC_POINT_cmp(group, p1, p2, ctx) != 0)
+            goto err;
+    }
+    BIO_printf(out, ".");
+    (void)BIO_flush(out);
+
+    BIO_printf(out, " ok\n");
+    ret = 1;
+err:
+    if (!ret)
+        BIO_printf(out, " failed\n");
+    ERR_clear_error();
+    for (i = 0; i < NUM; i++)
+        ECDSA_SIG_free(sigs[i]);
+    ECDSA_SIG_free(other_sig);
+    EC_KEY_free(key);
+    EC_KEY_free(other);
+    EC_POINT_free(gen2);
+    EC_POINT_free(p1);
+    EC_POINT_free(p2);
+    EC_GROUP_free(group);
+    BN_free(order);
+    BN_free(k);
+    BN_free(k2);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
 int main(void)
 {
     int ret = 1;
@@ -331,6 +645,12 @@ int main(void)
     /* the tests */
     if (!test_builtin(out))
         goto err;
+    if (!test_p256_order_arith(out))
+        goto err;
+    if (!test_verify_batch(out))
+        goto err;
+    if (!test_precompute(out))
+        goto err;
 
     ret = 0;
 err:
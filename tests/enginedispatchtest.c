@@ -0,0 +1,274 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that EVP picks up a cipher ENGINE as it is registered and
+ * unregistered, including while other threads are initialising contexts, and
+ * that every functional reference taken is released. With a "bench"
+ * argument, it then times initialising cipher contexts from several threads
+ * at once.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/opensslconf.h>
+
+#ifdef OPENSSL_NO_ENGINE
+int main(int argc, char *argv[])
+{
+    printf("No ENGINE support\n");
+    return 0;
+}
+#else
+#include <openssl/crypto.h>
+#include <openssl/engine.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+
+#include "internal/threads.h"
+
+#include "testutil.h"
+
+static EVP_CIPHER test_cipher;
+static int num_inits, num_finishes;
+
+static const uint8_t key[16], iv[16];
+
+static int test_init(ENGINE *e)
+{
+    num_inits++;
+    return 1;
+}
+
+static int test_finish(ENGINE *e)
+{
+    num_finishes++;
+    return 1;
+}
+
+static int test_ciphers(ENGINE *e, const EVP_CIPHER **cipher, const int **nids,
+                        int nid)
+{
+    static const int cipher_nids[] = { NID_aes_128_cbc };
+
+    if (cipher == NULL) {
+        *nids = cipher_nids;
+        return 1;
+    }
+    if (nid != NID_aes_128_cbc) {
+        *cipher = NULL;
+        return 0;
+    }
+    *cipher = &test_cipher;
+    return 1;
+}
+
+/* check_select checks which ENGINE is chosen for |nid|. */
+static int check_select(int nid, ENGINE *expected)
+{
+    ENGINE *e = ENGINE_get_cipher_engine(nid);
+
+    if (e != NULL)
+        ENGINE_finish(e);
+    if (e != expected) {
+        printf("Wrong ENGINE chosen for %s\n", OBJ_nid2sn(nid));
+        return 0;
+    }
+    return 1;
+}
+
+/* check_init checks which implementation of |cipher| EVP uses. */
+static int check_init(const EVP_CIPHER *cipher, const EVP_CIPHER *expected)
+{
+    EVP_CIPHER_CTX ctx;
+    int ret;
+
+    EVP_CIPHER_CTX_init(&ctx);
+    ret = EVP_EncryptInit_ex(&ctx, cipher, NULL, key, iv) &&
+          EVP_CIPHER_CTX_cipher(&ctx) == expected;
+    EVP_CIPHER_CTX_cleanup(&ctx);
+    if (!ret)
+        printf("Wrong implementation of %s used\n", OBJ_nid2sn(cipher->nid));
+    return ret;
+}
+
+static int test_register(ENGINE *e)
+{
+    if (!check_select(NID_aes_128_cbc, NULL))
+        return 0;
+
+    if (!ENGINE_register_ciphers(e) ||
+        !check_select(NID_aes_128_cbc, e) ||
+        !check_select(NID_aes_128_cbc, e) ||
+        !check_select(NID_des_cbc, NULL) ||
+        !check_init(EVP_aes_128_cbc(), &test_cipher) ||
+        !check_init(EVP_aes_256_cbc(), EVP_aes_256_cbc()))
+        return 0;
+    if (num_inits != 1 || num_finishes != 0) {
+        printf("ENGINE initialised %d times and finished %d times\n",
+               num_inits, num_finishes);
+        return 0;
+    }
+
+    ENGINE_unregister_ciphers(e);
+    if (!check_select(NID_aes_128_cbc, NULL) ||
+        !check_init(EVP_aes_128_cbc(), EVP_aes_128_cbc()))
+        return 0;
+    if (num_finishes != 1) {
+        printf("Unregistered ENGINE was not finished\n");
+        return 0;
+    }
+
+    if (!ENGINE_register_ciphers(e) || !check_select(NID_aes_128_cbc, e) ||
+        num_inits != 2)
+        return 0;
+    ENGINE_unregister_ciphers(e);
+
+    return 1;
+}
+
+#ifdef OPENSSL_THREADS
+
+#define STRESS_ITERATIONS 20000
+#define BENCH_ITERATIONS 200000
+
+static volatile int thread_failed;
+static int threads_done;
+
+static void *stress_thread(void *arg)
+{
+    EVP_CIPHER_CTX ctx;
+    int i, ref;
+
+    (void)arg;
+    EVP_CIPHER_CTX_init(&ctx);
+    for (i = 0; i < STRESS_ITERATIONS; i++) {
+        if (!EVP_EncryptInit_ex(&ctx, EVP_aes_128_cbc(), NULL, key, iv) ||
+            (EVP_CIPHER_CTX_cipher(&ctx) != &test_cipher &&
+             EVP_CIPHER_CTX_cipher(&ctx) != EVP_aes_128_cbc()))
+            thread_failed = 1;
+        EVP_CIPHER_CTX_cleanup(&ctx);
+    }
+    ERR_remove_thread_state(NULL);
+    CRYPTO_atomic_add(&threads_done, 1, &ref, NULL);
+    return NULL;
+}
+
+/*
+ * test_threads initialises contexts from several threads while the ENGINE is
+ * registered and unregistered until they finish, so that replaced dispatch
+ * snapshots are freed while lookups are running, then checks that no
+ * references were lost.
+ */
+static int test_threads(ENGINE *e)
+{
+    CRYPTO_THREAD threads[4];
+    int i, done = 0;
+
+    for (i = 0; i < 4; i++) {
+        if (!CRYPTO_thread_spawn(&threads[i], stress_thread, NULL))
+            return 0;
+    }
+    while (done < 4) {
+        ENGINE_register_ciphers(e);
+        ENGINE_unregister_ciphers(e);
+        CRYPTO_atomic_add(&threads_done, 0, &done, NULL);
+    }
+    for (i = 0; i < 4; i++)
+        CRYPTO_thread_join(threads[i]);
+
+    if (thread_failed) {
+        printf("Context initialisation failed in a thread\n");
+        return 0;
+    }
+    if (num_inits != num_finishes) {
+        printf("ENGINE initialised %d times but finished %d times\n",
+               num_inits, num_finishes);
+        return 0;
+    }
+    return 1;
+}
+
+static void *bench_thread(void *arg)
+{
+    const EVP_CIPHER *cipher = arg;
+    EVP_CIPHER_CTX ctx;
+    int i;
+
+    EVP_CIPHER_CTX_init(&ctx);
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        EVP_EncryptInit_ex(&ctx, cipher, NULL, key, iv);
+        EVP_CIPHER_CTX_cleanup(&ctx);
+    }
+    ERR_remove_thread_state(NULL);
+    return NULL;
+}
+
+static int bench(const char *name, const EVP_CIPHER *cipher, int num_threads)
+{
+    char what[32];
+    double secs;
+
+    if ((secs = test_run_threads(num_threads, bench_thread,
+                                 (void *)cipher)) < 0)
+        return 0;
+    snprintf(what, sizeof(what), "%s, %d thread(s)", name, num_threads);
+    test_report(what, (double)num_threads * BENCH_ITERATIONS, secs, "inits");
+    return 1;
+}
+
+#endif
+
+int main(int argc, char *argv[])
+{
+    ENGINE *e;
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+
+    test_cipher = *EVP_aes_128_cbc();
+    if ((e = ENGINE_new()) == NULL || !ENGINE_set_id(e, "dispatch") ||
+        !ENGINE_set_name(e, "Dispatch test") ||
+        !ENGINE_set_init_function(e, test_init) ||
+        !ENGINE_set_finish_function(e, test_finish) ||
+        !ENGINE_set_ciphers(e, test_ciphers))
+        goto err;
+
+    if (!test_register(e))
+        goto err;
+#ifdef OPENSSL_THREADS
+    if (!test_threads(e))
+        goto err;
+    if (test_bench_requested(argc, argv) &&
+        (!ENGINE_register_ciphers(e) ||
+         !bench("engine", EVP_aes_128_cbc(), 1) ||
+         !bench("engine", EVP_aes_128_cbc(), 4) ||
+         !bench("builtin", EVP_aes_256_cbc(), 1) ||
+         !bench("builtin", EVP_aes_256_cbc(), 4))) {
+        printf("Unable to start threads\n");
+        goto err;
+    }
+    ENGINE_unregister_ciphers(e);
+#endif
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    ENGINE_free(e);
+    ENGINE_cleanup();
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
+#endif
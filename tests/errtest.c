@@ -0,0 +1,231 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks error string lookups, including strings loaded and unloaded after
+ * the first lookup, and the data attached to queued errors. With a "bench"
+ * argument, it then times pushing, popping and formatting errors from several
+ * threads at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+
+#include "testutil.h"
+
+#define USER_FUNC 1
+#define USER_REASON 100
+
+static int test_strings(void)
+{
+    unsigned long e = ERR_PACK(ERR_LIB_RSA, RSA_F_RSA_NEW_METHOD,
+                               RSA_R_DATA_TOO_LARGE);
+    char buf[256];
+
+    if (ERR_lib_error_string(e) == NULL ||
+        strcmp(ERR_lib_error_string(e), "rsa routines") != 0 ||
+        ERR_func_error_string(e) == NULL ||
+        strcmp(ERR_func_error_string(e), "RSA_NEW_METHOD") != 0 ||
+        ERR_reason_error_string(e) == NULL ||
+        strcmp(ERR_reason_error_string(e), "data too large") != 0) {
+        printf("Wrong strings for %08lX\n", e);
+        return 0;
+    }
+
+    /* Common reasons are found from any library */
+    e = ERR_PACK(ERR_LIB_RSA, 0, ERR_R_MALLOC_FAILURE);
+    if (ERR_reason_error_string(e) == NULL ||
+        strcmp(ERR_reason_error_string(e), "malloc failure") != 0) {
+        printf("Wrong common reason string\n");
+        return 0;
+    }
+
+    e = ERR_PACK(ERR_LIB_RSA, 0xfff, 0xfff);
+    if (ERR_func_error_string(e) != NULL ||
+        ERR_reason_error_string(e) != NULL) {
+        printf("Strings found for unknown codes\n");
+        return 0;
+    }
+    ERR_error_string_n(e, buf, sizeof(buf));
+    if (strcmp(buf, "error:04FFFFFF:rsa routines:func(4095):reason(4095)") !=
+        0) {
+        printf("Wrong formatting: %s\n", buf);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int test_user_strings(void)
+{
+    ERR_STRING_DATA strings[] = {
+        { ERR_PACK(0, USER_FUNC, 0), "user function" },
+        { ERR_PACK(0, 0, USER_REASON), "user reason" },
+        { 0, NULL },
+    };
+    unsigned long e;
+    int lib;
+
+    lib = ERR_get_next_error_library();
+    e = ERR_PACK(lib, USER_FUNC, USER_REASON);
+
+    ERR_load_strings(lib, strings);
+    if (ERR_func_error_string(e) == NULL ||
+        strcmp(ERR_func_error_string(e), "user function") != 0 ||
+        ERR_reason_error_string(e) == NULL ||
+        strcmp(ERR_reason_error_string(e), "user reason") != 0) {
+        printf("Loaded strings not found\n");
+        return 0;
+    }
+
+    ERR_unload_strings(lib, strings);
+    if (ERR_func_error_string(e) != NULL ||
+        ERR_reason_error_string(e) != NULL ||
+        ERR_lib_error_string(ERR_PACK(ERR_LIB_RSA, 0, 0)) == NULL) {
+        printf("Unloaded strings still found\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+/* check_data pops an error and checks its data against |expected|. */
+static int check_data(const char *expected, int expected_flags)
+{
+    const char *data;
+    int flags;
+
+    if (ERR_get_error_line_data(NULL, NULL, &data, &flags) == 0 ||
+        (flags & ERR_TXT_STRING) != expected_flags ||
+        strcmp(data, expected) != 0) {
+        printf("Wrong error data, expected \"%.20s\"\n", expected);
+        return 0;
+    }
+    return 1;
+}
+
+static void push_errors(int n, const char *long_data)
+{
+    const char *data;
+
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+    ERR_asprintf_error_data("error %d", n);
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+    ERR_add_error_data(2, "long ", long_data);
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+    ERR_set_error_data("static", ERR_TXT_STRING);
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+    ERR_asprintf_error_data("short");
+    /* The new data may be built from the old */
+    ERR_add_error_data(2, "short", " again");
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+    /* Or formatted from the old, which was allocated */
+    ERR_set_error_data(strdup("formatted"), ERR_TXT_MALLOCED | ERR_TXT_STRING);
+    ERR_peek_last_error_line_data(NULL, NULL, &data, NULL);
+    ERR_asprintf_error_data("%s again", data);
+    RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+}
+
+static int test_data(void)
+{
+    char long_data[300], expected[310];
+    int i;
+
+    memset(long_data, 'x', sizeof(long_data) - 1);
+    long_data[sizeof(long_data) - 1] = '\0';
+    snprintf(expected, sizeof(expected), "long %s", long_data);
+
+    ERR_clear_error();
+
+    /* Go around the queue a few times so that slots are reused */
+    for (i = 0; i < 3 * ERR_NUM_ERRORS; i++) {
+        char number[32];
+
+        push_errors(i, long_data);
+        snprintf(number, sizeof(number), "error %d", i);
+        if (!check_data(number, ERR_TXT_STRING) ||
+            !check_data(expected, ERR_TXT_STRING) ||
+            !check_data("static", ERR_TXT_STRING) ||
+            !check_data("short again", ERR_TXT_STRING) ||
+            !check_data("formatted again", ERR_TXT_STRING) ||
+            !check_data("", 0))
+            return 0;
+        if (ERR_peek_error() != 0) {
+            printf("Errors left in the queue\n");
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#ifdef OPENSSL_THREADS
+
+#define BENCH_ITERATIONS 200000
+
+static void *bench_thread(void *arg)
+{
+    unsigned long e;
+    const char *file, *data;
+    char buf[256];
+    int i, line, flags;
+
+    (void)arg;
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        RSAerr(RSA_F_RSA_NEW_METHOD, RSA_R_DATA_TOO_LARGE);
+        ERR_asprintf_error_data("iteration %d", i);
+        e = ERR_get_error_line_data(&file, &line, &data, &flags);
+        ERR_error_string_n(e, buf, sizeof(buf));
+    }
+    ERR_remove_thread_state(NULL);
+    return NULL;
+}
+
+static int bench(int num_threads)
+{
+    char what[32];
+    double secs;
+
+    if ((secs = test_run_threads(num_threads, bench_thread, NULL)) < 0)
+        return 0;
+    snprintf(what, sizeof(what), "%d thread(s)", num_threads);
+    test_report(what, (double)num_threads * BENCH_ITERATIONS, secs, "errors");
+    return 1;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+
+    if (!test_strings() || !test_user_strings() || !test_data())
+        goto err;
+#ifdef OPENSSL_THREADS
+    if (test_bench_requested(argc, argv) && (!bench(1) || !bench(4))) {
+        printf("Unable to start threads\n");
+        goto err;
+    }
+#endif
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that large writes on AES-CBC-HMAC connections decode to the same
+ * plaintext with and without SSL_MODE_MULTIBLOCK_WRITE, and that the
+ * multi-block path is actually taken where the stitched ciphers exist, also
+ * when the write BIO stops accepting data in the middle of a batch of records
+ * and the write is retried. With a
+ * "bench" argument, it then reports the SSL_write throughput of each suite
+ * with the mode off and on.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "ssltestlib.h"
+#include "testutil.h"
+
+static char *cert = NULL;
+static char *privkey = NULL;
+
+static const struct {
+    const char *cipher;
+    const char *stitched;
+} suites[] = {
+    { "AES128-SHA", "AES-128-CBC-HMAC-SHA1" },
+    { "AES256-SHA", "AES-256-CBC-HMAC-SHA1" },
+    { "AES128-SHA256", "AES-128-CBC-HMAC-SHA256" },
+    { "AES256-SHA256", "AES-256-CBC-HMAC-SHA256" },
+};
+
+/* Below, at and above the four and eight record thresholds */
+static const int lengths[] = {
+    4 * 16384 - 1, 4 * 16384, 4 * 16384 + 4095, 8 * 16384, 8 * 16384 + 1,
+    20 * 16384 + 777,
+};
+
+#define MAX_LEN (20 * 16384 + 777)
+
+static uint8_t msg[MAX_LEN];
+static uint8_t got[MAX_LEN];
+
+/*
+ * read_all reads |len| bytes from |ssl| into |out|, which must all already
+ * be buffered in its read BIO.
+ */
+static int read_all(SSL *ssl, uint8_t *out, int len)
+{
+    int n, off = 0;
+
+    while (off < len) {
+        n = SSL_read(ssl, out + off, len - off);
+        if (n <= 0) {
+            printf("SSL_read() failed after %d of %d bytes\n", off, len);
+            ERR_print_errors_fp(stdout);
+            return 0;
+        }
+        off += n;
+    }
+    return 1;
+}
+
+/*
+ * first_record_len returns the length field of the first record buffered in
+ * the memory BIO under |ssl|'s write BIO, or -1 if there is none.
+ */
+static int first_record_len(SSL *ssl)
+{
+    BIO *bio = SSL_get_wbio(ssl);
+    char *data;
+    long n;
+
+    n = BIO_get_mem_data(bio, &data);
+    if (n < 5 || data[0] != SSL3_RT_APPLICATION_DATA)
+        return -1;
+    return ((uint8_t)data[3] << 8) | (uint8_t)data[4];
+}
+
+/*
+ * The throttle filter passes at most |throttle_budget| more bytes to the BIO
+ * under it and then asks the writer to retry, as a full socket buffer would.
+ * A negative budget passes everything.
+ */
+static int throttle_budget = -1;
+
+static int throttle_write(BIO *bio, const char *in, int inl)
+{
+    int ret;
+
+    BIO_clear_retry_flags(bio);
+    if (throttle_budget == 0) {
+        BIO_set_retry_write(bio);
+        return -1;
+    }
+    if (throttle_budget > 0 && inl > throttle_budget)
+        inl = throttle_budget;
+    ret = BIO_write(BIO_next(bio), in, inl);
+    BIO_copy_next_retry(bio);
+    if (ret > 0 && throttle_budget > 0)
+        throttle_budget -= ret;
+    return ret;
+}
+
+static int throttle_read(BIO *bio, char *out, int outl)
+{
+    int ret;
+
+    BIO_clear_retry_flags(bio);
+    ret = BIO_read(BIO_next(bio), out, outl);
+    BIO_copy_next_retry(bio);
+    return ret;
+}
+
+static long throttle_ctrl(BIO *bio, int cmd, long num, void *ptr)
+{
+    if (BIO_next(bio) == NULL || cmd == BIO_CTRL_DUP)
+        return 0;
+    return BIO_ctrl(BIO_next(bio), cmd, num, ptr);
+}
+
+static int throttle_new(BIO *bio)
+{
+    bio->init = 1;
+    return 1;
+}
+
+static int throttle_free(BIO *bio)
+{
+    bio->init = 0;
+    return 1;
+}
+
+static BIO_METHOD method_throttle = {
+    .type = 0x80 | BIO_TYPE_FILTER,
+    .name = "throttle filter",
+    .bwrite = throttle_write,
+    .bread = throttle_read,
+    .ctrl = throttle_ctrl,
+    .create = throttle_new,
+    .destroy = throttle_free,
+};
+
+/*
+ * connect_pair creates a connected client and server for |suite|, with
+ * SSL_MODE_MULTIBLOCK_WRITE on the client if |multiblock| is set. If |fbio|
+ * is not NULL, it is a filter on the client's write BIO.
+ */
+static int connect_pair(size_t suite, int multiblock, BIO *fbio,
+                        SSL_CTX **sctx, SSL_CTX **cctx, SSL **serverssl,
+                        SSL **clientssl)
+{
+    if (!create_ssl_ctx_pair(TLSv1_2_server_method(), TLSv1_2_client_method(),
+                             sctx, cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        BIO_free(fbio);
+        return 0;
+    }
+
+    if (!SSL_CTX_set_cipher_list(*cctx, suites[suite].cipher)) {
+        printf("Failed setting cipher list\n");
+        BIO_free(fbio);
+        return 0;
+    }
+    if (multiblock)
+        SSL_CTX_set_mode(*cctx, SSL_MODE_MULTIBLOCK_WRITE);
+
+    if (!create_ssl_objects(*sctx, *cctx, serverssl, clientssl, NULL, fbio)) {
+        printf("Unable to create SSL objects\n");
+        ERR_print_errors_fp(stdout);
+        return 0;
+    }
+
+    if (!create_ssl_connection(*serverssl, *clientssl)) {
+        printf("Unable to create SSL connection\n");
+        ERR_print_errors_fp(stdout);
+        return 0;
+    }
+    return 1;
+}
+
+static int test_multiblock(size_t suite, int multiblock)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int stitched, testresult = 0;
+    size_t i;
+
+    printf("Testing %s, multiblock %s\n", suites[suite].cipher,
+           multiblock ? "on" : "off");
+
+    if (!connect_pair(suite, multiblock, NULL, &sctx, &cctx, &serverssl,
+                      &clientssl))
+        goto end;
+
+    stitched = EVP_get_cipherbyname(suites[suite].stitched) != NULL;
+
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        int len = lengths[i], rec;
+
+        if (SSL_write(clientssl, msg, len) != len) {
+            printf("SSL_write() of %d bytes failed\n", len);
+            ERR_print_errors_fp(stdout);
+            goto end;
+        }
+
+        /*
+         * The multi-block path shortens the fragments so that the records of
+         * one batch do not alias each other in the cache.
+         */
+        rec = first_record_len(clientssl);
+        if (multiblock && stitched && len >= 4 * 16384) {
+            if (rec < 0 || rec >= 16384) {
+                printf("Multi-block write not used (record length %d)\n", rec);
+                goto end;
+            }
+        } else if (rec <= 16384) {
+            printf("Unexpected record length %d\n", rec);
+            goto end;
+        }
+
+        memset(got, 0, len);
+        if (!read_all(serverssl, got, len))
+            goto end;
+        if (memcmp(got, msg, len) != 0) {
+            printf("Data mismatch for a %d byte write\n", len);
+            goto end;
+        }
+
+        /* A short write afterwards checks the record sequence numbers */
+        if (SSL_write(clientssl, msg, 100) != 100 ||
+            !read_all(serverssl, got, 100) || memcmp(got, msg, 100) != 0) {
+            printf("Short write after %d bytes failed\n", len);
+            goto end;
+        }
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/* Bytes of records written before the write BIO first stalls */
+static const int cuts[] = { 1000, 3 * 16384 + 5, 9 * 16384 };
+
+/*
+ * write_stalled writes |len| bytes from |ssl| with the throttle filter
+ * stopping after |cut| bytes and again 5000 bytes later, retrying with the
+ * same buffer each time, and returns whether both stalls were reported as
+ * SSL_ERROR_WANT_WRITE and the retry then wrote everything.
+ */
+static int write_stalled(SSL *ssl, int len, int cut, int expect_multiblock)
+{
+    int ret, rec;
+
+    throttle_budget = cut;
+    ret = SSL_write(ssl, msg, len);
+    if (ret > 0 || SSL_get_error(ssl, ret) != SSL_ERROR_WANT_WRITE) {
+        printf("SSL_write() of %d bytes stalled after %d: returned %d\n", len,
+               cut, ret);
+        return 0;
+    }
+    rec = first_record_len(ssl);
+    if (expect_multiblock && (rec < 0 || rec >= 16384)) {
+        printf("Multi-block write not used (record length %d)\n", rec);
+        return 0;
+    }
+
+    throttle_budget = 5000;
+    ret = SSL_write(ssl, msg, len);
+    if (ret > 0 || SSL_get_error(ssl, ret) != SSL_ERROR_WANT_WRITE) {
+        printf("SSL_write() of %d bytes retried after %d: returned %d\n", len,
+               cut, ret);
+        return 0;
+    }
+
+    throttle_budget = -1;
+    if ((ret = SSL_write(ssl, msg, len)) != len) {
+        printf("SSL_write() of %d bytes completed after %d: returned %d\n",
+               len, cut, ret);
+        return 0;
+    }
+    return 1;
+}
+
+static int test_partial_write(size_t suite, int multiblock)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO *fbio;
+    int stitched, testresult = 0;
+    size_t i, j;
+
+    printf("Testing %s partial writes, multiblock %s\n", suites[suite].cipher,
+           multiblock ? "on" : "off");
+
+    throttle_budget = -1;
+    if ((fbio = BIO_new(&method_throttle)) == NULL ||
+        !connect_pair(suite, multiblock, fbio, &sctx, &cctx, &serverssl,
+                      &clientssl))
+        goto end;
+
+    stitched = EVP_get_cipherbyname(suites[suite].stitched) != NULL;
+
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        int len = lengths[i];
+
+        if (len < 4 * 16384)
+            continue;
+        for (j = 0; j < sizeof(cuts) / sizeof(cuts[0]); j++) {
+            if (cuts[j] + 5000 >= len)
+                continue;
+            if (!write_stalled(clientssl, len, cuts[j],
+                               multiblock && stitched)) {
+                ERR_print_errors_fp(stdout);
+                goto end;
+            }
+
+            memset(got, 0, len);
+            if (!read_all(serverssl, got, len))
+                goto end;
+            if (memcmp(got, msg, len) != 0) {
+                printf("Data mismatch for a %d byte write stalled after %d\n",
+                       len, cuts[j]);
+                goto end;
+            }
+
+            if (SSL_write(clientssl, msg, 100) != 100 ||
+                !read_all(serverssl, got, 100) ||
+                memcmp(got, msg, 100) != 0) {
+                printf("Short write after %d bytes failed\n", len);
+                goto end;
+            }
+        }
+    }
+
+    testresult = 1;
+ end:
+    throttle_budget = -1;
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+#define BENCH_WRITE (16 * 16384)
+#define BENCH_TOTAL (32 * 1024 * 1024)
+
+/*
+ * bench_write times BENCH_TOTAL bytes of BENCH_WRITE byte SSL_writes for
+ * |suite|, draining the client's write BIO after each write so that only
+ * the record encryption is measured.
+ */
+static int bench_write(size_t suite, int multiblock)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    char what[32];
+    double start;
+    int i, ret = 0;
+
+    if (!connect_pair(suite, multiblock, NULL, &sctx, &cctx, &serverssl,
+                      &clientssl))
+        goto end;
+
+    start = test_now();
+    for (i = 0; i < BENCH_TOTAL / BENCH_WRITE; i++) {
+        if (SSL_write(clientssl, msg, BENCH_WRITE) != BENCH_WRITE) {
+            printf("SSL_write() of %d bytes failed\n", BENCH_WRITE);
+            ERR_print_errors_fp(stdout);
+            goto end;
+        }
+        (void)BIO_reset(SSL_get_wbio(clientssl));
+    }
+    snprintf(what, sizeof(what), "%s, %s", suites[suite].cipher,
+             multiblock ? "multiblock" : "single");
+    test_report(what, BENCH_TOTAL / (1024.0 * 1024), test_now() - start, "MB");
+    ret = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    BIO *err = NULL;
+    int testresult = 0;
+    size_t i;
+
+    if (argc != 3 && !(argc == 4 && test_bench_requested(argc, argv))) {
+        printf("Usage: multiblocktest <cert> <key> [bench]\n");
+        return 1;
+    }
+
+    cert = argv[1];
+    privkey = argv[2];
+
+    err = BIO_new_fp(stderr, BIO_NOCLOSE | BIO_FP_TEXT);
+
+    SSL_library_init();
+    SSL_load_error_strings();
+
+    for (i = 0; i < sizeof(msg); i++)
+        msg[i] = (uint8_t)(i * 7 + (i >> 8));
+
+    for (i = 0; i < sizeof(suites) / sizeof(suites[0]); i++) {
+        if (!test_multiblock(i, 0) || !test_multiblock(i, 1) ||
+            !test_partial_write(i, 0) || !test_partial_write(i, 1))
+            testresult = 1;
+    }
+    if (test_bench_requested(argc, argv)) {
+        for (i = 0; testresult == 0 && i < sizeof(suites) / sizeof(suites[0]);
+             i++) {
+            if (!bench_write(i, 0) || !bench_write(i, 1)) {
+                printf("Benchmark failed\n");
+                testresult = 1;
+            }
+        }
+    }
+
+    ERR_free_strings();
+    ERR_remove_thread_state(NULL);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+    BIO_free(err);
+
+    if (!testresult)
+        printf("PASS\n");
+
+    return testresult;
+}
@@ -0,0 +1,539 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks the answers of an OCSP_RESPONDER loaded from an index: good and
+ * revoked certificates, unknown ones, malformed requests, re-signing when
+ * the window rolls and reloading the index. With a "bench" argument, it then
+ * sends requests over a loopback socket, HTTP as the ocsp command serves it,
+ * and compares the rate of pre-signed answers with that of signing each
+ * response.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include <openssl/bio.h>
+#include <openssl/bn.h>
+#include <openssl/buffer.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ocsp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include "testutil.h"
+
+#define NUM_EXTRA 1000
+#define BENCH_REQUESTS 200
+
+static X509 *issuer, *other_ca, *leaf;
+static EVP_PKEY *issuer_key;
+
+static int load_files(void)
+{
+    BIO *bio;
+
+    if ((bio = BIO_new_file("certs/subinterCA.pem", "r")) != NULL)
+        issuer = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if ((bio = BIO_new_file("certs/subinterCA.key", "r")) != NULL)
+        issuer_key = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if ((bio = BIO_new_file("certs/interCA.pem", "r")) != NULL)
+        other_ca = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if ((bio = BIO_new_file("certs/leaf.pem", "r")) != NULL)
+        leaf = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+
+    return issuer != NULL && issuer_key != NULL && other_ca != NULL &&
+           leaf != NULL;
+}
+
+/*
+ * load_index loads an index listing the leaf certificate, valid or revoked,
+ * a revoked certificate with serial 0x0bad, an expired one with serial
+ * 0x0e0e and NUM_EXTRA valid ones with serials from 0x10000 up.
+ */
+static int load_index(OCSP_RESPONDER *r, int leaf_revoked)
+{
+    BIGNUM *bn;
+    char *leaf_serial;
+    BIO *bio;
+    int i, ret;
+
+    if ((bio = BIO_new(BIO_s_mem())) == NULL)
+        return 0;
+    bn = ASN1_INTEGER_to_BN(X509_get_serialNumber(leaf), NULL);
+    if (bn == NULL || (leaf_serial = BN_bn2hex(bn)) == NULL) {
+        BN_free(bn);
+        BIO_free(bio);
+        return 0;
+    }
+    BN_free(bn);
+
+    if (leaf_revoked)
+        BIO_printf(bio, "R\t491231235959Z\t160101000000Z\t%s\tunknown\t"
+                        "/CN=leaf\n", leaf_serial);
+    else
+        BIO_printf(bio, "V\t491231235959Z\t\t%s\tunknown\t/CN=leaf\n",
+                   leaf_serial);
+    BIO_printf(bio, "R\t491231235959Z\t160101000000Z,keyCompromise\t0BAD\t"
+                    "unknown\t/CN=bad\n");
+    BIO_printf(bio, "E\t150101000000Z\t\t0E0E\tunknown\t/CN=expired\n");
+    for (i = 0; i < NUM_EXTRA; i++)
+        BIO_printf(bio, "V\t491231235959Z\t\t%X\tunknown\t/CN=%d\n",
+                   0x10000 + i, i);
+    free(leaf_serial);
+
+    ret = OCSP_RESPONDER_load_index(r, bio);
+    BIO_free(bio);
+    return ret;
+}
+
+/* make_request returns the DER request for |serial| under |ca|. */
+static int make_request(X509 *ca, const EVP_MD *md, long serial, int count,
+                        uint8_t **out)
+{
+    OCSP_REQUEST *req;
+    OCSP_CERTID *id;
+    ASN1_INTEGER *sn;
+    int i, ret = 0;
+
+    if (md == NULL)
+        md = EVP_sha1();
+    if ((req = OCSP_REQUEST_new()) == NULL)
+        return 0;
+    for (i = 0; i < count; i++) {
+        if (serial < 0)
+            id = OCSP_cert_to_id(md, leaf, ca);
+        else {
+            if ((sn = ASN1_INTEGER_new()) == NULL ||
+                !ASN1_INTEGER_set(sn, serial)) {
+                ASN1_INTEGER_free(sn);
+                goto err;
+            }
+            id = OCSP_cert_id_new(md, X509_get_subject_name(ca),
+                                  X509_get0_pubkey_bitstr(ca), sn);
+            ASN1_INTEGER_free(sn);
+        }
+        if (id == NULL || OCSP_request_add0_id(req, id) == NULL) {
+            OCSP_CERTID_free(id);
+            goto err;
+        }
+    }
+    if (!OCSP_request_add1_nonce(req, NULL, -1))
+        goto err;
+    ret = i2d_OCSP_REQUEST(req, out);
+
+ err:
+    OCSP_REQUEST_free(req);
+    return ret;
+}
+
+/*
+ * check_answer sends the request for |serial| (the leaf certificate if
+ * negative) and checks the response status and, when successful, the
+ * certificate status and signature.
+ */
+static int check_answer(OCSP_RESPONDER *r, X509 *ca, const EVP_MD *md,
+                        long serial, int count, int expected_resp,
+                        int expected_status, int expected_reason)
+{
+    OCSP_RESPONSE *resp = NULL;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_CERTID *id = NULL;
+    STACK_OF(X509) *signers = NULL;
+    ASN1_GENERALIZEDTIME *thisupd, *nextupd;
+    BUF_MEM *out;
+    uint8_t *req = NULL;
+    const uint8_t *p;
+    int req_len, status, reason, ret = 0;
+
+    if ((out = BUF_MEM_new()) == NULL ||
+        (req_len = make_request(ca, md, serial, count, &req)) <= 0)
+        goto err;
+
+    if (OCSP_RESPONDER_respond(r, req, req_len, out) != expected_resp) {
+        printf("Serial %ld: wrong response status\n", serial);
+        goto err;
+    }
+    p = (const uint8_t *)out->data;
+    if ((resp = d2i_OCSP_RESPONSE(NULL, &p, out->length)) == NULL ||
+        p != (const uint8_t *)out->data + out->length ||
+        OCSP_response_status(resp) != expected_resp) {
+        printf("Serial %ld: bad response\n", serial);
+        goto err;
+    }
+    if (expected_resp != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+        ret = 1;
+        goto err;
+    }
+
+    if ((signers = sk_X509_new_null()) == NULL ||
+        !sk_X509_push(signers, issuer) ||
+        (bs = OCSP_response_get1_basic(resp)) == NULL ||
+        OCSP_basic_verify(bs, signers, NULL, OCSP_NOVERIFY) <= 0) {
+        printf("Serial %ld: bad signature\n", serial);
+        goto err;
+    }
+    if (serial < 0)
+        id = OCSP_cert_to_id(NULL, leaf, ca);
+    else {
+        ASN1_INTEGER *sn = ASN1_INTEGER_new();
+
+        if (sn != NULL && ASN1_INTEGER_set(sn, serial))
+            id = OCSP_cert_id_new(EVP_sha1(), X509_get_subject_name(ca),
+                                  X509_get0_pubkey_bitstr(ca), sn);
+        ASN1_INTEGER_free(sn);
+    }
+    if (id == NULL ||
+        !OCSP_resp_find_status(bs, id, &status, &reason, NULL, &thisupd,
+                               &nextupd) ||
+        !OCSP_check_validity(thisupd, nextupd, 0, -1)) {
+        printf("Serial %ld: no valid status\n", serial);
+        goto err;
+    }
+    if (status != expected_status ||
+        (status == V_OCSP_CERTSTATUS_REVOKED && reason != expected_reason)) {
+        printf("Serial %ld: status %d reason %d, expected %d and %d\n",
+               serial, status, reason, expected_status, expected_reason);
+        goto err;
+    }
+    ret = 1;
+
+ err:
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(resp);
+    sk_X509_free(signers);
+    BUF_MEM_free(out);
+    free(req);
+    return ret;
+}
+
+static int test_responder(void)
+{
+    static const uint8_t garbage[] = { 0x30, 0x03, 0x02, 0x01, 0x00 };
+    OCSP_RESPONDER *r;
+    BUF_MEM *out = NULL;
+    time_t next_update, now;
+    int ret = 0;
+
+    if ((r = OCSP_RESPONDER_new(issuer, issuer, issuer_key,
+                                EVP_sha256())) == NULL ||
+        !load_index(r, 0) || (out = BUF_MEM_new()) == NULL)
+        goto err;
+
+    /* Nothing is answered before the first signing */
+    if (!check_answer(r, issuer, NULL, -1, 1, OCSP_RESPONSE_STATUS_TRYLATER,
+                      0, 0))
+        goto err;
+
+    now = time(NULL);
+    if (!OCSP_RESPONDER_update(r, 3600, 60)) {
+        printf("Signing failed\n");
+        goto err;
+    }
+    next_update = OCSP_RESPONDER_get_next_update(r);
+    if (next_update < now + 3600 || next_update > now + 3602) {
+        printf("Wrong nextUpdate time\n");
+        goto err;
+    }
+
+    if (!check_answer(r, issuer, NULL, -1, 1, OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                      V_OCSP_CERTSTATUS_GOOD, 0) ||
+        !check_answer(r, issuer, NULL, 0x10000 + NUM_EXTRA - 1, 1,
+                      OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                      V_OCSP_CERTSTATUS_GOOD, 0) ||
+        !check_answer(r, issuer, NULL, 0x0bad, 1,
+                      OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                      V_OCSP_CERTSTATUS_REVOKED,
+                      OCSP_REVOKED_STATUS_KEYCOMPROMISE))
+        goto err;
+
+    /* Unknown, expired, other issuers and other CertID digests */
+    if (!check_answer(r, issuer, NULL, 0x0e0e, 1,
+                      OCSP_RESPONSE_STATUS_UNAUTHORIZED, 0, 0) ||
+        !check_answer(r, issuer, NULL, 0x10000 + NUM_EXTRA, 1,
+                      OCSP_RESPONSE_STATUS_UNAUTHORIZED, 0, 0) ||
+        !check_answer(r, other_ca, NULL, 0x10000, 1,
+                      OCSP_RESPONSE_STATUS_UNAUTHORIZED, 0, 0) ||
+        !check_answer(r, issuer, EVP_sha256(), 0x10000, 1,
+                      OCSP_RESPONSE_STATUS_UNAUTHORIZED, 0, 0))
+        goto err;
+
+    /* Only single requests are answered */
+    if (!check_answer(r, issuer, NULL, 0x10000, 2,
+                      OCSP_RESPONSE_STATUS_MALFORMEDREQUEST, 0, 0) ||
+        OCSP_RESPONDER_respond(r, garbage, sizeof(garbage), out) !=
+            OCSP_RESPONSE_STATUS_MALFORMEDREQUEST) {
+        printf("Malformed request answered\n");
+        goto err;
+    }
+
+    /* Fresh responses are kept, expiring ones are replaced */
+    if (!OCSP_RESPONDER_update(r, 7200, 60) ||
+        OCSP_RESPONDER_get_next_update(r) != next_update) {
+        printf("Fresh responses were signed again\n");
+        goto err;
+    }
+    if (!load_index(r, 1) || !OCSP_RESPONDER_update(r, 7200, 3600) ||
+        OCSP_RESPONDER_get_next_update(r) < now + 7200) {
+        printf("Expiring responses were not signed again\n");
+        goto err;
+    }
+    if (!check_answer(r, issuer, NULL, -1, 1, OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                      V_OCSP_CERTSTATUS_REVOKED,
+                      OCSP_REVOKED_STATUS_NOSTATUS)) {
+        printf("Reloaded index not used\n");
+        goto err;
+    }
+
+    ret = 1;
+
+ err:
+    BUF_MEM_free(out);
+    OCSP_RESPONDER_free(r);
+    return ret;
+}
+
+#if !defined(_WIN32)
+
+/* sign_response answers |req| by signing a response, as the ocsp command */
+static int sign_response(const uint8_t *req_der, size_t req_len, BUF_MEM *out)
+{
+    OCSP_REQUEST *req;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_RESPONSE *resp = NULL;
+    ASN1_TIME *thisupd = NULL, *nextupd = NULL;
+    uint8_t *p;
+    int i, len, ret = 0;
+
+    if ((req = d2i_OCSP_REQUEST(NULL, &req_der, req_len)) == NULL)
+        return 0;
+    thisupd = X509_gmtime_adj(NULL, 0);
+    nextupd = X509_gmtime_adj(NULL, 3600);
+    if ((bs = OCSP_BASICRESP_new()) == NULL || thisupd == NULL ||
+        nextupd == NULL)
+        goto err;
+    for (i = 0; i < OCSP_request_onereq_count(req); i++) {
+        OCSP_CERTID *id;
+
+        id = OCSP_onereq_get0_id(OCSP_request_onereq_get0(req, i));
+        if (OCSP_basic_add1_status(bs, id, V_OCSP_CERTSTATUS_GOOD, 0, NULL,
+                                   thisupd, nextupd) == NULL)
+            goto err;
+    }
+    OCSP_copy_nonce(bs, req);
+    if (!OCSP_basic_sign(bs, issuer, issuer_key, EVP_sha256(), NULL,
+                         OCSP_NOCERTS) ||
+        (resp = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL,
+                                     bs)) == NULL ||
+        (len = i2d_OCSP_RESPONSE(resp, NULL)) <= 0 ||
+        !BUF_MEM_grow(out, len))
+        goto err;
+    p = (uint8_t *)out->data;
+    i2d_OCSP_RESPONSE(resp, &p);
+    ret = 1;
+
+ err:
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    OCSP_RESPONSE_free(resp);
+    OCSP_BASICRESP_free(bs);
+    OCSP_REQUEST_free(req);
+    return ret;
+}
+
+static int read_all(int fd, char *buf, size_t size, size_t *len)
+{
+    ssize_t n;
+
+    *len = 0;
+    while (*len < size && (n = read(fd, buf + *len, size - *len)) > 0)
+        *len += n;
+    return *len < size;
+}
+
+/*
+ * serve_one accepts a connection on |lfd|, reads an HTTP POST of an OCSP
+ * request and writes the answer.
+ */
+static int serve_one(int lfd, OCSP_RESPONDER *r, BUF_MEM *out)
+{
+    char buf[4096], hdr[128], *body;
+    size_t len = 0;
+    ssize_t n;
+    long clen;
+    int fd, ok;
+
+    if ((fd = accept(lfd, NULL, NULL)) < 0)
+        return 0;
+    for (;;) {
+        if ((n = read(fd, buf + len, sizeof(buf) - 1 - len)) <= 0)
+            goto err;
+        len += n;
+        buf[len] = '\0';
+        if ((body = strstr(buf, "\r\n\r\n")) == NULL ||
+            strstr(buf, "Content-Length: ") == NULL)
+            continue;
+        body += 4;
+        clen = strtol(strstr(buf, "Content-Length: ") + 16, NULL, 10);
+        if (buf + len - body >= clen)
+            break;
+    }
+
+    if (r != NULL)
+        ok = OCSP_RESPONDER_respond(r, (uint8_t *)body, clen, out) >= 0;
+    else
+        ok = sign_response((uint8_t *)body, clen, out);
+    if (!ok)
+        goto err;
+
+    n = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\n"
+                 "Content-type: application/ocsp-response\r\n"
+                 "Content-Length: %d\r\n\r\n", (int)out->length);
+    if (write(fd, hdr, n) != n ||
+        write(fd, out->data, out->length) != (ssize_t)out->length)
+        goto err;
+    close(fd);
+    return 1;
+
+ err:
+    close(fd);
+    return 0;
+}
+
+/*
+ * run_requests sends BENCH_REQUESTS requests over fresh connections to the
+ * listening socket |lfd| and answers them with |r|, or by signing if |r| is
+ * NULL. Requests and answers fit in the socket buffers, so one thread can
+ * play both sides.
+ */
+static int run_requests(int lfd, struct sockaddr_in *sin, OCSP_RESPONDER *r)
+{
+    BUF_MEM *out;
+    uint8_t *req = NULL;
+    char hdr[256], buf[8192], *body;
+    size_t len;
+    double start;
+    int i, fd, n, req_len, ret = 0;
+
+    if ((out = BUF_MEM_new()) == NULL ||
+        (req_len = make_request(issuer, NULL, 0x10000, 1, &req)) <= 0)
+        goto err;
+    n = snprintf(hdr, sizeof(hdr), "POST / HTTP/1.0\r\n"
+                 "Content-Type: application/ocsp-request\r\n"
+                 "Content-Length: %d\r\n\r\n", req_len);
+
+    start = test_now();
+    for (i = 0; i < BENCH_REQUESTS; i++) {
+        if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+            goto err;
+        if (connect(fd, (struct sockaddr *)sin, sizeof(*sin)) != 0 ||
+            write(fd, hdr, n) != n || write(fd, req, req_len) != req_len ||
+            !serve_one(lfd, r, out) ||
+            !read_all(fd, buf, sizeof(buf), &len)) {
+            close(fd);
+            goto err;
+        }
+        close(fd);
+        if ((body = strstr(buf, "\r\n\r\n")) == NULL ||
+            memcmp(body + 4, out->data, out->length) != 0)
+            goto err;
+    }
+    test_report(r != NULL ? "pre-signed" : "signing", BENCH_REQUESTS,
+                test_now() - start, "requests");
+    ret = 1;
+
+ err:
+    BUF_MEM_free(out);
+    free(req);
+    return ret;
+}
+
+static int bench(void)
+{
+    OCSP_RESPONDER *r;
+    struct sockaddr_in sin;
+    socklen_t sin_len = sizeof(sin);
+    int lfd, ret = 0;
+
+    if ((lfd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        return 0;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(lfd, (struct sockaddr *)&sin, sizeof(sin)) != 0 ||
+        listen(lfd, 16) != 0 ||
+        getsockname(lfd, (struct sockaddr *)&sin, &sin_len) != 0) {
+        close(lfd);
+        return 0;
+    }
+
+    if ((r = OCSP_RESPONDER_new(issuer, issuer, issuer_key,
+                                EVP_sha256())) != NULL &&
+        load_index(r, 0) && OCSP_RESPONDER_update(r, 3600, 60) &&
+        run_requests(lfd, &sin, NULL) && run_requests(lfd, &sin, r))
+        ret = 1;
+
+    OCSP_RESPONDER_free(r);
+    close(lfd);
+    return ret;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+    OpenSSL_add_all_algorithms();
+
+    if (!load_files()) {
+        printf("Unable to load the test certificates\n");
+        goto err;
+    }
+    if (!test_responder())
+        goto err;
+#if !defined(_WIN32)
+    if (test_bench_requested(argc, argv) && !bench()) {
+        printf("Benchmark requests failed\n");
+        goto err;
+    }
+#endif
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    X509_free(issuer);
+    X509_free(other_ca);
+    X509_free(leaf);
+    EVP_PKEY_free(issuer_key);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
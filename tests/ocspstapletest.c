@@ -0,0 +1,413 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks the built-in OCSP staple cache. The fetcher sends real OCSP
+ * requests with OCSP_sendreq_nbio over a BIO pair to a responder in this
+ * process, which signs its answers with the intermediate CA's key. The
+ * staples must be refreshed only when close to their nextUpdate time, be
+ * sent to clients asking for them, and not be sent once they have expired.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ocsp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "ssltestlib.h"
+#include "testutil.h"
+
+typedef struct {
+    X509 *cert;
+    EVP_PKEY *key;
+    /* Lifetime of the responses, in seconds */
+    long validity;
+    /* Number of requests answered */
+    int requests;
+    /* Fail the next fetch */
+    int fail;
+} RESPONDER;
+
+static OCSP_RESPONSE *make_response(RESPONDER *r, OCSP_REQUEST *req)
+{
+    OCSP_BASICRESP *bs;
+    OCSP_RESPONSE *resp = NULL;
+    ASN1_TIME *thisupd, *nextupd;
+    int i;
+
+    bs = OCSP_BASICRESP_new();
+    thisupd = X509_gmtime_adj(NULL, 0);
+    nextupd = X509_gmtime_adj(NULL, r->validity);
+    if (bs == NULL || thisupd == NULL || nextupd == NULL)
+        goto err;
+
+    for (i = 0; i < OCSP_request_onereq_count(req); i++) {
+        OCSP_CERTID *id;
+
+        id = OCSP_onereq_get0_id(OCSP_request_onereq_get0(req, i));
+        if (OCSP_basic_add1_status(bs, id, V_OCSP_CERTSTATUS_GOOD, 0, NULL,
+                                   thisupd, nextupd) == NULL)
+            goto err;
+    }
+    if (!OCSP_basic_sign(bs, r->cert, r->key, EVP_sha256(), NULL, 0))
+        goto err;
+    resp = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL, bs);
+
+ err:
+    OCSP_BASICRESP_free(bs);
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    return resp;
+}
+
+/*
+ * serve reads what has arrived at the responder's end of the BIO pair and,
+ * once the whole HTTP request is there, writes the response. It returns
+ * zero on error.
+ */
+static int serve(RESPONDER *r, BIO *bio, char *buf, size_t *len, size_t size)
+{
+    OCSP_REQUEST *req;
+    OCSP_RESPONSE *resp;
+    uint8_t *der = NULL;
+    const uint8_t *p;
+    char *body;
+    long clen;
+    int n, der_len, ret = 0;
+
+    while ((n = BIO_read(bio, buf + *len, size - 1 - *len)) > 0)
+        *len += n;
+    buf[*len] = '\0';
+
+    if ((body = strstr(buf, "\r\n\r\n")) == NULL)
+        return 1;
+    body += 4;
+    if (strstr(buf, "Content-Length: ") == NULL)
+        return 0;
+    clen = strtol(strstr(buf, "Content-Length: ") + 16, NULL, 10);
+    if (buf + *len - body < clen)
+        return 1;
+
+    p = (const uint8_t *)body;
+    if ((req = d2i_OCSP_REQUEST(NULL, &p, clen)) == NULL)
+        return 0;
+    if ((resp = make_response(r, req)) != NULL &&
+        (der_len = i2d_OCSP_RESPONSE(resp, &der)) > 0) {
+        BIO_printf(bio, "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: application/ocsp-response\r\n"
+                        "Content-Length: %d\r\n\r\n", der_len);
+        ret = BIO_write(bio, der, der_len) == der_len;
+    }
+    r->requests++;
+    *len = 0;
+
+    free(der);
+    OCSP_RESPONSE_free(resp);
+    OCSP_REQUEST_free(req);
+    return ret;
+}
+
+static OCSP_RESPONSE *fetch(SSL_CTX *ctx, X509 *x, X509 *issuer, void *arg)
+{
+    RESPONDER *r = arg;
+    OCSP_REQUEST *req = NULL;
+    OCSP_CERTID *id = NULL;
+    OCSP_REQ_CTX *rctx = NULL;
+    OCSP_RESPONSE *resp = NULL;
+    BIO *client = NULL, *server = NULL;
+    char buf[8192];
+    size_t len = 0;
+
+    if (r->fail) {
+        r->fail = 0;
+        return NULL;
+    }
+
+    if (!BIO_new_bio_pair(&client, 0, &server, 0) ||
+        (req = OCSP_REQUEST_new()) == NULL ||
+        (id = OCSP_cert_to_id(NULL, x, issuer)) == NULL ||
+        OCSP_request_add0_id(req, id) == NULL)
+        goto err;
+    id = NULL;
+
+    if ((rctx = OCSP_sendreq_new(client, "/", req, -1)) == NULL)
+        goto err;
+    while (OCSP_sendreq_nbio(&resp, rctx) == -1) {
+        if (!serve(r, server, buf, &len, sizeof(buf)))
+            break;
+    }
+
+ err:
+    OCSP_REQ_CTX_free(rctx);
+    OCSP_CERTID_free(id);
+    OCSP_REQUEST_free(req);
+    BIO_free(client);
+    BIO_free(server);
+    return resp;
+}
+
+typedef struct {
+    int called;
+    uint8_t *resp;
+    int resp_len;
+} CLIENT_STATUS;
+
+static int client_status_cb(SSL *s, void *arg)
+{
+    CLIENT_STATUS *cs = arg;
+    uint8_t *resp;
+    int len;
+
+    cs->called++;
+    len = SSL_get_tlsext_status_ocsp_resp(s, &resp);
+    if (resp != NULL && len > 0) {
+        if ((cs->resp = malloc(len)) == NULL)
+            return -1;
+        memcpy(cs->resp, resp, len);
+        cs->resp_len = len;
+    }
+    return 1;
+}
+
+/*
+ * handshake connects a client asking for certificate status and records in
+ * |cs| the response it received, if any.
+ */
+static int handshake(SSL_CTX *sctx, SSL_CTX *cctx, CLIENT_STATUS *cs)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int ret = 0;
+
+    free(cs->resp);
+    memset(cs, 0, sizeof(*cs));
+
+    if (!create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL, NULL))
+        goto end;
+    SSL_set_tlsext_status_type(clientssl, TLSEXT_STATUSTYPE_ocsp);
+    if (!create_ssl_connection(serverssl, clientssl)) {
+        printf("Handshake failed\n");
+        ERR_print_errors_fp(stdout);
+        goto end;
+    }
+    if (cs->called != 1) {
+        printf("Client status callback called %d times\n", cs->called);
+        goto end;
+    }
+    ret = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+/* check_staple checks that |cs| holds a good status for |x|. */
+static int check_staple(CLIENT_STATUS *cs, X509 *x, X509 *issuer)
+{
+    OCSP_RESPONSE *resp;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_CERTID *id = NULL;
+    const uint8_t *p = cs->resp;
+    int status, reason, ret = 0;
+
+    if (cs->resp == NULL) {
+        printf("No staple received\n");
+        return 0;
+    }
+    if ((resp = d2i_OCSP_RESPONSE(NULL, &p, cs->resp_len)) == NULL ||
+        p != cs->resp + cs->resp_len ||
+        (bs = OCSP_response_get1_basic(resp)) == NULL ||
+        (id = OCSP_cert_to_id(NULL, x, issuer)) == NULL ||
+        !OCSP_resp_find_status(bs, id, &status, &reason, NULL, NULL, NULL) ||
+        status != V_OCSP_CERTSTATUS_GOOD) {
+        printf("Bad staple received\n");
+        goto err;
+    }
+    ret = 1;
+
+ err:
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(resp);
+    return ret;
+}
+
+static int test_stapling(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    RESPONDER r;
+    CLIENT_STATUS cs;
+    X509 *leaf = NULL, *inter = NULL;
+    uint8_t *first = NULL;
+    int first_len = 0, ret = 0;
+    BIO *bio;
+
+    memset(&r, 0, sizeof(r));
+    memset(&cs, 0, sizeof(cs));
+
+    bio = BIO_new_file(test_data_path("certs/subinterCA.pem"), "r");
+    if (bio != NULL)
+        inter = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    bio = BIO_new_file(test_data_path("certs/subinterCA.key"), "r");
+    if (bio != NULL)
+        r.key = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if ((bio = BIO_new_file(test_data_path("certs/leaf.pem"), "r")) != NULL)
+        leaf = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if (inter == NULL || r.key == NULL || leaf == NULL) {
+        printf("Unable to load the test certificates\n");
+        goto end;
+    }
+    r.cert = inter;
+    r.validity = 3600;
+
+    if (!create_ssl_ctx_pair(TLSv1_2_server_method(), TLSv1_2_client_method(),
+                             &sctx, &cctx, test_data_path("certs/leaf.pem"),
+                             test_data_path("certs/leaf.key"))) {
+        printf("Unable to create SSL_CTX pair\n");
+        goto end;
+    }
+    X509_up_ref(inter);
+    if (!SSL_CTX_add_extra_chain_cert(sctx, inter)) {
+        X509_free(inter);
+        goto end;
+    }
+    SSL_CTX_set_tlsext_status_cb(cctx, client_status_cb);
+    SSL_CTX_set_tlsext_status_arg(cctx, &cs);
+
+    /* A fetcher is required */
+    if (SSL_CTX_refresh_ocsp_staples(sctx, 60)) {
+        printf("Refresh without a fetcher succeeded\n");
+        goto end;
+    }
+    ERR_clear_error();
+    SSL_CTX_set_ocsp_fetch_cb(sctx, fetch, &r);
+
+    /* Nothing fetched yet, so nothing to staple */
+    if (!handshake(sctx, cctx, &cs))
+        goto end;
+    if (cs.resp != NULL) {
+        printf("Staple sent before any was fetched\n");
+        goto end;
+    }
+
+    if (!SSL_CTX_refresh_ocsp_staples(sctx, 60) || r.requests != 1) {
+        printf("Initial refresh failed\n");
+        ERR_print_errors_fp(stdout);
+        goto end;
+    }
+    if (!handshake(sctx, cctx, &cs) || !check_staple(&cs, leaf, inter))
+        goto end;
+    first = cs.resp;
+    first_len = cs.resp_len;
+    cs.resp = NULL;
+
+    /* Every handshake gets the same response until it is refreshed */
+    if (!SSL_CTX_refresh_ocsp_staples(sctx, 60) || r.requests != 1) {
+        printf("Fresh staple was fetched again\n");
+        goto end;
+    }
+    if (!handshake(sctx, cctx, &cs) || cs.resp_len != first_len ||
+        memcmp(cs.resp, first, first_len) != 0) {
+        printf("Staple changed without a refresh\n");
+        goto end;
+    }
+
+    /* Within the margin of nextUpdate it is replaced */
+    if (!SSL_CTX_refresh_ocsp_staples(sctx, 7200) || r.requests != 2) {
+        printf("Expiring staple was not fetched again\n");
+        goto end;
+    }
+    if (!handshake(sctx, cctx, &cs) || !check_staple(&cs, leaf, inter))
+        goto end;
+
+    /* A failed fetch keeps the previous staple */
+    r.fail = 1;
+    if (SSL_CTX_refresh_ocsp_staples(sctx, 7200)) {
+        printf("Failed fetch reported success\n");
+        goto end;
+    }
+    ERR_clear_error();
+    if (!handshake(sctx, cctx, &cs) || !check_staple(&cs, leaf, inter))
+        goto end;
+
+    /* An expired response is not installed */
+    r.validity = -60;
+    if (SSL_CTX_refresh_ocsp_staples(sctx, 7200) || r.requests != 3) {
+        printf("Expired response was installed\n");
+        goto end;
+    }
+    ERR_clear_error();
+    if (!handshake(sctx, cctx, &cs) || !check_staple(&cs, leaf, inter))
+        goto end;
+
+    /* A staple is no longer sent once it has expired */
+    r.validity = 1;
+    if (!SSL_CTX_refresh_ocsp_staples(sctx, 7200) || r.requests != 4) {
+        printf("Refresh with a short-lived response failed\n");
+        goto end;
+    }
+    sleep(2);
+    if (!handshake(sctx, cctx, &cs))
+        goto end;
+    if (cs.resp != NULL) {
+        printf("Expired staple sent\n");
+        goto end;
+    }
+
+    ret = 1;
+
+ end:
+    free(first);
+    free(cs.resp);
+    X509_free(leaf);
+    X509_free(inter);
+    EVP_PKEY_free(r.key);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int testresult = 0;
+
+    if (argc != 2) {
+        printf("Usage: ocspstapletest <datadir>\n");
+        return 1;
+    }
+    test_set_data_dir(argv[1]);
+
+    SSL_library_init();
+    SSL_load_error_strings();
+
+    if (!test_stapling())
+        testresult = 1;
+
+    ERR_free_strings();
+    ERR_remove_thread_state(NULL);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+
+    if (!testresult)
+        printf("PASS\n");
+
+    return testresult;
+}
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks SSL_MODE_CACHE_PEER_CERTS: repeated handshakes with the same peer
+ * reuse the decoded public keys, in both directions, while a different
+ * peer, or a context without the mode, gets freshly decoded ones. Every
+ * handshake gets its own X509 objects, so a forged certificate accepted by
+ * a lenient verify callback is still rejected by a strict connection.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+
+#include "ssltestlib.h"
+#include "testutil.h"
+
+static int accept_any(int ok, X509_STORE_CTX *ctx)
+{
+    return 1;
+}
+
+static int accept_verified(int ok, X509_STORE_CTX *ctx)
+{
+    return ok;
+}
+
+static X509 *load_cert(const char *name)
+{
+    X509 *x = NULL;
+    BIO *bio;
+
+    if ((bio = BIO_new_file(test_data_path(name), "r")) != NULL)
+        x = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    return x;
+}
+
+/*
+ * make_ctx_pair creates a server using |server_cert| and |server_key|, which
+ * asks for a client certificate, and a client presenting the leaf
+ * certificate and its intermediate.
+ */
+static int make_ctx_pair(const char *server_cert, const char *server_key,
+                         SSL_CTX **sctx, SSL_CTX **cctx)
+{
+    X509 *inter;
+
+    if (!create_ssl_ctx_pair(TLSv1_2_server_method(), TLSv1_2_client_method(),
+                             sctx, cctx, test_data_path(server_cert),
+                             test_data_path(server_key)))
+        return 0;
+    SSL_CTX_set_verify(*sctx, SSL_VERIFY_PEER, accept_any);
+
+    if (SSL_CTX_use_certificate_file(*cctx, test_data_path("certs/leaf.pem"),
+                                     SSL_FILETYPE_PEM) <= 0 ||
+        SSL_CTX_use_PrivateKey_file(*cctx, test_data_path("certs/leaf.key"),
+                                    SSL_FILETYPE_PEM) <= 0 ||
+        (inter = load_cert("certs/interCA.pem")) == NULL)
+        return 0;
+    if (!SSL_CTX_add_extra_chain_cert(*cctx, inter)) {
+        X509_free(inter);
+        return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    X509 *server_cert;      /* as seen by the client */
+    X509 *client_cert;      /* as seen by the server */
+    X509 *client_chain;     /* the intermediate, as seen by the server */
+} PEER_CERTS;
+
+static void peer_certs_free(PEER_CERTS *pc)
+{
+    X509_free(pc->server_cert);
+    X509_free(pc->client_cert);
+    X509_free(pc->client_chain);
+}
+
+static int handshake(SSL_CTX *sctx, SSL_CTX *cctx, PEER_CERTS *pc)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    STACK_OF(X509) *chain;
+    int ret = 0;
+
+    memset(pc, 0, sizeof(*pc));
+
+    if (!create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL, NULL) ||
+        !create_ssl_connection(serverssl, clientssl)) {
+        printf("Handshake failed\n");
+        ERR_print_errors_fp(stdout);
+        goto end;
+    }
+
+    pc->server_cert = SSL_get_peer_certificate(clientssl);
+    pc->client_cert = SSL_get_peer_certificate(serverssl);
+    chain = SSL_get_peer_cert_chain(serverssl);
+    if (pc->server_cert == NULL || pc->client_cert == NULL ||
+        sk_X509_num(chain) != 1) {
+        printf("Peer certificates missing\n");
+        goto end;
+    }
+    pc->client_chain = sk_X509_value(chain, 0);
+    X509_up_ref(pc->client_chain);
+    ret = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+static int same_cert(X509 *a, X509 *b)
+{
+    return X509_cmp(a, b) == 0;
+}
+
+/* same_key returns whether |a| and |b| hold the same decoded key object. */
+static int same_key(X509 *a, X509 *b)
+{
+    EVP_PKEY *ka = X509_get_pubkey(a), *kb = X509_get_pubkey(b);
+    int ret = ka != NULL && ka == kb;
+
+    EVP_PKEY_free(ka);
+    EVP_PKEY_free(kb);
+    return ret;
+}
+
+static int test_cache(int mode)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL, *sctx2 = NULL, *cctx2 = NULL;
+    PEER_CERTS first, second, other;
+    X509 *server_cert = NULL, *leaf = NULL;
+    int ret = 0;
+
+    memset(&first, 0, sizeof(first));
+    memset(&second, 0, sizeof(second));
+    memset(&other, 0, sizeof(other));
+
+    printf("Testing with the peer certificate cache %s\n",
+           mode ? "on" : "off");
+
+    if (!make_ctx_pair("server.pem", "server.pem", &sctx, &cctx) ||
+        !make_ctx_pair("certs/leaf.pem", "certs/leaf.key", &sctx2, &cctx2)) {
+        printf("Unable to create SSL_CTX pairs\n");
+        goto end;
+    }
+
+    if (mode) {
+        SSL_CTX_set_mode(sctx, SSL_MODE_CACHE_PEER_CERTS);
+        SSL_CTX_set_mode(cctx, SSL_MODE_CACHE_PEER_CERTS);
+    }
+
+    server_cert = load_cert("server.pem");
+    leaf = load_cert("certs/leaf.pem");
+    if (server_cert == NULL || leaf == NULL)
+        goto end;
+
+    if (!handshake(sctx, cctx, &first) || !handshake(sctx, cctx, &second) ||
+        !handshake(sctx2, cctx, &other))
+        goto end;
+
+    if (!same_cert(first.server_cert, server_cert) ||
+        !same_cert(second.server_cert, server_cert) ||
+        !same_cert(other.server_cert, leaf) ||
+        !same_cert(first.client_cert, leaf) ||
+        !same_cert(second.client_cert, leaf)) {
+        printf("Wrong peer certificate\n");
+        goto end;
+    }
+
+    if (first.server_cert == second.server_cert ||
+        first.client_cert == second.client_cert ||
+        first.client_chain == second.client_chain) {
+        printf("Peer certificates shared between handshakes\n");
+        goto end;
+    }
+    if (same_key(first.server_cert, second.server_cert) != mode ||
+        same_key(first.client_cert, second.client_cert) != mode ||
+        same_key(first.client_chain, second.client_chain) != mode) {
+        printf("Peer keys %sshared between handshakes\n", mode ? "not " : "");
+        goto end;
+    }
+    if (same_key(other.server_cert, first.server_cert)) {
+        printf("Key of a different peer reused\n");
+        goto end;
+    }
+
+    ret = 1;
+
+ end:
+    peer_certs_free(&first);
+    peer_certs_free(&second);
+    peer_certs_free(&other);
+    X509_free(server_cert);
+    X509_free(leaf);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    SSL_CTX_free(sctx2);
+    SSL_CTX_free(cctx2);
+
+    return ret;
+}
+
+/* forge_leaf returns certs/leaf.pem with its signature corrupted. */
+static X509 *forge_leaf(void)
+{
+    X509 *leaf, *forged = NULL;
+    uint8_t *der = NULL;
+    const uint8_t *p;
+    int len;
+
+    if ((leaf = load_cert("certs/leaf.pem")) == NULL)
+        return NULL;
+    if ((len = i2d_X509(leaf, &der)) > 0) {
+        der[len - 1] ^= 1;
+        p = der;
+        forged = d2i_X509(NULL, &p, len);
+    }
+    free(der);
+    X509_free(leaf);
+    return forged;
+}
+
+/*
+ * connect_forged runs a handshake and returns whether it succeeded. A strict
+ * server fails the handshake on any verification error.
+ */
+static int connect_forged(SSL_CTX *sctx, SSL_CTX *cctx, int strict)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int ret;
+
+    if (!create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL, NULL))
+        return -1;
+    if (strict)
+        SSL_set_verify(serverssl, SSL_VERIFY_PEER, accept_verified);
+    ret = create_ssl_connection(serverssl, clientssl);
+    ERR_clear_error();
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+static int test_forged(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    X509 *forged = NULL;
+    int ret = 0;
+
+    printf("Testing a forged certificate with the peer certificate cache\n");
+
+    /* The leaf is issued by subinterCA, under interCA and rootCA */
+    if (!make_ctx_pair("server.pem", "server.pem", &sctx, &cctx) ||
+        !SSL_CTX_load_verify_locations(sctx,
+                                       test_data_path("certs/rootCA.pem"),
+                                       NULL) ||
+        !SSL_CTX_load_verify_locations(sctx,
+                                       test_data_path("certs/interCA.pem"),
+                                       NULL) ||
+        !SSL_CTX_load_verify_locations(sctx,
+                                       test_data_path("certs/subinterCA.pem"),
+                                       NULL)) {
+        printf("Unable to create SSL_CTX pair\n");
+        goto end;
+    }
+    SSL_CTX_set_mode(sctx, SSL_MODE_CACHE_PEER_CERTS);
+
+    if (connect_forged(sctx, cctx, 1) != 1) {
+        printf("Strict handshake with the genuine certificate failed\n");
+        goto end;
+    }
+
+    if ((forged = forge_leaf()) == NULL ||
+        !SSL_CTX_use_certificate(cctx, forged)) {
+        X509_free(forged);
+        goto end;
+    }
+    X509_free(forged);
+
+    if (connect_forged(sctx, cctx, 0) != 1) {
+        printf("Lenient handshake failed\n");
+        goto end;
+    }
+    if (connect_forged(sctx, cctx, 1) != 0) {
+        printf("Strict handshake accepted a forged certificate\n");
+        goto end;
+    }
+    /* And again, now that the first strict handshake has seen it */
+    if (connect_forged(sctx, cctx, 0) != 1 ||
+        connect_forged(sctx, cctx, 1) != 0) {
+        printf("Forged certificate handled differently on reuse\n");
+        goto end;
+    }
+
+    ret = 1;
+
+ end:
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int testresult = 0;
+
+    if (argc != 2) {
+        printf("Usage: peercerttest <datadir>\n");
+        return 1;
+    }
+    test_set_data_dir(argv[1]);
+
+    SSL_library_init();
+    SSL_load_error_strings();
+
+    if (!test_cache(0) || !test_cache(1) || !test_forged())
+        testresult = 1;
+
+    ERR_free_strings();
+    ERR_remove_thread_state(NULL);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+
+    if (!testresult)
+        printf("PASS\n");
+
+    return testresult;
+}
@@ -1,6 +1,7 @@
 /* test vectors from p1ovect1.txt */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <openssl/crypto.h>
@@ -172,6 +173,165 @@ static int pad_unknown(void)
     return (0);
 }
 
+/*
+ * check_crt checks the private key operation of |key| against a plain
+ * exponentiation by d, with the public key check that would otherwise hide a
+ * wrong CRT result turned off.
+ */
+static int check_crt(RSA *key, BN_CTX *ctx)
+{
+    BIGNUM *in, *out, *want, *e;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    in = BN_CTX_get(ctx);
+    out = BN_CTX_get(ctx);
+    want = BN_CTX_get(ctx);
+    if (want == NULL || !BN_rand_range(in, key->n) ||
+        !BN_mod_exp(want, in, key->d, key->n, ctx))
+        goto err;
+    e = key->e;
+    key->e = NULL;
+    ret = key->meth->rsa_mod_exp(out, in, key, ctx);
+    key->e = e;
+    ret = ret && BN_cmp(out, want) == 0;
+
+err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+static int test_multi_prime_key(int bits, int primes, BN_CTX *ctx)
+{
+    RSA *key = NULL, *key2 = NULL;
+    BIGNUM *e;
+    uint8_t *der = NULL, *der2 = NULL;
+    const uint8_t *p;
+    uint8_t msg[32], sig[512], sig2[512], out[512];
+    int derlen, der2len, siglen, ret = 0;
+
+    memset(msg, 0x5a, sizeof(msg));
+    e = BN_new();
+    key = RSA_new();
+    if (e == NULL || key == NULL || !BN_set_word(e, RSA_F4) ||
+        !RSA_generate_multi_prime_key(key, bits, primes, e, NULL)) {
+        printf("Multi-prime key generation failed\n");
+        goto err;
+    }
+    if (BN_num_bits(key->n) != bits ||
+        RSA_get_multi_prime_extra_count(key) != primes - 2 ||
+        RSA_check_key(key) != 1) {
+        printf("Multi-prime key is not valid\n");
+        goto err;
+    }
+    if (!check_crt(key, ctx)) {
+        printf("Multi-prime CRT is wrong\n");
+        goto err;
+    }
+    key->flags |= RSA_FLAG_NO_CONSTTIME;
+    if (!check_crt(key, ctx)) {
+        printf("Multi-prime CRT without constant time is wrong\n");
+        goto err;
+    }
+    key->flags &= ~RSA_FLAG_NO_CONSTTIME;
+
+    siglen = RSA_private_encrypt(sizeof(msg), msg, sig, key,
+                                 RSA_PKCS1_PADDING);
+    if (siglen <= 0 ||
+        RSA_public_decrypt(siglen, sig, out, key,
+                           RSA_PKCS1_PADDING) != sizeof(msg) ||
+        memcmp(out, msg, sizeof(msg)) != 0) {
+        printf("Multi-prime signature failed\n");
+        goto err;
+    }
+
+    /* The key must survive encoding, and sign the same with the copy */
+    if ((derlen = i2d_RSAPrivateKey(key, &der)) <= 0) {
+        printf("Multi-prime key encoding failed\n");
+        goto err;
+    }
+    p = der;
+    if ((key2 = d2i_RSAPrivateKey(NULL, &p, derlen)) == NULL ||
+        RSA_get_multi_prime_extra_count(key2) != primes - 2 ||
+        RSA_check_key(key2) != 1 || !check_crt(key2, ctx) ||
+        (der2len = i2d_RSAPrivateKey(key2, &der2)) != derlen ||
+        memcmp(der, der2, derlen) != 0) {
+        printf("Multi-prime key decoding failed\n");
+        goto err;
+    }
+    if (RSA_private_encrypt(sizeof(msg), msg, sig2, key2,
+                            RSA_PKCS1_PADDING) != siglen ||
+        memcmp(sig, sig2, siglen) != 0) {
+        printf("Decoded multi-prime key signs differently\n");
+        goto err;
+    }
+    ret = 1;
+
+err:
+    if (!ret)
+        ERR_print_errors_fp(stdout);
+    free(der);
+    free(der2);
+    RSA_free(key);
+    RSA_free(key2);
+    BN_free(e);
+    return ret;
+}
+
+static int test_multi_prime(void)
+{
+    RSA *key = NULL, *key2;
+    BIGNUM *e = NULL;
+    BN_CTX *ctx;
+    uint8_t *der = NULL;
+    const uint8_t *p;
+    int derlen, ret = 0;
+
+    ERR_clear_error();
+    if ((ctx = BN_CTX_new()) == NULL)
+        return 0;
+    if (!test_multi_prime_key(1024, 2, ctx) ||
+        !test_multi_prime_key(2048, 3, ctx) ||
+        !test_multi_prime_key(4096, 4, ctx))
+        goto err;
+
+    /* Too many primes for the length are refused */
+    e = BN_new();
+    key = RSA_new();
+    if (e == NULL || key == NULL || !BN_set_word(e, RSA_F4))
+        goto err;
+    if (RSA_generate_multi_prime_key(key, 2048, 4, e, NULL) ||
+        RSA_generate_multi_prime_key(key, 512, 3, e, NULL)) {
+        printf("Too many primes accepted\n");
+        goto err;
+    }
+    ERR_clear_error();
+
+    /* and a multi-prime key must carry further primes */
+    if (!RSA_generate_key_ex(key, 512, e, NULL))
+        goto err;
+    key->version = RSA_ASN1_VERSION_MULTI;
+    if ((derlen = i2d_RSAPrivateKey(key, &der)) <= 0)
+        goto err;
+    p = der;
+    if ((key2 = d2i_RSAPrivateKey(NULL, &p, derlen)) != NULL) {
+        printf("Multi-prime key without further primes decoded\n");
+        RSA_free(key2);
+        goto err;
+    }
+    ERR_clear_error();
+
+    printf("Multi-prime keys ok\n");
+    ret = 1;
+
+err:
+    free(der);
+    RSA_free(key);
+    BN_free(e);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
     int err = 0;
@@ -281,6 +441,9 @@ int main(int argc, char *argv[])
         RSA_free(key);
     }
 
+    if (!test_multi_prime())
+        err = 1;
+
     CRYPTO_cleanup_all_ex_data();
     ERR_remove_thread_state(NULL);
 
@@ -28,6 +28,38 @@ static const char *ret[] = {
 static const char *bigret = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
 
 static char *pt(uint8_t *md);
+
+/*
+ * Hashes batches of messages whose lengths straddle the block and padding
+ * boundaries with SHA1_multi and compares the results with SHA1.
+ */
+static int test_multi(void)
+{
+    static const size_t sizes[] = {
+        0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 1000, 3000,
+    };
+    static uint8_t buf[4096];
+    const uint8_t *data[20];
+    size_t lens[20], num, i;
+    uint8_t md[20 * SHA_DIGEST_LENGTH], ref[SHA_DIGEST_LENGTH];
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 7 + 1);
+
+    for (num = 1; num <= 20; num++) {
+        for (i = 0; i < num; i++) {
+            lens[i] = sizes[(i * 7 + num) % (sizeof(sizes) / sizeof(sizes[0]))];
+            data[i] = buf + (i * 11) % 512;
+        }
+        SHA1_multi(num, data, lens, md);
+        for (i = 0; i < num; i++) {
+            SHA1(data[i], lens[i], ref);
+            if (memcmp(md + i * SHA_DIGEST_LENGTH, ref, sizeof(ref)) != 0)
+                return 0;
+        }
+    }
+    return 1;
+}
 int main(int argc, char *argv[])
 {
     int i, err = 0;
@@ -69,6 +101,12 @@ int main(int argc, char *argv[])
     } else
         printf("test 3 ok\n");
 
+    if (!test_multi()) {
+        printf("error calculating SHA1 with SHA1_multi\n");
+        err++;
+    } else
+        printf("test 4 ok\n");
+
     EVP_MD_CTX_cleanup(&c);
     exit(err);
     return (0);
@@ -57,6 +57,38 @@ uint8_t addenum_3[SHA224_DIGEST_LENGTH] = {
     0x4e, 0xe7, 0xad, 0x67
 };
 
+/*
+ * Hashes batches of messages whose lengths straddle the block and padding
+ * boundaries with SHA256_multi and compares the results with SHA256.
+ */
+static int test_multi(void)
+{
+    static const size_t sizes[] = {
+        0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 1000, 3000,
+    };
+    static uint8_t buf[4096];
+    const uint8_t *data[20];
+    size_t lens[20], num, i;
+    uint8_t md[20 * SHA256_DIGEST_LENGTH], ref[SHA256_DIGEST_LENGTH];
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 7 + 1);
+
+    for (num = 1; num <= 20; num++) {
+        for (i = 0; i < num; i++) {
+            lens[i] = sizes[(i * 7 + num) % (sizeof(sizes) / sizeof(sizes[0]))];
+            data[i] = buf + (i * 11) % 512;
+        }
+        SHA256_multi(num, data, lens, md);
+        for (i = 0; i < num; i++) {
+            SHA256(data[i], lens[i], ref);
+            if (memcmp(md + i * SHA256_DIGEST_LENGTH, ref, sizeof(ref)) != 0)
+                return 0;
+        }
+    }
+    return 1;
+}
+
 int main(int argc, char **argv)
 {
     uint8_t md[SHA256_DIGEST_LENGTH];
@@ -181,5 +213,18 @@ int main(int argc, char **argv)
     fprintf(stdout, " passed.\n");
     fflush(stdout);
 
+    fprintf(stdout, "Testing SHA256_multi ");
+
+    if (!test_multi()) {
+        fflush(stdout);
+        fprintf(stderr, "\nTEST 1 of 1 failed.\n");
+        return 1;
+    } else
+        fprintf(stdout, ".");
+    fflush(stdout);
+
+    fprintf(stdout, " passed.\n");
+    fflush(stdout);
+
     return 0;
 }
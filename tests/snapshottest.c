@@ -0,0 +1,293 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Writes a trust store snapshot of certs/roots.pem and checks that loading
+ * it through X509_LOOKUP_file verifies chains exactly as the PEM file does,
+ * that damaged snapshots are refused, and that lookups stay within a loaded
+ * snapshot that is rewritten in place.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+static STACK_OF(X509) *load_certs(const char *filename)
+{
+    STACK_OF(X509) *certs;
+    BIO *bio;
+    X509 *x;
+
+    if ((bio = BIO_new_file(filename, "r")) == NULL)
+        return NULL;
+    if ((certs = sk_X509_new_null()) == NULL) {
+        BIO_free(bio);
+        return NULL;
+    }
+    while ((x = PEM_read_bio_X509(bio, NULL, 0, NULL)) != NULL) {
+        if (!sk_X509_push(certs, x)) {
+            X509_free(x);
+            sk_X509_pop_free(certs, X509_free);
+            certs = NULL;
+            break;
+        }
+    }
+    ERR_clear_error();
+    BIO_free(bio);
+    return certs;
+}
+
+/* write_file writes |len| bytes of |data| to a new temporary file. */
+static int write_file(char *path, const uint8_t *data, size_t len)
+{
+    int fd, ok;
+
+    strcpy(path, "/tmp/snapshottestXXXXXX");
+    if ((fd = mkstemp(path)) < 0)
+        return 0;
+    ok = write(fd, data, len) == (ssize_t)len;
+    close(fd);
+    if (!ok)
+        unlink(path);
+    return ok;
+}
+
+static X509_STORE *load_store(const char *file)
+{
+    X509_STORE *store;
+    X509_LOOKUP *lookup;
+
+    if ((store = X509_STORE_new()) == NULL)
+        return NULL;
+    lookup = X509_STORE_add_lookup(store, X509_LOOKUP_file());
+    if (lookup == NULL ||
+        !X509_LOOKUP_load_file(lookup, file, X509_FILETYPE_PEM)) {
+        X509_STORE_free(store);
+        return NULL;
+    }
+    return store;
+}
+
+/*
+ * verify returns the X509_verify_cert error verifying the certificate in
+ * |file| with |untrusted| against |store|, or -1 if it could not be run.
+ */
+static int verify(X509_STORE *store, const char *file,
+                  STACK_OF(X509) *untrusted)
+{
+    X509_STORE_CTX *sctx;
+    BIO *bio;
+    X509 *x = NULL;
+    int ret = -1;
+
+    if ((bio = BIO_new_file(file, "r")) == NULL)
+        return -1;
+    x = PEM_read_bio_X509(bio, NULL, 0, NULL);
+    BIO_free(bio);
+    if (x == NULL)
+        return -1;
+    if ((sctx = X509_STORE_CTX_new()) != NULL &&
+        X509_STORE_CTX_init(sctx, store, x, untrusted)) {
+        X509_verify_cert(sctx);
+        ret = X509_STORE_CTX_get_error(sctx);
+    }
+    X509_STORE_CTX_free(sctx);
+    X509_free(x);
+    return ret;
+}
+
+static int test_verify(const char *snapshot, STACK_OF(X509) *untrusted)
+{
+    static const char *const leaves[] = { "certs/leaf.pem", "certs/bad.pem",
+                                          "certs/interCA.pem" };
+    X509_STORE *pem = NULL, *snap = NULL;
+    int i, want, got, ret = 0;
+
+    if ((pem = load_store("certs/roots.pem")) == NULL ||
+        (snap = load_store(snapshot)) == NULL) {
+        printf("Loading stores failed\n");
+        goto err;
+    }
+    for (i = 0; i < (int)(sizeof(leaves) / sizeof(leaves[0])); i++) {
+        want = verify(pem, leaves[i], untrusted);
+        got = verify(snap, leaves[i], untrusted);
+        if (want < 0 || got != want) {
+            printf("Verifying %s gave %d from the snapshot, %d from PEM\n",
+                   leaves[i], got, want);
+            goto err;
+        }
+    }
+    /* The chain must have come from the snapshot rather than the PEM. */
+    if (verify(snap, "certs/bad.pem", untrusted) != X509_V_ERR_INVALID_CA) {
+        printf("Snapshot did not catch the alternate chain forgery\n");
+        goto err;
+    }
+    ret = 1;
+
+err:
+    X509_STORE_free(pem);
+    X509_STORE_free(snap);
+    return ret;
+}
+
+/*
+ * load_damaged returns whether X509_LOOKUP_file loads |len| bytes of |data|,
+ * or -1 if it could not be run.
+ */
+static int load_damaged(const uint8_t *data, size_t len)
+{
+    char path[32];
+    X509_STORE *store;
+
+    if (!write_file(path, data, len))
+        return -1;
+    store = load_store(path);
+    unlink(path);
+    ERR_clear_error();
+    X509_STORE_free(store);
+    return store != NULL;
+}
+
+static int test_damaged(const uint8_t *data, size_t len)
+{
+    uint8_t *copy;
+    size_t i, count, off;
+    int ret = 0;
+
+    if ((copy = malloc(len)) == NULL)
+        return 0;
+    for (i = 0; i < 20; i++) {
+        if (load_damaged(data, i * len / 20) != 0) {
+            printf("Loaded a snapshot truncated to %zu bytes\n", i * len / 20);
+            goto err;
+        }
+    }
+    /* Point each offset and length of each index entry past the end. */
+    count = (size_t)data[12] << 24 | data[13] << 16 | data[14] << 8 | data[15];
+    for (i = 0; i < count * 6; i++) {
+        memcpy(copy, data, len);
+        off = 20 + (i / 6) * 7 * 4 + (1 + i % 6) * 4;
+        copy[off] = 0xff;
+        if (load_damaged(copy, len) != 0) {
+            printf("Loaded a snapshot with a bad index field at %zu\n", off);
+            goto err;
+        }
+    }
+    ret = 1;
+
+err:
+    free(copy);
+    return ret;
+}
+
+/*
+ * test_rewritten loads a snapshot of |len| bytes of |data| and then
+ * overwrites it in place with one whose offsets all point past the end, which
+ * a mapped snapshot sees, and checks that verifying finds no issuer in it
+ * rather than reading outside it.
+ */
+static int test_rewritten(const uint8_t *data, size_t len,
+                          STACK_OF(X509) *untrusted)
+{
+    X509_STORE *store = NULL;
+    uint8_t *copy;
+    char path[32];
+    size_t i, count, off;
+    int fd = -1, ret = 0;
+
+    if ((copy = malloc(len)) == NULL)
+        return 0;
+    memcpy(copy, data, len);
+    count = (size_t)data[12] << 24 | data[13] << 16 | data[14] << 8 | data[15];
+    for (i = 0; i < count * 3; i++) {
+        off = 20 + (i / 3) * 7 * 4 + (1 + (i % 3) * 2) * 4;
+        copy[off] = 0xff;
+    }
+
+    if (!write_file(path, data, len))
+        goto err;
+    if ((store = load_store(path)) == NULL ||
+        (fd = open(path, O_WRONLY)) < 0 ||
+        pwrite(fd, copy, len, 0) != (ssize_t)len) {
+        printf("Rewriting the snapshot failed\n");
+        goto err;
+    }
+    if (verify(store, "certs/leaf.pem", untrusted) !=
+        X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY) {
+        printf("Verified against a snapshot rewritten in place\n");
+        goto err;
+    }
+    ERR_clear_error();
+    ret = 1;
+
+err:
+    if (fd >= 0)
+        close(fd);
+    unlink(path);
+    X509_STORE_free(store);
+    free(copy);
+    return ret;
+}
+
+int main(void)
+{
+    STACK_OF(X509) *roots = NULL, *untrusted = NULL;
+    BIO *mem = NULL;
+    char path[32];
+    uint8_t *data;
+    long len;
+    int ret = 1;
+
+    ERR_load_crypto_strings();
+    OpenSSL_add_all_digests();
+
+    if ((roots = load_certs("certs/roots.pem")) == NULL ||
+        (untrusted = load_certs("certs/untrusted.pem")) == NULL ||
+        (mem = BIO_new(BIO_s_mem())) == NULL)
+        goto err;
+    /* Duplicates are dropped on writing. */
+    if (!sk_X509_push(roots, X509_dup(sk_X509_value(roots, 0))) ||
+        !X509_snapshot_write_bio(mem, roots)) {
+        printf("Writing snapshot failed\n");
+        goto err;
+    }
+    len = BIO_get_mem_data(mem, (char **)&data);
+    if (!write_file(path, data, len))
+        goto err;
+    if (!test_verify(path, untrusted)) {
+        unlink(path);
+        goto err;
+    }
+    unlink(path);
+    if (!test_damaged(data, len) || !test_rewritten(data, len, untrusted))
+        goto err;
+
+    printf("PASS\n");
+    ret = 0;
+
+err:
+    if (ret != 0)
+        ERR_print_errors_fp(stderr);
+    BIO_free(mem);
+    sk_X509_pop_free(roots, X509_free);
+    sk_X509_pop_free(untrusted, X509_free);
+    EVP_cleanup();
+    CRYPTO_cleanup_all_ex_data();
+    ERR_remove_thread_state(NULL);
+    ERR_free_strings();
+    return ret;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Checks that finds in a stack with a hash index agree with searching it
+ * while the stack is changed in every way, and that appending in order keeps
+ * a stack sorted. With a "bench" argument, it then times deduplicating names,
+ * as loading a client CA list does, and finding ciphers by pointer, with and
+ * without an index.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/stack.h>
+#include <openssl/x509.h>
+
+#include "testutil.h"
+
+#define NUM_VALUES 64
+#define NUM_OPS 20000
+
+static int values[NUM_VALUES];
+
+static int int_cmp(const void *a, const void *b)
+{
+    return **(const int *const *)a - **(const int *const *)b;
+}
+
+static unsigned long int_hash(const void *a)
+{
+    return *(const int *)a;
+}
+
+static unsigned long ptr_hash(const void *a)
+{
+    return (unsigned long)(size_t)a;
+}
+
+/* first_match returns the first position of |data| in |st| by searching. */
+static int first_match(_STACK *st, int *data)
+{
+    int i;
+
+    for (i = 0; i < sk_num(st); i++) {
+        if (st->comp != NULL ? *(int *)sk_value(st, i) == *data
+                             : sk_value(st, i) == data)
+            return i;
+    }
+    return -1;
+}
+
+/* apply_op makes a random change to |st| and returns the stack to use. */
+static _STACK *apply_op(_STACK *st, int op)
+{
+    int *v = &values[rand() % NUM_VALUES];
+    int loc = sk_num(st) > 0 ? rand() % sk_num(st) : 0;
+    _STACK *dup;
+
+    switch (op) {
+    case 0:
+    case 1:
+    case 2:
+        sk_push(st, v);
+        break;
+    case 3:
+        sk_unshift(st, v);
+        break;
+    case 4:
+        sk_insert(st, v, loc);
+        break;
+    case 5:
+        sk_delete(st, loc);
+        break;
+    case 6:
+        sk_set(st, loc, v);
+        break;
+    case 7:
+        sk_pop(st);
+        break;
+    case 8:
+        sk_shift(st);
+        break;
+    case 9:
+        sk_sort(st);
+        break;
+    case 10:
+        if ((dup = sk_dup(st)) != NULL) {
+            sk_free(st);
+            st = dup;
+        }
+        break;
+    case 11:
+        if (rand() % 20 == 0)
+            sk_zero(st);
+        break;
+    }
+    return st;
+}
+
+/*
+ * test_index checks each find in an indexed stack against searching it in
+ * order and against sk_find on an unindexed copy, which sorts the copy.
+ */
+static int test_index(int (*cmp)(const void *, const void *),
+                      unsigned long (*hash)(const void *))
+{
+    _STACK *st, *copy = NULL;
+    int i, j, ret = 0;
+
+    if ((st = sk_new(cmp)) == NULL || !sk_set_hash_func(st, hash))
+        goto err;
+
+    for (i = 0; i < NUM_OPS; i++) {
+        st = apply_op(st, rand() % 12);
+        if (i % 16 != 0)
+            continue;
+        if ((copy = sk_dup(st)) == NULL || !sk_set_hash_func(copy, NULL))
+            goto err;
+        for (j = 0; j < NUM_VALUES; j++) {
+            int *v = &values[j];
+            int found = sk_find(st, v);
+
+            if (found != first_match(st, v) ||
+                (found >= 0) != (sk_find(copy, v) >= 0)) {
+                printf("Find of %d disagrees after %d changes\n", *v, i);
+                goto err;
+            }
+        }
+        sk_free(copy);
+        copy = NULL;
+    }
+    ret = 1;
+
+ err:
+    sk_free(copy);
+    sk_free(st);
+    return ret;
+}
+
+static int test_sorted_append(void)
+{
+    int ordered[NUM_VALUES];
+    _STACK *st;
+    int i, ret = 0;
+
+    if ((st = sk_new(int_cmp)) == NULL)
+        return 0;
+    for (i = 0; i < NUM_VALUES; i++)
+        ordered[i] = i;
+    for (i = NUM_VALUES / 2; i > 0; i--)
+        sk_push(st, &ordered[i]);
+    sk_sort(st);
+    for (i = NUM_VALUES / 2; i < NUM_VALUES; i++)
+        sk_push(st, &ordered[i]);
+    if (!sk_is_sorted(st)) {
+        printf("Appending in order unsorted the stack\n");
+        goto err;
+    }
+    sk_push(st, &ordered[0]);
+    if (sk_is_sorted(st)) {
+        printf("Appending out of order left the stack sorted\n");
+        goto err;
+    }
+    ret = 1;
+
+ err:
+    sk_free(st);
+    return ret;
+}
+
+static int name_cmp(const X509_NAME *const *a, const X509_NAME *const *b)
+{
+    return X509_NAME_cmp(*a, *b);
+}
+
+static unsigned long name_hash(const X509_NAME *a)
+{
+    return X509_NAME_hash((X509_NAME *)a);
+}
+
+/*
+ * bench_names adds |num| names, each twice, to a stack that is searched
+ * before every push, as SSL_load_client_CA_file does.
+ */
+static int bench_names(X509_NAME **names, int num, int indexed)
+{
+    STACK_OF(X509_NAME) *sk;
+    double start;
+    int i, ret = 0;
+
+    if ((sk = sk_X509_NAME_new(name_cmp)) == NULL)
+        return 0;
+    if (indexed && !sk_X509_NAME_set_hash_func(sk, name_hash))
+        goto err;
+
+    start = test_now();
+    for (i = 0; i < 2 * num; i++) {
+        if (sk_X509_NAME_find(sk, names[i % num]) < 0)
+            sk_X509_NAME_push(sk, names[i % num]);
+    }
+    test_report(indexed ? "names, indexed" : "names, sorted", 2.0 * num,
+                test_now() - start, "lookups");
+
+    ret = sk_X509_NAME_num(sk) == num;
+
+ err:
+    sk_X509_NAME_free(sk);
+    return ret;
+}
+
+#define NUM_CIPHERS 100
+#define CIPHER_ROUNDS 2000
+
+static int ciphers[NUM_CIPHERS];
+
+/*
+ * bench_pointers finds each element of a list of pointers, without a
+ * comparison function, as when choosing a cipher.
+ */
+static int bench_pointers(int indexed)
+{
+    _STACK *st;
+    double start;
+    int i, j, ret = 0;
+
+    if ((st = sk_new_null()) == NULL)
+        return 0;
+    if (indexed && !sk_set_hash_func(st, ptr_hash))
+        goto err;
+    for (i = 0; i < NUM_CIPHERS; i++)
+        sk_push(st, &ciphers[i]);
+
+    start = test_now();
+    for (j = 0; j < CIPHER_ROUNDS; j++) {
+        for (i = NUM_CIPHERS - 1; i >= 0; i--) {
+            if (sk_find(st, sk_value(st, i)) != i)
+                goto err;
+        }
+    }
+    test_report(indexed ? "pointers, indexed" : "pointers, search",
+                (double)NUM_CIPHERS * CIPHER_ROUNDS, test_now() - start,
+                "lookups");
+    ret = 1;
+
+ err:
+    sk_free(st);
+    return ret;
+}
+
+#define NUM_NAMES 1000
+
+static int bench(void)
+{
+    X509_NAME *names[NUM_NAMES];
+    char cn[32];
+    int i, ret = 0;
+
+    memset(names, 0, sizeof(names));
+    for (i = 0; i < NUM_NAMES; i++) {
+        snprintf(cn, sizeof(cn), "Client CA %d", i);
+        if ((names[i] = X509_NAME_new()) == NULL ||
+            !X509_NAME_add_entry_by_txt(names[i], "O", MBSTRING_ASC,
+                                        (const uint8_t *)"Example", -1, -1,
+                                        0) ||
+            !X509_NAME_add_entry_by_txt(names[i], "CN", MBSTRING_ASC,
+                                        (const uint8_t *)cn, -1, -1, 0))
+            goto err;
+    }
+
+    if (bench_names(names, NUM_NAMES, 0) && bench_names(names, NUM_NAMES, 1) &&
+        bench_pointers(0) && bench_pointers(1))
+        ret = 1;
+
+ err:
+    for (i = 0; i < NUM_NAMES; i++)
+        X509_NAME_free(names[i]);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int i, ret = 1;
+
+    for (i = 0; i < NUM_VALUES; i++)
+        values[i] = i % (NUM_VALUES / 2);
+
+    if (!test_index(int_cmp, int_hash) || !test_index(NULL, ptr_hash) ||
+        !test_sorted_append())
+        goto err;
+    if (test_bench_requested(argc, argv) && !bench()) {
+        printf("Benchmark failed\n");
+        goto err;
+    }
+
+    printf("PASS\n");
+    ret = 0;
+
+ err:
+    if (ret != 0)
+        ERR_print_errors_fp(stdout);
+    return ret;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <openssl/crypto.h>
+
+#include "internal/threads.h"
+
+#include "testutil.h"
+
+static const char *data_dir = ".";
+
+int test_bench_requested(int argc, char *argv[])
+{
+    return argc > 1 && strcmp(argv[argc - 1], "bench") == 0;
+}
+
+double test_now(void)
+{
+#if defined(_WIN32)
+    return GetTickCount64() / 1e3;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+double test_run_threads(int num, void *(*start)(void *), void *arg)
+{
+    CRYPTO_THREAD threads[TEST_MAX_THREADS];
+    double begin;
+    int i, ok = 1;
+
+    if (num > TEST_MAX_THREADS)
+        return -1;
+    begin = test_now();
+    for (i = 0; i < num; i++) {
+        if (!CRYPTO_thread_spawn(&threads[i], start, arg)) {
+            ok = 0;
+            break;
+        }
+    }
+    while (i-- > 0)
+        CRYPTO_thread_join(threads[i]);
+    return ok ? test_now() - begin : -1;
+}
+
+void test_report(const char *what, double count, double secs,
+                 const char *unit)
+{
+    printf("%-30s %12.0f %s/s\n", what, secs > 0 ? count / secs : 0.0, unit);
+}
+
+void test_set_data_dir(const char *dir)
+{
+    data_dir = dir;
+}
+
+char *test_data_path(const char *name)
+{
+    static char path[4][1024];
+    static int next;
+    char *p = path[next++ % 4];
+
+    snprintf(p, sizeof(path[0]), "%s/%s", data_dir, name);
+    return p;
+}
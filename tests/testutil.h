@@ -0,0 +1,44 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef HEADER_TESTUTIL_H
+#define HEADER_TESTUTIL_H
+
+/*
+ * test_bench_requested returns whether "bench" is the last argument. Tests
+ * only run their benchmarks then, as in "stacktest bench", so that ctest
+ * runs just the checks.
+ */
+int test_bench_requested(int argc, char *argv[]);
+
+/* The most threads test_run_threads() starts at once */
+#define TEST_MAX_THREADS 8
+
+/* test_now returns a monotonic time in seconds. */
+double test_now(void);
+
+/*
+ * test_run_threads runs |start| with |arg| on |num| threads at once and
+ * returns the seconds until all of them finished, or a negative value if the
+ * threads could not be started.
+ */
+double test_run_threads(int num, void *(*start)(void *), void *arg);
+
+/* test_report prints |count| |unit| in |secs| seconds as a rate. */
+void test_report(const char *what, double count, double secs,
+                 const char *unit);
+
+/*
+ * test_data_path returns the path of |name| in the directory given to
+ * test_set_data_dir(). The last four paths returned stay valid.
+ */
+void test_set_data_dir(const char *dir);
+char *test_data_path(const char *name);
+
+#endif
@@ -79,6 +79,10 @@ extern "C" {
     ((int (*)(const void *, const void *)) \
         ((1 ? p : (int (*)(const type * const *, const type * const *))0)))
 
+# define CHECKED_SK_HASH_FUNC(type, p) \
+    ((unsigned long (*)(const void *)) \
+        ((1 ? p : (unsigned long (*)(const type *))0)))
+
 # define STACK_OF(type) struct stack_st_##type
 # define PREDECLARE_STACK_OF(type) STACK_OF(type);
 
@@ -159,6 +163,8 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 # define SKM_sk_set_cmp_func(type, st, cmp) \
         ((int (*)(const type * const *,const type * const *)) \
         sk_set_cmp_func(CHECKED_STACK_OF(type, st), CHECKED_SK_CMP_FUNC(type, cmp)))
+# define SKM_sk_set_hash_func(type, st, hash) \
+        sk_set_hash_func(CHECKED_STACK_OF(type, st), CHECKED_SK_HASH_FUNC(type, hash))
 # define SKM_sk_dup(type, st) \
         (STACK_OF(type) *)sk_dup(CHECKED_STACK_OF(type, st))
 # define SKM_sk_pop_free(type, st, free_func) \
@@ -227,6 +233,7 @@ foreach $type_thing (sort @stacklst) {
 # define sk_${type_thing}_delete_ptr(st, ptr) SKM_sk_delete_ptr($type_thing, (st), (ptr))
 # define sk_${type_thing}_insert(st, val, i) SKM_sk_insert($type_thing, (st), (val), (i))
 # define sk_${type_thing}_set_cmp_func(st, cmp) SKM_sk_set_cmp_func($type_thing, (st), (cmp))
+# define sk_${type_thing}_set_hash_func(st, hash) SKM_sk_set_hash_func($type_thing, (st), (hash))
 # define sk_${type_thing}_dup(st) SKM_sk_dup($type_thing, st)
 # define sk_${type_thing}_pop_free(st, free_func) SKM_sk_pop_free($type_thing, (st), (free_func))
 # define sk_${type_thing}_deep_copy(st, copy_func, free_func) SKM_sk_deep_copy($type_thing, (st), (copy_func), (free_func))